@@ -10,8 +10,10 @@ Developed for IEEE Southeastcon Hardware Competition 2025
 #include "src/handler/ButtonHandler.h"
 #include "src/handler/GyroHandler.h"
 #include "src/handler/HallHandler.h"
+#include "src/handler/I2CBus.h"
 #include "src/handler/LightHandler.h"
 #include "src/handler/LineHandler.h"
+#include "src/handler/MissionHandler.h"
 #include "src/handler/RCHandler.h"
 #include "src/handler/RGBHandler.h"
 // #include "src/handler/ROSHandler.h"
@@ -23,12 +25,24 @@ Developed for IEEE Southeastcon Hardware Competition 2025
 #include "src/subsystem/SorterSubsystem.h"
 using namespace GlobalColors;
 
+#include "src/drive/DriveLoop.h"
 #include "src/drive/DriveMotor.h"
+#include "src/drive/ParticleLocalizer.h"
 #include "src/drive/SimpleRobotDrive.h"
+#include "src/drive/StartPoseEstimator.h"
 #include "src/drive/VectorRobotDrive.h"
 #include "src/drive/VectorRobotDrivePID.h"
+#include "src/drive/math/FieldMap.h"
 #include "src/drive/math/Pose2D.h"
 #include "src/drive/paths.h"
+#include "src/util/ConfigStore.h"
+#include "src/util/Logger.h"
+#include "src/util/Profiler.h"
+#include "src/util/Registry.h"
+#include "src/util/Scheduler.h"
+#include "src/util/StartupSequencer.h"
+#include "src/util/Telemetry.h"
+#include "src/util/Tracer.h"
 
 // These functions are used to control the state of pins while the teensy starts.
 extern "C" void startup_early_hook(void);
@@ -75,12 +89,27 @@ int kButton[BUTTON_COUNT] = {40, 39, 38, 37};
 int kLED = 14;
 int cLight = 0;
 
+// TOF sampling per phase; sensor 4 is the sorter's. Before the match the side sensors take slow,
+// accurate readings of the walls; during it the sorter runs at full rate and the sides keep
+// feeding the localizer with shorter budgets.
+const TOFSetting TOF_PROFILE_PREMATCH[TOF_COUNT] = {{TOF_PRIORITY_NORMAL, 50000},
+                                                   {TOF_PRIORITY_NORMAL, 50000},
+                                                   {TOF_PRIORITY_NORMAL, 50000},
+                                                   {TOF_PRIORITY_NORMAL, 50000},
+                                                   {TOF_PRIORITY_IDLE, 20000}};
+const TOFSetting TOF_PROFILE_MATCH[TOF_COUNT] = {{TOF_PRIORITY_NORMAL, 33000},
+                                                {TOF_PRIORITY_NORMAL, 33000},
+                                                {TOF_PRIORITY_NORMAL, 33000},
+                                                {TOF_PRIORITY_NORMAL, 33000},
+                                                {TOF_PRIORITY_HIGH, 20000}};
+
 /*
 --- Handlers ---
 */
-TOFHandler tofs(cTOF, TOF_COUNT);
+I2CBus i2c(Wire1, 17, 16, 1000000);  // SDA1, SCL1; owns the mux, handlers only pass a channel
+TOFHandler tofs(i2c, cTOF, TOF_COUNT);
 GyroHandler gyro;
-LightHandler light(cLight);
+LightHandler light(i2c, cLight);
 HallHandler halls(kHall, HALL_COUNT);
 ButtonHandler buttons(kButton, BUTTON_COUNT);
 RGBHandler rgb(kLED);
@@ -119,10 +148,26 @@ PIDConfig pidConfigs[DRIVEMOTOR_COUNT]{
      .maxRate = MAX_ANGULAR_ACCELERATION,
      .thetaFix = true},
 };
-VectorRobotDrivePID drive(driveMotors, DRIVEMOTOR_COUNT, Serial, pidConfigs[0], pidConfigs[0],
+VectorRobotDrivePID drive(driveMotors, DRIVEMOTOR_COUNT, Log, pidConfigs[0], pidConfigs[0],
                           pidConfigs[2]);
-DriveMotor intakeMotor(nonDriveMotors[0], Serial);
-DriveMotor transferMotor(nonDriveMotors[1], Serial);
+DriveMotor intakeMotor(nonDriveMotors[0], Log);
+DriveMotor transferMotor(nonDriveMotors[1], Log);
+
+/*
+--- Configuration ---
+  Tuning constants are stored in EEPROM and pushed to the drive and subsystems at startup. The
+  values here are only the defaults used when nothing valid is stored. Send "cfg" over Serial to
+  see the active values, or read, diff and write them with tools/config_tool.py.
+*/
+RobotConfig DefaultConfig() {
+  RobotConfig defaults;
+  defaults.xPID = pidConfigs[0];
+  defaults.yPID = pidConfigs[0];  // The drive has always run the X gains on Y
+  defaults.thetaPID = pidConfigs[2];
+  defaults.wheelDiameter = WHEEL_DIAMETER;
+  return defaults;
+}
+ConfigStore configStore(DefaultConfig());
 
 /*
 --- Subsystems ---
@@ -131,6 +176,214 @@ SorterSubsystem sorter(4, 3, 2, tofs, halls, servos, transferMotor, rgb);
 MandibleSubsystem mandibles(0, 1, servos);
 BeaconSubsystem beacon(3, servos);
 PathHandler paths(drive);
+MissionHandler mission(paths);
+
+/*
+--- Missions ---
+  Hard coded programs as step tables, run by the MissionHandler at 200 Hz.
+*/
+// Starts a timed hopper dump from the deposit corner.
+void StartDump() {
+  drive.SetPosition(Pose2D(12, MAXY - 6, EAST));
+  sorter.SetTransferOverride(255);
+}
+
+void StopDump() { sorter.ClearTransferOverride(); }
+
+const MissionStep noBoxMission[] = {
+    PathStep("slam left corner", Paths::slam_left_corner),
+    ActionStep("set corner pose", [] { drive.SetPosition(Pose2D(6, 6, PI * 0.5)); }),
+    PathStep("beacon position", Paths::beacon_position),
+    ActionStep("beacon down 1", [] { beacon.MoveDown1(); }),
+    DwellStep("beacon settle 1", 200),
+    ActionStep("beacon down 2", [] { beacon.MoveDown2(); }),
+    DwellStep("beacon settle 2", 200),
+    ActionStep("beacon down", [] { beacon.MoveDownFinal(); }),
+    DwellStep("beacon hold", 2000),
+    PathStep("jostle beacon", Paths::jostle_beacon),
+    PathStep("beacon pullout", Paths::beacon_pullout),
+};
+
+const MissionStep boxMission[] = {
+    PathStep("start to slam SW", HardBox::startToSlamSW90),
+    ActionStep("set SW corner pose", [] { drive.SetPosition(Pose2D(6, 6, NORTH)); }),
+    PathStep("beacon approach", HardBox::supposedBeacon),
+    ActionStep("beacon down 1", [] { beacon.MoveDown1(); }),
+    DwellStep("beacon settle 1", 200),
+    ActionStep("beacon down 2", [] { beacon.MoveDown2(); }),
+    DwellStep("beacon settle 2", 200),
+    ActionStep("beacon down", [] { beacon.MoveDownFinal(); }),
+    PathStep("jostle beacon", HardBox::jostleBeacon),
+    PathStep("beacon pullout", HardBox::beaconPullout),
+    ParallelStep("stow beacon", 2),
+    ActionStep("beacon up", [] { beacon.MoveUp(); }),
+    ActionStep("open left mandible", [] { mandibles.OpenLeft(); }),
+    PathStep("csc pickup", HardBox::cscPickup),
+    ActionStep("dump start", StartDump),
+    DwellStep("dump", 2000),
+    ActionStep("dump stop", StopDump),
+    PathStep("deposit sweep 1", HardBox::depositSweep1),
+    ActionStep("dump start", StartDump),
+    DwellStep("dump", 2000),
+    ActionStep("dump stop", StopDump),
+    PathStep("deposit sweep 2", HardBox::depositSweep2),
+    ActionStep("dump start", StartDump),
+    DwellStep("dump", 2000),
+    ActionStep("dump stop", StopDump),
+    PathStep("deposit sweep 3", HardBox::depositSweep3),
+    ActionStep("dump start", StartDump),
+    DwellStep("dump", 2000),
+    ActionStep("dump stop", StopDump),
+    PathStep("deposit sweep 4", HardBox::depositSweep4),
+    ActionStep("dump start", StartDump),
+    DwellStep("dump", 2000),
+    ActionStep("dump stop", StopDump),
+    PathStep("deposit sweep 5", HardBox::depositSweep5),
+    ActionStep("dump start", StartDump),
+    DwellStep("dump", 2000),
+    ActionStep("dump stop", StopDump),
+    PathStep("setup cave sweep north", HardBox::setupCaveSweepNorth),
+    PathStep("cave sweep north", HardBox::caveSweepNorth),
+    PathStep("cave return", HardBox::caveSweepReturn),
+    ActionStep("dump start", StartDump),
+    DwellStep("dump", 2000),
+    ActionStep("dump stop", StopDump),
+    PathStep("setup cave sweep south", HardBox::setupCaveSweepSouth),
+    PathStep("cave sweep south", HardBox::caveSweepSouth),
+    PathStep("cave return", HardBox::caveSweepReturn),
+    ActionStep("dump start", StartDump),
+    DwellStep("dump", 4000),
+    ActionStep("dump stop", StopDump),
+    PathStep("return to start", HardBox::returnToStart),
+    ActionStep("finished", [] {
+      for (int i = 0; i < 7; i++) {
+        rgb.setSectionSolidColor(i, GOLD);
+      }
+    }),
+};
+
+static_assert(sizeof(noBoxMission) / sizeof(noBoxMission[0]) <= MISSION_MAX_STEPS,
+              "noBoxMission is longer than MissionHandler can run");
+static_assert(sizeof(boxMission) / sizeof(boxMission[0]) <= MISSION_MAX_STEPS,
+              "boxMission is longer than MissionHandler can run");
+
+/*
+--- Scheduling ---
+*/
+Scheduler scheduler;
+
+/*
+--- Startup ---
+  The gyro, TOF sensors and light sensor are brought up from the main loop one step at a time
+  so LEDs, buttons, RC and the DIP switches are live during boot. Failed devices are retried in
+  the background. Arming waits for the required stages. Send "boot" over Serial for timings.
+*/
+StartupSequencer startup;
+
+/*
+--- Profiling ---
+  Send "prof" over Serial to dump zone timings, "prof reset" to clear them.
+*/
+Profiler profiler;
+const int ZONE_RC = profiler.AddZone("rc");
+const int ZONE_GYRO = profiler.AddZone("gyro");
+const int ZONE_TOF = profiler.AddZone("tof");
+const int ZONE_LIGHT = profiler.AddZone("light");
+const int ZONE_I2C = profiler.AddZone("i2c");
+const int ZONE_HALLS = profiler.AddZone("halls");
+const int ZONE_BUTTONS = profiler.AddZone("buttons");
+const int ZONE_RGB = profiler.AddZone("rgb");
+const int ZONE_SERVOS = profiler.AddZone("servos");
+const int ZONE_DRIVE_READ = profiler.AddZone("drive read");
+const int ZONE_DRIVE_STEP = profiler.AddZone("drive step");
+const int ZONE_DRIVE_WRITE = profiler.AddZone("drive write");
+const int ZONE_MISSION = profiler.AddZone("mission");
+const int ZONE_SORTER = profiler.AddZone("sorter");
+const int ZONE_PRINT = profiler.AddZone("print");
+const int ZONE_TELEMETRY = profiler.AddZone("telemetry");
+const int ZONE_LOCALIZE = profiler.AddZone("localize");
+const int ZONE_START_POSE = profiler.AddZone("start pose");
+
+/*
+--- Tracing ---
+  State changes, mission steps and the profiler zones above are recorded into a RAM timeline
+  (Trace). Send "trace dump" over Serial and convert the capture with tools/trace_to_chrome.py,
+  then open it in Perfetto. The dump blocks on Serial, so it is refused while RUNNING; dump after
+  the match instead. "trace tracks 6" keeps only state and mission events, which covers a whole
+  match; "trace tracks 7" records everything again.
+*/
+
+/*
+--- Telemetry ---
+  With TELEMETRY_BINARY set, the text status dump is replaced by COBS-framed binary packets.
+  Decode them on the host with tools/telemetry_decode.py. A packet that does not fit in the USB
+  transmit buffer is dropped rather than waited on, so a slow or absent host never stalls the
+  loop; "tlm" shows the drop count.
+*/
+#define TELEMETRY_BINARY 1
+#define TELEMETRY_PERIOD_US 20000  // 50 Hz for pose, velocity, encoders and motors
+#define TELEMETRY_SLOW_DIVIDER 5   // TOF, RC and servos every 5th packet (10 Hz)
+Telemetry telemetry(Serial);
+
+/*
+--- Drive Control ---
+  With DRIVE_CONTROL_ISR set, odometry, the PID step and the motor writes run from a hardware
+  timer once the robot starts. Odometry integrates at DRIVE_ODOMETRY_RATE_HZ so each arc is short;
+  the PID step and motor writes run at DRIVE_CONTROL_RATE_HZ. loop() only publishes the gyro yaw,
+  rate and sample time, and sets targets. Send "drive" over Serial to see the step timings, or
+  "odom" for the pose, each wheel's slip and the EKF estimate with its standard deviations.
+*/
+#define DRIVE_CONTROL_ISR 1
+#define DRIVE_CONTROL_RATE_HZ 500
+#define DRIVE_ODOMETRY_RATE_HZ 2000
+DriveLoop driveLoop(drive);
+
+/*
+--- Localization ---
+  A particle filter fuses the four side TOF ranges with the drive's odometry against the known
+  field walls. Send "loc" over Serial for its pose and timing, or read the loc.* registry values.
+  With LOCALIZER_CORRECTS_DRIVE set, a converged estimate that is more than
+  LOCALIZER_MIN_CORRECTION away from odometry is written back to the drive while running, where it
+  is fused into the drive's EKF with the particle spread as its error. A pose set by the mission
+  (after a wall slam) restarts the filter around it.
+  The ranges are matched to the odometry at the newest reading's time, looked up in the drive's
+  pose history, and the correction is applied at that time so the motion since is kept. The
+  history covers more than LOCALIZER_MAX_AGE_US; "odom" prints its span and misses.
+*/
+#define LOCALIZER_CORRECTS_DRIVE 1
+#define LOCALIZER_PERIOD_US 50000           // 20 Hz
+#define LOCALIZER_BEAMS 4                   // TOF sensors 0-3; sensor 4 is inside the sorter
+#define LOCALIZER_MIN_CORRECTION 0.5f       // in
+#define LOCALIZER_RESET_SPREAD 1.0f         // in, around a pose set by the mission
+#define LOCALIZER_RESET_SPREAD_THETA 0.05f  // rad
+#define LOCALIZER_MAX_AGE_US 100000         // Older TOF readings are not used
+#define CAVE_OPENING 12.0                   // Gap (in) in the cave wall around CENTERY; estimate
+
+// TOF mounting (x forward, y left, in inches); approximate, measure on the robot
+const RangeBeam TOF_BEAMS[LOCALIZER_BEAMS] = {
+    {4.5f, 0.0f, 0.0f}, {0.0f, 4.5f, HALF_PI}, {-4.5f, 0.0f, PI}, {0.0f, -4.5f, -HALF_PI}};
+FieldMap field;
+ParticleLocalizer localizer(field, TOF_BEAMS, LOCALIZER_BEAMS);
+
+/*
+--- Start Pose ---
+  Until the match starts, the side TOF ranges are fitted to the field around the nominal start
+  pose. When the match starts a good fit becomes the drive pose and the gyro heading; a poor one
+  leaves both as they were and, while waiting, turns LED sections 1 and 3 red. Send "start" over
+  Serial for the fit.
+*/
+#define START_POSE_PERIOD_US 200000  // 5 Hz
+const Pose2D START_POSE_NOMINAL(STARTX, STARTY, DRIVER_START_OFFSET);
+StartPoseEstimator startPose(field, TOF_BEAMS, LOCALIZER_BEAMS);
+
+/*
+--- Registry ---
+  Named values that can be read, tuned and streamed over Serial:
+    ls [pattern], get <name>, set <name> <value>, sub <pattern> <Hz>, unsub [pattern]
+  A pattern ending in '*' matches a prefix, e.g. "sub drive.pose.* 200". Gains changed with
+  "set" take effect immediately and are kept across a reboot only after "cfg save".
+*/
+Registry registry(Log);
 
 /*
 --- Program Control ---
@@ -165,10 +418,10 @@ bool RC_READY;
 
 bool *dips;
 
-bool SuccessTOF = false;
-bool SuccessLight = false;
-
 bool detectLight = false;
+
+bool update10Available = false;   // Set by the 10 Hz mode task, cleared by RUNNING
+bool update200Available = false;  // Set by the 200 Hz mode task, cleared by RUNNING
 /*
 --- Statistics ---
 */
@@ -177,6 +430,8 @@ long fps = 0;
 void setup() {
   // --- BEGIN SETUP PHASE ---
   STATE = SETUP;
+  TraceState();
+  UpdateTOFProfile();
   buttons.Begin();  // Necessary to begin buttons here to get CONTROLLED_BY_PI
   updateDips();
   Serial.begin(9600);
@@ -191,7 +446,8 @@ void setup() {
       }
     }
   }*/
-  Serial.println("Hello");
+  Log.println("Hello");
+  configStore.Load();
 
   // Begin I2C
   Wire.setClock(400000);
@@ -199,12 +455,11 @@ void setup() {
   Wire.begin();
   Wire1.begin();
 
-  // Begin all Handlers
-  SuccessTOF = tofs.Begin();
-  if (!gyro.Begin()) {
-    reset();
-  }
-  SuccessLight = light.Begin();
+  // Begin fast Handlers; the gyro, TOFs and light sensor are started by RunStartup()
+  TOFFilterConfig sorterFilter;  // Sensor 4 gates the transfer motor: no median, steps at once
+  sorterFilter.medianWindow = 1;
+  sorterFilter.maxOutliers = 1;
+  tofs.SetFilterConfig(4, sorterFilter);
   halls.Begin();
   // buttons.Begin();
   rgb.Begin();
@@ -213,47 +468,87 @@ void setup() {
   drive.Begin();
   intakeMotor.Begin();
   transferMotor.Begin();
-  sorter.Begin();
-  mandibles.Begin();
-  beacon.Begin();
+  ApplyConfig();  // Drive gains, then Begin() for the sorter, mandibles and beacon
+  BuildField();
+  localizer.Reset(drive.GetPosition(), LOCALIZER_RESET_SPREAD, LOCALIZER_RESET_SPREAD_THETA);
+  RegisterValues();
 
   // Print setups
-  tofs.PrintInfo(Serial, true);
-  gyro.PrintInfo(Serial, true);
-  light.PrintInfo(Serial, true);
-  halls.PrintInfo(Serial, true);
-  buttons.PrintInfo(Serial, true);
-  rgb.PrintInfo(Serial, true);
-  servos.PrintInfo(Serial, true);
-  sorter.PrintInfo(Serial, true);
-  rc.PrintInfo(Serial, true);
-  drive.PrintInfo(Serial, true);
-  Serial.println("Intake: ");
-  intakeMotor.PrintInfo(Serial, true);
-  Serial.println("Transfer: ");
-  transferMotor.PrintInfo(Serial, true);
-  // mandibles.PrintInfo(Serial, true); placeholder
-  // beacon.PrintInfo(Serial, true); placeholder
+  configStore.PrintInfo(Log, true);
+  registry.PrintInfo(Log, true);
+  Trace.PrintInfo(Log, true);
+  halls.PrintInfo(Log, true);
+  buttons.PrintInfo(Log, true);
+  rgb.PrintInfo(Log, true);
+  servos.PrintInfo(Log, true);
+  sorter.PrintInfo(Log, true);
+  rc.PrintInfo(Log, true);
+  drive.PrintInfo(Log, true);
+  field.PrintInfo(Log, true);
+  localizer.PrintInfo(Log, true);
+  startPose.PrintInfo(Log, true);
+  Log.println("Intake: ");
+  intakeMotor.PrintInfo(Log, true);
+  Log.println("Transfer: ");
+  transferMotor.PrintInfo(Log, true);
+  // mandibles.PrintInfo(Log, true); placeholder
+  // beacon.PrintInfo(Log, true); placeholder
+
+  // --- STARTUP STAGES ---
+  startup.AddStage("gyro", StartGyro, true);
+  startup.AddStage("tof", StartTOF);
+  startup.AddStage("light", StartLight);
+  startup.PrintInfo(Log, true);
+
+  // --- SCHEDULER ---
+  scheduler.AddTask("startup", RunStartup, 10000, 0, 0);
+  scheduler.AddTask("rc", ReadRC, 5000, 0, 3);
+  scheduler.AddTask("mode200hz", [] { update200Available = true; }, 5000, 0, 3);
+  scheduler.AddTask("gyro", ReadGyro, GYRO_REPORT_INTERVAL_US / 2, 0, 2);
+  scheduler.AddTask("rgb", UpdateOutputs, 20000, 0, 1);
+  scheduler.AddTask("tof", ReadTOF, 5000, 0, 1);  // Polls 2 of 5 sensors per call, never waits
+  scheduler.AddTask("light", ReadLight, 100000, 0, 0);
+  scheduler.AddTask("i2c", RunI2C, 2500, 0, 1);  // Runs the TOF and light reads queued above
+  scheduler.AddTask("localize", UpdateLocalizer, LOCALIZER_PERIOD_US, 0, 0);
+  scheduler.AddTask("start pose", EstimateStartPose, START_POSE_PERIOD_US, 0, 0);
+  scheduler.AddTask("halls", ReadHalls, 100000, 0, 0);
+  scheduler.AddTask("buttons", ReadButtons, 100000, 0, 0);
+  scheduler.AddTask("mode10hz", [] { update10Available = true; }, 100000, 0, 1);
+#if TELEMETRY_BINARY
+  scheduler.AddTask("telemetry", SendTelemetry, TELEMETRY_PERIOD_US, 0, 0);
+  telemetry.PrintInfo(Log, true);
+#else
+  scheduler.AddTask("print", GlobalPrint, 200000, 0, 0);
+#endif
+  scheduler.AddTask("commands", ReadCommands, 50000, 0, 0);
+  scheduler.AddTask("log", DrainLog, 2000, 0, 0);
+  scheduler.AddTask("registry", [] { registry.Update(); }, 1000, 0, 0);
+  scheduler.AddTask("trace", [] { Trace.Update(); }, 1000000, 0, 0);
+  scheduler.SpreadPhases();
+  scheduler.PrintInfo(Log, true);
+  profiler.Begin();
+  profiler.PrintInfo(Log, true);
+  Log.PrintInfo(Log, true);
+  Log.Drain();
 
   // --- PROGRAM CONTROL ---
-  delay(500);
   updateDips();  // Update dips so we don't get any unexpected readings
-  light.Update();
   buttons.Update();
   STATE = WAITINGFORSTART;
   rgb.setGlobalBrightness(175);
+  scheduler.Begin();
 }
 
 void loop() {
+  TraceState();
+  UpdateTOFProfile();
   switch (STATE) {
     case SETUP: {
       delay(10);
       break;
     }
     case WAITINGFORSTART: {
-      GlobalRead();
-      GlobalUpdate();
-      GlobalPrint();
+      scheduler.Update();
       GlobalStats();
 
       static elapsedMillis update = 0;
@@ -262,7 +557,7 @@ void loop() {
         updateDips();  // updates dips/buttons
 
         // --- Indicator for Light and TOF I2C ---
-        if (SuccessLight && SuccessTOF) {
+        if (startup.IsDone()) {
           rgb.setSectionSolidColor(5, GOLD);
           rgb.setSectionSolidColor(6, GOLD);
         } else {
@@ -270,8 +565,14 @@ void loop() {
           rgb.setSectionPulseEffect(6, RED, 20);
         }
 
-        rgb.setSectionStreakEffect(1, GOLD, 200);
-        rgb.setSectionStreakEffect(3, GOLD, 200);
+        // --- Indicator for the start pose fit ---
+        if (startup.IsDone() && !startPose.IsGood()) {
+          rgb.setSectionPulseEffect(1, RED, 20);
+          rgb.setSectionPulseEffect(3, RED, 20);
+        } else {
+          rgb.setSectionStreakEffect(1, GOLD, 200);
+          rgb.setSectionStreakEffect(3, GOLD, 200);
+        }
 
         // --- Ready function ---
         bool READY_TO_ARM;
@@ -311,6 +612,7 @@ void loop() {
           }
         }
 
+        READY_TO_ARM = READY_TO_ARM && startup.IsRequiredDone();
         if (READY_TO_ARM)  // Ready to arm!
         {
           rgb.setSectionSolidColor(0, sideColor);
@@ -332,12 +634,10 @@ void loop() {
       break;
     }
     case ARMED: {
-      GlobalRead();
-      GlobalUpdate();
-      GlobalPrint();
+      scheduler.Update();
       GlobalStats();
       for (uint8_t i = 0; i < 5; i++) {
-        rgb.setSectionPulseEffect(i, GOLD, 20);
+        rgb.setSectionPulseEffect(i, (i == 1 || i == 3) && !startPose.IsGood() ? RED : GOLD, 20);
       }
 
       // --- Servo Setup ---
@@ -380,38 +680,34 @@ void loop() {
           rgb.Update();
         }
         gyro.Update();
-        gyro.Set_Gametime_Offset(gyro.GetGyroData()[0]);
+        ApplyStartPose();
         updateDips();
         RESET_AVAILABLE = !dips[0];
         rgb.setSectionPulseEffect(5, PURPLE, 20);
         rgb.setSectionPulseEffect(6, PURPLE, 20);
+        if (ROBOT_CONTROL_TYPE != REMOTE_CON) {
+          StartMission();
+        }
+#if DRIVE_CONTROL_ISR
+        driveLoop.SetYaw(gyro.GetGyroData()[0]);  // Offset yaw before the first step
+        if (!driveLoop.Begin(DRIVE_CONTROL_RATE_HZ, DRIVE_ODOMETRY_RATE_HZ)) {
+          LOG_ERROR("Drive timer unavailable, stepping drive from loop()");
+        }
+#endif
         STATE = RUNNING;
       }
       break;
     }
     case RUNNING: {
-      static elapsedMillis update10hz = 0;
-      static elapsedMillis update200hz = 0;  // 200hz
-      static bool update10Available = false;
-      static bool update200Available = false;
-      if (update10hz >= 100) {
-        update10hz = 0;
-        update10Available = true;
-      }
-      if (update200hz >= 5) {
-        update200hz = 0;
-        update200Available = true;
-      }
       switch (ROBOT_CONTROL_TYPE) {
         case HARD:
         case RASP_PI: {
-          GlobalRead();
-          GlobalUpdate();
+          scheduler.Update();
           GlobalStats();
-          if (GlobalPrint()) {
-            // drive.PrintController(Serial, false);
+          if (!driveLoop.IsRunning()) {
+            PROFILE_ZONE(profiler, ZONE_DRIVE_READ);
+            drive.ReadAll(gyro.GetGyroData()[0], drive.GetYawRate());
           }
-          drive.ReadAll(gyro.GetGyroData()[0]);
           switch (PROGRAM_SELECTION) {
             case NO_BOX:  // Green
             {
@@ -430,83 +726,19 @@ void loop() {
 
               if (update200Available) {
                 update200Available = false;
-                // Path logic
-                static int path_index = -1;
-                static bool command_set = false;
-                static elapsedMillis command_timer = 0;
-                switch (path_index) {
-                  case -1:  // start
-                    command_set = false;
-                    path_index++;
-                    break;
-                  case 0:  // slam into the left corner
-                    if (!command_set) {
-                      paths.addWaypoints(Paths::slam_left_corner);
-                      command_set = true;
-                      command_timer = 0;
-                    }
-                    if (paths.executePath()) {
-                      drive.SetPosition(Pose2D(6, 6, PI * 0.5));
-                      command_set = false;
-                      path_index++;
-                    }
-                    break;
-                  case 1:  // go to beacon position
-                    if (!command_set) {
-                      paths.addWaypoints(Paths::beacon_position);
-                      command_set = true;
-                      command_timer = 0;
-                    }
-                    if (paths.executePath()) {
-                      command_set = false;
-                      path_index++;
-                    }
-                    break;
-                  case 2:  // lower servo arm
-                    if (!command_set) {
-                      beacon.MoveDown();
-                      command_set = true;
-                      command_timer = 0;
-                    }
-                    if (command_timer > 2000) {
-                      command_set = false;
-                      path_index++;
-                    }
-                    break;
-                  case 3:  // jostle beacon
-                    if (!command_set) {
-                      paths.addWaypoints(Paths::jostle_beacon);
-                      command_set = true;
-                      command_timer = 0;
-                    }
-                    if (paths.executePath()) {
-                      command_set = false;
-                      path_index++;
-                    }
-                    break;
-                  case 4:  // slide out beacon
-                    if (!command_set) {
-                      paths.addWaypoints(Paths::beacon_pullout);
-                      command_set = true;
-                      command_timer = 0;
-                    }
-                    if (paths.executePath()) {
-                      command_set = false;
-                      path_index++;
-                    }
-                    break;
-                }
-                /*static bool path_clear = false;
-                path_clear = paths.executePath();
-                if (path_clear)
-                {
-                  paths.addWaypoints(Paths::andrew_waypoint);
-                }*/
+                PROFILE_ZONE(profiler, ZONE_MISSION);
+                mission.Update();
               }
 
-              // Drive update
-              drive.Set(drive.Step());
-              drive.Write();
+              // Drive update, unless the drive timer is running it
+              if (!driveLoop.IsRunning()) {
+                {
+                  PROFILE_ZONE(profiler, ZONE_DRIVE_STEP);
+                  drive.Set(drive.Step());
+                }
+                PROFILE_ZONE(profiler, ZONE_DRIVE_WRITE);
+                drive.Write();
+              }
               break;
             }
             case BOX:  // Cyan
@@ -523,284 +755,17 @@ void loop() {
                 }
                 break;
               }
-              static int path_index = -1;
               if (update200Available) {
                 update200Available = false;
-                // Path logic
-                static bool command_set = false;
-                static elapsedMillis command_timer = 0;
-                switch (path_index) {
-                  case -1:  // start
-                    command_set = false;
-                    path_index++;
-                    break;
-                  case 0:  // start to slam sw north
-                    if (!command_set) {
-                      paths.addWaypoints(HardBox::startToSlamSW90);
-                      command_set = true;
-                      command_timer = 0;
-                    }
-                    if (paths.executePath()) {
-                      drive.SetPosition(Pose2D(6, 6, NORTH));
-                      command_set = false;
-                      path_index++;
-                    }
-                    break;
-                  case 1:  // go to beacon position
-                    if (!command_set) {
-                      paths.addWaypoints(HardBox::supposedBeacon);
-                      command_set = true;
-                      command_timer = 0;
-                    }
-                    if (paths.executePath()) {
-                      beacon.MoveDown();
-                      static elapsedMillis timer = 0;
-                      while (timer < 0) {
-                      }
-                      command_set = false;
-                      path_index++;
-                    }
-                    break;
-                  case 2:  // jostle beacon, pullout
-                    if (!command_set) {
-                      paths.addWaypoints(HardBox::jostleBeacon);
-                      paths.addWaypoint(Pose2D(BEACONX + 10, BEACONY, NORTH));  // slide beacon out)
-                      paths.addWaypoint(Pose2D(BEACONX + 5, MAXY - 3, NORTH));
-                      paths.addWaypoint(Pose2D(BEACONX + 5, MAXY - 13, NORTH));
-                      paths.addWaypoint(Pose2D(BEACONX - 1, MAXY - 13, NORTH));
-                      paths.addWaypoint(Pose2D(BEACONX - 1, MAXY - 3, NORTH));
-                      paths.addWaypoint(Pose2D(BEACONX + 5, BEACONY - 4, NORTH));
-
-                      command_set = true;
-                      command_timer = 0;
-                    }
-                    if (paths.executePath()) {
-                      beacon.MoveUp();
-                      mandibles.OpenLeft();
-                      command_set = false;
-                      path_index++;
-                    }
-                    break;
-                  case 3:  // go to get csc
-                    if (!command_set) {
-                      paths.addWaypoint(Pose2D(70, BEACONY - 4, NORTH));
-                      paths.addWaypoint(Pose2D(50, BEACONY - 4, NORTH));
-                      paths.addWaypoint(Pose2D(37, MAXY - 6, NORTH));
-                      paths.addWaypoint(Pose2D(10, MAXY - 6, NORTH));
-                      paths.addWaypoint(Pose2D(30, MAXY - 22, NORTH));
-                      paths.addWaypoint(Pose2D(30, MAXY - 22, EAST));
-                      paths.addWaypoint(Pose2D(30, MAXY - 2, EAST));
-                      paths.addWaypoint(Pose2D(2, MAXY - 2, EAST));
-                      command_set = true;
-                      command_timer = 0;
-                    }
-                    if (paths.executePath()) {
-                      drive.SetPosition(Pose2D(12, MAXY - 6, EAST));
-                      transferMotor.Set(255);
-                      static elapsedMillis timer = 0;
-                      while (timer < 1000) {
-                        transferMotor.Write();
-                      }
-                      delay(1000);
-                      transferMotor.Set(0);
-                      transferMotor.Write();
-                      command_set = false;
-                      path_index = 7;
-                    }
-                    break;
-                  case 7:  // sweep north
-                    if (!command_set) {
-                      paths.addWaypoint(Pose2D(12, MAXY - 6, EAST));
-                      paths.addWaypoint(Pose2D(50, MAXY - 8, EAST));
-                      paths.addWaypoint(Pose2D(12, MAXY - 8, EAST));
-                      paths.addWaypoint(Pose2D(18, MAXY - 3, EAST));
-                      paths.addWaypoint(Pose2D(10, MAXY - 3, EAST));
-                      command_set = true;
-                      command_timer = 0;
-                    }
-                    if (paths.executePath()) {
-                      drive.SetPosition(Pose2D(12, MAXY - 6, EAST));
-                      transferMotor.Set(255);
-                      static elapsedMillis timer = 0;
-                      while (timer < 1000) {
-                        transferMotor.Write();
-                      }
-                      delay(1000);
-                      transferMotor.Set(0);
-                      transferMotor.Write();
-                      command_set = false;
-                      path_index++;
-                    }
-                    break;
-                  case 8:
-                    if (!command_set) {
-                      paths.addWaypoint(Pose2D(12, MAXY - 12, EAST));
-                      paths.addWaypoint(Pose2D(50, MAXY - 12, EAST));
-                      paths.addWaypoint(Pose2D(12, MAXY - 12, EAST));
-                      paths.addWaypoint(Pose2D(18, MAXY - 3, EAST));
-                      paths.addWaypoint(Pose2D(10, MAXY - 3, EAST));
-                      command_set = true;
-                      command_timer = 0;
-                    }
-                    if (paths.executePath()) {
-                      drive.SetPosition(Pose2D(12, MAXY - 6, EAST));
-                      transferMotor.Set(255);
-                      static elapsedMillis timer = 0;
-                      while (timer < 1000) {
-                        transferMotor.Write();
-                      }
-                      delay(1000);
-                      transferMotor.Set(0);
-                      transferMotor.Write();
-                      command_set = false;
-                      path_index++;
-                    }
-                    break;
-                  case 9:
-                    if (!command_set) {
-                      paths.addWaypoint(Pose2D(12, MAXY - 18, EAST));
-                      paths.addWaypoint(Pose2D(50, MAXY - 18, EAST));
-                      paths.addWaypoint(Pose2D(12, MAXY - 18, EAST));
-                      paths.addWaypoint(Pose2D(18, MAXY - 3, EAST));
-                      paths.addWaypoint(Pose2D(10, MAXY - 3, EAST));
-                      command_set = true;
-                      command_timer = 0;
-                    }
-                    if (paths.executePath()) {
-                      drive.SetPosition(Pose2D(12, MAXY - 6, EAST));
-                      transferMotor.Set(255);
-                      static elapsedMillis timer = 0;
-                      while (timer < 1000) {
-                        transferMotor.Write();
-                      }
-                      delay(1000);
-                      transferMotor.Set(0);
-                      transferMotor.Write();
-                      command_set = false;
-                      path_index++;
-                    }
-                    break;
-                  case 10:
-                    if (!command_set) {
-                      paths.addWaypoint(Pose2D(12, MAXY - 24, EAST));
-                      paths.addWaypoint(Pose2D(40, MAXY - 24, EAST));
-                      paths.addWaypoint(Pose2D(12, MAXY - 24, EAST));
-                      paths.addWaypoint(Pose2D(18, MAXY - 3, EAST));
-                      paths.addWaypoint(Pose2D(10, MAXY - 3, EAST));
-                      command_set = true;
-                      command_timer = 0;
-                    }
-                    if (paths.executePath()) {
-                      drive.SetPosition(Pose2D(12, MAXY - 6, EAST));
-                      transferMotor.Set(255);
-                      static elapsedMillis timer = 0;
-                      while (timer < 1000) {
-                        transferMotor.Write();
-                      }
-                      delay(1000);
-                      transferMotor.Set(0);
-                      transferMotor.Write();
-                      command_set = false;
-                      path_index++;
-                    }
-                    break;
-                  case 11:
-                    if (!command_set) {
-                      paths.addWaypoint(Pose2D(12, MAXY - 30, EAST));
-                      paths.addWaypoint(Pose2D(50, MAXY - 30, EAST));
-                      paths.addWaypoint(Pose2D(12, MAXY - 30, EAST));
-                      paths.addWaypoint(Pose2D(18, MAXY - 3, EAST));
-                      paths.addWaypoint(Pose2D(10, MAXY - 3, EAST));
-                      command_set = true;
-                      command_timer = 0;
-                    }
-                    if (paths.executePath()) {
-                      drive.SetPosition(Pose2D(12, MAXY - 6, EAST));
-                      transferMotor.Set(255);
-                      static elapsedMillis timer = 0;
-                      while (timer < 1000) {
-                        transferMotor.Write();
-                      }
-                      delay(1000);
-                      transferMotor.Set(0);
-                      transferMotor.Write();
-                      command_set = false;
-                      path_index = 19;
-                    }
-                    break;
-                  case 19:  // sweep north
-                    if (!command_set) {
-                      paths.addWaypoints(HardBox::setupCaveSweepNorth);
-                      paths.addWaypoints(HardBox::caveSweepNorth);
-                      paths.addWaypoints(HardBox::caveSweepReturn);
-                      command_set = true;
-                      command_timer = 0;
-                    }
-                    if (paths.executePath()) {
-                      drive.SetPosition(Pose2D(12, MAXY - 6, EAST));
-                      transferMotor.Set(255);
-                      static elapsedMillis timer = 0;
-                      while (timer < 1000) {
-                        transferMotor.Write();
-                      }
-                      delay(1000);
-                      transferMotor.Set(0);
-                      transferMotor.Write();
-                      command_set = false;
-                      path_index++;
-                    }
-                    break;
-                  case 20:  // sweep south
-                    if (!command_set) {
-                      paths.addWaypoints(HardBox::setupCaveSweepSouth);
-                      paths.addWaypoints(HardBox::caveSweepSouth);
-                      paths.addWaypoints(HardBox::caveSweepReturn);
-                      command_set = true;
-                      command_timer = 0;
-                    }
-                    if (paths.executePath()) {
-                      drive.SetPosition(Pose2D(12, MAXY - 6, EAST));
-                      transferMotor.Set(255);
-                      static elapsedMillis timer = 0;
-                      while (timer < 3000) {
-                        transferMotor.Write();
-                      }
-                      delay(1000);
-                      transferMotor.Set(0);
-                      transferMotor.Write();
-                      command_set = false;
-                      path_index++;
-                    }
-                    break;
-                  case 21:
-                    if (!command_set) {
-                      paths.addWaypoint(Pose2D(31.5, 6, NORTH));
-                      command_set = true;
-                      command_timer = 0;
-                    }
-                    if (paths.executePath()) {
-                      command_set = false;
-                      path_index++;
-                    }
-                    break;
-                  case 22:
-                    for (int i = 0; i < 7; i++) {
-                      rgb.setSectionSolidColor(i, GOLD);
-                    }
-                    break;
-                }
-                /*static bool path_clear = false;
-                path_clear = paths.executePath();
-                if (path_clear)
-                {
-                  paths.addWaypoints(Paths::andrew_waypoint);
-                }*/
+                PROFILE_ZONE(profiler, ZONE_MISSION);
+                mission.Update();
               }
-              // Drive update
-              if (path_index != 22) {
-                drive.Set(drive.Step());
-              } else {
+              // Drive update, unless the drive timer is running it
+              if (mission.IsFinished()) {
                 reset();
+              } else if (!driveLoop.IsRunning()) {
+                PROFILE_ZONE(profiler, ZONE_DRIVE_STEP);
+                drive.Set(drive.Step());
               }
               static elapsedMillis timer = 0;
               if (timer > 5500) {
@@ -810,11 +775,17 @@ void loop() {
               } else {
                 intakeMotor.Set(150);
               }
-              sorter.Update();
+              {
+                PROFILE_ZONE(profiler, ZONE_SORTER);
+                sorter.Update();
+              }
               transferMotor.Write();
               intakeMotor.Write();
               transferMotor.Write();
-              drive.Write();
+              if (!driveLoop.IsRunning()) {
+                PROFILE_ZONE(profiler, ZONE_DRIVE_WRITE);
+                drive.Write();
+              }
               break;
             }
           }
@@ -822,13 +793,12 @@ void loop() {
         }
 
         case REMOTE_CON: {
-          GlobalRead();
-          GlobalUpdate();
+          scheduler.Update();
           GlobalStats();
-          if (GlobalPrint()) {
-            drive.PrintController(Serial, false);
+          if (!driveLoop.IsRunning()) {
+            PROFILE_ZONE(profiler, ZONE_DRIVE_READ);
+            drive.ReadAll(gyro.GetGyroData()[0], drive.GetYawRate());  // Encoders every frame
           }
-          drive.ReadAll(gyro.GetGyroData()[0]);  // Update encoders every frame
 
           if (update10Available) {
             update10Available = false;
@@ -844,17 +814,22 @@ void loop() {
 
           if (update200Available) {
             update200Available = false;
-            update200hz = 0;
 
             // --- Drive Update ---
             Pose2D speedPose =
                 CalculateRCVector(true);  // drive.ConstrainNewSpeedPose(CalculateRCVector(true));
             drive.SetTargetByVelocity(speedPose);
-            Pose2D hihi = drive.Step();
-            drive.Set(hihi);
+            if (!driveLoop.IsRunning()) {
+              PROFILE_ZONE(profiler, ZONE_DRIVE_STEP);
+              Pose2D hihi = drive.Step();
+              drive.Set(hihi);
+            }
 
             // --- Other systems update ---
-            sorter.Update();  // Update sorter
+            {
+              PROFILE_ZONE(profiler, ZONE_SORTER);
+              sorter.Update();  // Update sorter
+            }
             int intakeSpeed = rc.Get(5);
             if (abs(intakeSpeed) < 30) {
               intakeSpeed = 0;
@@ -870,7 +845,10 @@ void loop() {
           }
 
           // Write
-          drive.Write();
+          if (!driveLoop.IsRunning()) {
+            PROFILE_ZONE(profiler, ZONE_DRIVE_WRITE);
+            drive.Write();
+          }
           transferMotor.Write();
           intakeMotor.Write();
           break;
@@ -892,70 +870,601 @@ void loop() {
   }
 }
 
-void GlobalRead() {
-  static elapsedMillis read10hz = 0;
-  if (read10hz > 100) {
-    read10hz = 0;
-    light.Update();
-    halls.Update();
-    buttons.Update();
+/*
+--- Mission Control ---
+*/
+void StartMission() {
+  switch (PROGRAM_SELECTION) {
+    case NO_BOX:
+      mission.Load(noBoxMission, sizeof(noBoxMission) / sizeof(noBoxMission[0]));
+      break;
+    case BOX:
+      mission.Load(boxMission, sizeof(boxMission) / sizeof(boxMission[0]));
+      break;
+  }
+  mission.PrintInfo(Log, true);
+  mission.Start();
+}
+
+// Marks state machine transitions on the trace. Called at the top of every loop(), so a change
+// is recorded at the start of the iteration after it is made.
+void TraceState() {
+  static const char *names[] = {"SETUP", "WAITINGFORSTART", "ARMED", "RUNNING", "STOPPED", "ERROR"};
+  static int traced = -1;
+  if (traced == STATE) return;
+  if (traced >= 0) TRACE_END(TRACE_TRACK_STATE, names[traced]);
+  TRACE_BEGIN(TRACE_TRACK_STATE, names[STATE]);
+  traced = STATE;
+}
+
+/*
+--- Startup Stages ---
+  Each call does a bounded amount of work and reports whether the device is ready.
+*/
+StageResult StartGyro() {
+  if (!gyro.Begin()) {
+    return STAGE_FAILED;
+  }
+  gyro.PrintInfo(Log, true);
+  return STAGE_DONE;
+}
+
+// Starts one TOF sensor per call, skipping sensors that are already running.
+StageResult StartTOF() {
+  static int index = 0;
+  if (!tofs.IsSensorReady(index)) {
+    tofs.BeginSensor(index);
+  }
+  if (++index < TOF_COUNT) {
+    return STAGE_PENDING;
+  }
+  index = 0;
+  if (tofs.GetReadyCount() < TOF_COUNT) {
+    return STAGE_FAILED;
+  }
+  tofs.PrintInfo(Log, true);
+  return STAGE_DONE;
+}
+
+StageResult StartLight() {
+  if (!light.Begin()) {
+    return STAGE_FAILED;
+  }
+  light.PrintInfo(Log, true);
+  return STAGE_DONE;
+}
+
+// Switches the TOF sampling profile when the state enters or leaves RUNNING.
+void UpdateTOFProfile() {
+  static int applied = -1;
+  const int running = STATE == RUNNING;
+  if (applied == running) return;
+  tofs.ApplyProfile(running ? TOF_PROFILE_MATCH : TOF_PROFILE_PREMATCH);
+  applied = running;
+}
+
+/*
+--- Scheduled Tasks ---
+*/
+// Runs startup stages until every device is up. Paused while running so a retry cannot stall
+// the match.
+void RunStartup() {
+  if (STATE == RUNNING || startup.IsDone()) return;
+  startup.Update();
+  if (startup.IsDone()) {
+    Log << startup;
+  }
+}
+
+void ReadRC() {
+  PROFILE_ZONE(profiler, ZONE_RC);
+  rc.Update();
+}
+
+void ReadGyro() {
+  PROFILE_ZONE(profiler, ZONE_GYRO);
+  gyro.Update();
+  GyroSample sample;
+  if (gyro.GetLatestSample(sample)) {
+    driveLoop.SetYaw(sample.yaw, sample.yawRate, sample.timeUs);  // Extrapolated between reports
+  } else {
+    driveLoop.SetYaw(gyro.GetGyroData()[0]);
+  }
+  float yawRate;
+  uint32_t yawRateUs;
+  drive.SetYawRate(gyro.GetYawRate(yawRate, yawRateUs) ? yawRate : NAN);  // NAN: difference yaw
+
+  // Tell the gyro whether the wheels moved, so it only learns drift while the robot is at rest
+  static long lastEnc[DRIVEMOTOR_COUNT];
+  if (STATE != RUNNING && !driveLoop.IsRunning()) {
+    drive.ReadEnc();  // Otherwise ReadAll() already keeps the encoders current
+  }
+  const long *enc = drive.GetEnc();
+  bool moving = false;
+  for (int i = 0; i < DRIVEMOTOR_COUNT; i++) {
+    moving |= enc[i] != lastEnc[i];
+    lastEnc[i] = enc[i];
+  }
+  gyro.SetMoving(moving);
+}
+
+void ReadTOF() {
+  PROFILE_ZONE(profiler, ZONE_TOF);
+  tofs.Update();
+}
+
+void ReadLight() {
+  PROFILE_ZONE(profiler, ZONE_LIGHT);
+  light.Update();
+}
+
+void RunI2C() {
+  PROFILE_ZONE(profiler, ZONE_I2C);
+  i2c.Update();
+}
+
+// Fits the start pose to the latest TOF ranges until the match starts.
+void EstimateStartPose() {
+  if (STATE == RUNNING) return;
+  PROFILE_ZONE(profiler, ZONE_START_POSE);
+  float ranges[LOCALIZER_BEAMS];
+  for (uint8_t i = 0; i < LOCALIZER_BEAMS; i++) {
+    ranges[i] = ReadRange(i);
   }
+  startPose.Estimate(ranges, START_POSE_NOMINAL);
+}
 
-  static elapsedMillis read20hz = 0;
-  if (read20hz > 50) {
-    read20hz = 0;
-    tofs.Update();
+// Starts the gyro heading and the drive pose at the fitted start pose, or the gyro at its
+// nominal heading if the fit is poor. Called once as the match starts.
+void ApplyStartPose() {
+  Log << startPose;
+  if (!startPose.IsGood()) {
+    LOG_WARN("Start pose fit poor, keeping the nominal pose");
+    gyro.Set_Gametime_Offset(gyro.GetGyroData()[0]);
+    return;
   }
+  const Pose2D fitted = startPose.GetPose();
+  float headingError = fitted.getTheta() - DRIVER_START_OFFSET;
+  headingError = atan2f(sinf(headingError), cosf(headingError));
+  gyro.Set_Gametime_Offset(gyro.GetGyroData()[0] - headingError);  // Yaw starts at the fit
+  drive.SetPosition(fitted);
+}
+
+// Gets a TOF distance in inches, or -1 if the sensor has no valid, recent reading.
+float ReadRange(uint8_t index) {
+  const int mm = tofs.GetDistanceAtIndex(index);
+  if (mm < 0 || tofs.GetSampleAge(index) >= LOCALIZER_MAX_AGE_US) return -1;
+  return mm / 25.4f;
+}
+
+// Moves the particles with odometry and weights them with the TOF ranges read since the last
+// correction. The odometry is taken at the time of the newest range rather than now, since the
+// robot may have moved an inch or more since. The other ranges are at most a sensor period older.
+// Waits while a pose request is pending, since odometry is about to jump.
+void UpdateLocalizer() {
+  PROFILE_ZONE(profiler, ZONE_LOCALIZE);
+  static uint32_t seenRequest = 0;  // Last pose request applied by the drive
+  static uint32_t ownRequest = 0;   // Last pose request written by this task
+  static uint32_t usedSamples[LOCALIZER_BEAMS];
+  const uint32_t applied = drive.GetAppliedPositionCount();
+  if (drive.GetPositionRequestCount() != applied) return;
 
-  static elapsedMillis read100hz = 0;
-  if (read100hz > 10) {
-    read100hz = 0;
-    gyro.Update();
+  float ranges[LOCALIZER_BEAMS];
+  uint32_t samples[LOCALIZER_BEAMS];
+  uint32_t rangeTime = 0;
+  bool fresh = false;
+  for (uint8_t i = 0; i < LOCALIZER_BEAMS; i++) {
+    samples[i] = tofs.GetSampleTime(i);
+    ranges[i] = samples[i] != usedSamples[i] ? ReadRange(i) : -1;
+    if (ranges[i] >= 0 && (!fresh || static_cast<int32_t>(samples[i] - rangeTime) > 0)) {
+      rangeTime = samples[i];
+      fresh = true;
+    }
   }
+  if (!fresh) return;
+  PoseSample then;
+  if (!drive.GetPoseAt(rangeTime, then)) return;  // Older than the pose history
+  const Pose2D odometry = then.pose;
+  if (applied == seenRequest) {
+    localizer.Predict(odometry);
+  } else if (applied == ownRequest) {
+    localizer.SetOdometry(odometry);
+  } else {
+    localizer.Reset(odometry, LOCALIZER_RESET_SPREAD, LOCALIZER_RESET_SPREAD_THETA);
+  }
+  seenRequest = applied;
+
+  if (!localizer.Correct(ranges)) return;
+  memcpy(usedSamples, samples, sizeof(samples));
 
-  static elapsedMillis read200hz = 0;
-  if (read200hz > 5) {
-    read200hz = 0;
-    rc.Update();
+#if LOCALIZER_CORRECTS_DRIVE
+  const Pose2D estimate = localizer.GetPose();
+  const float error = hypotf(estimate.getX() - odometry.getX(), estimate.getY() - odometry.getY());
+  if (STATE == RUNNING && localizer.IsConverged() && error > LOCALIZER_MIN_CORRECTION) {
+    drive.CorrectPosition(estimate, rangeTime, max(localizer.GetSpread(), EKF_FIX_SIGMA_XY));
+    ownRequest = drive.GetPositionRequestCount();
   }
+#endif
+}
+
+void ReadHalls() {
+  PROFILE_ZONE(profiler, ZONE_HALLS);
+  halls.Update();
+}
+
+void ReadButtons() {
+  PROFILE_ZONE(profiler, ZONE_BUTTONS);
+  buttons.Update();
 }
 
-void GlobalUpdate() {
-  static elapsedMillis rgbUpdate = 0;
-  if (rgbUpdate > 20) {
-    rgbUpdate = 0;
+void UpdateOutputs() {
+  {
+    PROFILE_ZONE(profiler, ZONE_RGB);
     rgb.Update();
+  }
+  {
+    PROFILE_ZONE(profiler, ZONE_SERVOS);
     servos.Update();
   }
 }
 
-bool GlobalPrint() {
-  static elapsedMillis printTimer = 0;
-  if (printTimer > 200) {
-    printTimer = 0;
-    Serial.print("State: ");
-    Serial.println(STATE);
-    Serial.print("Progam: ");
-    Serial.println(ROBOT_CONTROL_TYPE);
-    Serial.print("Path Selection: ");
-    Serial.println(PROGRAM_SELECTION);
-    Serial.print("FPS: ");
-    Serial.println(fps);
-    Serial << tofs << gyro << light << halls << buttons << rgb << servos << rc;
-    Serial.print("ControllerPose: ");
-    Serial << CalculateRCVector(true) << drive;
-    Serial.print("SpeedPose: ");
-    Serial << drive.GetVelocity();
-    Serial.print("IdealSpeedPose: ");
-    Serial << drive.GetIdealVelocity();
-    Serial.print("Transfer: ");
-    Serial << transferMotor;
-    Serial.print("Intake: ");
-    Serial << intakeMotor;
-    return true;
+// Forwards buffered log text to Serial as space allows.
+void DrainLog() { Log.Drain(); }
+
+// Reads newline-terminated commands from Serial without blocking.
+void ReadCommands() {
+  static char line[64];
+  static uint8_t length = 0;
+  while (Serial.available() > 0) {
+    const char c = Serial.read();
+    if (c == '\n' || c == '\r') {
+      if (length > 0) {
+        line[length] = '\0';
+        HandleCommand(line);
+        length = 0;
+      }
+    } else if (length < sizeof(line) - 1) {
+      line[length++] = c;
+    }
+  }
+}
+
+void HandleCommand(const char *command) {
+  unsigned int mask = 0;
+  if (strcmp(command, "prof") == 0) {
+    Log << profiler;
+  } else if (strcmp(command, "prof reset") == 0) {
+    profiler.Reset();
+  } else if (strcmp(command, "status") == 0) {
+    GlobalPrint();
+  } else if (strcmp(command, "log") == 0) {
+    Log << Log;
+  } else if (strcmp(command, "log debug") == 0) {
+    Log.SetLevel(LOG_LEVEL_DEBUG);
+  } else if (strcmp(command, "log info") == 0) {
+    Log.SetLevel(LOG_LEVEL_INFO);
+  } else if (strcmp(command, "log warn") == 0) {
+    Log.SetLevel(LOG_LEVEL_WARN);
+  } else if (strcmp(command, "boot") == 0) {
+    Log << startup;
+  } else if (strcmp(command, "drive") == 0) {
+    driveLoop.PrintInfo(Log, true);
+    Log << driveLoop;
+  } else if (strcmp(command, "odom") == 0) {
+    drive.PrintLocal(Log);
+  } else if (strncmp(command, "cfg", 3) == 0) {
+    HandleConfigCommand(command + 3);
+  } else if (strcmp(command, "tlm") == 0) {
+    Log << telemetry;
+  } else if (strcmp(command, "tlm key") == 0) {
+    telemetry.ForceKeyframe();
+  } else if (strcmp(command, "trace") == 0) {
+    Log << Trace;
+  } else if (strcmp(command, "trace dump") == 0) {
+    if (STATE == RUNNING) {
+      // Too large for the log buffer, so it blocks until the host has read it
+      LOG_WARN("trace dump would stall the match; dump once stopped");
+    } else {
+      Log.Drain();
+      Trace.Dump(Serial);
+    }
+  } else if (strcmp(command, "trace clear") == 0) {
+    Trace.Clear();
+  } else if (sscanf(command, "trace tracks %u", &mask) == 1) {
+    Trace.SetTrackMask(mask);
+  } else if (strcmp(command, "i2c") == 0) {
+    Log << i2c;
+  } else if (strcmp(command, "i2c reset") == 0) {
+    i2c.ResetStats();
+  } else if (strcmp(command, "loc") == 0) {
+    Log << localizer;
+  } else if (strcmp(command, "start") == 0) {
+    Log << startPose;
+  } else if (strcmp(command, "reg") == 0) {
+    Log << registry;
+  } else if (!HandleRegistryCommand(command)) {
+    Log.print("Unknown command: ");
+    Log.println(command);
+  }
+}
+
+// Handles "cfg ..." commands from tools/config_tool.py. Replies end with "CFG OK" or "CFG ERR".
+void HandleConfigCommand(const char *args) {
+  if (args[0] == '\0') {
+    configStore.PrintInfo(Log, true);
+    return;
+  }
+  if (strcmp(args, " dump") == 0) {
+    configStore.Dump(Log);
+    return;
+  }
+  if (STATE == RUNNING) {  // Saving stalls on flash writes and Begin() moves the servos
+    Log.println("CFG ERR running");
+    return;
+  }
+
+  unsigned int offset = 0;
+  unsigned int crc = 0;
+  char hex[2 * CONFIG_CHUNK_BYTES + 1];
+  bool ok = true;
+  if (strcmp(args, " begin") == 0) {
+    configStore.BeginWrite();
+  } else if (sscanf(args, " w %u %32s", &offset, hex) == 2) {
+    ok = configStore.WriteChunk(offset, hex);
+  } else if (sscanf(args, " commit %x", &crc) == 1) {
+    ok = configStore.CommitWrite(crc);
+    if (ok) ApplyConfig();
+  } else if (strcmp(args, " save") == 0) {
+    ok = configStore.Save();
+  } else if (strcmp(args, " defaults") == 0) {
+    configStore.RestoreDefaults();
+    ApplyConfig();
+  } else {
+    ok = false;
+  }
+  Log.println(ok ? "CFG OK" : "CFG ERR");
+}
+
+// Handles the registry commands. Returns false if the command is not one of them.
+bool HandleRegistryCommand(const char *command) {
+  char name[40];
+  char text[24];
+  unsigned int rate = 0;
+  if (strcmp(command, "ls") == 0) {
+    registry.List(Log, "*");
+  } else if (sscanf(command, "ls %39s", name) == 1) {
+    registry.List(Log, name);
+  } else if (sscanf(command, "get %39s", name) == 1) {
+    const int id = registry.Find(name);
+    if (id < 0) {
+      Log.println("REG ERR unknown name");
+      return true;
+    }
+    registry.PrintValue(Log, id);
+    Log.println();
+  } else if (sscanf(command, "set %39s %23s", name, text) == 2) {
+    const int id = registry.Find(name);
+    char *end = nullptr;
+    const double value = strtod(text, &end);
+    if (id < 0 || *end != '\0' || !registry.Set(id, value)) {
+      Log.println("REG ERR");
+      return true;
+    }
+    registry.PrintValue(Log, id);  // Echo the value as stored, after rounding and clamping
+    Log.println();
+  } else if (sscanf(command, "sub %39s %u", name, &rate) == 2) {
+    const int count = registry.Subscribe(name, rate);
+    Log.print(count > 0 ? "REG OK " : "REG ERR ");
+    Log.println(count);
+  } else if (strcmp(command, "unsub") == 0) {
+    Log.print("REG OK ");
+    Log.println(registry.Unsubscribe("*"));
+  } else if (sscanf(command, "unsub %39s", name) == 1) {
+    Log.print("REG OK ");
+    Log.println(registry.Unsubscribe(name));
   } else {
     return false;
   }
+  return true;
+}
+
+// Exposes tuning gains and live signals to the registry. Gains point into the active
+// configuration; live values go through getters so the drive timer's snapshots are respected.
+void RegisterValues() {
+  RobotConfig &cfg = configStore.Edit();
+  registry.Add("pid.x.kp", &cfg.xPID.kp, true, OnTuningSet);
+  registry.Add("pid.x.ki", &cfg.xPID.ki, true, OnTuningSet);
+  registry.Add("pid.x.kd", &cfg.xPID.kd, true, OnTuningSet);
+  registry.Add("pid.y.kp", &cfg.yPID.kp, true, OnTuningSet);
+  registry.Add("pid.y.ki", &cfg.yPID.ki, true, OnTuningSet);
+  registry.Add("pid.y.kd", &cfg.yPID.kd, true, OnTuningSet);
+  registry.Add("pid.theta.kp", &cfg.thetaPID.kp, true, OnTuningSet);
+  registry.Add("pid.theta.ki", &cfg.thetaPID.ki, true, OnTuningSet);
+  registry.Add("pid.theta.kd", &cfg.thetaPID.kd, true, OnTuningSet);
+  registry.Add("drive.wheelDiameter", &cfg.wheelDiameter, true, OnTuningSet);
+
+  registry.Add("drive.pose.x", [](uint8_t) { return drive.GetPosition().getX(); });
+  registry.Add("drive.pose.y", [](uint8_t) { return drive.GetPosition().getY(); });
+  registry.Add("drive.pose.theta", [](uint8_t) { return drive.GetPosition().getTheta(); });
+  registry.Add("drive.vel.x", [](uint8_t) { return drive.GetVelocity().getX(); });
+  registry.Add("drive.vel.y", [](uint8_t) { return drive.GetVelocity().getY(); });
+  registry.Add("drive.vel.theta", [](uint8_t) { return drive.GetVelocity().getTheta(); });
+  registry.Add("drive.mvel.x", [](uint8_t) { return drive.GetMeasuredVelocity().getX(); });
+  registry.Add("drive.mvel.y", [](uint8_t) { return drive.GetMeasuredVelocity().getY(); });
+  registry.Add("drive.mvel.theta", [](uint8_t) { return drive.GetMeasuredVelocity().getTheta(); });
+  registry.Add("drive.target.x", [](uint8_t) { return drive.GetTarget().getX(); });
+  registry.Add("drive.target.y", [](uint8_t) { return drive.GetTarget().getY(); });
+  registry.Add("drive.target.theta", [](uint8_t) { return drive.GetTarget().getTheta(); });
+  registry.Add("drive.sigma.xy", [](uint8_t) { return drive.GetEstimate().GetPositionSigma(); });
+  registry.Add("drive.sigma.theta", [](uint8_t) { return drive.GetEstimate().GetHeadingSigma(); });
+  static const char *encoderNames[DRIVEMOTOR_COUNT] = {"drive.enc[0]", "drive.enc[1]",
+                                                       "drive.enc[2]"};
+  static const char *motorNames[DRIVEMOTOR_COUNT] = {"drive.motor[0]", "drive.motor[1]",
+                                                     "drive.motor[2]"};
+  static const char *slipNames[DRIVEMOTOR_COUNT] = {"drive.slip[0]", "drive.slip[1]",
+                                                    "drive.slip[2]"};
+  static const char *wheelVelNames[DRIVEMOTOR_COUNT] = {"drive.wheelVel[0]", "drive.wheelVel[1]",
+                                                        "drive.wheelVel[2]"};
+  for (uint8_t i = 0; i < DRIVEMOTOR_COUNT; i++) {
+    registry.Add(encoderNames[i], [](uint8_t index) -> float { return drive.GetEnc()[index]; }, i);
+    registry.Add(
+        motorNames[i], [](uint8_t index) -> float { return drive.GetMotorSpeed(index); }, i);
+    registry.Add(slipNames[i], [](uint8_t index) { return drive.GetWheelSlip(index); }, i);
+    registry.Add(wheelVelNames[i], [](uint8_t index) { return drive.GetWheelVelocity(index); }, i);
+  }
+  registry.Add("drive.ticks", [](uint8_t) -> float { return driveLoop.GetTicks(); });
+  registry.Add("intake.speed", [](uint8_t) -> float { return intakeMotor.GetSpeed(); });
+  registry.Add("transfer.speed", [](uint8_t) -> float { return transferMotor.GetSpeed(); });
+
+  static const char *tofNames[TOF_COUNT] = {"tof[0].mm", "tof[1].mm", "tof[2].mm", "tof[3].mm",
+                                            "tof[4].mm"};
+  for (uint8_t i = 0; i < TOF_COUNT; i++) {
+    registry.Add(
+        tofNames[i], [](uint8_t index) -> float { return tofs.GetDistanceAtIndex(index); }, i);
+  }
+  registry.Add("loc.x", [](uint8_t) { return localizer.GetPose().getX(); });
+  registry.Add("loc.y", [](uint8_t) { return localizer.GetPose().getY(); });
+  registry.Add("loc.theta", [](uint8_t) { return localizer.GetPose().getTheta(); });
+  registry.Add("loc.spread", [](uint8_t) { return localizer.GetSpread(); });
+  registry.Add("loc.us", [](uint8_t) -> float { return localizer.GetLastCorrectUs(); });
+  registry.Add("start.x", [](uint8_t) { return startPose.GetPose().getX(); });
+  registry.Add("start.y", [](uint8_t) { return startPose.GetPose().getY(); });
+  registry.Add("start.theta", [](uint8_t) { return startPose.GetPose().getTheta(); });
+  registry.Add("start.conf", [](uint8_t) { return startPose.GetConfidence(); });
+  registry.Add("gyro.yaw", [](uint8_t) { return gyro.GetGyroData()[0]; });
+  registry.Add("gyro.yawRate", [](uint8_t) { return drive.GetYawRate(); });
+  registry.Add("gyro.driftRate", [](uint8_t) { return gyro.GetDriftRate(); });
+  registry.Add("gyro.yawCorrection", [](uint8_t) { return gyro.GetYawCorrection(); });
+  registry.Add("gyro.rateBias", [](uint8_t) { return gyro.GetRateBias(); });
+  registry.Add("gyro.stationary", [](uint8_t) -> float { return gyro.IsStationary(); });
+  registry.Add("state", [](uint8_t) -> float { return STATE; });
+  registry.Add("fps", [](uint8_t) -> float { return fps; });
+
+  // Each rejected value was reported by name; make the failure stand out in the boot log
+  if (registry.GetRejectedCount() > 0) {
+    LOG_ERROR("Registry rejected ", registry.GetRejectedCount(), " values, ",
+              registry.GetCount(), "/", REGISTRY_MAX_ENTRIES, " registered");
+  }
+}
+
+// Pushes a gain changed with "set" to the drive. The change stays unsaved until "cfg save".
+void OnTuningSet() {
+  configStore.MarkEdited();
+  ApplyDriveConfig();
+}
+
+// Pushes the drive part of the active configuration. Safe while the drive timer is running.
+void ApplyDriveConfig() {
+  const RobotConfig &cfg = configStore.Get();
+  noInterrupts();  // The drive timer may be stepping the PIDs
+  drive.Configure(cfg.xPID, cfg.yPID, cfg.thetaPID);
+  drive.SetWheelDiameter(cfg.wheelDiameter);
+  interrupts();
+}
+
+// Pushes the active configuration to the drive and subsystems.
+void ApplyConfig() {
+  const RobotConfig &cfg = configStore.Get();
+  ApplyDriveConfig();
+  sorter.Begin(cfg.sorter);
+  mandibles.Begin(cfg.mandibles);
+  beacon.Begin(cfg.beacon);
+}
+
+// Walls the localizer casts TOF ranges against: the field border and the cave's west wall, which
+// is open around CENTERY where the robot drives in.
+void BuildField() {
+  field.AddBox(0, 0, MAXX, MAXY);
+  field.AddWall(LEFTCAVEWALLX, 0, LEFTCAVEWALLX, CENTERY - CAVE_OPENING / 2);
+  field.AddWall(LEFTCAVEWALLX, CENTERY + CAVE_OPENING / 2, LEFTCAVEWALLX, MAXY);
+}
+
+void SendTelemetry() {
+  PROFILE_ZONE(profiler, ZONE_TELEMETRY);
+  int32_t fields[TELEMETRY_MAX_FIELDS];
+
+  const Pose2D pose = drive.GetPosition();
+  fields[0] = lroundf(pose.getX() * 100.0f);
+  fields[1] = lroundf(pose.getY() * 100.0f);
+  fields[2] = lroundf(pose.getTheta() * 1000.0f);
+  telemetry.Send(TELEMETRY_POSE, fields, 3);
+
+  const Pose2D velocity = drive.GetVelocity();
+  const Pose2D idealVelocity = drive.GetIdealVelocity();
+  fields[0] = lroundf(velocity.getX() * 100.0f);
+  fields[1] = lroundf(velocity.getY() * 100.0f);
+  fields[2] = lroundf(velocity.getTheta() * 1000.0f);
+  fields[3] = lroundf(idealVelocity.getX() * 100.0f);
+  fields[4] = lroundf(idealVelocity.getY() * 100.0f);
+  fields[5] = lroundf(idealVelocity.getTheta() * 1000.0f);
+  const Pose2D measuredVelocity = drive.GetMeasuredVelocity();
+  fields[6] = lroundf(measuredVelocity.getX() * 100.0f);
+  fields[7] = lroundf(measuredVelocity.getY() * 100.0f);
+  fields[8] = lroundf(measuredVelocity.getTheta() * 1000.0f);
+  telemetry.Send(TELEMETRY_VELOCITY, fields, 9);
+
+  const long *encoders = drive.GetEnc();
+  for (int i = 0; i < DRIVEMOTOR_COUNT; i++) {
+    fields[i] = encoders[i];
+  }
+  telemetry.Send(TELEMETRY_ENCODERS, fields, DRIVEMOTOR_COUNT);
+
+  for (int i = 0; i < DRIVEMOTOR_COUNT; i++) {
+    fields[i] = drive.GetMotorSpeed(i);
+  }
+  fields[DRIVEMOTOR_COUNT] = intakeMotor.GetSpeed();
+  fields[DRIVEMOTOR_COUNT + 1] = transferMotor.GetSpeed();
+  telemetry.Send(TELEMETRY_MOTOR, fields, DRIVEMOTOR_COUNT + 2);
+
+  static uint8_t slowCount = 0;
+  if (++slowCount < TELEMETRY_SLOW_DIVIDER) return;
+  slowCount = 0;
+
+  const int *distances = tofs.GetDistances();
+  for (int i = 0; i < TOF_COUNT; i++) {
+    fields[i] = distances[i];
+  }
+  telemetry.Send(TELEMETRY_TOF, fields, TOF_COUNT);
+
+  for (int i = 0; i < 10; i++) {
+    fields[i] = rc.Get(i);
+  }
+  telemetry.Send(TELEMETRY_RC, fields, 10);
+
+  const int *angles = servos.GetCurrentCommandedAngles();
+  for (int i = 0; i < SERVO_COUNT; i++) {
+    fields[i] = angles[i];
+  }
+  telemetry.Send(TELEMETRY_SERVO, fields, SERVO_COUNT);
+}
+
+void GlobalPrint() {
+  PROFILE_ZONE(profiler, ZONE_PRINT);
+  Log.print("State: ");
+  Log.println(STATE);
+  Log.print("Progam: ");
+  Log.println(ROBOT_CONTROL_TYPE);
+  Log.print("Path Selection: ");
+  Log.println(PROGRAM_SELECTION);
+  Log.print("FPS: ");
+  Log.println(fps);
+  Log << tofs << gyro << light << halls << buttons << rgb << servos << rc;
+  Log.print("ControllerPose: ");
+  Log << CalculateRCVector(true) << drive;
+  Log.print("SpeedPose: ");
+  Log << drive.GetVelocity();
+  Log.print("IdealSpeedPose: ");
+  Log << drive.GetIdealVelocity();
+  Log.print("MeasuredSpeedPose: ");
+  Log << drive.GetMeasuredVelocity();
+  Log.print("Transfer: ");
+  Log << transferMotor;
+  Log.print("Intake: ");
+  Log << intakeMotor;
+  Log << scheduler << mission;
+  if (STATE == RUNNING && ROBOT_CONTROL_TYPE == REMOTE_CON) {
+    drive.PrintController(Log, false);
+  }
 }
 
 bool GlobalStats() {
@@ -967,6 +1476,7 @@ bool GlobalStats() {
     fpsTimer = 0;
     lastCycles = cycles;
     fps = lastCycles;
+    TRACE_COUNTER(TRACE_TRACK_LOOP, "fps", fps);
     cycles = 0;
     return true;
   } else {
@@ -0,0 +1,174 @@
+#include "DriveLoop.h"
+
+DriveLoop *DriveLoop::active = nullptr;
+
+/**
+ * @brief Constructs a DriveLoop. The timer is not started until Begin().
+ * @param drive Drive to control.
+ */
+DriveLoop::DriveLoop(VectorRobotDrivePID &drive)
+    : drive(drive),
+      periodUs(0),
+      controlDivider(1),
+      controlPhase(0),
+      running(false),
+      ticks(0),
+      odometryTicks(0),
+      lastStartUs(0),
+      lastTickUs(0),
+      maxTickUs(0),
+      maxJitterUs(0),
+      overruns(0) {}
+
+/**
+ * @brief Starts calling the control step from the hardware timer.
+ *  The PID minimum time step is cleared so every control step produces a new command.
+ * @param rateHz Control rate, constrained to DRIVELOOP_MIN_RATE_HZ..DRIVELOOP_MAX_RATE_HZ.
+ * @param odometryRateHz Odometry rate, rounded to a whole multiple of the control rate and capped
+ * at DRIVELOOP_MAX_RATE_HZ. 0 runs odometry once per control step.
+ * @return False if no IntervalTimer was available. The caller should keep stepping the drive
+ * from loop() in that case.
+ */
+bool DriveLoop::Begin(uint32_t rateHz, uint32_t odometryRateHz) {
+  if (running) return true;
+  rateHz = constrain(rateHz, DRIVELOOP_MIN_RATE_HZ, DRIVELOOP_MAX_RATE_HZ);
+  odometryRateHz = constrain(odometryRateHz, rateHz, DRIVELOOP_MAX_RATE_HZ);
+  controlDivider = constrain((odometryRateHz + rateHz / 2) / rateHz, (uint32_t)1, (uint32_t)255);
+  controlPhase = 0;
+  periodUs = 1000000UL / (rateHz * controlDivider);
+  drive.SetMinTimeStep(0);
+  ResetStats();
+  active = this;
+  running = timer.begin(isr, periodUs);
+  if (!running) {
+    active = nullptr;
+  }
+  return running;
+}
+
+/**
+ * @brief Stops the timer. The drive keeps its last motor outputs.
+ */
+void DriveLoop::End() {
+  timer.end();
+  running = false;
+  active = nullptr;
+}
+
+/**
+ * @brief Clears the timing statistics.
+ */
+void DriveLoop::ResetStats() {
+  noInterrupts();
+  ticks = 0;
+  odometryTicks = 0;
+  lastTickUs = 0;
+  maxTickUs = 0;
+  maxJitterUs = 0;
+  overruns = 0;
+  interrupts();
+}
+
+/**
+ * @brief Timer interrupt entry point.
+ */
+void DriveLoop::isr() {
+  if (active) {
+    active->tick();
+  }
+}
+
+/**
+ * @brief Runs one odometry update, plus the PID step and motor output every controlDivider ticks.
+ */
+void DriveLoop::tick() {
+  const uint32_t start = micros();
+  if (odometryTicks > 0) {
+    const int32_t jitter = static_cast<int32_t>(start - lastStartUs - periodUs);
+    const uint32_t absJitter = jitter < 0 ? -jitter : jitter;
+    if (absJitter > maxJitterUs) maxJitterUs = absJitter;
+  }
+  lastStartUs = start;
+
+  float yawRate;
+  const float yaw = currentYaw(start, yawRate);
+  drive.ReadAll(yaw, yawRate);
+  odometryTicks++;
+  if (++controlPhase >= controlDivider) {
+    controlPhase = 0;
+    drive.Set(drive.Step());
+    drive.Write();
+    ticks++;
+  }
+
+  const uint32_t elapsed = micros() - start;
+  lastTickUs = elapsed;
+  if (elapsed > maxTickUs) maxTickUs = elapsed;
+  if (elapsed > periodUs) overruns++;
+}
+
+/**
+ * @brief Carries the latest published yaw forward to a time with its rate.
+ *  Extrapolation stops DRIVELOOP_MAX_YAW_EXTRAPOLATION_US after the sample, so a stalled gyro
+ * holds its last heading rather than spinning the odometry. The rate is passed on only while the
+ * sample is that fresh.
+ * @param nowUs Time to estimate the yaw at.
+ * @param rate Set to the yaw rate in rad/s, or NAN if unknown or stale.
+ * @return Yaw in radians, -PI to PI.
+ */
+float DriveLoop::currentYaw(uint32_t nowUs, float &rate) const {
+  const YawInput input = yawInput.Read();
+  const int32_t ageUs = static_cast<int32_t>(nowUs - input.timeUs);
+  const int32_t maxAgeUs = DRIVELOOP_MAX_YAW_EXTRAPOLATION_US;
+  rate = ageUs <= maxAgeUs ? input.rate : NAN;
+  if (isnan(input.rate)) return input.yaw;
+  const float dt = constrain(ageUs, (int32_t)0, maxAgeUs) * 1e-6f;
+  float yaw = input.yaw + input.rate * dt;
+  if (yaw > PI) yaw -= 2 * PI;
+  if (yaw < -PI) yaw += 2 * PI;
+  return yaw;
+}
+
+/**
+ * @brief Prints the loop configuration or its timing statistics.
+ * @param output Output stream for logging.
+ * @param printConfig If true, prints the rate; otherwise, prints step counts and timings.
+ */
+void DriveLoop::PrintInfo(Print &output, bool printConfig) const {
+  if (printConfig) {
+    output.print(F("DriveLoop Configuration: "));
+    if (periodUs > 0) {
+      output.print(1000000UL / (periodUs * controlDivider));
+      output.print(F(" Hz, odometry "));
+      output.print(1000000UL / periodUs);
+      output.print(F(" Hz"));
+    } else {
+      output.print(F("not started"));
+    }
+    output.println(running ? F(", running") : F(", stopped"));
+  } else {
+    output.print(F("DriveLoop: ticks "));
+    output.print(ticks);
+    output.print(F(", odometry "));
+    output.print(odometryTicks);
+    output.print(F(", last "));
+    output.print(lastTickUs);
+    output.print(F(" us, max "));
+    output.print(maxTickUs);
+    output.print(F(" us, jitter "));
+    output.print(maxJitterUs);
+    output.print(F(" us, overruns "));
+    output.println(overruns);
+  }
+}
+
+/**
+ * @brief Overloaded stream operator for printing loop statistics.
+ * @param output Output stream.
+ * @param loop DriveLoop instance.
+ * @return Modified output stream.
+ */
+Print &operator<<(Print &output, const DriveLoop &loop) {
+  loop.PrintInfo(output, false);
+  return output;
+}
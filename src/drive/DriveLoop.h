@@ -0,0 +1,88 @@
+/**
+ * @file DriveLoop.h
+ * @ingroup drives
+ * @brief Runs the drive control step from a hardware timer interrupt.
+ *
+ * Odometry, the PID step and the motor writes are moved out of loop() so they happen at a fixed
+ * rate no matter how long the rest of the loop takes.
+ *
+ * @author Aldem Pido
+ */
+
+#ifndef DRIVELOOP_H
+#define DRIVELOOP_H
+
+#include <Arduino.h>
+#include <IntervalTimer.h>
+#include <Print.h>
+
+#include "../util/DoubleBuffer.h"
+#include "VectorRobotDrivePID.h"
+
+#define DRIVELOOP_MIN_RATE_HZ 50                  ///< Slowest accepted control rate.
+#define DRIVELOOP_MAX_RATE_HZ 2000                ///< Fastest accepted control or odometry rate.
+#define DRIVELOOP_MAX_YAW_EXTRAPOLATION_US 20000  ///< Longest a yaw sample is extrapolated.
+
+/**
+ * @struct YawInput
+ * @ingroup drives
+ * @brief Gyro yaw published to the timer interrupt, with the rate to carry it forward.
+ */
+struct YawInput {
+  float yaw = 0;        ///< Yaw in radians.
+  float rate = NAN;     ///< Yaw rate in rad/s, NAN if unknown.
+  uint32_t timeUs = 0;  ///< micros() at which the yaw was measured.
+};
+
+/**
+ * @class DriveLoop
+ * @ingroup drives
+ * @brief Calls ReadAll(), Step(), Set() and Write() on a drive from an IntervalTimer.
+ *  Odometry can run faster than the control step: the timer fires at the odometry rate, calls
+ * ReadAll() every time and steps the controller every few ticks. Sensor inputs that need the I2C
+ * bus cannot be read inside the interrupt, so loop() publishes the latest gyro yaw with SetYaw().
+ * Given its rate and timestamp, the yaw is extrapolated to each tick, so odometry sees a smooth
+ * heading between gyro reports instead of steps. Targets and poses cross over through the drive's
+ * own double buffers, so SetTarget(), SetPosition() and GetPosition() keep working from loop().
+ * The velocity getters are not buffered and should only be used for diagnostics while the loop is
+ * running.
+ */
+class DriveLoop {
+ public:
+  DriveLoop(VectorRobotDrivePID &drive);
+
+  bool Begin(uint32_t rateHz, uint32_t odometryRateHz = 0);
+  void End();
+  void SetYaw(float yaw) { SetYaw(yaw, NAN, micros()); }
+  void SetYaw(float yaw, float rate, uint32_t timeUs) { yawInput.Write({yaw, rate, timeUs}); }
+  bool IsRunning() const { return running; }
+  uint32_t GetTicks() const { return ticks; }
+  uint32_t GetOdometryTicks() const { return odometryTicks; }
+  void ResetStats();
+
+  void PrintInfo(Print &output, bool printConfig = false) const;
+  friend Print &operator<<(Print &output, const DriveLoop &loop);
+
+ private:
+  static DriveLoop *active;  ///< Instance serviced by the timer interrupt.
+  static void isr();
+  void tick();
+  float currentYaw(uint32_t nowUs, float &rate) const;
+
+  VectorRobotDrivePID &drive;       ///< Drive being controlled.
+  IntervalTimer timer;              ///< Hardware timer that calls isr().
+  DoubleBuffer<YawInput> yawInput;  ///< Latest gyro yaw from loop().
+  uint32_t periodUs;                ///< Timer period, which is the odometry period.
+  uint8_t controlDivider;           ///< Timer ticks per control step.
+  uint8_t controlPhase;             ///< Timer ticks since the last control step.
+  volatile bool running;            ///< True while the timer is attached.
+  volatile uint32_t ticks;          ///< Control steps since Begin().
+  volatile uint32_t odometryTicks;  ///< Odometry updates since Begin().
+  volatile uint32_t lastStartUs;    ///< micros() at the start of the previous tick.
+  volatile uint32_t lastTickUs;     ///< Duration of the previous tick.
+  volatile uint32_t maxTickUs;      ///< Longest tick since ResetStats().
+  volatile uint32_t maxJitterUs;    ///< Largest deviation of the tick interval from periodUs.
+  volatile uint32_t overruns;       ///< Ticks that took longer than periodUs.
+};
+
+#endif  // DRIVELOOP_H
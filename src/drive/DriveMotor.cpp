@@ -19,7 +19,19 @@ int DriveMotor::encoderNum = 1;
  * @param output Output stream for logging.
  */
 DriveMotor::DriveMotor(const MotorSetup &motorSetup, Print &output)
-    : motorSetup(motorSetup), output(output), pwmout(0), cwout(true), enc(0), timeSinceReverse(0) {}
+    : motorSetup(motorSetup),
+      output(output),
+      speed(0),
+      pwmout(0),
+      cwout(true),
+      enc(0),
+      lastEnc(0),
+      lastEdgeUs(0),
+      windowEnc(0),
+      windowUs(0),
+      windowOpen(false),
+      velocity(0),
+      timeSinceReverse(0) {}
 
 /**
  * @brief Initializes the motor and encoder.
@@ -56,6 +68,7 @@ void DriveMotor::Begin() {
  * @param speed Speed value ranging from -255 to 255.
  */
 void DriveMotor::Set(int speed) {
+  this->speed = speed;
   speed = motorSetup.rev ? -speed : speed;
   pwmout = map(abs(speed), 0, SPEED_MAX, PWM_MAX, 0);
   constrain(pwmout, 0, 255);
@@ -63,7 +76,7 @@ void DriveMotor::Set(int speed) {
 }
 
 /**
- * @brief Reads encoder values and updates internal state.
+ * @brief Reads encoder values and updates internal state, including the measured velocity.
  */
 void DriveMotor::ReadEnc() {
   if (encoder) {
@@ -71,6 +84,52 @@ void DriveMotor::ReadEnc() {
     if (!motorSetup.rev) {
       enc = -enc;
     }
+    updateVelocity(micros());
+  }
+}
+
+/**
+ * @brief Zeroes the encoder count and restarts the velocity measurement.
+ */
+void DriveMotor::ResetEnc() {
+  if (encoder) {
+    encoder->write(0);
+  }
+  enc = 0;
+  lastEnc = 0;
+  windowOpen = false;
+  velocity = 0;
+}
+
+/**
+ * @brief Updates the measured velocity from the latest encoder reading.
+ *  The i.MX RT encoder block has no edge time capture, so an edge is timed by the first reading
+ * that sees it. Both ends of a window are timed the same way, so the error is at most one
+ * reading period over a window of ENC_VELOCITY_WINDOW_US or more. The first edge seen, and the
+ * first after a stop, only open a window, so the count at boot is never taken for motion.
+ * @param now micros() of the reading.
+ */
+void DriveMotor::updateVelocity(uint32_t now) {
+  if (enc != lastEnc) {
+    lastEnc = enc;
+    lastEdgeUs = now;
+    if (!windowOpen) {
+      windowOpen = true;
+      windowEnc = enc;
+      windowUs = now;
+    } else if (now - windowUs >= ENC_VELOCITY_WINDOW_US) {
+      velocity = (enc - windowEnc) * 1e6f / (now - windowUs);
+      windowEnc = enc;
+      windowUs = now;
+    }
+  }
+  const uint32_t sinceEdge = now - lastEdgeUs;
+  if (sinceEdge >= ENC_VELOCITY_TIMEOUT_US) {
+    velocity = 0;
+    windowOpen = false;  // Stopped; the next edge starts afresh
+  } else if (fabsf(velocity) * sinceEdge > 1e6f) {
+    // No edge for longer than one tick should take at this velocity
+    velocity = (velocity > 0 ? 1e6f : -1e6f) / sinceEdge;
   }
 }
 
@@ -126,7 +185,10 @@ void DriveMotor::PrintInfo(Print &output, bool printConfig) const {
     output.print(F(", CW Output: "));
     output.print(cwout ? F("True") : F("False"));
     output.print(F(", Encoder: "));
-    output.println(enc);
+    output.print(enc);
+    output.print(F(", Velocity: "));
+    output.print(velocity);
+    output.println(F(" ticks/s"));
   }
 }
 
@@ -21,6 +21,9 @@
 #define SPEED_MAX 255  ///< Maximum speed value
 #define PWM_MAX 255    ///< Maximum PWM value
 
+#define ENC_VELOCITY_WINDOW_US 10000    ///< Shortest span a wheel velocity is measured over
+#define ENC_VELOCITY_TIMEOUT_US 500000  ///< Time without an edge after which the wheel is stopped
+
 /**
  * @struct MotorSetup
  * @brief Motor configuration settings.
@@ -36,6 +39,14 @@ struct MotorSetup {
 /**
  * @class DriveMotor
  * @brief Controls a motor using PWM and encoder feedback.
+ *  ReadEnc() also measures the wheel velocity from the times the count changes. Each estimate
+ * spans whole edges, from the first change after the previous estimate to the first change at
+ * least ENC_VELOCITY_WINDOW_US later. A slow wheel is timed across a single edge, while a fast
+ * one counts many edges in the window. Between edges the velocity is capped at one tick over the
+ * time since the last edge, so it falls toward zero as a wheel stops. The first edge seen, and
+ * the first after a stop or ResetEnc(), only opens a window, so no estimate spans a count or time
+ * from before it. The edges are timestamped by the ReadEnc() calls, so call it often; a DriveLoop
+ * does so at its odometry rate.
  */
 class DriveMotor {
  public:
@@ -45,7 +56,10 @@ class DriveMotor {
   void Begin();
   void Set(int speed);
   void ReadEnc();
+  void ResetEnc();
   long GetEnc() const;
+  float GetVelocity() const { return velocity; }  ///< Measured ticks per second.
+  int GetSpeed() const { return speed; }  ///< Last commanded speed (-255 to 255).
   void Write();
   void PrintInfo(Print &output, bool printConfig = false) const;
 
@@ -54,12 +68,21 @@ class DriveMotor {
  private:
   MotorSetup motorSetup;                 ///< Motor configuration settings
   Print &output;                         ///< Output stream for logging
+  int speed;                             ///< Last commanded speed
   int pwmout;                            ///< PWM output value
   bool cwout;                            ///< Motor direction flag
   long enc;                              ///< Encoder value
+  long lastEnc;                          ///< Encoder value at the previous ReadEnc()
+  uint32_t lastEdgeUs;                   ///< micros() at which the count last changed
+  long windowEnc;                        ///< Encoder value at the start of the velocity window
+  uint32_t windowUs;                     ///< micros() at the start of the velocity window
+  bool windowOpen;                       ///< False until an edge starts a velocity window
+  float velocity;                        ///< Measured velocity in ticks per second
   elapsedMicros timeSinceReverse;        ///< Time tracking for motor reversal
   std::unique_ptr<QuadEncoder> encoder;  ///< Encoder instance
   static int encoderNum;                 ///< Static variable to track encoder numbers
+
+  void updateVelocity(uint32_t now);
 };
 
 #endif
@@ -7,41 +7,209 @@
 /**
  * @brief Constructs a LocalizationEncoder object.
  */
-LocalizationEncoder::LocalizationEncoder() : transform(0, 0, 0) {
-  setPosition(Pose2D(STARTX, STARTY, 0));
+LocalizationEncoder::LocalizationEncoder() : transform(STARTX, STARTY, 0) {
+  OdometryWheel defaults[3];
+  defaults[0].y = WHEEL_OFFSET_Y + TRACK_WIDTH * 0.5f;  // Left
+  defaults[1].x = -BACK_OFFSET_F;                      // Back
+  defaults[1].angle = PI * 0.5f;
+  defaults[2].y = WHEEL_OFFSET_Y - TRACK_WIDTH * 0.5f;  // Right
+  setWheels(defaults, 3);
+}
+
+/**
+ * @brief Sets the tracking wheel geometry and clears the slip metrics.
+ *  A wheel rolling in direction a at (x, y) travels cos(a) per inch forward, sin(a) per inch left
+ * and x sin(a) - y cos(a) per radian turned. The wheels together with the gyro must pin down all
+ * three, e.g. two parallel wheels and one across them. Call before the first updatePosition() so
+ * the count history matches the wheels.
+ * @param wheels Mounting pose of each wheel; wheel i reads encoderCounts[i] in updatePosition().
+ * @param numWheels Number of wheels, up to ODOM_MAX_WHEELS.
+ * @return False, keeping the old geometry, if there are too many wheels or they cannot pin down
+ * the forward and left travel.
+ */
+bool LocalizationEncoder::setWheels(const OdometryWheel wheels[], int numWheels) {
+  if (numWheels < 1 || numWheels > ODOM_MAX_WHEELS) {
+    return false;
+  }
+  float newRows[ODOM_MAX_WHEELS][3];
+  float xx = 0, xy = 0, yy = 0;  // Forward and left rows of the normal matrix
+  for (int i = 0; i < numWheels; i++) {
+    const float c = cosf(wheels[i].angle);
+    const float s = sinf(wheels[i].angle);
+    newRows[i][0] = c;
+    newRows[i][1] = s;
+    newRows[i][2] = wheels[i].x * s - wheels[i].y * c;
+    xx += c * c;
+    xy += c * s;
+    yy += s * s;
+  }
+  if (xx * yy - xy * xy < 1e-3f) {
+    return false;  // All wheels roll the same way
+  }
+  for (int i = 0; i < numWheels; i++) {
+    this->wheels[i] = wheels[i];
+    memcpy(rows[i], newRows[i], sizeof(rows[i]));
+    slip[i] = 0;
+    slipping[i] = false;
+    slipEvents[i] = 0;
+  }
+  this->numWheels = numWheels;
+  return true;
 }
 
 /**
  * @brief Updates the robot's position based on encoder counts and yaw angle.
- * @param encoderCounts Array containing encoder counts {left, back, right}.
- * @param yaw Gyro yaw reading (in radians).
+ *  The wheel travel and yaw change are solved for the chassis twist (see solve()), and the
+ * residuals update the slip metrics. If that flags or clears a wheel, the twist is solved again
+ * with the new weights. The step is then integrated as an arc: the chassis is assumed to move
+ * with a constant body-frame velocity and turn rate over the step (the SE(2) exponential map),
+ * starting from the current heading. This is exact for any step along a circle, so the result
+ * does not depend on how often it is called. The first call only records the readings and, unless
+ * setPosition() has placed the robot, turns the start heading by the gyro yaw.
+ * @param encoderCounts Encoder count of each wheel, in the order given to setWheels().
+ * @param yaw Gyro yaw reading (in radians), or NAN to use the wheels alone.
  */
-void LocalizationEncoder::updatePosition(const long encoderCounts[3], float yaw) {
-  const long leftChangeTicks = encoderCounts[0] - previousLeftTicks;
-  const long backChangeTicks = encoderCounts[1] - previousBackTicks;
-  const long rightChangeTicks = encoderCounts[2] - previousRightTicks;
-  const float yawChange = yaw - previousYaw;
+void LocalizationEncoder::updatePosition(const long encoderCounts[], float yaw) {
+  for (int i = 0; i < numWheels; i++) {
+    travel[i] = started ? (encoderCounts[i] - previousTicks[i]) * inchesPerTick : 0;
+    previousTicks[i] = encoderCounts[i];
+  }
+  float yawChange = NAN;
+  if (!isnan(yaw)) {
+    yawChange = yaw - previousYaw;
+    if (yawChange > PI) yawChange -= 2 * PI;
+    if (yawChange < -PI) yawChange += 2 * PI;
+    previousYaw = yaw;
+  }
+  step = Pose2D();
+  if (!started) {
+    started = true;
+    if (!isnan(yawChange) && !placed) transform.add(Pose2D(0, 0, yawChange)).fixTheta();
+    return;
+  }
 
-  previousLeftTicks = encoderCounts[0];
-  previousBackTicks = encoderCounts[1];
-  previousRightTicks = encoderCounts[2];
-  previousYaw = yaw;
+  float twist[3];
+  if (!solve(travel, yawChange, twist)) {
+    if (!isnan(yawChange)) {
+      step = Pose2D(0, 0, yawChange);
+      transform.add(step).fixTheta();
+    }
+    return;
+  }
+  bool changed = false;
+  for (int pass = 0; pass < 2; pass++) {
+    if (pass == 1) {
+      if (!changed) break;
+      solve(travel, yawChange, twist);
+    }
+    for (int i = 0; i < numWheels; i++) {
+      const float residual =
+          travel[i] - (rows[i][0] * twist[0] + rows[i][1] * twist[1] + rows[i][2] * twist[2]);
+      if (pass == 0) {
+        const float keep = max(0.0f, 1 - fabsf(travel[i]) / ODOM_SLIP_DISTANCE);
+        slip[i] = slip[i] * keep + residual;
+      }
+      const float limit = slipping[i] ? ODOM_SLIP_LIMIT * 0.5f : ODOM_SLIP_LIMIT;
+      const bool flagged = fabsf(slip[i]) > limit;
+      if (flagged != slipping[i]) {
+        slipping[i] = flagged;
+        if (flagged) slipEvents[i]++;
+        changed = true;
+      }
+    }
+  }
 
-  const float leftDistance = leftChangeTicks * IN_PER_TICK;
-  const float backDistance = backChangeTicks * IN_PER_TICK;
-  const float rightDistance = rightChangeTicks * IN_PER_TICK;
+  // Chassis travel in the robot frame at the start of the step
+  const float forward = twist[0];
+  const float lateral = twist[1];
+  yawChange = twist[2];
 
-  const float cosTheta = cosf(yaw);
-  const float sinTheta = sinf(yaw);
+  // sin(a)/a and (1 - cos(a))/a, by series near zero where they are 0/0
+  float arcSin, arcCos;
+  if (fabsf(yawChange) < 1e-3f) {
+    arcSin = 1 - yawChange * yawChange / 6;
+    arcCos = yawChange * 0.5f;
+  } else {
+    arcSin = sinf(yawChange) / yawChange;
+    arcCos = (1 - cosf(yawChange)) / yawChange;
+  }
+  const float arcX = arcSin * forward - arcCos * lateral;
+  const float arcY = arcCos * forward + arcSin * lateral;
+  step = Pose2D(arcX, arcY, yawChange);
 
-  const float deltaX =
-      ((leftDistance + rightDistance) * 0.5f * cosTheta) - (backDistance * sinTheta);
+  const float cosTheta = cosf(transform.getTheta());
+  const float sinTheta = sinf(transform.getTheta());
+  const float deltaX = arcX * cosTheta - arcY * sinTheta;
+  const float deltaY = arcX * sinTheta + arcY * cosTheta;
 
-  const float deltaY =
-      ((leftDistance + rightDistance) * 0.5f * sinTheta) + (backDistance * cosTheta);
+  transform.add(Pose2D(deltaX, deltaY, yawChange)).fixTheta();
+}
 
-  const float deltaTheta = yawChange;
-  transform.add(Pose2D(deltaX, deltaY, deltaTheta)).fixTheta();
+/**
+ * @brief Converts wheel rates to the chassis velocity, weighting the wheels as the odometry does.
+ * @param tickRates Rate of each wheel in ticks per second, in the order given to setWheels().
+ * @param velocity Set to the forward and left velocity (in/s) and turn rate (rad/s).
+ * @return False, leaving velocity alone, if the wheels cannot pin down all three.
+ */
+bool LocalizationEncoder::getVelocity(const float tickRates[], Pose2D &velocity) const {
+  float rates[ODOM_MAX_WHEELS];
+  for (int i = 0; i < numWheels; i++) {
+    rates[i] = tickRates[i] * inchesPerTick;
+  }
+  float twist[3];
+  if (!solve(rates, NAN, twist)) return false;
+  velocity = Pose2D(twist[0], twist[1], twist[2]);
+  return true;
+}
+
+/**
+ * @brief Solves for the chassis twist that best fits the given wheel travel and yaw change.
+ *  Weighted least squares over one row per wheel and one for the gyro: the 3x3 normal equations
+ * are solved by Cramer's rule. Wheels are weighted by ODOM_WHEEL_SIGMA, cut by ODOM_SLIP_WEIGHT
+ * while flagged, and the gyro by ODOM_GYRO_SIGMA, so the heading follows the gyro closely.
+ * @param measured Travel of each wheel in inches, or its rate for a twist per second.
+ * @param yawChange Gyro yaw change in radians, or NAN to leave it out.
+ * @param twist Set to the forward and left travel in inches and the turn in radians, or their
+ * rates.
+ * @return False if the measurements cannot pin down all three, e.g. no gyro and no wheel pair.
+ */
+bool LocalizationEncoder::solve(const float measured[], float yawChange, float twist[3]) const {
+  float n[3][3] = {};  // Normal matrix, sum of w a a^T
+  float b[3] = {};     // Sum of w a m
+  for (int i = 0; i < numWheels; i++) {
+    const float weight =
+        (slipping[i] ? ODOM_SLIP_WEIGHT : 1.0f) / (ODOM_WHEEL_SIGMA * ODOM_WHEEL_SIGMA);
+    for (int r = 0; r < 3; r++) {
+      for (int c = r; c < 3; c++) {
+        n[r][c] += weight * rows[i][r] * rows[i][c];
+      }
+      b[r] += weight * rows[i][r] * measured[i];
+    }
+  }
+  if (!isnan(yawChange)) {
+    const float weight = 1.0f / (ODOM_GYRO_SIGMA * ODOM_GYRO_SIGMA);
+    n[2][2] += weight;
+    b[2] += weight * yawChange;
+  }
+  n[1][0] = n[0][1];
+  n[2][0] = n[0][2];
+  n[2][1] = n[1][2];
+
+  const float c00 = n[1][1] * n[2][2] - n[1][2] * n[2][1];
+  const float c01 = n[1][2] * n[2][0] - n[1][0] * n[2][2];
+  const float c02 = n[1][0] * n[2][1] - n[1][1] * n[2][0];
+  const float det = n[0][0] * c00 + n[0][1] * c01 + n[0][2] * c02;
+  if (!(fabsf(det) > 1e-6f * n[0][0] * n[1][1] * n[2][2])) {
+    return false;
+  }
+  const float c11 = n[0][0] * n[2][2] - n[0][2] * n[2][0];
+  const float c12 = n[0][2] * n[1][0] - n[0][0] * n[1][2];
+  const float c22 = n[0][0] * n[1][1] - n[0][1] * n[1][0];
+  // The inverse of a symmetric matrix is its cofactor matrix over the determinant
+  twist[0] = (c00 * b[0] + c01 * b[1] + c02 * b[2]) / det;
+  twist[1] = (c01 * b[0] + c11 * b[1] + c12 * b[2]) / det;
+  twist[2] = (c02 * b[0] + c12 * b[1] + c22 * b[2]) / det;
+  return true;
 }
 
 /**
@@ -52,9 +220,14 @@ Pose2D LocalizationEncoder::getPosition() const { return transform; }
 
 /**
  * @brief Manually sets the robot's position.
+ *  Before the first updatePosition(), the heading given here is kept rather than turned by the
+ * gyro yaw that call reads.
  * @param transform New position and orientation.
  */
-void LocalizationEncoder::setPosition(const Pose2D &transform) { this->transform = transform; }
+void LocalizationEncoder::setPosition(const Pose2D &transform) {
+  this->transform = transform;
+  placed = true;
+}
 
 /**
  * @brief Prints localization information.
@@ -64,6 +237,21 @@ void LocalizationEncoder::PrintInfo(Print &output) const {
   output.println(F("Localization Encoder Information:"));
   output.print(F("Location "));
   output << transform;
+  for (int i = 0; i < numWheels; i++) {
+    output.print(F("Wheel "));
+    output.print(i);
+    output.print(F(" ("));
+    output.print(wheels[i].x);
+    output.print(F(", "));
+    output.print(wheels[i].y);
+    output.print(F(", "));
+    output.print(wheels[i].angle);
+    output.print(F("): slip "));
+    output.print(slip[i]);
+    output.print(F(" in, events "));
+    output.print(slipEvents[i]);
+    output.println(slipping[i] ? F(", SLIPPING") : F(""));
+  }
 }
 
 /**
@@ -2,8 +2,11 @@
  * @file LocalizationEncoder.h
  * @brief Tracks the robot's position using encoder counts and a gyro yaw reading.
  *
- * Maintains the robot's position by processing encoder data from three wheels
- * along with yaw readings from a gyroscope.
+ * Maintains the robot's position by fusing the travel of any number of tracking wheels with
+ * yaw readings from a gyroscope. Each wheel is described by where it sits and which way it rolls
+ * (see OdometryWheel); the default set is the robot's left, back and right drive wheels, whose
+ * midline sits WHEEL_OFFSET_Y to the left of the turning center with the back wheel
+ * BACK_OFFSET_F behind it. Use negative offsets for the other side.
  *
  * @author Aldem Pido
  */
@@ -19,23 +22,83 @@
 #define STARTX 30.5  ///< Initial X position
 #define STARTY 6     ///< Initial Y position
 
+#define ODOM_MAX_WHEELS 6        ///< Tracking wheels that can be fused.
+#define ODOM_WHEEL_SIGMA 0.1f    ///< Wheel travel error (in) per update, about one tick.
+#define ODOM_GYRO_SIGMA 0.002f   ///< Gyro yaw change error (rad) per update.
+#define ODOM_SLIP_DISTANCE 6.0f  ///< Wheel travel (in) over which its slip residual decays.
+#define ODOM_SLIP_LIMIT 0.5f     ///< Slip residual (in) at which a wheel is flagged as slipping.
+#define ODOM_SLIP_WEIGHT 0.01f   ///< Weight multiplier for a wheel flagged as slipping.
+
 using namespace MotorConstants;
 
+/**
+ * @struct OdometryWheel
+ * @brief Where a tracking wheel sits on the robot: x forward, y left, in inches from the turning
+ * center, and the direction it rolls forward, in radians from the robot's forward.
+ */
+struct OdometryWheel {
+  float x = 0;      ///< Forward offset from the turning center.
+  float y = 0;      ///< Left offset from the turning center.
+  float angle = 0;  ///< Rolling direction; PI / 2 for a wheel that tracks leftward travel.
+};
+
+/**
+ * @class LocalizationEncoder
+ * @brief Integrates the chassis motion measured by the tracking wheels and the gyro.
+ *  Each update solves for the chassis twist (forward, left and turn) that best explains every
+ * wheel's travel and the gyro's yaw change in a weighted least-squares sense, then integrates it
+ * as an exact arc. Wheel i reads encoderCounts[i]. A yaw of NAN leaves the gyro out, so the
+ * heading comes from the wheels alone.
+ *
+ *  Each wheel's residual, the travel the solution does not explain, is summed with a decay over
+ * ODOM_SLIP_DISTANCE of that wheel's travel, so the sum is a share of recent travel whatever the
+ * update rate. Counting noise cancels out of the sum while slip builds up, so a wheel whose sum
+ * passes ODOM_SLIP_LIMIT is flagged and its weight cut to ODOM_SLIP_WEIGHT until the sum decays
+ * below half of that. Slip can only be pinned to one wheel when the others over-determine the
+ * motion. With the default three wheels and the gyro, slip on the left or right wheel splits
+ * between the two until one is flagged, which is not always the one slipping; without the gyro
+ * nothing is redundant and no slip is seen.
+ *
+ *  getVelocity() puts wheel rates through the same solve, without the gyro, for the chassis
+ * velocity the wheels measure.
+ */
 class LocalizationEncoder {
  public:
   LocalizationEncoder();
-  void updatePosition(const long encoderCounts[3], float yaw);
+  bool setWheels(const OdometryWheel wheels[], int numWheels);
+  void updatePosition(const long encoderCounts[], float yaw);
+  bool getVelocity(const float tickRates[], Pose2D &velocity) const;
   Pose2D getPosition() const;
   void setPosition(const Pose2D &transform);
+  void setInchesPerTick(float inchesPerTick) { this->inchesPerTick = inchesPerTick; }
+  int getWheelCount() const { return numWheels; }
+  const float *getRow(int index) const { return rows[index]; }
+  float getTravel(int index) const { return travel[index]; }
+  Pose2D getStep() const { return step; }
+  float getSlip(int index) const { return slip[index]; }
+  bool isSlipping(int index) const { return slipping[index]; }
+  uint32_t getSlipEvents(int index) const { return slipEvents[index]; }
   void PrintInfo(Print &output) const;
   friend Print &operator<<(Print &output, const LocalizationEncoder &transform);
 
  private:
   Pose2D transform;
-  long previousLeftTicks = 0;
-  long previousBackTicks = 0;
-  long previousRightTicks = 0;
+  OdometryWheel wheels[ODOM_MAX_WHEELS];  ///< Wheel mounting poses
+  float rows[ODOM_MAX_WHEELS][3];         ///< Travel of each wheel per unit forward, left and turn
+  int numWheels = 0;                      ///< Number of wheels in use
+  long previousTicks[ODOM_MAX_WHEELS] = {};
+  float travel[ODOM_MAX_WHEELS] = {};  ///< Travel of each wheel in the last update, in inches
   float previousYaw = 0;
+  bool started = false;  ///< Set by the first updatePosition(), which only records readings
+  bool placed = false;   ///< Set by setPosition(); the first update then keeps the heading
+  Pose2D step;           ///< Chord and turn of the last update, in the robot frame at its start
+  float inchesPerTick = IN_PER_TICK;
+
+  float slip[ODOM_MAX_WHEELS] = {};           ///< Decaying sum of each wheel's residual, in inches
+  bool slipping[ODOM_MAX_WHEELS] = {};        ///< Wheels currently down-weighted
+  uint32_t slipEvents[ODOM_MAX_WHEELS] = {};  ///< Times each wheel has been flagged
+
+  bool solve(const float measured[], float yawChange, float twist[3]) const;
 };
 
 #endif
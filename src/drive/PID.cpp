@@ -41,6 +41,22 @@ PID::PID(const PIDConfig &config)
       thetaFix(config.thetaFix),
       timer(0) {}
 
+/**
+ * @brief Replaces the gains and limits, keeping the integral and previous outputs.
+ * @param config PIDConfig struct containing all gain values.
+ */
+void PID::Configure(const PIDConfig &config) {
+  kp = config.kp;
+  ki = config.ki;
+  kd = config.kd;
+  kaw = config.kaw;
+  timeConst = config.timeConst;
+  max = config.max;
+  min = config.min;
+  maxRate = config.maxRate;
+  thetaFix = config.thetaFix;
+}
+
 /**
  * @brief Performs a PID step and calculates an output correction.
  * @param measurement The current measured value.
@@ -50,33 +66,75 @@ PID::PID(const PIDConfig &config)
 double PID::Step(double measurement, double setpoint) {
   if (timer > timeStepMinSeconds * 1000.0f) {
     double timeStep = timer / 1000000.0f;
+    double error = wrapError(setpoint - measurement);
+    double deriv_filter = (error - prevError + timeConst * derivPrev) / (timeStep + timeConst);
+    update(error, deriv_filter, timeStep);
+  }
+  return satCommand;
+}
 
-    double error = setpoint - measurement;
-    if (thetaFix) {
-      if (error < -PI)
-        error += 2 * PI;
-      else if (error > PI)
-        error -= 2 * PI;
+/**
+ * @brief Performs a PID step using a measured rate for the derivative term.
+ *  The derivative is the setpoint rate minus measurementRate instead of a filtered difference
+ * of the error, so a clean rate sensor such as a gyro removes the noise and filter lag of
+ * differencing. The setpoint rate is still differenced, which is smooth for planned targets.
+ * @param measurement The current measured value.
+ * @param setpoint The desired target value.
+ * @param measurementRate The measured rate of change of measurement, per second.
+ * @return The computed correction value.
+ */
+double PID::Step(double measurement, double setpoint, double measurementRate) {
+  if (timer > timeStepMinSeconds * 1000.0f) {
+    double timeStep = timer / 1000000.0f;
+    double error = wrapError(setpoint - measurement);
+    double setpointRate = 0;
+    if (hasPrevSetpoint) {
+      setpointRate = wrapError(setpoint - prevSetpoint) / timeStep;
     }
+    prevSetpoint = setpoint;
+    hasPrevSetpoint = true;
+    update(error, setpointRate - measurementRate, timeStep);
+  }
+  return satCommand;
+}
 
-    integral += (ki * error + kaw * (prevSatCommand - prevCommand)) * timeStep;
-    double deriv_filter = (error - prevError + timeConst * derivPrev) / (timeStep + timeConst);
-    double command = kp * error + integral + kd * deriv_filter;
+/**
+ * @brief Wraps an angular error into -PI to PI when thetaFix is enabled.
+ * @param error Raw error.
+ * @return The error, wrapped if needed.
+ */
+double PID::wrapError(double error) const {
+  if (thetaFix) {
+    if (error < -PI)
+      error += 2 * PI;
+    else if (error > PI)
+      error -= 2 * PI;
+  }
+  return error;
+}
 
-    prevCommand = command;
-    satCommand = constrain(command, min, max);
+/**
+ * @brief Applies the gains, output limits and rate limit, and restarts the step timer.
+ * @param error Error for this step.
+ * @param derivative Derivative term input for this step.
+ * @param timeStep Seconds since the previous step.
+ */
+void PID::update(double error, double derivative, double timeStep) {
+  integral += (ki * error + kaw * (prevSatCommand - prevCommand)) * timeStep;
+  double command = kp * error + integral + kd * derivative;
 
-    float maxStep = maxRate * timeStep;
-    satCommand = constrain(satCommand, prevSatCommand - maxStep, prevSatCommand + maxStep);
-    if (abs(satCommand) - abs(prevSatCommand) < 0) {
-      float deltaCommand = satCommand - prevSatCommand;
-      satCommand += deltaCommand * 2;
-    }
+  prevCommand = command;
+  satCommand = constrain(command, min, max);
 
-    prevSatCommand = satCommand;
-    timer = 0;
+  float maxStep = maxRate * timeStep;
+  satCommand = constrain(satCommand, prevSatCommand - maxStep, prevSatCommand + maxStep);
+  if (abs(satCommand) - abs(prevSatCommand) < 0) {
+    float deltaCommand = satCommand - prevSatCommand;
+    satCommand += deltaCommand * 2;
   }
-  return satCommand;
+
+  prevSatCommand = satCommand;
+  timer = 0;
 }
 
 /**
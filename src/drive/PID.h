@@ -40,7 +40,10 @@ class PID {
                double min, double maxRate, bool thetaFix);
   explicit PID(const PIDConfig &config);
 
+  void Configure(const PIDConfig &config);
   double Step(double measurement, double setpoint);
+  double Step(double measurement, double setpoint, double measurementRate);
+  void SetMinTimeStep(double seconds) { timeStepMinSeconds = seconds; }
   void PrintInfo(Print &output, bool printConfig) const;
 
   friend Print &operator<<(Print &output, const PID &pid);
@@ -50,9 +53,14 @@ class PID {
   bool thetaFix;                                         ///< Corrects angular values (if needed)
   double integral = 0, prevError = 0, derivPrev = 0;
   double prevSatCommand = 0, prevCommand = 0, satCommand = 0;
+  double prevSetpoint = 0;       ///< Setpoint of the previous measured-rate step
+  bool hasPrevSetpoint = false;  ///< Whether prevSetpoint is valid
   double timeStepMinSeconds = 0.005;
   elapsedMicros timer;
   bool saturated = false;
+
+  double wrapError(double error) const;
+  void update(double error, double derivative, double timeStep);
 };
 
 #endif
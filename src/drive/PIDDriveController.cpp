@@ -20,16 +20,63 @@ Pose2D PIDDriveController::Step(const Pose2D &currentPose, const Pose2D &targetP
   float xSpeed = xPID.Step(currentPose.getX(), targetPose.getX());
   float ySpeed = yPID.Step(currentPose.getY(), targetPose.getY());
   float thetaSpeed = thetaPID.Step(currentPose.getTheta(), targetPose.getTheta());
+  return toRobotFrame(Pose2D(xSpeed, ySpeed, thetaSpeed), currentPose.getTheta());
+}
+
+/**
+ * @brief Calculates movement correction, using a measured yaw rate for the heading derivative.
+ * @param currentPose Current position of the robot.
+ * @param targetPose Desired target position.
+ * @param yawRate Measured angular velocity in radians per second, e.g. from the gyro.
+ * @return Pose2D containing computed movement corrections.
+ */
+Pose2D PIDDriveController::Step(const Pose2D &currentPose, const Pose2D &targetPose,
+                                float yawRate) {
+  float xSpeed = xPID.Step(currentPose.getX(), targetPose.getX());
+  float ySpeed = yPID.Step(currentPose.getY(), targetPose.getY());
+  float thetaSpeed = thetaPID.Step(currentPose.getTheta(), targetPose.getTheta(), yawRate);
+  return toRobotFrame(Pose2D(xSpeed, ySpeed, thetaSpeed), currentPose.getTheta());
+}
 
-  Pose2D speedPose = Pose2D(xSpeed, ySpeed, thetaSpeed)
-                         .constrainXyMag(MAX_VELOCITY)
-                         .constrainTheta(MAX_ANGULAR_VELOCITY);
+/**
+ * @brief Limits a field-frame speed command and rotates it into the robot frame.
+ * @param speedPose Field-frame speeds from the PID controllers.
+ * @param theta Current robot heading in radians.
+ * @return Robot-frame speed command.
+ */
+Pose2D PIDDriveController::toRobotFrame(Pose2D speedPose, float theta) {
+  speedPose.constrainXyMag(MAX_VELOCITY).constrainTheta(MAX_ANGULAR_VELOCITY);
 
-  Pose2D angleOffsetPose = Pose2D(0, 0, -currentPose.getTheta()).fixTheta();
+  Pose2D angleOffsetPose = Pose2D(0, 0, -theta).fixTheta();
   Pose2D rotatedSpeedPose = speedPose.rotateVector(angleOffsetPose.getTheta());
   return rotatedSpeedPose;
 }
 
+/**
+ * @brief Sets the minimum time between updates for all three PID controllers.
+ *  Calls to Step() that arrive sooner return the previous command unchanged. Set this to 0 when
+ * the caller already runs at a fixed rate.
+ * @param seconds Minimum time step in seconds.
+ */
+void PIDDriveController::SetMinTimeStep(double seconds) {
+  xPID.SetMinTimeStep(seconds);
+  yPID.SetMinTimeStep(seconds);
+  thetaPID.SetMinTimeStep(seconds);
+}
+
+/**
+ * @brief Replaces the gains of all three PID controllers.
+ * @param xConfig Configuration for X-axis PID.
+ * @param yConfig Configuration for Y-axis PID.
+ * @param thetaConfig Configuration for Theta PID.
+ */
+void PIDDriveController::Configure(const PIDConfig &xConfig, const PIDConfig &yConfig,
+                                   const PIDConfig &thetaConfig) {
+  xPID.Configure(xConfig);
+  yPID.Configure(yConfig);
+  thetaPID.Configure(thetaConfig);
+}
+
 /**
  * @brief Prints PID controller information.
  * @param output Output stream for logging.
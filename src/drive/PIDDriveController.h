@@ -26,6 +26,9 @@ class PIDDriveController {
                      const PIDConfig &thetaConfig);
 
   Pose2D Step(const Pose2D &currentPose, const Pose2D &targetPose) const;
+  Pose2D Step(const Pose2D &currentPose, const Pose2D &targetPose, float yawRate);
+  void SetMinTimeStep(double seconds);
+  void Configure(const PIDConfig &xConfig, const PIDConfig &yConfig, const PIDConfig &thetaConfig);
   void PrintInfo(Print &output, bool printConfig) const;
   friend Print &operator<<(Print &output, const PIDDriveController &controller);
 
@@ -33,6 +36,8 @@ class PIDDriveController {
   PID xPID;      ///< PID controller for X-axis movement
   PID yPID;      ///< PID controller for Y-axis movement
   PID thetaPID;  ///< PID controller for rotational movement
+
+  static Pose2D toRobotFrame(Pose2D speedPose, float theta);
 };
 
 #endif  // PIDDRIVECONTROLLER_H
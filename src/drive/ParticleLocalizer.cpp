@@ -0,0 +1,300 @@
+/**
+ * @file ParticleLocalizer.cpp
+ * @author Aldem Pido
+ * @brief Implements the ParticleLocalizer class for range-sensor localization against the field.
+ */
+#include "ParticleLocalizer.h"
+
+#include <Arduino.h>  // For micros(), Print, F()
+
+/**
+ * @brief Wraps an angle to -PI to PI.
+ * @param angle Angle in radians, within a few turns of the range.
+ * @return The same direction in -PI to PI.
+ */
+static float wrapAngle(float angle) {
+  while (angle > PI) angle -= 2 * PI;
+  while (angle < -PI) angle += 2 * PI;
+  return angle;
+}
+
+/**
+ * @brief Constructs a ParticleLocalizer with every particle at the origin.
+ *  Call Reset() with the starting pose before use.
+ * @param map Walls to cast ranges against. Must outlive the localizer.
+ * @param beams Mounting pose of each range sensor; ranges passed to Correct() use the same order.
+ * @param numBeams Number of sensors, up to PF_MAX_BEAMS.
+ * @param numParticles Number of particles, up to PF_MAX_PARTICLES.
+ */
+ParticleLocalizer::ParticleLocalizer(const FieldMap &map, const RangeBeam beams[], int numBeams,
+                                     int numParticles)
+    : map(map),
+      numBeams(constrain(numBeams, 0, PF_MAX_BEAMS)),
+      numParticles(constrain(numParticles, 1, PF_MAX_PARTICLES)),
+      lastCorrectUs(0),
+      maxCorrectUs(0),
+      rng(0x2545F491) {
+  for (int i = 0; i < this->numBeams; i++) {
+    this->beams[i] = beams[i];
+    beamCos[i] = cosf(beams[i].angle);
+    beamSin[i] = sinf(beams[i].angle);
+  }
+  Reset(Pose2D(), 0, 0);
+}
+
+/**
+ * @brief Scatters the particles around a pose and restarts the statistics.
+ *  The next Correct() runs without waiting for motion, so a wide spread can settle at once.
+ * @param pose Best guess of the robot pose; also taken as the current odometry pose.
+ * @param spreadXY Standard deviation of the particle positions, in inches.
+ * @param spreadTheta Standard deviation of the particle headings, in radians.
+ */
+void ParticleLocalizer::Reset(const Pose2D &pose, float spreadXY, float spreadTheta) {
+  const float weight = 1.0f / numParticles;
+  for (int i = 0; i < numParticles; i++) {
+    Particle &p = particles[i];
+    p.x = pose.getX() + spreadXY * gaussian();
+    p.y = pose.getY() + spreadXY * gaussian();
+    p.theta = wrapAngle(pose.getTheta() + spreadTheta * gaussian());
+    p.weight = weight;
+  }
+  odometry = pose;
+  pendingMotion = PF_MIN_MOTION;
+  pendingTurn = 0;
+  corrections = 0;
+  resamples = 0;
+  updateEstimate();
+}
+
+/**
+ * @brief Takes a new odometry pose as the reference without moving the particles.
+ *  Use after the odometry was overwritten, e.g. with this localizer's own estimate.
+ * @param odometry Current odometry pose.
+ */
+void ParticleLocalizer::SetOdometry(const Pose2D &odometry) { this->odometry = odometry; }
+
+/**
+ * @brief Moves every particle by the odometry change since the last call.
+ *  The change is taken in the robot frame of the previous odometry pose and applied in each
+ * particle's own frame, so particles with a different heading move in their own direction.
+ * @param odometry Current odometry pose.
+ */
+void ParticleLocalizer::Predict(const Pose2D &odometry) {
+  const float dxField = odometry.getX() - this->odometry.getX();
+  const float dyField = odometry.getY() - this->odometry.getY();
+  const float cosPrev = cosf(this->odometry.getTheta());
+  const float sinPrev = sinf(this->odometry.getTheta());
+  const float dx = cosPrev * dxField + sinPrev * dyField;
+  const float dy = -sinPrev * dxField + cosPrev * dyField;
+  const float dtheta = wrapAngle(odometry.getTheta() - this->odometry.getTheta());
+  this->odometry = odometry;
+
+  const float distance = sqrtf(dx * dx + dy * dy);
+  if (distance == 0 && dtheta == 0) return;
+  pendingMotion += distance;
+  pendingTurn += fabsf(dtheta);
+
+  const float sigmaXY = PF_TRANS_NOISE * distance;
+  const float sigmaTheta = PF_TURN_NOISE * fabsf(dtheta) + PF_DRIFT_NOISE * distance;
+  for (int i = 0; i < numParticles; i++) {
+    Particle &p = particles[i];
+    const float localX = dx + sigmaXY * gaussian();
+    const float localY = dy + sigmaXY * gaussian();
+    const float c = cosf(p.theta);
+    const float s = sinf(p.theta);
+    p.x += c * localX - s * localY;
+    p.y += s * localX + c * localY;
+    p.theta = wrapAngle(p.theta + dtheta + sigmaTheta * gaussian());
+  }
+  updateEstimate();
+}
+
+/**
+ * @brief Weights the particles by a set of ranges and resamples if needed.
+ *  Each range is compared with a ray cast from the particle's sensor pose. The likelihood is a
+ * Gaussian whose width grows with distance, mixed with PF_RANGE_FLOOR so that a reading off a
+ * game piece or another robot lowers a particle's weight without zeroing it. Particles off the
+ * field get the floor for every range.
+ * @param ranges One range per beam in inches; negative or beyond PF_MAX_RANGE to skip a beam.
+ * @return False if nothing was done: too little motion since the last correction, or no ranges.
+ */
+bool ParticleLocalizer::Correct(const float ranges[]) {
+  if (pendingMotion < PF_MIN_MOTION && pendingTurn < PF_MIN_TURN) {
+    return false;
+  }
+  bool used[PF_MAX_BEAMS];
+  int numUsed = 0;
+  for (int b = 0; b < numBeams; b++) {
+    used[b] = ranges[b] >= 0 && ranges[b] <= PF_MAX_RANGE;
+    if (used[b]) numUsed++;
+  }
+  if (numUsed == 0) {
+    return false;
+  }
+
+  const uint32_t start = micros();
+  float offField = 1;
+  for (int b = 0; b < numUsed; b++) offField *= PF_RANGE_FLOOR;
+  float total = 0;
+  for (int i = 0; i < numParticles; i++) {
+    Particle &p = particles[i];
+    float likelihood = 1;
+    if (!map.Contains(p.x, p.y)) {
+      likelihood = offField;
+    } else {
+      const float c = cosf(p.theta);
+      const float s = sinf(p.theta);
+      for (int b = 0; b < numBeams; b++) {
+        if (!used[b]) continue;
+        const RangeBeam &beam = beams[b];
+        const float originX = p.x + c * beam.x - s * beam.y;
+        const float originY = p.y + s * beam.x + c * beam.y;
+        const float cosRay = c * beamCos[b] - s * beamSin[b];
+        const float sinRay = s * beamCos[b] + c * beamSin[b];
+        const float expected = map.RayCast(originX, originY, cosRay, sinRay, PF_MAX_RANGE);
+        const float sigma = PF_RANGE_SIGMA + PF_RANGE_SIGMA_SCALE * expected;
+        const float error = (ranges[b] - expected) / sigma;
+        likelihood *= (1 - PF_RANGE_FLOOR) * expf(-0.5f * error * error) + PF_RANGE_FLOOR;
+      }
+    }
+    p.weight *= likelihood;
+    total += p.weight;
+  }
+
+  const float uniformWeight = 1.0f / numParticles;
+  for (int i = 0; i < numParticles; i++) {
+    particles[i].weight = total > 0 ? particles[i].weight / total : uniformWeight;
+  }
+  updateEstimate();
+  if (effectiveCount < PF_RESAMPLE_RATIO * numParticles) {
+    resample();
+    updateEstimate();
+  }
+  pendingMotion = 0;
+  pendingTurn = 0;
+  corrections++;
+
+  lastCorrectUs = micros() - start;
+  if (lastCorrectUs > maxCorrectUs) maxCorrectUs = lastCorrectUs;
+  return true;
+}
+
+/**
+ * @brief Draws a new, equally weighted particle set in proportion to the weights.
+ *  Low-variance (systematic) resampling: one random offset, then evenly spaced picks, so a
+ * particle with weight w is copied about w x N times. Copies are jittered slightly so they do not
+ * stay identical while the robot is still.
+ */
+void ParticleLocalizer::resample() {
+  const float step = 1.0f / numParticles;
+  float target = step * uniform();
+  float cumulative = particles[0].weight;
+  int source = 0;
+  for (int i = 0; i < numParticles; i++) {
+    while (target > cumulative && source < numParticles - 1) {
+      cumulative += particles[++source].weight;
+    }
+    Particle &p = scratch[i];
+    p = particles[source];
+    p.x += PF_JITTER_XY * gaussian();
+    p.y += PF_JITTER_XY * gaussian();
+    p.theta = wrapAngle(p.theta + PF_JITTER_THETA * gaussian());
+    p.weight = step;
+    target += step;
+  }
+  memcpy(particles, scratch, numParticles * sizeof(Particle));
+  resamples++;
+}
+
+/**
+ * @brief Recomputes the mean pose, spread and effective particle count from the weights.
+ */
+void ParticleLocalizer::updateEstimate() {
+  float x = 0, y = 0, c = 0, s = 0, squares = 0;
+  for (int i = 0; i < numParticles; i++) {
+    const Particle &p = particles[i];
+    x += p.weight * p.x;
+    y += p.weight * p.y;
+    c += p.weight * cosf(p.theta);
+    s += p.weight * sinf(p.theta);
+    squares += p.weight * p.weight;
+  }
+  float variance = 0;
+  for (int i = 0; i < numParticles; i++) {
+    const Particle &p = particles[i];
+    variance += p.weight * ((p.x - x) * (p.x - x) + (p.y - y) * (p.y - y));
+  }
+  estimate = Pose2D(x, y, atan2f(s, c));
+  spread = sqrtf(variance);
+  effectiveCount = squares > 0 ? 1.0f / squares : 0;
+}
+
+/**
+ * @brief Draws a uniform random number with xorshift32.
+ * @return A value in [0, 1).
+ */
+float ParticleLocalizer::uniform() {
+  rng ^= rng << 13;
+  rng ^= rng >> 17;
+  rng ^= rng << 5;
+  return (rng >> 8) * (1.0f / 16777216.0f);
+}
+
+/**
+ * @brief Draws an approximately standard normal number.
+ *  Sum of four uniforms, scaled to unit variance. The tails stop at about 3.5 sigma, which is
+ * plenty for motion noise and far cheaper than Box-Muller.
+ * @return A value with mean 0 and standard deviation 1.
+ */
+float ParticleLocalizer::gaussian() {
+  return (uniform() + uniform() + uniform() + uniform() - 2.0f) * 1.7320508f;
+}
+
+/**
+ * @brief Prints the localizer configuration or its state.
+ * @param output Output stream for logging.
+ * @param printConfig If true, prints the particle, beam and wall counts; otherwise, prints the
+ * estimate and timing.
+ */
+void ParticleLocalizer::PrintInfo(Print &output, bool printConfig) const {
+  if (printConfig) {
+    output.print(F("ParticleLocalizer Configuration: "));
+    output.print(numParticles);
+    output.print(F(" particles, "));
+    output.print(numBeams);
+    output.print(F(" beams, "));
+    output.print(map.GetWallCount());
+    output.println(F(" walls"));
+    return;
+  }
+  output.print(F("Localizer: ("));
+  output.print(estimate.getX());
+  output.print(F(", "));
+  output.print(estimate.getY());
+  output.print(F(", "));
+  output.print(estimate.getTheta());
+  output.print(F("), spread "));
+  output.print(spread);
+  output.print(F(" in, neff "));
+  output.print(effectiveCount);
+  output.print(F(", corrections "));
+  output.print(corrections);
+  output.print(F(", resamples "));
+  output.print(resamples);
+  output.print(F(", last "));
+  output.print(lastCorrectUs);
+  output.print(F("us max "));
+  output.print(maxCorrectUs);
+  output.println(F("us"));
+}
+
+/**
+ * @brief Overloaded stream operator for printing the localizer state.
+ * @param output Output stream.
+ * @param localizer ParticleLocalizer instance.
+ * @return Modified output stream.
+ */
+Print &operator<<(Print &output, const ParticleLocalizer &localizer) {
+  localizer.PrintInfo(output, false);
+  return output;
+}
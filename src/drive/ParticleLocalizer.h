@@ -0,0 +1,122 @@
+/**
+ * @file ParticleLocalizer.h
+ * @author Aldem Pido
+ * @brief Defines the ParticleLocalizer class, which corrects odometry with range sensors and a
+ * field map.
+ * @ingroup drives
+ */
+
+#ifndef PARTICLELOCALIZER_H
+#define PARTICLELOCALIZER_H
+
+#include <Arduino.h>
+#include <Print.h>
+
+#include "math/FieldMap.h"
+#include "math/Pose2D.h"
+
+#define PF_MAX_PARTICLES 200  ///< Particle storage; 2 x 16 bytes each.
+#define PF_MAX_BEAMS 4        ///< Range sensors that can be fused.
+#define PF_MAX_RANGE 47.0f    ///< Longest range (in) trusted from a sensor or predicted by the map.
+
+#define PF_RANGE_SIGMA 0.75f        ///< Range noise (in) at zero distance.
+#define PF_RANGE_SIGMA_SCALE 0.04f  ///< Extra range noise per inch of distance.
+#define PF_RANGE_FLOOR 0.05f        ///< Likelihood kept for a range the map cannot explain.
+#define PF_TRANS_NOISE 0.05f        ///< Travel noise (in) per inch travelled.
+#define PF_TURN_NOISE 0.02f         ///< Heading noise (rad) per radian turned.
+#define PF_DRIFT_NOISE 0.002f       ///< Heading noise (rad) per inch travelled.
+#define PF_MIN_MOTION 0.25f         ///< Travel (in) needed before the next correction.
+#define PF_MIN_TURN 0.02f           ///< Turn (rad) needed before the next correction.
+#define PF_RESAMPLE_RATIO 0.5f      ///< Resample when the effective count drops below this share.
+#define PF_JITTER_XY 0.05f          ///< Position noise (in) added to resampled particles.
+#define PF_JITTER_THETA 0.005f      ///< Heading noise (rad) added to resampled particles.
+#define PF_CONVERGED_SPREAD 1.0f    ///< Spread (in) below which the estimate is trusted.
+
+/**
+ * @struct RangeBeam
+ * @ingroup drives
+ * @brief Where a range sensor sits on the robot: x forward, y left, in inches, angle in radians
+ * from forward.
+ */
+struct RangeBeam {
+  float x = 0;      ///< Forward offset from the robot center.
+  float y = 0;      ///< Left offset from the robot center.
+  float angle = 0;  ///< Direction the sensor faces.
+};
+
+/**
+ * @class ParticleLocalizer
+ * @ingroup drives
+ * @brief Monte Carlo localization of the robot against a FieldMap.
+ *  Each particle is a pose hypothesis. Predict() moves every particle by the change in the
+ * odometry pose (encoders and gyro) plus noise that grows with the motion. Correct() weights each
+ * particle by how well the ranges it would measure, ray cast against the map, match the real
+ * ones, then resamples when the weights have collapsed onto a few particles. GetPose() is the
+ * weighted mean. Corrections wait for PF_MIN_MOTION of travel or PF_MIN_TURN of turning so a
+ * robot at rest does not keep re-weighting the same readings into overconfidence.
+ *
+ *  The cost of Correct() is particles x beams x walls ray casts; GetLastCorrectUs() reports it.
+ * Storage is fixed at PF_MAX_PARTICLES.
+ */
+class ParticleLocalizer {
+ public:
+  ParticleLocalizer(const FieldMap &map, const RangeBeam beams[], int numBeams,
+                    int numParticles = PF_MAX_PARTICLES);
+
+  void Reset(const Pose2D &pose, float spreadXY, float spreadTheta);
+  void SetOdometry(const Pose2D &odometry);
+  void Predict(const Pose2D &odometry);
+  bool Correct(const float ranges[]);
+
+  Pose2D GetPose() const { return estimate; }
+  float GetSpread() const { return spread; }
+  float GetEffectiveCount() const { return effectiveCount; }
+  bool IsConverged() const { return corrections > 0 && spread < PF_CONVERGED_SPREAD; }
+  int GetParticleCount() const { return numParticles; }
+  uint32_t GetCorrectionCount() const { return corrections; }
+  uint32_t GetLastCorrectUs() const { return lastCorrectUs; }
+  uint32_t GetMaxCorrectUs() const { return maxCorrectUs; }
+
+  void PrintInfo(Print &output, bool printConfig = false) const;
+  friend Print &operator<<(Print &output, const ParticleLocalizer &localizer);
+
+ private:
+  /**
+   * @struct Particle
+   * @brief One pose hypothesis and its weight.
+   */
+  struct Particle {
+    float x, y, theta;  ///< Pose in field inches and radians.
+    float weight;       ///< Normalized weight; all weights sum to 1.
+  };
+
+  const FieldMap &map;                   ///< Walls the ranges are cast against.
+  RangeBeam beams[PF_MAX_BEAMS];         ///< Sensor mounting poses.
+  float beamCos[PF_MAX_BEAMS];           ///< Cosine of each beam angle.
+  float beamSin[PF_MAX_BEAMS];           ///< Sine of each beam angle.
+  const int numBeams;                    ///< Number of beams in use.
+  const int numParticles;                ///< Number of particles in use.
+  Particle particles[PF_MAX_PARTICLES];  ///< Current particle set.
+  Particle scratch[PF_MAX_PARTICLES];    ///< Resampling buffer.
+
+  Pose2D odometry;      ///< Odometry pose at the last Predict().
+  float pendingMotion;  ///< Travel since the last correction.
+  float pendingTurn;    ///< Turning since the last correction.
+
+  Pose2D estimate;       ///< Weighted mean pose.
+  float spread;          ///< Weighted RMS distance of the particles from the estimate.
+  float effectiveCount;  ///< 1 / sum of squared weights.
+
+  uint32_t corrections;    ///< Corrections applied since Reset().
+  uint32_t resamples;      ///< Resamples since Reset().
+  uint32_t lastCorrectUs;  ///< Duration of the last correction.
+  uint32_t maxCorrectUs;   ///< Longest correction seen.
+  uint32_t rng;            ///< xorshift32 state.
+
+  float uniform();
+  float gaussian();
+  void resample();
+  void updateEstimate();
+};
+
+#endif  // PARTICLELOCALIZER_H
@@ -0,0 +1,237 @@
+/**
+ * @file PoseEKF.cpp
+ * @author Aldem Pido
+ * @brief Implements the PoseEKF class for fusing odometry and gyro readings into a pose estimate
+ * with covariance.
+ */
+#include "PoseEKF.h"
+
+#include <Arduino.h>  // For Print, F()
+
+/**
+ * @brief Wraps an angle to -PI to PI.
+ * @param angle Angle in radians, within a few turns of the range.
+ * @return The same direction in -PI to PI.
+ */
+static float wrapAngle(float angle) {
+  while (angle > PI) angle -= 2 * PI;
+  while (angle < -PI) angle += 2 * PI;
+  return angle;
+}
+
+/**
+ * @brief Constructs a PoseEKF at the origin, at rest.
+ */
+PoseEKF::PoseEKF() {
+  for (int i = 0; i < EKF_STATES; i++) {
+    state[i] = 0;
+    for (int j = 0; j < EKF_STATES; j++) {
+      covariance[i][j] = 0;
+    }
+  }
+  for (int i = 3; i < EKF_STATES; i++) {
+    covariance[i][i] = EKF_INITIAL_SIGMA_VEL * EKF_INITIAL_SIGMA_VEL;
+  }
+  Reset(Pose2D(), EKF_RESET_SIGMA_XY, EKF_RESET_SIGMA_THETA);
+}
+
+/**
+ * @brief Sets the pose and its uncertainty, keeping the velocity estimate.
+ *  The correlation between the old pose and the velocity is dropped along with the old pose.
+ * @param pose New pose.
+ * @param sigmaXY Standard deviation of x and y, in inches.
+ * @param sigmaTheta Standard deviation of the heading, in radians.
+ */
+void PoseEKF::Reset(const Pose2D &pose, float sigmaXY, float sigmaTheta) {
+  state[0] = pose.getX();
+  state[1] = pose.getY();
+  state[2] = wrapAngle(pose.getTheta());
+  for (int i = 0; i < 3; i++) {
+    for (int j = 0; j < EKF_STATES; j++) {
+      covariance[i][j] = 0;
+      covariance[j][i] = 0;
+    }
+  }
+  covariance[0][0] = covariance[1][1] = sigmaXY * sigmaXY;
+  covariance[2][2] = sigmaTheta * sigmaTheta;
+}
+
+/**
+ * @brief Moves the pose by one odometry step and fuses the step as a velocity measurement.
+ *  The covariance is propagated through the Jacobian F of the move, P = F P F^T + Q. Q holds
+ * velocity noise in proportion to dt, then, once the step has updated the velocity, odometry
+ * noise set in the robot frame and rotated into the field.
+ * @param step Chord (in) and turn (rad) of the step, in the robot frame at its start.
+ * @param dt Duration of the step in seconds; clamped to EKF_MAX_DT.
+ */
+void PoseEKF::Predict(const Pose2D &step, float dt) {
+  dt = constrain(dt, 0.0f, EKF_MAX_DT);
+  if (dt == 0) return;
+  const float c = cosf(state[2]);
+  const float s = sinf(state[2]);
+  const float dx = step.getX() * c - step.getY() * s;
+  const float dy = step.getX() * s + step.getY() * c;
+  state[0] += dx;
+  state[1] += dy;
+  state[2] = wrapAngle(state[2] + step.getTheta());
+
+  // F is the identity except for the heading column: x and y depend on theta through the
+  // rotation, so F P F^T only changes the rows and columns of x and y
+  const float fx = -dy;  // d(x)/d(theta)
+  const float fy = dx;   // d(y)/d(theta)
+  for (int j = 0; j < EKF_STATES; j++) {
+    covariance[0][j] += fx * covariance[2][j];
+    covariance[1][j] += fy * covariance[2][j];
+  }
+  for (int i = 0; i < EKF_STATES; i++) {
+    covariance[i][0] += fx * covariance[i][2];
+    covariance[i][1] += fy * covariance[i][2];
+  }
+
+  covariance[3][3] += EKF_ACCEL_NOISE * EKF_ACCEL_NOISE * dt;
+  covariance[4][4] += EKF_ACCEL_NOISE * EKF_ACCEL_NOISE * dt;
+  covariance[5][5] += EKF_ALPHA_NOISE * EKF_ALPHA_NOISE * dt;
+  const float stepVariance = (EKF_STEP_SIGMA / dt) * (EKF_STEP_SIGMA / dt);
+  const float turnVariance = (EKF_STEP_TURN_SIGMA / dt) * (EKF_STEP_TURN_SIGMA / dt);
+  const float hx[EKF_STATES] = {0, 0, 0, 1, 0, 0};
+  const float hy[EKF_STATES] = {0, 0, 0, 0, 1, 0};
+  const float ht[EKF_STATES] = {0, 0, 0, 0, 0, 1};
+  update(hx, step.getX() / dt - state[3], stepVariance);
+  update(hy, step.getY() / dt - state[4], stepVariance);
+  update(ht, step.getTheta() / dt - state[5], turnVariance);
+
+  // Odometry noise grows with the distance covered, taken from the filtered velocity because the
+  // step itself carries tick counting noise that would add up faster at higher rates
+  const float forward = EKF_TRAVEL_NOISE * EKF_TRAVEL_NOISE * fabsf(state[3]) * dt;
+  const float left = EKF_TRAVEL_NOISE * EKF_TRAVEL_NOISE * fabsf(state[4]) * dt;
+  covariance[0][0] += c * c * forward + s * s * left;
+  covariance[1][1] += s * s * forward + c * c * left;
+  covariance[0][1] += c * s * (forward - left);
+  covariance[1][0] = covariance[0][1];
+  covariance[2][2] += EKF_TURN_NOISE * EKF_TURN_NOISE * fabsf(state[5]) * dt;
+}
+
+/**
+ * @brief Fuses a gyro yaw rate reading.
+ * @param rate Yaw rate in rad/s, counterclockwise positive.
+ */
+void PoseEKF::UpdateYawRate(float rate) {
+  const float h[EKF_STATES] = {0, 0, 0, 0, 0, 1};
+  update(h, rate - state[5], EKF_RATE_SIGMA * EKF_RATE_SIGMA);
+}
+
+/**
+ * @brief Fuses a measurement of the whole pose, such as a range fix.
+ *  x, y and heading are taken as independent errors and fused one after another, which is exact
+ * for independent errors, so the covariance shrinks by what the fix actually tells.
+ * @param pose Measured pose.
+ * @param sigmaXY Standard deviation of the measured x and y, in inches.
+ * @param sigmaTheta Standard deviation of the measured heading, in radians.
+ */
+void PoseEKF::UpdatePose(const Pose2D &pose, float sigmaXY, float sigmaTheta) {
+  const float hx[EKF_STATES] = {1, 0, 0, 0, 0, 0};
+  const float hy[EKF_STATES] = {0, 1, 0, 0, 0, 0};
+  const float ht[EKF_STATES] = {0, 0, 1, 0, 0, 0};
+  update(hx, pose.getX() - state[0], sigmaXY * sigmaXY);
+  update(hy, pose.getY() - state[1], sigmaXY * sigmaXY);
+  update(ht, wrapAngle(pose.getTheta() - state[2]), sigmaTheta * sigmaTheta);
+  state[2] = wrapAngle(state[2]);
+}
+
+/**
+ * @brief Applies a scalar measurement update.
+ *  With PH = P h^T and S = h PH + R, the gain is K = PH / S, the state moves by K times the
+ * innovation and P loses K PH^T, which stays symmetric because K is a multiple of PH.
+ * @param h Measurement row.
+ * @param innovation Measurement minus its prediction.
+ * @param variance Measurement noise variance R.
+ */
+void PoseEKF::update(const float h[EKF_STATES], float innovation, float variance) {
+  float ph[EKF_STATES];
+  float s = variance;
+  for (int i = 0; i < EKF_STATES; i++) {
+    float sum = 0;
+    for (int k = 0; k < EKF_STATES; k++) sum += covariance[i][k] * h[k];
+    ph[i] = sum;
+    s += h[i] * sum;
+  }
+  if (!(s > 0)) return;
+  for (int i = 0; i < EKF_STATES; i++) {
+    const float gain = ph[i] / s;
+    state[i] += gain * innovation;
+    for (int j = 0; j < EKF_STATES; j++) {
+      covariance[i][j] -= gain * ph[j];
+    }
+  }
+}
+
+/**
+ * @brief Packs the pose, velocity and pose covariance for publishing.
+ * @return The current estimate.
+ */
+PoseEstimate PoseEKF::GetEstimate() const {
+  PoseEstimate estimate;
+  estimate.pose = GetPose();
+  estimate.velocity = GetVelocity();
+  for (int i = 0; i < 3; i++) {
+    for (int j = 0; j < 3; j++) {
+      estimate.covariance[i][j] = covariance[i][j];
+    }
+  }
+  return estimate;
+}
+
+/**
+ * @brief Prints the noise settings or the current estimate.
+ * @param output Output stream for logging.
+ * @param printConfig If true, prints the noise settings; otherwise, prints the estimate and its
+ * standard deviations.
+ */
+void PoseEKF::PrintInfo(Print &output, bool printConfig) const {
+  if (printConfig) {
+    output.print(F("PoseEKF Configuration: accel "));
+    output.print(EKF_ACCEL_NOISE);
+    output.print(F(" in/s^2, alpha "));
+    output.print(EKF_ALPHA_NOISE);
+    output.print(F(" rad/s^2, travel "));
+    output.print(EKF_TRAVEL_NOISE);
+    output.print(F(" in/sqrt(in), turn "));
+    output.print(EKF_TURN_NOISE);
+    output.print(F(" rad/sqrt(rad), step turn "));
+    output.print(EKF_STEP_TURN_SIGMA, 3);
+    output.print(F(" rad, rate "));
+    output.print(EKF_RATE_SIGMA);
+    output.println(F(" rad/s"));
+    return;
+  }
+  output.print(F("EKF: ("));
+  output.print(state[0]);
+  output.print(F(", "));
+  output.print(state[1]);
+  output.print(F(", "));
+  output.print(state[2]);
+  output.print(F(") +/- ("));
+  output.print(sqrtf(covariance[0][0]));
+  output.print(F(", "));
+  output.print(sqrtf(covariance[1][1]));
+  output.print(F(", "));
+  output.print(sqrtf(covariance[2][2]), 3);
+  output.print(F("), vel ("));
+  output.print(state[3]);
+  output.print(F(", "));
+  output.print(state[4]);
+  output.print(F(", "));
+  output.print(state[5]);
+  output.println(')');
+}
+
+/**
+ * @brief Overloaded stream operator for printing the estimate.
+ * @param output Output stream.
+ * @param ekf PoseEKF instance.
+ * @return Modified output stream.
+ */
+Print &operator<<(Print &output, const PoseEKF &ekf) {
+  ekf.PrintInfo(output, false);
+  return output;
+}
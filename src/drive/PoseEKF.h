@@ -0,0 +1,91 @@
+/**
+ * @file PoseEKF.h
+ * @author Aldem Pido
+ * @brief Defines the PoseEKF class, which estimates the robot pose, velocity and their
+ * uncertainty from the wheels and the gyro.
+ * @ingroup drives
+ */
+
+#ifndef POSEEKF_H
+#define POSEEKF_H
+
+#include <Arduino.h>
+#include <Print.h>
+
+#include "math/Pose2D.h"
+
+#define EKF_STATES 6  ///< x, y, theta, forward velocity, left velocity, turn rate.
+
+#define EKF_ACCEL_NOISE 60.0f        ///< Unmodelled acceleration (in/s^2) of the chassis.
+#define EKF_ALPHA_NOISE 15.0f        ///< Unmodelled angular acceleration (rad/s^2).
+#define EKF_TRAVEL_NOISE 0.1f        ///< Odometry position error (in) per square root inch.
+#define EKF_TURN_NOISE 0.01f         ///< Odometry heading error (rad) per square root radian.
+#define EKF_STEP_SIGMA 0.05f         ///< Error (in) of one odometry step, from tick counting.
+#define EKF_STEP_TURN_SIGMA 0.005f   ///< Error (rad) of one odometry step's turn, gyro included.
+#define EKF_RATE_SIGMA 0.05f         ///< Gyro yaw rate error (rad/s).
+#define EKF_FIX_SIGMA_XY 0.75f       ///< Default position error (in) of a pose fix.
+#define EKF_FIX_SIGMA_THETA 0.03f    ///< Default heading error (rad) of a pose fix.
+#define EKF_RESET_SIGMA_XY 0.5f      ///< Position uncertainty (in) after a pose is set.
+#define EKF_RESET_SIGMA_THETA 0.02f  ///< Heading uncertainty (rad) after a pose is set.
+#define EKF_INITIAL_SIGMA_VEL 1.0f   ///< Velocity uncertainty (in/s or rad/s) at construction.
+#define EKF_MAX_DT 0.1f              ///< Longest step (s); longer gaps are clamped.
+
+/**
+ * @struct PoseEstimate
+ * @ingroup drives
+ * @brief A pose with its velocity and uncertainty, as published by the drive.
+ */
+struct PoseEstimate {
+  Pose2D pose;                  ///< Field pose in inches and radians.
+  Pose2D velocity;              ///< Forward and left velocity (in/s) and turn rate (rad/s).
+  float covariance[3][3] = {};  ///< Covariance of x, y and theta.
+
+  float GetPositionSigma() const { return sqrtf(covariance[0][0] + covariance[1][1]); }
+  float GetHeadingSigma() const { return sqrtf(covariance[2][2]); }
+};
+
+/**
+ * @class PoseEKF
+ * @ingroup drives
+ * @brief Extended Kalman filter over the pose and the robot-frame velocity.
+ *  The state is (x, y, theta, vx, vy, omega), with the velocity in the robot frame. Each odometry
+ * step (the chord and turn from LocalizationEncoder) moves the pose directly, the usual odometry
+ * motion model, and adds pose noise that grows with the square root of the distance. Tick
+ * counting errors do not accumulate, since the counts are totals; what does is slip and scrub,
+ * which EKF_TRAVEL_NOISE and EKF_TURN_NOISE describe independently of the update rate. The step
+ * over its duration is also a measurement of the velocity, whose uncertainty grows between steps by
+ * EKF_ACCEL_NOISE and EKF_ALPHA_NOISE. The gyro yaw rate is fused as a further measurement.
+ * Every measurement is a scalar update, so no matrix is inverted and a full update costs a few
+ * hundred multiplies.
+ *
+ *  The gyro yaw is fused in one place only: LocalizationEncoder already solves its changes into
+ * each step's turn, so it is not fused again here, and the heading uncertainty grows with turning
+ * until a fix brings it back down. UpdatePose() fuses a pose fix, such as one from the range
+ * sensors, with its own noise. Reset() the filter only when the pose is set outright, such as a
+ * start pose.
+ */
+class PoseEKF {
+ public:
+  PoseEKF();
+
+  void Reset(const Pose2D &pose, float sigmaXY, float sigmaTheta);
+  void Predict(const Pose2D &step, float dt);
+  void UpdateYawRate(float rate);
+  void UpdatePose(const Pose2D &pose, float sigmaXY, float sigmaTheta);
+
+  Pose2D GetPose() const { return Pose2D(state[0], state[1], state[2]); }
+  Pose2D GetVelocity() const { return Pose2D(state[3], state[4], state[5]); }
+  float GetCovariance(int row, int col) const { return covariance[row][col]; }
+  PoseEstimate GetEstimate() const;
+
+  void PrintInfo(Print &output, bool printConfig = false) const;
+  friend Print &operator<<(Print &output, const PoseEKF &ekf);
+
+ private:
+  float state[EKF_STATES];                   ///< x, y, theta, vx, vy, omega.
+  float covariance[EKF_STATES][EKF_STATES];  ///< State covariance.
+
+  void update(const float h[EKF_STATES], float innovation, float variance);
+};
+
+#endif  // POSEEKF_H
@@ -0,0 +1,183 @@
+/**
+ * @file PoseHistory.cpp
+ * @author Aldem Pido
+ * @brief Implements the PoseHistory class for looking up and correcting past poses.
+ */
+#include "PoseHistory.h"
+
+#include <Arduino.h>  // For Print, F()
+
+/**
+ * @brief Wraps an angle to -PI to PI.
+ * @param angle Angle in radians, within a few turns of the range.
+ * @return The same direction in -PI to PI.
+ */
+static float wrapAngle(float angle) {
+  while (angle > PI) angle -= 2 * PI;
+  while (angle < -PI) angle += 2 * PI;
+  return angle;
+}
+
+/**
+ * @brief Constructs an empty history.
+ */
+PoseHistory::PoseHistory() : lookups(0), misses(0) {}
+
+/**
+ * @brief Stores a sample unless the newest is less than POSE_HISTORY_PERIOD_US old.
+ *  When full, the oldest sample is dropped.
+ * @param timeUs micros() at which the pose held.
+ * @param pose Field pose.
+ * @param velocity Robot-frame velocity.
+ * @return True if the sample was stored.
+ */
+bool PoseHistory::Add(uint32_t timeUs, const Pose2D &pose, const Pose2D &velocity) {
+  if (!samples.Empty() && timeUs - samples.PeekNewest().timeUs < POSE_HISTORY_PERIOD_US) {
+    return false;
+  }
+  PoseSample sample;
+  if (samples.Full()) samples.Pop(sample);
+  sample.timeUs = timeUs;
+  sample.pose = pose;
+  sample.velocity = velocity;
+  return samples.Push(sample);
+}
+
+/**
+ * @brief Estimates the pose and velocity at a time.
+ *  Between two samples, both are interpolated linearly, the heading the short way round. After
+ * the newest sample, its pose is carried forward at its velocity, which is exact enough for the
+ * few milliseconds until the next sample.
+ * @param timeUs micros() of interest.
+ * @param sample Set to the estimate, with timeUs as given.
+ * @return False if the time is before the oldest sample or nothing is stored.
+ */
+bool PoseHistory::Lookup(uint32_t timeUs, PoseSample &sample) const {
+  lookups++;
+  const size_t size = samples.Size();
+  if (size == 0 || static_cast<int32_t>(timeUs - samples.Peek(0).timeUs) < 0) {
+    misses++;
+    return false;
+  }
+
+  const PoseSample &newest = samples.PeekNewest();
+  const int32_t sinceNewest = static_cast<int32_t>(timeUs - newest.timeUs);
+  if (sinceNewest >= 0) {
+    const float dt = sinceNewest * 1e-6f;
+    const float c = cosf(newest.pose.getTheta());
+    const float s = sinf(newest.pose.getTheta());
+    const float vx = newest.velocity.getX();
+    const float vy = newest.velocity.getY();
+    sample.pose = Pose2D(newest.pose.getX() + (vx * c - vy * s) * dt,
+                         newest.pose.getY() + (vx * s + vy * c) * dt,
+                         wrapAngle(newest.pose.getTheta() + newest.velocity.getTheta() * dt));
+    sample.velocity = newest.velocity;
+    sample.timeUs = timeUs;
+    return true;
+  }
+
+  // Most lookups are recent, so search back from the newest
+  size_t age = 1;
+  while (age < size && static_cast<int32_t>(timeUs - samples.PeekNewest(age).timeUs) < 0) {
+    age++;
+  }
+  const PoseSample &before = samples.PeekNewest(age);
+  const PoseSample &after = samples.PeekNewest(age - 1);
+  const float t = static_cast<float>(timeUs - before.timeUs) / (after.timeUs - before.timeUs);
+  const Pose2D &a = before.pose;
+  const Pose2D &b = after.pose;
+  sample.pose = Pose2D(a.getX() + (b.getX() - a.getX()) * t, a.getY() + (b.getY() - a.getY()) * t,
+                       wrapAngle(a.getTheta() + wrapAngle(b.getTheta() - a.getTheta()) * t));
+  const Pose2D &u = before.velocity;
+  const Pose2D &v = after.velocity;
+  sample.velocity =
+      Pose2D(u.getX() + (v.getX() - u.getX()) * t, u.getY() + (v.getY() - u.getY()) * t,
+             u.getTheta() + (v.getTheta() - u.getTheta()) * t);
+  sample.timeUs = timeUs;
+  return true;
+}
+
+/**
+ * @brief Moves every sample by the rigid motion that takes one pose to another.
+ *  The motion between samples is kept, so the history stays consistent with the odometry after
+ * the current pose is rebased the same way.
+ * @param from A pose in the current history, e.g. a Lookup() at the time of a late reading.
+ * @param to Where that pose should have been.
+ */
+void PoseHistory::Rebase(const Pose2D &from, const Pose2D &to) {
+  const size_t size = samples.Size();
+  for (size_t i = 0; i < size; i++) {
+    PoseSample sample;
+    samples.Pop(sample);
+    sample.pose = Rebase(sample.pose, from, to);
+    samples.Push(sample);
+  }
+}
+
+/**
+ * @brief Applies to one pose the rigid motion that takes from to to.
+ *  The pose keeps its offset from from, measured in from's frame, relative to to.
+ * @param pose Pose to move.
+ * @param from Reference pose before the move.
+ * @param to Reference pose after the move.
+ * @return The moved pose.
+ */
+Pose2D PoseHistory::Rebase(const Pose2D &pose, const Pose2D &from, const Pose2D &to) {
+  const float turn = wrapAngle(to.getTheta() - from.getTheta());
+  const float c = cosf(turn);
+  const float s = sinf(turn);
+  const float dx = pose.getX() - from.getX();
+  const float dy = pose.getY() - from.getY();
+  return Pose2D(to.getX() + c * dx - s * dy, to.getY() + s * dx + c * dy,
+                wrapAngle(pose.getTheta() + turn));
+}
+
+/**
+ * @brief Removes every sample.
+ */
+void PoseHistory::Clear() { samples.Clear(); }
+
+/**
+ * @brief Gets the time between the oldest and newest samples.
+ * @return Span in microseconds, 0 if fewer than two samples are stored.
+ */
+uint32_t PoseHistory::GetSpanUs() const {
+  if (samples.Size() < 2) return 0;
+  return samples.PeekNewest().timeUs - samples.Peek(0).timeUs;
+}
+
+/**
+ * @brief Prints the history settings or its state.
+ * @param output Output stream for logging.
+ * @param printConfig If true, prints the capacity and spacing; otherwise, prints the span and
+ * lookup counts.
+ */
+void PoseHistory::PrintInfo(Print &output, bool printConfig) const {
+  if (printConfig) {
+    output.print(F("PoseHistory Configuration: "));
+    output.print(POSE_HISTORY_SIZE);
+    output.print(F(" samples every "));
+    output.print(POSE_HISTORY_PERIOD_US);
+    output.println(F("us"));
+    return;
+  }
+  output.print(F("Pose history: "));
+  output.print(samples.Size());
+  output.print(F(" samples over "));
+  output.print(GetSpanUs() / 1000);
+  output.print(F("ms, lookups "));
+  output.print(lookups);
+  output.print(F(", misses "));
+  output.println(misses);
+}
+
+/**
+ * @brief Overloaded stream operator for printing the history state.
+ * @param output Output stream.
+ * @param history PoseHistory instance.
+ * @return Modified output stream.
+ */
+Print &operator<<(Print &output, const PoseHistory &history) {
+  history.PrintInfo(output, false);
+  return output;
+}
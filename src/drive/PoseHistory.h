@@ -0,0 +1,68 @@
+/**
+ * @file PoseHistory.h
+ * @author Aldem Pido
+ * @brief Defines the PoseHistory class, which remembers recent poses so late sensor readings can
+ * be matched to where the robot was when they were taken.
+ * @ingroup drives
+ */
+
+#ifndef POSEHISTORY_H
+#define POSEHISTORY_H
+
+#include <Arduino.h>
+#include <Print.h>
+
+#include "../util/RingBuffer.h"
+#include "math/Pose2D.h"
+
+#define POSE_HISTORY_SIZE 64         ///< Samples kept; with the period below, about 320 ms.
+#define POSE_HISTORY_PERIOD_US 5000  ///< Shortest spacing between stored samples.
+
+/**
+ * @struct PoseSample
+ * @ingroup drives
+ * @brief A pose and velocity at one time.
+ */
+struct PoseSample {
+  uint32_t timeUs = 0;  ///< micros() at which the pose held.
+  Pose2D pose;          ///< Field pose in inches and radians.
+  Pose2D velocity;      ///< Forward and left velocity (in/s) and turn rate (rad/s).
+};
+
+/**
+ * @class PoseHistory
+ * @ingroup drives
+ * @brief Fixed-size history of timestamped poses with interpolated lookup.
+ *  Add() stores at most one sample per POSE_HISTORY_PERIOD_US and drops the oldest when full.
+ * Lookup() interpolates between the two samples around a time, or carries the newest sample
+ * forward with its velocity for times after it. Rebase() moves every sample by the rigid motion
+ * that takes one pose to another, which is how a late correction is applied to the past and,
+ * with the same call on the current pose, carried through to the present.
+ *
+ *  Not safe to use from an interrupt and loop() at once; SimpleRobotDrive guards its lookups.
+ */
+class PoseHistory {
+ public:
+  PoseHistory();
+
+  bool Add(uint32_t timeUs, const Pose2D &pose, const Pose2D &velocity);
+  bool Lookup(uint32_t timeUs, PoseSample &sample) const;
+  void Rebase(const Pose2D &from, const Pose2D &to);
+  void Clear();
+
+  size_t GetSize() const { return samples.Size(); }
+  uint32_t GetSpanUs() const;
+  uint32_t GetMissCount() const { return misses; }
+
+  static Pose2D Rebase(const Pose2D &pose, const Pose2D &from, const Pose2D &to);
+
+  void PrintInfo(Print &output, bool printConfig = false) const;
+  friend Print &operator<<(Print &output, const PoseHistory &history);
+
+ private:
+  RingBuffer<PoseSample, POSE_HISTORY_SIZE> samples;  ///< Oldest first.
+  mutable uint32_t lookups;                           ///< Lookup() calls.
+  mutable uint32_t misses;                            ///< Lookups older than every sample.
+};
+
+#endif  // POSEHISTORY_H
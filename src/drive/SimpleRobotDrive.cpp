@@ -12,7 +12,10 @@ SimpleRobotDrive::SimpleRobotDrive(const MotorSetup motorSetups[], int numMotors
     : numMotors(numMotors > 0 ? numMotors : 1),
       output(output),
       enc(std::make_unique<long[]>(numMotors)),
-      localization() {
+      localization(),
+      lastReadUs(0),
+      ekfStarted(false),
+      appliedRequest(0) {
   if (numMotors <= 0) {
     output.println(F("Error: numMotors must be > 0!"));
     numMotors = 1;  // Fallback to prevent crashes
@@ -23,6 +26,8 @@ SimpleRobotDrive::SimpleRobotDrive(const MotorSetup motorSetups[], int numMotors
     motors.emplace_back(std::make_unique<DriveMotor>(motorSetups[i], output));
     enc[i] = 0;
   }
+  positionOutput.Write(localization.getPosition());
+  estimateOutput.Write(ekf.GetEstimate());
 }
 
 /**
@@ -58,7 +63,8 @@ void SimpleRobotDrive::SetIndex(int motorDirectSpeed, int index) {
 }
 
 /**
- * @brief Reads encoder values for all motors.
+ * @brief Reads encoder values for all motors without updating localization.
+ *  Like ReadAll(), do not call this from loop() while a DriveLoop is running.
  */
 void SimpleRobotDrive::ReadEnc() {
   for (int i = 0; i < numMotors; i++) {
@@ -69,11 +75,92 @@ void SimpleRobotDrive::ReadEnc() {
 
 /**
  * @brief Reads encoder values and updates localization.
- * @param yaw Current gyro yaw reading.
+ *  A pose passed to SetPosition() or CorrectPosition() since the last call is applied first.
+ * SetPosition() moves the current pose and the history by the rigid motion from the current pose
+ * to the new one, and restarts the PoseEKF there. CorrectPosition() carries the fix forward by the
+ * motion recorded since its time and fuses the result into the PoseEKF as a pose measurement with
+ * the fix's noise, so the covariance keeps tracking the real uncertainty; the pose and history
+ * then move to the filtered pose. A fix older than the history is dropped without touching the
+ * pose or the filter. The odometry step, which has the gyro yaw solved into its turn, then drives
+ * the PoseEKF along with the gyro rate; the first call starts the filter at the odometry pose
+ * instead. The updated pose and estimate are
+ * then recorded and published for GetPosition() and GetEstimate(), along with the wheel-measured
+ * velocity for GetMeasuredVelocity().
+ * @param yaw Current gyro yaw reading, or NAN to use the wheels alone.
+ * @param yawRate Current gyro yaw rate in rad/s, or NAN if unknown.
  */
-void SimpleRobotDrive::ReadAll(float yaw) {
+void SimpleRobotDrive::ReadAll(float yaw, float yawRate) {
   ReadEnc();
+  const uint32_t now = micros();
+  const float dt = (now - lastReadUs) * 1e-6f;
+  lastReadUs = now;
+  bool reset = !ekfStarted;
+  const uint32_t request = positionRequest.GetSequence();
+  if (request != appliedRequest) {
+    appliedRequest = request;
+    const PoseRequest pending = positionRequest.Read();
+    const Pose2D current = localization.getPosition();
+    PoseSample then;
+    if (pending.timeUs == 0) {
+      localization.setPosition(pending.pose);
+      history.Rebase(current, pending.pose);
+      reset = true;
+    } else if (history.Lookup(pending.timeUs, then)) {  // Else too old to place; drop it
+      ekf.UpdatePose(PoseHistory::Rebase(current, then.pose, pending.pose), pending.sigmaXY,
+                     pending.sigmaTheta);
+      const Pose2D corrected = ekf.GetPose();
+      localization.setPosition(corrected);
+      history.Rebase(current, corrected);
+    }
+  }
   localization.updatePosition(enc.get(), yaw);
+  if (reset) {
+    ekf.Reset(localization.getPosition(), EKF_RESET_SIGMA_XY, EKF_RESET_SIGMA_THETA);
+    ekfStarted = true;
+  } else {
+    ekf.Predict(localization.getStep(), dt);
+    if (!isnan(yawRate)) ekf.UpdateYawRate(yawRate);
+  }
+  history.Add(now, localization.getPosition(), ekf.GetVelocity());
+  positionOutput.Write(localization.getPosition());
+  estimateOutput.Write(ekf.GetEstimate());
+
+  float tickRates[ODOM_MAX_WHEELS];
+  for (int i = 0; i < localization.getWheelCount(); i++) {
+    tickRates[i] = motors[i]->GetVelocity();
+  }
+  Pose2D measured;
+  if (localization.getVelocity(tickRates, measured)) velocityOutput.Write(measured);
+}
+
+/**
+ * @brief Looks up where the robot was at a past time.
+ *  Interrupts are held off during the lookup, since a DriveLoop may be adding to the history.
+ * @param timeUs micros() of interest.
+ * @param sample Set to the pose and velocity at that time.
+ * @return False if the time is older than the history, about POSE_HISTORY_SIZE x
+ * POSE_HISTORY_PERIOD_US.
+ */
+bool SimpleRobotDrive::GetPoseAt(uint32_t timeUs, PoseSample &sample) const {
+  noInterrupts();
+  const bool found = history.Lookup(timeUs, sample);
+  interrupts();
+  return found;
+}
+
+/**
+ * @brief Sets the odometry wheel geometry; wheel i reads motor i's encoder.
+ *  Call before the first ReadAll().
+ * @param wheels Mounting pose of each tracking wheel.
+ * @param numWheels Number of wheels, at most the number of motors.
+ * @return False, keeping the old geometry, if the wheels are rejected.
+ */
+bool SimpleRobotDrive::SetOdometryWheels(const OdometryWheel wheels[], int numWheels) {
+  if (numWheels > this->numMotors) {
+    output.println(F("Error: more odometry wheels than encoders"));
+    return false;
+  }
+  return localization.setWheels(wheels, numWheels);
 }
 
 /**
@@ -111,9 +198,20 @@ void SimpleRobotDrive::PrintInfo(Print &output, bool printConfig) const {
 
 /**
  * @brief Prints localization information.
+ *  ReadAll() may be updating the odometry, filter and history from a DriveLoop interrupt, so
+ * they are copied with interrupts held off and the copies are printed.
  * @param output Output stream for logging.
  */
-void SimpleRobotDrive::PrintLocal(Print &output) const { localization.PrintInfo(output); }
+void SimpleRobotDrive::PrintLocal(Print &output) const {
+  noInterrupts();
+  const LocalizationEncoder localizationCopy = localization;
+  const PoseEKF ekfCopy = ekf;
+  const PoseHistory historyCopy = history;
+  interrupts();
+  localizationCopy.PrintInfo(output);
+  output << ekfCopy;
+  output << historyCopy;
+}
 
 /**
  * @brief Overloaded stream operator for printing drive details.
@@ -18,13 +18,37 @@
 #include <memory>
 #include <vector>
 
+#include "../util/DoubleBuffer.h"
 #include "DriveMotor.h"
 #include "LocalizationEncoder.h"
+#include "PoseEKF.h"
+#include "PoseHistory.h"
+
+/**
+ * @struct PoseRequest
+ * @ingroup drives
+ * @brief A pose for ReadAll() to apply, either now or at a past time.
+ */
+struct PoseRequest {
+  Pose2D pose;                             ///< Where the robot is, or was.
+  uint32_t timeUs = 0;                     ///< micros() at which it was there, or 0 for now.
+  float sigmaXY = EKF_FIX_SIGMA_XY;        ///< Position error (in) of a fix.
+  float sigmaTheta = EKF_FIX_SIGMA_THETA;  ///< Heading error (rad) of a fix.
+};
 
 /**
  * @class SimpleRobotDrive
  * @ingroup drives
  * @brief Base class for a robot drive system.
+ *  ReadAll() and Write() may run inside a timer interrupt (see DriveLoop). SetPosition() and
+ * GetPosition() pass poses through double buffers, so they are safe to call from loop() either way,
+ * as does GetEstimate() for the PoseEKF estimate with its covariance. CorrectPosition() is the
+ * latency-compensated form of SetPosition() for a fix that describes a past time, such as a range
+ * reading; the drive keeps a PoseHistory to apply it and answers GetPoseAt() from it.
+ * GetMeasuredVelocity() is the chassis velocity the wheels measure (see DriveMotor), put through
+ * the odometry wheel geometry; unlike the EKF velocity it does not use the gyro.
+ * A pose request is pending until GetAppliedPositionCount() catches up with
+ * GetPositionRequestCount(). The slip getters are not buffered and are for diagnostics only.
  */
 class SimpleRobotDrive {
  public:
@@ -32,12 +56,32 @@ class SimpleRobotDrive {
   void Begin();
   void Set(const int motorDirectSpeed[]);
   void SetIndex(int motorDirectSpeed, int index);
-  void ReadAll(float yaw);
+  void ReadAll(float yaw, float yawRate = NAN);
+  void ReadEnc();
   void Write();
   virtual void PrintInfo(Print &output, bool printConfig = false) const;
   virtual void PrintLocal(Print &output) const;
-  void SetPosition(const Pose2D &setPosition) { localization.setPosition(setPosition); }
-  Pose2D GetPosition() const { return localization.getPosition(); }
+  void SetPosition(const Pose2D &setPosition) { positionRequest.Write({setPosition, 0}); }
+  void CorrectPosition(const Pose2D &pose, uint32_t timeUs, float sigmaXY = EKF_FIX_SIGMA_XY,
+                       float sigmaTheta = EKF_FIX_SIGMA_THETA) {
+    positionRequest.Write({pose, timeUs != 0 ? timeUs : 1, sigmaXY, sigmaTheta});
+  }
+  bool GetPoseAt(uint32_t timeUs, PoseSample &sample) const;
+  Pose2D GetPosition() const { return positionOutput.Read(); }
+  PoseEstimate GetEstimate() const { return estimateOutput.Read(); }
+  Pose2D GetMeasuredVelocity() const { return velocityOutput.Read(); }
+  uint32_t GetPositionRequestCount() const { return positionRequest.GetSequence(); }
+  uint32_t GetAppliedPositionCount() const { return appliedRequest; }
+  void SetWheelDiameter(float diameter) {
+    localization.setInchesPerTick(PI * diameter / TICKS_PER_REVOLUTION);
+  }
+  bool SetOdometryWheels(const OdometryWheel wheels[], int numWheels);
+  float GetWheelSlip(int index) const { return localization.getSlip(index); }
+  bool IsWheelSlipping(int index) const { return localization.isSlipping(index); }
+  const long *GetEnc() const;
+  int GetMotorCount() const { return numMotors; }
+  int GetMotorSpeed(int index) const { return motors[index]->GetSpeed(); }
+  float GetWheelVelocity(int index) const { return motors[index]->GetVelocity(); }
 
  protected:
   const int numMotors;
@@ -46,9 +90,15 @@ class SimpleRobotDrive {
   std::unique_ptr<long[]> enc;
   std::vector<std::unique_ptr<DriveMotor>> motors;
   LocalizationEncoder localization;
-
-  void ReadEnc();
-  const long *GetEnc() const;
+  PoseEKF ekf;                                ///< Pose, velocity and covariance from the readings
+  uint32_t lastReadUs;                        ///< micros() at the previous ReadAll()
+  bool ekfStarted;                            ///< False until the first ReadAll() seeds the filter
+  PoseHistory history;                        ///< Recent poses, written by ReadAll()
+  DoubleBuffer<PoseRequest> positionRequest;  ///< Pose to apply, read by ReadAll()
+  DoubleBuffer<Pose2D> positionOutput;        ///< Pose published by ReadAll() for GetPosition()
+  DoubleBuffer<PoseEstimate> estimateOutput;  ///< Estimate published by ReadAll()
+  DoubleBuffer<Pose2D> velocityOutput;        ///< Velocity measured by the wheels in ReadAll()
+  volatile uint32_t appliedRequest;           ///< Sequence number of the last applied request
 
   friend Print &operator<<(Print &output, const SimpleRobotDrive &drive);
 };
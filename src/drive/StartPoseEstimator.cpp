@@ -0,0 +1,204 @@
+/**
+ * @file StartPoseEstimator.cpp
+ * @author Aldem Pido
+ * @brief Implements the StartPoseEstimator class for finding the starting pose from range sensors.
+ */
+#include "StartPoseEstimator.h"
+
+#include <Arduino.h>  // For micros(), Print, F()
+
+/**
+ * @brief Constructs a StartPoseEstimator with no fit.
+ * @param map Walls to cast ranges against. Must outlive the estimator.
+ * @param beams Mounting pose of each range sensor; ranges passed to Estimate() use the same order.
+ * @param numBeams Number of sensors, up to PF_MAX_BEAMS.
+ */
+StartPoseEstimator::StartPoseEstimator(const FieldMap &map, const RangeBeam beams[], int numBeams)
+    : map(map), numBeams(constrain(numBeams, 0, PF_MAX_BEAMS)), lastEstimateUs(0) {
+  for (int i = 0; i < this->numBeams; i++) {
+    this->beams[i] = beams[i];
+  }
+  Clear();
+}
+
+/**
+ * @brief Forgets the fit.
+ */
+void StartPoseEstimator::Clear() {
+  pose = Pose2D();
+  confidence = 0;
+  residual = 0;
+  inliers = 0;
+  fits = 0;
+}
+
+/**
+ * @brief Fits a pose to the ranges within the search window around the nominal start.
+ *  Takes a few hundred microseconds: a coarse grid of about 450 poses and a refinement of
+ * about 40, each costing one ray cast per range.
+ * @param ranges One range per beam in inches; negative or beyond PF_MAX_RANGE to skip a beam.
+ * @param nominal Where the robot is supposed to start.
+ * @return False, clearing the fit, if fewer than START_MIN_BEAMS ranges were given.
+ */
+bool StartPoseEstimator::Estimate(const float ranges[], const Pose2D &nominal) {
+  int given = 0;
+  for (int b = 0; b < numBeams; b++) {
+    if (ranges[b] >= 0 && ranges[b] <= PF_MAX_RANGE) given++;
+  }
+  if (given < START_MIN_BEAMS) {
+    Clear();
+    return false;
+  }
+  const uint32_t start = micros();
+
+  float bestX = nominal.getX();
+  float bestY = nominal.getY();
+  float bestTheta = nominal.getTheta();
+  float best = cost(ranges, bestX, bestY, bestTheta);
+  for (float dx = -START_SEARCH_XY; dx <= START_SEARCH_XY; dx += START_GRID_XY) {
+    for (float dy = -START_SEARCH_XY; dy <= START_SEARCH_XY; dy += START_GRID_XY) {
+      for (float dt = -START_SEARCH_THETA; dt <= START_SEARCH_THETA; dt += START_GRID_THETA) {
+        const float x = nominal.getX() + dx;
+        const float y = nominal.getY() + dy;
+        const float theta = nominal.getTheta() + dt;
+        const float c = cost(ranges, x, y, theta);
+        if (c < best) {
+          best = c;
+          bestX = x;
+          bestY = y;
+          bestTheta = theta;
+        }
+      }
+    }
+  }
+
+  float stepXY = 0.5f * START_GRID_XY;
+  float stepTheta = 0.5f * START_GRID_THETA;
+  for (int i = 0; i < START_REFINE_STEPS; i++) {
+    bool moved = true;
+    while (moved) {
+      moved = false;
+      const float candidates[6][3] = {{stepXY, 0, 0}, {-stepXY, 0, 0}, {0, stepXY, 0},
+                                      {0, -stepXY, 0}, {0, 0, stepTheta}, {0, 0, -stepTheta}};
+      for (const auto &d : candidates) {
+        const float c = cost(ranges, bestX + d[0], bestY + d[1], bestTheta + d[2]);
+        if (c < best) {
+          best = c;
+          bestX += d[0];
+          bestY += d[1];
+          bestTheta += d[2];
+          moved = true;
+        }
+      }
+    }
+    stepXY *= 0.5f;
+    stepTheta *= 0.5f;
+  }
+
+  float squares = 0;
+  cost(ranges, bestX, bestY, bestTheta, &inliers, &squares);
+  residual = inliers > 0 ? sqrtf(squares / inliers) : 0;
+  const float error = residual / START_RANGE_SIGMA;
+  confidence = inliers >= START_MIN_BEAMS
+                   ? static_cast<float>(inliers) / given * expf(-0.5f * error * error)
+                   : 0;
+  pose = Pose2D(bestX, bestY, bestTheta).fixTheta();
+  fits++;
+  lastEstimateUs = micros() - start;
+  return true;
+}
+
+/**
+ * @brief Scores a pose against the ranges.
+ * @param ranges One range per beam in inches; negative or beyond PF_MAX_RANGE to skip a beam.
+ * @param x Robot X in inches.
+ * @param y Robot Y in inches.
+ * @param theta Robot heading in radians.
+ * @param inliers If not null, receives the number of beams within START_INLIER_RANGE.
+ * @param squares If not null, receives the sum of squared inlier residuals.
+ * @return Sum of squared residuals, each capped at START_INLIER_RANGE squared. Off the field,
+ * every beam costs the cap.
+ */
+float StartPoseEstimator::cost(const float ranges[], float x, float y, float theta, int *inliers,
+                               float *squares) const {
+  const float cap = START_INLIER_RANGE * START_INLIER_RANGE;
+  const bool onField = map.Contains(x, y);
+  const float c = cosf(theta);
+  const float s = sinf(theta);
+  float total = 0;
+  int count = 0;
+  float inlierSquares = 0;
+  for (int b = 0; b < numBeams; b++) {
+    if (ranges[b] < 0 || ranges[b] > PF_MAX_RANGE) continue;
+    if (!onField) {
+      total += cap;
+      continue;
+    }
+    const RangeBeam &beam = beams[b];
+    const float originX = x + c * beam.x - s * beam.y;
+    const float originY = y + s * beam.x + c * beam.y;
+    const float angle = theta + beam.angle;
+    const float expected = map.RayCast(originX, originY, cosf(angle), sinf(angle), PF_MAX_RANGE);
+    const float error = ranges[b] - expected;
+    const float square = error * error;
+    if (square < cap) {
+      total += square;
+      inlierSquares += square;
+      count++;
+    } else {
+      total += cap;
+    }
+  }
+  if (inliers != nullptr) *inliers = count;
+  if (squares != nullptr) *squares = inlierSquares;
+  return total;
+}
+
+/**
+ * @brief Prints the search settings or the current fit.
+ * @param output Output stream for logging.
+ * @param printConfig If true, prints the search window; otherwise, prints the fit.
+ */
+void StartPoseEstimator::PrintInfo(Print &output, bool printConfig) const {
+  if (printConfig) {
+    output.print(F("StartPoseEstimator Configuration: +/-"));
+    output.print(START_SEARCH_XY);
+    output.print(F(" in, +/-"));
+    output.print(START_SEARCH_THETA);
+    output.print(F(" rad, "));
+    output.print(numBeams);
+    output.println(F(" beams"));
+    return;
+  }
+  output.print(F("Start pose: "));
+  if (!HasFit()) {
+    output.println(F("no fit"));
+    return;
+  }
+  output.print('(');
+  output.print(pose.getX());
+  output.print(F(", "));
+  output.print(pose.getY());
+  output.print(F(", "));
+  output.print(pose.getTheta());
+  output.print(F("), conf "));
+  output.print(confidence);
+  output.print(F(", rms "));
+  output.print(residual);
+  output.print(F(" in, inliers "));
+  output.print(inliers);
+  output.print(IsGood() ? F(", good, ") : F(", POOR, "));
+  output.print(lastEstimateUs);
+  output.println(F("us"));
+}
+
+/**
+ * @brief Overloaded stream operator for printing the current fit.
+ * @param output Output stream.
+ * @param estimator StartPoseEstimator instance.
+ * @return Modified output stream.
+ */
+Print &operator<<(Print &output, const StartPoseEstimator &estimator) {
+  estimator.PrintInfo(output, false);
+  return output;
+}
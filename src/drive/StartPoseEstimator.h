@@ -0,0 +1,73 @@
+/**
+ * @file StartPoseEstimator.h
+ * @author Aldem Pido
+ * @brief Defines the StartPoseEstimator class, which finds where the robot was placed from its
+ * range sensors.
+ * @ingroup drives
+ */
+
+#ifndef STARTPOSEESTIMATOR_H
+#define STARTPOSEESTIMATOR_H
+
+#include <Arduino.h>
+#include <Print.h>
+
+#include "ParticleLocalizer.h"  // For RangeBeam
+#include "math/FieldMap.h"
+#include "math/Pose2D.h"
+
+#define START_SEARCH_XY 6.0f        ///< Search half-width (in) around the nominal position.
+#define START_SEARCH_THETA 0.35f    ///< Search half-width (rad) around the nominal heading.
+#define START_GRID_XY 2.0f          ///< Coarse grid step (in).
+#define START_GRID_THETA 0.0873f    ///< Coarse grid step (rad), 5 degrees.
+#define START_REFINE_STEPS 6        ///< Halvings of the step in the local refinement.
+#define START_RANGE_SIGMA 0.5f      ///< Expected range error (in) of a good fit.
+#define START_INLIER_RANGE 2.0f     ///< Residuals (in) beyond this count as unexplained.
+#define START_MIN_BEAMS 3           ///< Ranges needed to fix x, y and heading.
+#define START_MIN_CONFIDENCE 0.5f   ///< Confidence at or above which the fit is good.
+
+/**
+ * @class StartPoseEstimator
+ * @ingroup drives
+ * @brief Fits the starting pose to a set of ranges by searching around the nominal start.
+ *  A coarse grid over position and heading picks the best-fitting cell, then a pattern search
+ * refines it with a halving step. The cost of a pose is the sum of squared range residuals, each
+ * capped at START_INLIER_RANGE so one blocked sensor cannot drag the fit. The confidence is the
+ * share of beams that are inliers times a Gaussian of their RMS residual, so it is near 1 for a
+ * clean fit and near 0 when the ranges do not match the map anywhere nearby.
+ */
+class StartPoseEstimator {
+ public:
+  StartPoseEstimator(const FieldMap &map, const RangeBeam beams[], int numBeams);
+
+  bool Estimate(const float ranges[], const Pose2D &nominal);
+  void Clear();
+
+  bool HasFit() const { return fits > 0; }
+  bool IsGood() const { return HasFit() && confidence >= START_MIN_CONFIDENCE; }
+  Pose2D GetPose() const { return pose; }
+  float GetConfidence() const { return confidence; }
+  float GetResidual() const { return residual; }
+  int GetInliers() const { return inliers; }
+  uint32_t GetLastEstimateUs() const { return lastEstimateUs; }
+
+  void PrintInfo(Print &output, bool printConfig = false) const;
+  friend Print &operator<<(Print &output, const StartPoseEstimator &estimator);
+
+ private:
+  const FieldMap &map;            ///< Walls the ranges are cast against.
+  RangeBeam beams[PF_MAX_BEAMS];  ///< Sensor mounting poses.
+  const int numBeams;             ///< Number of beams in use.
+
+  Pose2D pose;              ///< Best-fit pose.
+  float confidence;         ///< 0 to 1.
+  float residual;           ///< RMS residual (in) of the inlier beams.
+  int inliers;              ///< Beams within START_INLIER_RANGE of the map.
+  uint32_t fits;            ///< Successful estimates since Clear().
+  uint32_t lastEstimateUs;  ///< Duration of the last estimate.
+
+  float cost(const float ranges[], float x, float y, float theta, int *inliers = nullptr,
+             float *squares = nullptr) const;
+};
+
+#endif  // STARTPOSEESTIMATOR_H
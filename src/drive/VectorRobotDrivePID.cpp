@@ -25,7 +25,14 @@ class VectorRobotDrivePID : public VectorRobotDrive {
                       const PIDConfig &xConfig, const PIDConfig &yConfig,
                       const PIDConfig &thetaConfig);
 
-  void SetTarget(const Pose2D &targetPose) { this->targetPose = targetPose; }
+  void SetTarget(const Pose2D &targetPose) { targetInput.Write(targetPose); }
+  Pose2D GetTarget() const { return targetInput.Read(); }
+  void SetYawRate(float yawRate) { yawRateInput.Write(yawRate); }
+  float GetYawRate() const { return yawRateInput.Read(); }
+  void SetMinTimeStep(double seconds) { pidController.SetMinTimeStep(seconds); }
+  void Configure(const PIDConfig &xConfig, const PIDConfig &yConfig, const PIDConfig &thetaConfig) {
+    pidController.Configure(xConfig, yConfig, thetaConfig);
+  }
   Pose2D Step();
   void SetTargetByVelocity(const Pose2D &speedPose);
   void PrintInfo(Print &output, bool printConfig) const;
@@ -34,7 +41,8 @@ class VectorRobotDrivePID : public VectorRobotDrive {
 
  private:
   PIDDriveController pidController;  ///< PID controller for position correction
-  Pose2D targetPose;                 ///< Target position for the robot
+  DoubleBuffer<Pose2D> targetInput;  ///< Target position for the robot, read by Step()
+  DoubleBuffer<float> yawRateInput;  ///< Measured yaw rate in rad/s, or NAN to difference yaw
 };
 
 #endif  // VECTORROBOTDRIVEPID_H
@@ -13,8 +13,10 @@ VectorRobotDrivePID::VectorRobotDrivePID(const MotorSetup motorSetups[], int num
                                          Print &output, const PIDConfig &xConfig,
                                          const PIDConfig &yConfig, const PIDConfig &thetaConfig)
     : VectorRobotDrive(motorSetups, numMotors, output),
-      pidController(xConfig, yConfig, thetaConfig),
-      targetPose(0, 0, DRIVER_START_OFFSET) {}
+      pidController(xConfig, yConfig, thetaConfig) {
+  targetInput.Write(Pose2D(0, 0, DRIVER_START_OFFSET));
+  yawRateInput.Write(NAN);
+}
 
 /**
  * @brief Computes a new velocity target based on the current speed.
@@ -28,16 +30,24 @@ void VectorRobotDrivePID::SetTargetByVelocity(const Pose2D &speedPose) {
                          .multConstant(totTime)
                          .multConstant(0.7f);
 
+  Pose2D targetPose = targetInput.Read();
   targetPose.add(deltaPose).fixTheta();
+  targetInput.Write(targetPose);
   callTime = 0;  // Reset the timer after updating
 }
 
 /**
  * @brief Computes the correction using PID control to move towards the target pose.
+ *  If a measured yaw rate has been published with SetYawRate(), the heading controller uses it
+ * for its derivative term instead of differencing the yaw.
  * @return Pose2D containing the corrected movement.
  */
 Pose2D VectorRobotDrivePID::Step() {
-  return pidController.Step(localization.getPosition(), targetPose);
+  const float yawRate = yawRateInput.Read();
+  if (isnan(yawRate)) {
+    return pidController.Step(localization.getPosition(), targetInput.Read());
+  }
+  return pidController.Step(localization.getPosition(), targetInput.Read(), yawRate);
 }
 
 /**
@@ -63,9 +73,9 @@ void VectorRobotDrivePID::PrintInfo(Print &output, bool printConfig) const {
  * @param output Output stream for logging.
  */
 void VectorRobotDrivePID::PrintLocal(Print &output) const {
-  localization.PrintInfo(output);
+  SimpleRobotDrive::PrintLocal(output);
   output.print(F("Target Location "));
-  output << targetPose;
+  output << targetInput.Read();
 }
 
 /**
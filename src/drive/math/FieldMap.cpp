@@ -0,0 +1,142 @@
+/**
+ * @file FieldMap.cpp
+ * @author Aldem Pido
+ * @brief Implements the FieldMap class for ray casting range sensors against the field walls.
+ */
+#include "FieldMap.h"
+
+#include <Arduino.h>  // For Print, F()
+
+/**
+ * @brief Constructs an empty map.
+ */
+FieldMap::FieldMap() { Clear(); }
+
+/**
+ * @brief Removes every wall.
+ */
+void FieldMap::Clear() {
+  numWalls = 0;
+  minX = minY = 0;
+  maxX = maxY = 0;
+}
+
+/**
+ * @brief Adds a wall segment.
+ * @param x0 X of the first end, in inches.
+ * @param y0 Y of the first end, in inches.
+ * @param x1 X of the second end, in inches.
+ * @param y1 Y of the second end, in inches.
+ * @return False if the map is full.
+ */
+bool FieldMap::AddWall(float x0, float y0, float x1, float y1) {
+  if (numWalls >= FIELD_MAX_WALLS) {
+    return false;
+  }
+  walls[numWalls] = {x0, y0, x1, y1};
+  if (numWalls == 0) {
+    minX = maxX = x0;
+    minY = maxY = y0;
+  }
+  minX = min(minX, min(x0, x1));
+  minY = min(minY, min(y0, y1));
+  maxX = max(maxX, max(x0, x1));
+  maxY = max(maxY, max(y0, y1));
+  numWalls++;
+  return true;
+}
+
+/**
+ * @brief Adds the four walls of an axis-aligned rectangle.
+ * @param x0 Left edge, in inches.
+ * @param y0 Bottom edge, in inches.
+ * @param x1 Right edge, in inches.
+ * @param y1 Top edge, in inches.
+ * @return False if not all four walls fit.
+ */
+bool FieldMap::AddBox(float x0, float y0, float x1, float y1) {
+  return AddWall(x0, y0, x1, y0) && AddWall(x1, y0, x1, y1) && AddWall(x1, y1, x0, y1) &&
+         AddWall(x0, y1, x0, y0);
+}
+
+/**
+ * @brief Finds the nearest wall along a ray.
+ *  The direction is passed as its cosine and sine so callers casting many rays can reuse them.
+ * @param x Ray origin X, in inches.
+ * @param y Ray origin Y, in inches.
+ * @param cosAngle Cosine of the ray direction.
+ * @param sinAngle Sine of the ray direction.
+ * @param maxRange Distance returned when no wall is closer.
+ * @return Distance to the first wall hit, in inches, or maxRange.
+ */
+float FieldMap::RayCast(float x, float y, float cosAngle, float sinAngle, float maxRange) const {
+  float nearest = maxRange;
+  for (int i = 0; i < numWalls; i++) {
+    const FieldWall &wall = walls[i];
+    const float ex = wall.x1 - wall.x0;
+    const float ey = wall.y1 - wall.y0;
+    const float denom = cosAngle * ey - sinAngle * ex;  // Zero when the ray is parallel
+    if (fabsf(denom) < 1e-6f) continue;
+    const float wx = wall.x0 - x;
+    const float wy = wall.y0 - y;
+    const float t = (wx * ey - wy * ex) / denom;  // Distance along the ray
+    if (t < 0 || t >= nearest) continue;
+    const float u = (wx * sinAngle - wy * cosAngle) / denom;  // Position along the wall, 0 to 1
+    if (u < 0 || u > 1) continue;
+    nearest = t;
+  }
+  return nearest;
+}
+
+/**
+ * @brief Checks whether a point is inside the box around every wall.
+ * @param x X in inches.
+ * @param y Y in inches.
+ * @return True if the point could be on the field.
+ */
+bool FieldMap::Contains(float x, float y) const {
+  return numWalls > 0 && x >= minX && x <= maxX && y >= minY && y <= maxY;
+}
+
+/**
+ * @brief Prints the walls or a summary.
+ * @param output Output stream for logging.
+ * @param printConfig If true, prints every wall; otherwise, prints the wall count and bounds.
+ */
+void FieldMap::PrintInfo(Print &output, bool printConfig) const {
+  output.print(F("FieldMap: "));
+  output.print(numWalls);
+  output.print(F(" walls, ("));
+  output.print(minX);
+  output.print(F(", "));
+  output.print(minY);
+  output.print(F(") to ("));
+  output.print(maxX);
+  output.print(F(", "));
+  output.print(maxY);
+  output.println(')');
+  if (!printConfig) return;
+  for (int i = 0; i < numWalls; i++) {
+    const FieldWall &wall = walls[i];
+    output.print(F("  ("));
+    output.print(wall.x0);
+    output.print(F(", "));
+    output.print(wall.y0);
+    output.print(F(") - ("));
+    output.print(wall.x1);
+    output.print(F(", "));
+    output.print(wall.y1);
+    output.println(')');
+  }
+}
+
+/**
+ * @brief Overloaded stream operator for printing the map summary.
+ * @param output Output stream.
+ * @param map FieldMap instance.
+ * @return Modified output stream.
+ */
+Print &operator<<(Print &output, const FieldMap &map) {
+  map.PrintInfo(output, false);
+  return output;
+}
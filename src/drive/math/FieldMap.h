@@ -0,0 +1,60 @@
+/**
+ * @file FieldMap.h
+ * @author Aldem Pido
+ * @brief Defines the FieldMap class, a list of wall segments that range sensors can be ray cast
+ * against.
+ * @ingroup drives
+ */
+
+#ifndef FIELDMAP_H
+#define FIELDMAP_H
+
+#include <Arduino.h>
+#include <Print.h>
+
+#define FIELD_MAX_WALLS 16  ///< Maximum number of wall segments.
+
+/**
+ * @struct FieldWall
+ * @ingroup drives
+ * @brief One straight wall, in field inches.
+ */
+struct FieldWall {
+  float x0, y0;  ///< First end.
+  float x1, y1;  ///< Second end.
+};
+
+/**
+ * @class FieldMap
+ * @ingroup drives
+ * @brief Known walls of the field, in the same inches and axes as the drive's pose.
+ *  RayCast() returns the distance along a ray to the nearest wall it hits, which is what a range
+ * sensor at that pose should read. A ray hits either face of a wall. The map is filled once at
+ * setup and never allocates.
+ */
+class FieldMap {
+ public:
+  FieldMap();
+
+  bool AddWall(float x0, float y0, float x1, float y1);
+  bool AddBox(float x0, float y0, float x1, float y1);
+  void Clear();
+
+  float RayCast(float x, float y, float cosAngle, float sinAngle, float maxRange) const;
+  bool Contains(float x, float y) const;
+
+  int GetWallCount() const { return numWalls; }
+  const FieldWall &GetWall(int index) const { return walls[index]; }
+
+  void PrintInfo(Print &output, bool printConfig = false) const;
+  friend Print &operator<<(Print &output, const FieldMap &map);
+
+ private:
+  FieldWall walls[FIELD_MAX_WALLS];  ///< Wall segments.
+  int numWalls;                      ///< Number of walls in use.
+
+  float minX, minY;  ///< Lower corner of the box around every wall.
+  float maxX, maxY;  ///< Upper corner of the box around every wall.
+};
+
+#endif  // FIELDMAP_H
@@ -40,6 +40,13 @@ std::vector<Pose2D> jostleBeacon = {
 
 };
 
+std::vector<Pose2D> beaconPullout = {
+    Pose2D(BEACONX + 10, BEACONY, NORTH),  // slide beacon out
+    Pose2D(BEACONX + 5, MAXY - 3, NORTH),     Pose2D(BEACONX + 5, MAXY - 13, NORTH),
+    Pose2D(BEACONX - 1, MAXY - 13, NORTH),    Pose2D(BEACONX - 1, MAXY - 3, NORTH),
+    Pose2D(BEACONX + 5, BEACONY - 4, NORTH),
+};
+
 // Open geod servo
 
 std::vector<Pose2D> positionGeoCSC = {
@@ -159,6 +166,44 @@ std::vector<Pose2D> mainSweep = {
     Pose2D(MAINSWEEPLEFTX + 3, 6 * 7, EAST), Pose2D(LEFTCAVEWALLX - 3, 6 * 7, EAST),
     Pose2D(MAINSWEEPLEFTX + 3, 6 * 7, EAST),
 };
+
+std::vector<Pose2D> cscPickup = {
+    Pose2D(70, BEACONY - 4, NORTH), Pose2D(50, BEACONY - 4, NORTH), Pose2D(37, MAXY - 6, NORTH),
+    Pose2D(10, MAXY - 6, NORTH),    Pose2D(30, MAXY - 22, NORTH),   Pose2D(30, MAXY - 22, EAST),
+    Pose2D(30, MAXY - 2, EAST),     Pose2D(2, MAXY - 2, EAST),
+};
+
+// Set to (12, MAXY - 6, EAST), dump transfer
+
+// Sweeps out from the deposit corner and back, each one lane further south
+std::vector<Pose2D> depositSweep1 = {
+    Pose2D(12, MAXY - 6, EAST), Pose2D(50, MAXY - 8, EAST), Pose2D(12, MAXY - 8, EAST),
+    Pose2D(18, MAXY - 3, EAST), Pose2D(10, MAXY - 3, EAST),
+};
+
+std::vector<Pose2D> depositSweep2 = {
+    Pose2D(12, MAXY - 12, EAST), Pose2D(50, MAXY - 12, EAST), Pose2D(12, MAXY - 12, EAST),
+    Pose2D(18, MAXY - 3, EAST),  Pose2D(10, MAXY - 3, EAST),
+};
+
+std::vector<Pose2D> depositSweep3 = {
+    Pose2D(12, MAXY - 18, EAST), Pose2D(50, MAXY - 18, EAST), Pose2D(12, MAXY - 18, EAST),
+    Pose2D(18, MAXY - 3, EAST),  Pose2D(10, MAXY - 3, EAST),
+};
+
+std::vector<Pose2D> depositSweep4 = {
+    Pose2D(12, MAXY - 24, EAST), Pose2D(40, MAXY - 24, EAST), Pose2D(12, MAXY - 24, EAST),
+    Pose2D(18, MAXY - 3, EAST),  Pose2D(10, MAXY - 3, EAST),
+};
+
+std::vector<Pose2D> depositSweep5 = {
+    Pose2D(12, MAXY - 30, EAST), Pose2D(50, MAXY - 30, EAST), Pose2D(12, MAXY - 30, EAST),
+    Pose2D(18, MAXY - 3, EAST),  Pose2D(10, MAXY - 3, EAST),
+};
+
+std::vector<Pose2D> returnToStart = {
+    Pose2D(31.5, 6, NORTH),
+};
 };  // namespace HardBox
 
 namespace Paths {
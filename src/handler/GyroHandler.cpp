@@ -1,39 +1,103 @@
 #include "GyroHandler.h"
 
+#include "../util/Logger.h"
+
 /**
  * @brief Constructs a GyroHandler object.
  */
-GyroHandler::GyroHandler() : bno08x(Adafruit_BNO08x(-1)), Gametime_Offset(0) {}
+GyroHandler::GyroHandler()
+    : bno08x(Adafruit_BNO08x(-1)),
+      Gametime_Offset(0),
+      ready(false),
+      sampleCount(0),
+      yawRate(0),
+      yawRateTimeUs(0),
+      moving(false),
+      stationary(false),
+      stillSinceUs(0),
+      rateMean(0),
+      rateVariance(0),
+      rateBias(0),
+      driftRate(0),
+      yawCorrection(0),
+      prevRawYaw(0),
+      prevRawYawUs(0) {}
 
 /**
  * @brief Initializes the BNO08x gyro sensor.
+ *  May be called again after a failure to retry.
  * @return True if initialization succeeds, false otherwise.
  */
 bool GyroHandler::Begin() {
   if (!bno08x.begin_I2C(0x4B)) {
-    Serial.println("Failed to find BNO08x chip");
+    LOG_ERROR("Failed to find BNO08x chip");
     return false;
   }
-  Serial.println("BNO08x Found!");
-  if (!bno08x.enableReport(SH2_GAME_ROTATION_VECTOR)) {
-    Serial.println(F("Could not enable rotation vector"));
+  LOG_INFO("BNO08x Found!");
+  if (!enableReports()) {
     return false;
   }
+  ready = true;
   return true;
 }
 
 /**
- * @brief Reads and updates gyro sensor data.
+ * @brief Requests the reports GyroHandler parses at their native rates.
+ *  Needed again after the hub resets, which clears its report configuration.
+ * @return True if every report was enabled.
+ */
+bool GyroHandler::enableReports() {
+  if (!bno08x.enableReport(SH2_GAME_ROTATION_VECTOR, GYRO_REPORT_INTERVAL_US)) {
+    LOG_ERROR(F("Could not enable rotation vector"));
+    return false;
+  }
+  if (!bno08x.enableReport(SH2_GYROSCOPE_CALIBRATED, GYRO_REPORT_INTERVAL_US)) {
+    LOG_ERROR(F("Could not enable calibrated gyroscope"));
+    return false;
+  }
+  return true;
+}
+
+/**
+ * @brief Reads every queued report, up to GYRO_MAX_EVENTS_PER_UPDATE.
+ *  Reports are stored in the sample buffer in the order the hub sent them. Each is stamped with
+ * micros() as it is read rather than with the SH-2 timestamp, which the Adafruit HAL takes from
+ * millis() and so only has 1 ms steps against the 5 ms report period. Read this way, a report is
+ * late by at most one call period plus its transfer.
  */
 void GyroHandler::Update() {
-  if (!bno08x.getSensorEvent(&sensorValue)) {
+  if (!ready) {
+    return;
+  }
+  if (bno08x.wasReset()) {
+    LOG_WARN("BNO08x reset, enabling reports");
+    enableReports();
+  }
+  for (int i = 0; i < GYRO_MAX_EVENTS_PER_UPDATE && bno08x.getSensorEvent(&sensorValue); i++) {
+    handleEvent(sensorValue, micros());
+  }
+}
+
+/**
+ * @brief Converts one report and stores it.
+ * @param value Report read from the hub.
+ * @param timeUs micros() at which the report was read.
+ */
+void GyroHandler::handleEvent(const sh2_SensorValue_t &value, uint32_t timeUs) {
+  if (value.sensorId == SH2_GYROSCOPE_CALIBRATED) {
+    yawRate = value.un.gyroscope.z;
+    yawRateTimeUs = timeUs;
+    updateRateStats(yawRate, yawRateTimeUs);
+    return;
+  }
+  if (value.sensorId != SH2_GAME_ROTATION_VECTOR) {
     return;
   }
 
-  float qr = sensorValue.un.rotationVector.real;
-  float qi = sensorValue.un.rotationVector.i;
-  float qj = sensorValue.un.rotationVector.j;
-  float qk = sensorValue.un.rotationVector.k;
+  float qr = value.un.gameRotationVector.real;
+  float qi = value.un.gameRotationVector.i;
+  float qj = value.un.gameRotationVector.j;
+  float qk = value.un.gameRotationVector.k;
 
   float sqr = sq(qr);
   float sqi = sq(qi);
@@ -44,6 +108,7 @@ void GyroHandler::Update() {
   float pitch = asin(-2.0 * (qi * qk - qj * qr) / (sqi + sqj + sqk + sqr));
   float roll = atan2(2.0 * (qj * qk + qi * qr), (-sqi - sqj + sqk + sqr));
 
+  yaw -= correctDrift(yaw, timeUs);
   yaw += (BEGIN_OFFSET * PI / 180) - Gametime_Offset;
   while (yaw > PI) yaw -= 2 * PI;
   while (yaw < -PI) yaw += 2 * PI;
@@ -51,6 +116,89 @@ void GyroHandler::Update() {
   gyroData[0] = yaw;
   gyroData[1] = pitch;
   gyroData[2] = roll;
+
+  GyroSample sample;
+  sample.timeUs = timeUs;
+  sample.yaw = yaw;
+  sample.pitch = pitch;
+  sample.roll = roll;
+  sample.yawRate = yawRate - rateBias;
+  if (samples.Full()) {
+    GyroSample oldest;
+    samples.Pop(oldest);
+  }
+  samples.Push(sample);
+  sampleCount++;
+}
+
+/**
+ * @brief Sets whether the encoders show the robot moving.
+ *  Motion ends stationary mode at once; rest only counts once the yaw rate is quiet as well.
+ * @param moving True if any wheel turned since the last call.
+ */
+void GyroHandler::SetMoving(bool moving) {
+  this->moving = moving;
+  if (moving) {
+    stationary = false;
+    stillSinceUs = 0;
+  }
+}
+
+/**
+ * @brief Tracks the yaw rate statistics and learns the rate bias while stationary.
+ * @param rate Calibrated yaw rate in rad/s.
+ * @param timeUs micros() at which the rate was measured.
+ */
+void GyroHandler::updateRateStats(float rate, uint32_t timeUs) {
+  const float deviation = rate - rateMean;
+  rateMean += GYRO_RATE_STATS_ALPHA * deviation;
+  rateVariance = (1 - GYRO_RATE_STATS_ALPHA) *
+                 (rateVariance + GYRO_RATE_STATS_ALPHA * deviation * deviation);
+
+  const bool quiet = rateVariance < sq(GYRO_STILL_RATE_STDDEV) &&
+                     fabsf(rateMean - rateBias) < GYRO_STILL_RATE;
+  if (moving || !quiet) {
+    stationary = false;
+    stillSinceUs = 0;
+    return;
+  }
+  if (stillSinceUs == 0) {
+    stillSinceUs = timeUs ? timeUs : 1;
+  }
+  if (!stationary && timeUs - stillSinceUs >= GYRO_STILL_TIME_US) {
+    stationary = true;
+  }
+  if (stationary) {
+    rateBias += GYRO_BIAS_ALPHA * (rate - rateBias);
+  }
+}
+
+/**
+ * @brief Updates the drift estimate and returns the total correction to subtract from yaw.
+ *  While stationary, any change in yaw is drift: it is removed in full and used to learn the
+ * drift rate. While moving, the learned drift rate is removed instead.
+ * @param rawYaw Quaternion yaw in radians, before offsets.
+ * @param timeUs micros() at which the yaw was measured.
+ * @return Accumulated correction in radians, -PI to PI.
+ */
+float GyroHandler::correctDrift(float rawYaw, uint32_t timeUs) {
+  if (prevRawYawUs != 0) {
+    const float dt = (timeUs - prevRawYawUs) * 1e-6f;
+    float delta = rawYaw - prevRawYaw;
+    if (delta > PI) delta -= 2 * PI;
+    if (delta < -PI) delta += 2 * PI;
+    if (stationary && dt > 0) {
+      driftRate += GYRO_BIAS_ALPHA * (delta / dt - driftRate);
+      yawCorrection += delta;
+    } else {
+      yawCorrection += driftRate * dt;
+    }
+    if (yawCorrection > PI) yawCorrection -= 2 * PI;
+    if (yawCorrection < -PI) yawCorrection += 2 * PI;
+  }
+  prevRawYaw = rawYaw;
+  prevRawYawUs = timeUs ? timeUs : 1;
+  return yawCorrection;
 }
 
 /**
@@ -59,6 +207,70 @@ void GyroHandler::Update() {
  */
 float *GyroHandler::GetGyroData() { return gyroData; }
 
+/**
+ * @brief Gets the newest stored sample.
+ * @param sample Set to the newest sample.
+ * @return False if no report has been received yet.
+ */
+bool GyroHandler::GetLatestSample(GyroSample &sample) const {
+  if (samples.Empty()) return false;
+  sample = samples.PeekNewest();
+  return true;
+}
+
+/**
+ * @brief Gets the latest calibrated yaw rate, less the bias learned while stationary.
+ *  The rate is measured directly by the gyroscope, so it needs no differencing or filtering.
+ * @param rate Set to the yaw rate in rad/s, counterclockwise positive like yaw.
+ * @param timeUs Set to micros() at which the rate was measured.
+ * @return False if no rate report has arrived within GYRO_RATE_TIMEOUT_US.
+ */
+bool GyroHandler::GetYawRate(float &rate, uint32_t &timeUs) const {
+  if (yawRateTimeUs == 0 || static_cast<int32_t>(micros() - yawRateTimeUs) > GYRO_RATE_TIMEOUT_US) {
+    return false;
+  }
+  rate = yawRate - rateBias;
+  timeUs = yawRateTimeUs;
+  return true;
+}
+
+/**
+ * @brief Gets the orientation at a point in time.
+ *  Interpolates between the two samples around timeUs, taking the shorter way around for yaw.
+ * A time after the newest sample returns the newest sample unchanged.
+ * @param timeUs micros() of the moment of interest.
+ * @param sample Set to the interpolated orientation, with timeUs set to the requested time.
+ * @return False if no samples are stored or timeUs is older than the oldest stored sample.
+ */
+bool GyroHandler::GetSampleAt(uint32_t timeUs, GyroSample &sample) const {
+  if (samples.Empty()) return false;
+  const GyroSample &newest = samples.PeekNewest();
+  if (static_cast<int32_t>(timeUs - newest.timeUs) >= 0) {
+    sample = newest;
+    return true;
+  }
+  for (size_t age = 1; age < samples.Size(); age++) {
+    const GyroSample &before = samples.PeekNewest(age);
+    if (static_cast<int32_t>(timeUs - before.timeUs) < 0) continue;
+    const GyroSample &after = samples.PeekNewest(age - 1);
+    const float span = static_cast<float>(after.timeUs - before.timeUs);
+    const float t = span > 0 ? (timeUs - before.timeUs) / span : 0;
+    float deltaYaw = after.yaw - before.yaw;
+    if (deltaYaw > PI) deltaYaw -= 2 * PI;
+    if (deltaYaw < -PI) deltaYaw += 2 * PI;
+    float yaw = before.yaw + t * deltaYaw;
+    if (yaw > PI) yaw -= 2 * PI;
+    if (yaw < -PI) yaw += 2 * PI;
+    sample.timeUs = timeUs;
+    sample.yaw = yaw;
+    sample.pitch = before.pitch + t * (after.pitch - before.pitch);
+    sample.roll = before.roll + t * (after.roll - before.roll);
+    sample.yawRate = before.yawRate + t * (after.yawRate - before.yawRate);
+    return true;
+  }
+  return false;
+}
+
 /**
  * @brief Prints gyro configuration or current sensor readings.
  * @param output Output stream for logging.
@@ -68,6 +280,12 @@ void GyroHandler::PrintInfo(Print &output, bool printConfig) const {
   if (printConfig) {
     output.println(F("BNO08x Configuration:"));
     output.println(F("I2C Address: 0x55"));
+    output.print(F("Report interval: "));
+    output.print(GYRO_REPORT_INTERVAL_US);
+    output.println(F(" us"));
+    output.print(F("Stationary after: "));
+    output.print(GYRO_STILL_TIME_US);
+    output.println(F(" us"));
   } else {
     output.println(F("Gyro Data:"));
     output.print(F("Yaw: "));
@@ -76,6 +294,18 @@ void GyroHandler::PrintInfo(Print &output, bool printConfig) const {
     output.println(gyroData[1]);
     output.print(F("Roll: "));
     output.println(gyroData[2]);
+    output.print(F("Samples: "));
+    output.println(sampleCount);
+    output.print(F("Yaw Rate: "));
+    output.println(yawRate - rateBias);
+    output.print(F("Stationary: "));
+    output.println(stationary ? F("yes") : F("no"));
+    output.print(F("Drift Rate: "));
+    output.println(driftRate, 5);
+    output.print(F("Yaw Correction: "));
+    output.println(yawCorrection, 4);
+    output.print(F("Rate Bias: "));
+    output.println(rateBias, 5);
   }
 }
 
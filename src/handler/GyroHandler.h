@@ -14,25 +14,93 @@
 #include <Adafruit_BNO08x.h>
 #include <Wire.h>
 
+#include "../util/RingBuffer.h"
+
+#define GYRO_REPORT_INTERVAL_US 5000   ///< Requested report period for both reports (200 Hz).
+#define GYRO_SAMPLE_BUFFER 32          ///< Timestamped samples kept for GetSampleAt().
+#define GYRO_MAX_EVENTS_PER_UPDATE 8   ///< Bounds the time one Update() spends draining the hub.
+#define GYRO_RATE_TIMEOUT_US 20000     ///< Age after which GetYawRate() reports no rate.
+#define GYRO_STILL_TIME_US 300000      ///< Time at rest before the robot is treated as stationary.
+#define GYRO_STILL_RATE 0.02f          ///< Largest debiased mean yaw rate at rest, rad/s.
+#define GYRO_STILL_RATE_STDDEV 0.005f  ///< Largest yaw rate standard deviation at rest, rad/s.
+#define GYRO_RATE_STATS_ALPHA 0.05f    ///< EMA weight of the rate mean and variance per report.
+#define GYRO_BIAS_ALPHA 0.01f          ///< EMA weight of the bias and drift per stationary report.
+
+/**
+ * @struct GyroSample
+ * @ingroup sensors
+ * @brief One orientation report with the time it was measured.
+ */
+struct GyroSample {
+  uint32_t timeUs = 0;  ///< micros() at which the report was read from the hub.
+  float yaw = 0;        ///< Offset yaw in radians, -PI to PI.
+  float pitch = 0;      ///< Pitch in radians.
+  float roll = 0;       ///< Roll in radians.
+  float yawRate = 0;    ///< Latest calibrated yaw rate in rad/s, counterclockwise positive.
+};
+
 /**
  * @class GyroHandler
  * @ingroup sensors
  * @brief Reads gyro sensor data using the BNO08x sensor.
+ *  Update() drains every report the hub has queued instead of taking one and dropping the rest,
+ * so it should be called at least as often as GYRO_REPORT_INTERVAL_US. Each report is stored
+ * with the time it was read, so consumers can ask for the orientation at the time
+ * their own data was sampled rather than using a reading of unknown age. The calibrated gyroscope
+ * report is parsed alongside the game rotation vector to give a measured yaw rate, which is
+ * cleaner and has less lag than differencing yaw.
+ *
+ *  While the robot is stationary, which needs both SetMoving(false) from the encoders and a quiet
+ * yaw rate for GYRO_STILL_TIME_US, yaw is held still and its drift rate and the gyroscope bias are
+ * learned. Once moving, the learned drift rate keeps being removed from yaw and the bias from the
+ * yaw rate, so heading does not creep while waiting for the start or over a long match.
  */
 class GyroHandler {
  public:
   GyroHandler();
   bool Begin();
+  bool IsReady() const { return ready; }
   void Update();
   void PrintInfo(Print &output, bool printConfig = false) const;
   void Set_Gametime_Offset(float angleRad) { Gametime_Offset = angleRad - BEGIN_OFFSET * PI / 180; }
   float *GetGyroData();
+  bool GetLatestSample(GyroSample &sample) const;
+  bool GetSampleAt(uint32_t timeUs, GyroSample &sample) const;
+  uint32_t GetSampleCount() const { return sampleCount; }
+  bool GetYawRate(float &rate, uint32_t &timeUs) const;
+  void SetMoving(bool moving);
+  bool IsStationary() const { return stationary; }
+  float GetDriftRate() const { return driftRate; }
+  float GetYawCorrection() const { return yawCorrection; }
+  float GetRateBias() const { return rateBias; }
 
  private:
   Adafruit_BNO08x bno08x;         ///< BNO08x gyro sensor instance
   sh2_SensorValue_t sensorValue;  ///< Stores sensor event data
   float gyroData[3];              ///< Array containing yaw, pitch, and roll values
   float Gametime_Offset;          ///< Offset for angle adjustments
+  bool ready;                     ///< Set once Begin() succeeds; Update() is skipped until then
+
+  RingBuffer<GyroSample, GYRO_SAMPLE_BUFFER> samples;  ///< Recent samples, oldest first
+  uint32_t sampleCount;                                ///< Orientation reports received
+  float yawRate;                                       ///< Latest calibrated z rate in rad/s
+  uint32_t yawRateTimeUs;                              ///< micros() of the latest rate report
+
+  bool moving;            ///< Encoder motion hint from SetMoving()
+  bool stationary;        ///< Set after GYRO_STILL_TIME_US of rest
+  uint32_t stillSinceUs;  ///< micros() at which the current rest began, 0 if not at rest
+  float rateMean;         ///< EMA of the raw yaw rate in rad/s
+  float rateVariance;     ///< EMA of the squared deviation from rateMean
+  float rateBias;         ///< Yaw rate measured at rest in rad/s
+  float driftRate;        ///< Yaw drift measured at rest in rad/s
+  float yawCorrection;    ///< Drift removed from yaw so far in radians
+  float prevRawYaw;       ///< Quaternion yaw of the previous report, before offsets
+  uint32_t prevRawYawUs;  ///< Timestamp of prevRawYaw, 0 before the first report
+
+  bool enableReports();
+  void handleEvent(const sh2_SensorValue_t &value, uint32_t timeUs);
+  void updateRateStats(float rate, uint32_t timeUs);
+  float correctDrift(float rawYaw, uint32_t timeUs);
 };
 
 // Overloaded stream operator for printing gyro information
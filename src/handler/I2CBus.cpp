@@ -0,0 +1,324 @@
+/**
+ * @file I2CBus.cpp
+ * @author Aldem Pido
+ * @brief Implements the I2CBus class for shared, mux-aware I2C access.
+ */
+#include "I2CBus.h"
+
+#include <Arduino.h>  // For micros(), Print, F()
+
+/**
+ * @brief Constructs an I2CBus with an empty queue.
+ *  The mux selection is unknown until the first Select().
+ * @param wire Bus the multiplexer and its devices are on. Must already be started.
+ * @param sdaPin SDA pin of the bus, for bus clears.
+ * @param sclPin SCL pin of the bus, for bus clears.
+ * @param clockHz Bus clock, restored after a bus clear.
+ * @param muxAddress I2C address of the TCA9548A.
+ */
+I2CBus::I2CBus(TwoWire &wire, uint8_t sdaPin, uint8_t sclPin, uint32_t clockHz,
+               uint8_t muxAddress)
+    : wire(wire),
+      sdaPin(sdaPin),
+      sclPin(sclPin),
+      clockHz(clockHz),
+      muxAddress(muxAddress),
+      selectedChannel(I2C_NO_CHANNEL),
+      queueLength(0),
+      numStats(0),
+      muxWrites(0),
+      muxSkips(0),
+      muxErrors(0),
+      dropped(0),
+      busUp(true),
+      recoveryWanted(false),
+      consecutiveErrors(0),
+      recoveries(0),
+      lastRecoveryUs(0) {}
+
+/**
+ * @brief Routes the bus to a mux channel.
+ *  Nothing is written if the channel is already selected. I2C_NO_CHANNEL is for devices wired
+ * before the mux, which are reachable whatever the mux has selected.
+ * @param channel Mux channel, 0 to I2C_MUX_CHANNELS-1, or I2C_NO_CHANNEL.
+ * @return False if the mux did not acknowledge the select or the channel is invalid.
+ */
+bool I2CBus::Select(uint8_t channel) {
+  if (channel == I2C_NO_CHANNEL) {
+    return true;
+  }
+  if (channel >= I2C_MUX_CHANNELS) {
+    return false;
+  }
+  if (channel == selectedChannel) {
+    muxSkips++;
+    return true;
+  }
+  muxWrites++;
+  wire.beginTransmission(muxAddress);
+  wire.write(1 << channel);
+  if (wire.endTransmission() != 0) {
+    muxErrors++;
+    selectedChannel = I2C_NO_CHANNEL;  // The mux state is unknown now
+    return false;
+  }
+  selectedChannel = channel;
+  return true;
+}
+
+/**
+ * @brief Queues a transaction for the next Update().
+ *  A transaction already queued with the same function, context and argument is not queued
+ * twice, so a handler that polls faster than the bus is serviced does not flood the queue.
+ * Transactions must not call Submit() themselves.
+ * @param channel Mux channel of the device, or I2C_NO_CHANNEL.
+ * @param name Statistics name. Must outlive the bus.
+ * @param transaction Function that performs the transfer.
+ * @param context First argument passed to the transaction, usually the handler.
+ * @param arg Second argument passed to the transaction, usually a device index.
+ * @return False if the queue is full.
+ */
+bool I2CBus::Submit(uint8_t channel, const char *name, I2CTransaction transaction, void *context,
+                    uint8_t arg) {
+  for (int i = 0; i < queueLength; i++) {
+    const Job &job = queue[i];
+    if (job.transaction == transaction && job.context == context && job.arg == arg) {
+      return true;
+    }
+  }
+  if (queueLength >= I2C_QUEUE_SIZE) {
+    dropped++;
+    return false;
+  }
+  Job &job = queue[queueLength++];
+  job.channel = channel;
+  job.name = name;
+  job.transaction = transaction;
+  job.context = context;
+  job.arg = arg;
+  return true;
+}
+
+/**
+ * @brief Runs a transaction immediately, ahead of anything queued.
+ * @param channel Mux channel of the device, or I2C_NO_CHANNEL.
+ * @param name Statistics name. Must outlive the bus.
+ * @param transaction Function that performs the transfer.
+ * @param context First argument passed to the transaction.
+ * @param arg Second argument passed to the transaction.
+ * @return The transaction's result, or false if the channel could not be selected.
+ */
+bool I2CBus::Run(uint8_t channel, const char *name, I2CTransaction transaction, void *context,
+                 uint8_t arg) {
+  Job job;
+  job.channel = channel;
+  job.name = name;
+  job.transaction = transaction;
+  job.context = context;
+  job.arg = arg;
+  return execute(job);
+}
+
+/**
+ * @brief Runs every queued transaction.
+ *  Transactions on the selected channel run first, then each remaining channel in the order its
+ * oldest transaction was queued. Order is kept within a channel. The budget is checked before
+ * each transaction: once I2C_UPDATE_BUDGET_US has passed, the rest of the queue waits for the next
+ * call, so only the transaction already running can overrun it. Clears the bus first if failures
+ * asked for it, and drops the queue while the bus is down.
+ * @return Number of transactions run.
+ */
+int I2CBus::Update() {
+  if ((recoveryWanted || !busUp) && micros() - lastRecoveryUs >= I2C_RECOVERY_INTERVAL_US) {
+    Recover();
+  }
+  if (!busUp) {
+    dropped += queueLength;
+    queueLength = 0;
+    return 0;
+  }
+  const uint32_t start = micros();
+  int ran = 0;
+  bool inBudget = true;
+  while (queueLength > 0 && inBudget) {
+    uint8_t channel = queue[0].channel;
+    for (int i = 0; i < queueLength; i++) {
+      if (queue[i].channel == selectedChannel) {
+        channel = selectedChannel;
+        break;
+      }
+    }
+    int kept = 0;
+    for (int i = 0; i < queueLength; i++) {
+      if (queue[i].channel == channel && inBudget) {
+        execute(queue[i]);
+        ran++;
+        inBudget = micros() - start < I2C_UPDATE_BUDGET_US;
+      } else {
+        queue[kept++] = queue[i];
+      }
+    }
+    queueLength = kept;
+  }
+  return ran;
+}
+
+/**
+ * @brief Selects a transaction's channel, runs it and records its time and result.
+ * @param job Transaction to run.
+ * @return False if the select or the transaction failed.
+ */
+bool I2CBus::execute(const Job &job) {
+  I2CStats *stat = findStats(job.name);
+  const uint32_t start = micros();
+  const bool selected = Select(job.channel);
+  const bool ok = selected && job.transaction(job.context, job.arg);
+  const uint32_t elapsed = micros() - start;
+  if (ok) {
+    consecutiveErrors = 0;
+  } else {
+    Invalidate();  // A failed transfer may have left the mux in an unknown state
+    if (!selected || ++consecutiveErrors >= I2C_RECOVER_AFTER_ERRORS) {
+      recoveryWanted = true;
+    }
+  }
+  if (stat != nullptr) {
+    stat->count++;
+    if (!ok) stat->errors++;
+    if (elapsed > I2C_SLOW_TRANSACTION_US) stat->slow++;
+    stat->lastUs = elapsed;
+    if (elapsed > stat->maxUs) stat->maxUs = elapsed;
+    stat->totalUs += elapsed;
+  }
+  return ok;
+}
+
+/**
+ * @brief Frees a bus held by a slave stuck mid-transfer, then restarts Wire.
+ *  Takes the pins from Wire, clocks SCL up to I2C_CLEAR_PULSES times until SDA is released, and
+ * sends a STOP. Takes about 100 us. The mux selection is forgotten, since a reset mux or a glitched
+ * select may have changed it.
+ * @return True if SDA is high afterwards, which also marks the bus up again.
+ */
+bool I2CBus::Recover() {
+  recoveries++;
+  lastRecoveryUs = micros();
+  recoveryWanted = false;
+  consecutiveErrors = 0;
+  Invalidate();
+
+  wire.end();
+  pinMode(sdaPin, INPUT_PULLUP);
+  pinMode(sclPin, OUTPUT_OPENDRAIN);
+  digitalWrite(sclPin, HIGH);
+  delayMicroseconds(5);
+  for (int i = 0; i < I2C_CLEAR_PULSES && digitalRead(sdaPin) == LOW; i++) {
+    digitalWrite(sclPin, LOW);
+    delayMicroseconds(5);
+    digitalWrite(sclPin, HIGH);
+    delayMicroseconds(5);
+  }
+  // STOP: SDA rises while SCL is high
+  pinMode(sdaPin, OUTPUT_OPENDRAIN);
+  digitalWrite(sdaPin, LOW);
+  delayMicroseconds(5);
+  digitalWrite(sdaPin, HIGH);
+  delayMicroseconds(5);
+  pinMode(sdaPin, INPUT_PULLUP);
+  busUp = digitalRead(sdaPin) == HIGH;
+
+  wire.begin();
+  wire.setClock(clockHz);
+  return busUp;
+}
+
+/**
+ * @brief Finds the counters for a name, adding them if there is room.
+ * @param name Statistics name, compared by pointer and then by content.
+ * @return The counters, or nullptr if the table is full.
+ */
+I2CStats *I2CBus::findStats(const char *name) {
+  for (int i = 0; i < numStats; i++) {
+    if (stats[i].name == name || strcmp(stats[i].name, name) == 0) {
+      return &stats[i];
+    }
+  }
+  if (numStats >= I2C_MAX_STATS) {
+    return nullptr;
+  }
+  stats[numStats].name = name;
+  return &stats[numStats++];
+}
+
+/**
+ * @brief Clears all counters, keeping the registered names.
+ */
+void I2CBus::ResetStats() {
+  for (int i = 0; i < numStats; i++) {
+    const char *name = stats[i].name;
+    stats[i] = I2CStats();
+    stats[i].name = name;
+  }
+  muxWrites = 0;
+  muxSkips = 0;
+  muxErrors = 0;
+  dropped = 0;
+  recoveries = 0;
+}
+
+/**
+ * @brief Prints the bus configuration or its transaction statistics.
+ * @param output Output stream for logging.
+ * @param printConfig If true, prints the mux address and queue size; otherwise, prints counters.
+ */
+void I2CBus::PrintInfo(Print &output, bool printConfig) const {
+  if (printConfig) {
+    output.print(F("I2CBus Configuration: mux 0x"));
+    output.print(muxAddress, HEX);
+    output.print(F(", queue "));
+    output.print(I2C_QUEUE_SIZE);
+    output.print(F(", budget "));
+    output.print(I2C_UPDATE_BUDGET_US);
+    output.println(F(" us"));
+    return;
+  }
+  output.print(F("I2C: "));
+  output.print(busUp ? F("up") : F("DOWN"));
+  output.print(F(", recoveries "));
+  output.print(recoveries);
+  output.print(F(", mux writes "));
+  output.print(muxWrites);
+  output.print(F(", skipped "));
+  output.print(muxSkips);
+  output.print(F(", errors "));
+  output.print(muxErrors);
+  output.print(F(", dropped "));
+  output.println(dropped);
+  for (int i = 0; i < numStats; i++) {
+    const I2CStats &stat = stats[i];
+    output.print(F("  "));
+    output.print(stat.name);
+    output.print(F(": n="));
+    output.print(stat.count);
+    output.print(F(" err="));
+    output.print(stat.errors);
+    output.print(F(" slow="));
+    output.print(stat.slow);
+    output.print(F(" avg="));
+    output.print(stat.count ? stat.totalUs / stat.count : 0);
+    output.print(F("us max="));
+    output.print(stat.maxUs);
+    output.println(F("us"));
+  }
+}
+
+/**
+ * @brief Overloaded stream operator for printing bus statistics.
+ * @param output Output stream.
+ * @param bus I2CBus instance.
+ * @return Modified output stream.
+ */
+Print &operator<<(Print &output, const I2CBus &bus) {
+  bus.PrintInfo(output, false);
+  return output;
+}
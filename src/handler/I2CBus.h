@@ -0,0 +1,184 @@
+/**
+ * @file I2CBus.h
+ * @author Aldem Pido
+ * @brief Defines the I2CBus class, which owns an I2C bus and the multiplexer on it.
+ * @ingroup i2c
+ */
+
+#ifndef I2CBUS_H
+#define I2CBUS_H
+
+#include <Arduino.h>
+#include <Print.h>
+#include <Wire.h>
+
+#include "i2cmux.h"
+
+#define I2C_QUEUE_SIZE 16    ///< Transactions that can wait for the next Update().
+#define I2C_MAX_STATS 8      ///< Transaction names that get their own statistics.
+#define I2C_NO_CHANNEL 0xFF  ///< Channel of a device not behind the mux, or an unknown selection.
+#define I2C_MUX_CHANNELS 8   ///< Channels on the TCA9548A.
+
+#define I2C_UPDATE_BUDGET_US 2000        ///< Update() leaves the rest of the queue after this.
+#define I2C_SLOW_TRANSACTION_US 5000     ///< Slower transactions are counted as slow.
+#define I2C_RECOVER_AFTER_ERRORS 3       ///< Consecutive failed transactions before a bus clear.
+#define I2C_RECOVERY_INTERVAL_US 100000  ///< Minimum time between bus clears.
+#define I2C_CLEAR_PULSES 9               ///< SCL pulses that free any stuck slave.
+#define I2C_FAIL_AFTER_ERRORS 5          ///< Consecutive device errors before it is re-initialized.
+#define I2C_RETRY_MS 250                 ///< First delay before re-initializing a failed device.
+#define I2C_MAX_RETRY_MS 4000            ///< Cap on the re-init delay, which doubles per failure.
+
+typedef bool (*I2CTransaction)(void *context, uint8_t arg);  ///< Returns false on a bus error.
+
+/**
+ * @enum I2CHealth
+ * @ingroup i2c
+ * @brief Health of one device on the bus.
+ */
+enum I2CHealth : uint8_t {
+  I2C_HEALTH_OFF,       ///< Never started; bring-up is left to the startup sequence.
+  I2C_HEALTH_OK,        ///< Last transaction succeeded.
+  I2C_HEALTH_DEGRADED,  ///< Recent errors, still in use.
+  I2C_HEALTH_FAILED,    ///< Lost after starting; its handler re-initializes it in the background.
+};
+
+/**
+ * @struct I2CDeviceHealth
+ * @ingroup i2c
+ * @brief Error counting and re-init back-off for one device.
+ *  Handlers call Ok() and Error() with each transaction result. After I2C_FAIL_AFTER_ERRORS
+ * errors in a row the device is FAILED, and RetryDue() paces re-init attempts with a doubling
+ * delay so a dead device costs one attempt per few seconds rather than one per loop.
+ */
+struct I2CDeviceHealth {
+  I2CHealth state = I2C_HEALTH_OFF;  ///< Current health.
+  uint8_t consecutiveErrors = 0;     ///< Errors since the last success.
+  uint32_t errors = 0;               ///< Errors since boot.
+  uint32_t reinits = 0;              ///< Successful re-inits after a failure.
+  uint32_t retryMs = 0;              ///< Current re-init delay.
+  uint32_t retryAtMs = 0;            ///< millis() of the next re-init attempt.
+
+  bool Usable() const { return state == I2C_HEALTH_OK || state == I2C_HEALTH_DEGRADED; }
+  bool RetryDue() const {
+    return state == I2C_HEALTH_FAILED && static_cast<int32_t>(millis() - retryAtMs) >= 0;
+  }
+  void Ok() {
+    if (state == I2C_HEALTH_FAILED) reinits++;
+    state = I2C_HEALTH_OK;
+    consecutiveErrors = 0;
+    retryMs = 0;
+  }
+  void Error() {
+    errors++;
+    if (!Usable()) return;
+    if (++consecutiveErrors >= I2C_FAIL_AFTER_ERRORS) {
+      Fail();
+    } else {
+      state = I2C_HEALTH_DEGRADED;
+    }
+  }
+  void Fail() {
+    state = I2C_HEALTH_FAILED;
+    retryMs = retryMs == 0 ? I2C_RETRY_MS : min(2 * retryMs, (uint32_t)I2C_MAX_RETRY_MS);
+    retryAtMs = millis() + retryMs;
+  }
+};
+
+/**
+ * @struct I2CStats
+ * @ingroup i2c
+ * @brief Counters kept for every transaction name.
+ */
+struct I2CStats {
+  const char *name = nullptr;  ///< Name passed to Submit() or Run().
+  uint32_t count = 0;          ///< Transactions run.
+  uint32_t errors = 0;         ///< Transactions that failed, including failed channel selects.
+  uint32_t slow = 0;           ///< Transactions slower than I2C_SLOW_TRANSACTION_US.
+  uint32_t lastUs = 0;         ///< Duration of the last transaction.
+  uint32_t maxUs = 0;          ///< Longest transaction seen.
+  uint32_t totalUs = 0;        ///< Sum of all durations, for the average.
+};
+
+/**
+ * @class I2CBus
+ * @ingroup i2c
+ * @brief Shares one I2C bus and its TCA9548A multiplexer between handlers.
+ *  Handlers address a device by its mux channel and never talk to the mux themselves. The
+ * selected channel is remembered, so a select is only written when the channel changes.
+ * Transactions queued with Submit() are run by Update() grouped by channel, starting with the
+ * channel already selected, so handlers polling different channels share as few switches as
+ * possible. Run() executes a transaction at once, for setup code that needs the result.
+ *
+ *  Each Update() stops at the first transaction boundary after I2C_UPDATE_BUDGET_US. After a mux
+ * select fails or I2C_RECOVER_AFTER_ERRORS transactions fail in a row, the bus is cleared by
+ * clocking SCL until a slave holding SDA lets go. If SDA stays low the bus is marked down: queued
+ * transactions are dropped instead of each waiting out the Wire timeout, and the clear is retried
+ * every I2C_RECOVERY_INTERVAL_US. The Wire library bounds each transfer; the drivers' own polling
+ * loops must be given a timeout by their handlers. A running transaction is never cut short, so
+ * the last one can overrun the budget by its own length; those past I2C_SLOW_TRANSACTION_US are
+ * counted as slow.
+ */
+class I2CBus {
+ public:
+  I2CBus(TwoWire &wire, uint8_t sdaPin, uint8_t sclPin, uint32_t clockHz,
+         uint8_t muxAddress = TCAADDR);
+
+  TwoWire &GetWire() { return wire; }
+  bool Select(uint8_t channel);
+  void Invalidate() { selectedChannel = I2C_NO_CHANNEL; }
+  bool Submit(uint8_t channel, const char *name, I2CTransaction transaction, void *context,
+              uint8_t arg = 0);
+  bool Run(uint8_t channel, const char *name, I2CTransaction transaction, void *context,
+           uint8_t arg = 0);
+  int Update();
+  bool Recover();
+
+  bool IsBusUp() const { return busUp; }
+  int GetQueueLength() const { return queueLength; }
+  uint8_t GetSelectedChannel() const { return selectedChannel; }
+  void ResetStats();
+
+  void PrintInfo(Print &output, bool printConfig = false) const;
+  friend Print &operator<<(Print &output, const I2CBus &bus);
+
+ private:
+  /**
+   * @struct Job
+   * @brief One queued transaction.
+   */
+  struct Job {
+    uint8_t channel = I2C_NO_CHANNEL;      ///< Mux channel of the device.
+    const char *name = nullptr;            ///< Statistics name.
+    I2CTransaction transaction = nullptr;  ///< Function that performs the transfer.
+    void *context = nullptr;               ///< First argument of the transaction.
+    uint8_t arg = 0;                       ///< Second argument of the transaction.
+  };
+
+  TwoWire &wire;             ///< Bus the mux and devices are on.
+  const uint8_t sdaPin;      ///< SDA pin, driven directly while clearing the bus.
+  const uint8_t sclPin;      ///< SCL pin, driven directly while clearing the bus.
+  const uint32_t clockHz;    ///< Bus clock restored after a clear.
+  const uint8_t muxAddress;  ///< I2C address of the TCA9548A.
+  uint8_t selectedChannel;   ///< Channel the mux is known to have selected.
+
+  Job queue[I2C_QUEUE_SIZE];      ///< Transactions waiting for Update(), oldest first.
+  int queueLength;                ///< Number of queued transactions.
+  I2CStats stats[I2C_MAX_STATS];  ///< Per-name counters.
+  int numStats;                   ///< Names with counters.
+
+  uint32_t muxWrites;  ///< Channel selects written to the mux.
+  uint32_t muxSkips;   ///< Selects skipped because the channel was already selected.
+  uint32_t muxErrors;  ///< Channel selects the mux did not acknowledge.
+  uint32_t dropped;    ///< Transactions rejected because the queue was full or the bus was down.
+
+  bool busUp;                 ///< False while SDA is stuck low after a clear.
+  bool recoveryWanted;        ///< Set by failures; Update() clears the bus when allowed.
+  uint8_t consecutiveErrors;  ///< Failed transactions since the last success.
+  uint32_t recoveries;        ///< Bus clears performed.
+  uint32_t lastRecoveryUs;    ///< micros() of the last bus clear.
+
+  bool execute(const Job &job);
+  I2CStats *findStats(const char *name);
+};
+
+#endif  // I2CBUS_H
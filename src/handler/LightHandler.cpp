@@ -1,33 +1,84 @@
 #include "LightHandler.h"
 
+#include "../util/Logger.h"
+
 /**
  * @brief Constructs a LightHandler object.
+ * @param bus I2C bus the sensor and its multiplexer are on.
  * @param cLight Channel index for the I2C multiplexer.
  */
-LightHandler::LightHandler(int cLight) : cLight(cLight), lightMeter(), lightLevel(0.0) {}
+LightHandler::LightHandler(I2CBus &bus, int cLight)
+    : bus(bus), cLight(cLight), lightMeter(), lightLevel(0.0) {}
 
 /**
  * @brief Initializes the BH1750 light sensor.
  * @return True if initialization succeeds, false otherwise.
  */
 bool LightHandler::Begin() {
-  i2cmux::tcaselect(cLight);
-
-  if (lightMeter.begin(BH1750::CONTINUOUS_HIGH_RES_MODE, 0x23, &Wire1)) {
-    Serial.println("Light sensor initialized");
+  if (bus.Run(cLight, "light init", beginSensor, this)) {
+    LOG_INFO("Light sensor initialized");
     return true;
   } else {
-    Serial.println("Error initializing light sensor");
+    LOG_ERROR("Error initializing light sensor");
     return false;
   }
 }
 
 /**
- * @brief Reads and updates the light sensor data.
+ * @brief I2CBus transaction that configures the sensor; the channel is already selected.
+ * @param context The LightHandler.
+ * @param arg Unused.
+ * @return False if the sensor did not answer.
+ */
+bool LightHandler::beginSensor(void *context, uint8_t arg) {
+  LightHandler *handler = static_cast<LightHandler *>(context);
+  const bool restart = handler->health.state == I2C_HEALTH_FAILED;
+  if (!handler->lightMeter.begin(BH1750::CONTINUOUS_HIGH_RES_MODE, 0x23, &handler->bus.GetWire())) {
+    if (restart) {
+      handler->health.errors++;
+      handler->health.Fail();  // Pushes the next attempt back
+    }
+    return false;
+  }
+  handler->health.Ok();
+  if (restart) {
+    LOG_INFO("Light sensor restarted");
+  }
+  return true;
+}
+
+/**
+ * @brief Queues a read of the light sensor data, or a re-init once a failed sensor is due one.
  */
 void LightHandler::Update() {
-  i2cmux::tcaselect(cLight);
-  lightLevel = lightMeter.readLightLevel();
+  if (health.RetryDue()) {
+    bus.Submit(cLight, "light init", beginSensor, this);
+    return;
+  }
+  if (!health.Usable()) return;
+  bus.Submit(cLight, "light", readLevel, this);
+}
+
+/**
+ * @brief I2CBus transaction that reads the light level; the channel is already selected.
+ * @param context The LightHandler.
+ * @param arg Unused.
+ * @return False if the sensor did not answer.
+ */
+bool LightHandler::readLevel(void *context, uint8_t arg) {
+  LightHandler *handler = static_cast<LightHandler *>(context);
+  if (!handler->health.Usable()) return true;  // Failed while queued
+  const float level = handler->lightMeter.readLightLevel();
+  if (level < 0) {
+    handler->health.Error();  // readLightLevel() returns -1 or -2 on a bus error
+    if (handler->health.state == I2C_HEALTH_FAILED) {
+      LOG_WARN("Light sensor failed");
+    }
+    return false;
+  }
+  handler->health.Ok();
+  handler->lightLevel = level;
+  return true;
 }
 
 /**
@@ -40,6 +91,11 @@ void LightHandler::PrintInfo(Print &output, bool printConfig) const {
   output.print(lightLevel);
   output.println(" lx");
 
+  if (!health.Usable()) {
+    output.print("Light sensor not running, errors: ");
+    output.println(health.errors);
+  }
+
   if (printConfig) {
     output.println("Configuration:");
     output.println("Mode: Continuous High Resolution");
@@ -14,25 +14,36 @@
 #include <BH1750.h>
 #include <Wire.h>
 
-#include "i2cmux.h"
+#include "I2CBus.h"
 
 /**
  * @class LightHandler
  * @ingroup sensors
  * @brief Manages BH1750 light sensor readings.
+ *  Update() queues the read on the I2CBus, so the level changes when the bus runs its queue.
+ * If the sensor stops answering it is marked failed and Update() re-initializes it in the
+ * background with a growing delay between attempts.
  */
 class LightHandler {
  public:
-  LightHandler(int cLight);
+  LightHandler(I2CBus &bus, int cLight);
   bool Begin();
+  bool IsReady() const { return health.Usable(); }
+  const I2CDeviceHealth &GetHealth() const { return health; }
   void Update();
   void PrintInfo(Print &output, bool printConfig = false) const;
   float GetLightLevel() const;
 
  private:
+  I2CBus &bus;        ///< Bus the sensor is on
   int cLight;         ///< Channel index for I2C multiplexer
   BH1750 lightMeter;  ///< BH1750 light sensor instance
   float lightLevel;   ///< Stores the latest light level measurement
+
+  I2CDeviceHealth health;  ///< Usable once Begin() succeeds; Update() is skipped until then
+
+  static bool readLevel(void *context, uint8_t arg);
+  static bool beginSensor(void *context, uint8_t arg);
 };
 
 // Overloaded stream operator for printing sensor details.
@@ -0,0 +1,328 @@
+/**
+ * @file MissionHandler.cpp
+ * @author Aldem Pido
+ * @brief Implements the MissionHandler class and the mission step helpers.
+ */
+#include "MissionHandler.h"
+
+#include <Arduino.h>  // For millis(), F()
+
+#include "../util/Logger.h"
+#include "../util/Tracer.h"
+
+/**
+ * @brief Builds a step that drives through a waypoint list.
+ * @param name Name used in status output.
+ * @param path Waypoints to follow. Must outlive the mission table.
+ * @return The step record.
+ */
+MissionStep PathStep(const char *name, const std::vector<Pose2D> &path) {
+  MissionStep step;
+  step.type = StepType::PATH;
+  step.name = name;
+  step.path = &path;
+  return step;
+}
+
+/**
+ * @brief Builds a step that holds for a fixed time.
+ * @param name Name used in status output.
+ * @param durationMs Time to hold in milliseconds.
+ * @return The step record.
+ */
+MissionStep DwellStep(const char *name, uint32_t durationMs) {
+  MissionStep step;
+  step.type = StepType::DWELL;
+  step.name = name;
+  step.durationMs = durationMs;
+  return step;
+}
+
+/**
+ * @brief Builds a step that runs an actuator command once.
+ * @param name Name used in status output.
+ * @param action Command to run when the step starts.
+ * @return The step record.
+ */
+MissionStep ActionStep(const char *name, StepAction action) {
+  MissionStep step;
+  step.type = StepType::ACTION;
+  step.name = name;
+  step.action = action;
+  return step;
+}
+
+/**
+ * @brief Builds a step that waits for a condition.
+ * @param name Name used in status output.
+ * @param condition Polled on every Update(). The step finishes once it returns true.
+ * @param timeoutMs Time after which the step finishes anyway, or 0 to wait forever.
+ * @return The step record.
+ */
+MissionStep WaitUntilStep(const char *name, StepCondition condition, uint32_t timeoutMs) {
+  MissionStep step;
+  step.type = StepType::WAIT_UNTIL;
+  step.name = name;
+  step.condition = condition;
+  step.durationMs = timeoutMs;
+  return step;
+}
+
+/**
+ * @brief Builds a header that runs the following steps together.
+ *  The grouped steps must not be PARALLEL headers themselves, and at most one of them may be
+ * a PATH step since there is only one path follower.
+ * @param name Name used in status output.
+ * @param groupSize Number of steps directly after this one that belong to the group.
+ * @return The step record.
+ */
+MissionStep ParallelStep(const char *name, uint8_t groupSize) {
+  MissionStep step;
+  step.type = StepType::PARALLEL;
+  step.name = name;
+  step.groupSize = groupSize;
+  return step;
+}
+
+/**
+ * @brief Constructs a MissionHandler with no mission loaded.
+ * @param paths Path follower used by PATH steps.
+ */
+MissionHandler::MissionHandler(PathHandler &paths)
+    : paths(paths),
+      steps(nullptr),
+      numSteps(0),
+      state(IDLE),
+      groupHead(0),
+      groupFirst(0),
+      groupEnd(0),
+      groupActive(false),
+      doneMask(0),
+      groupStartMs(0),
+      elapsedMs{0} {}
+
+/**
+ * @brief Loads a mission table and resets execution to its first step.
+ * @param steps Mission table. Must outlive the handler.
+ * @param numSteps Number of steps in the table, at most MISSION_MAX_STEPS.
+ * @return False, leaving no steps loaded, if the table is too long; running part of a mission
+ * would skip its last steps, such as the return to start.
+ */
+bool MissionHandler::Load(const MissionStep *steps, int numSteps) {
+  const bool fits = numSteps >= 0 && numSteps <= MISSION_MAX_STEPS;
+  if (!fits) {
+    LOG_ERROR(F("Mission table has too many steps: "), numSteps);
+  }
+  this->steps = fits ? steps : nullptr;
+  this->numSteps = fits ? numSteps : 0;
+  state = IDLE;
+  groupHead = 0;
+  groupActive = false;
+  for (int i = 0; i < MISSION_MAX_STEPS; i++) {
+    elapsedMs[i] = 0;
+  }
+  return fits;
+}
+
+/**
+ * @brief Starts executing the loaded mission from its first step.
+ */
+void MissionHandler::Start() {
+  Load(steps, numSteps);
+  state = (numSteps > 0) ? RUNNING : FINISHED;
+}
+
+/**
+ * @brief Advances the mission by one control tick.
+ *  This function is intended to be called at the control rate and never blocks. It starts the
+ * current group if needed, polls each unfinished step in it, and moves to the next group once
+ * all of them are done. Groups that finish immediately are chained within the same call.
+ */
+void MissionHandler::Update() {
+  while (state == RUNNING) {
+    const uint32_t nowMs = millis();
+    if (!groupActive) {
+      startGroup(nowMs);
+    }
+
+    const uint32_t elapsed = nowMs - groupStartMs;
+    bool allDone = true;
+    for (int i = groupFirst; i < groupEnd; i++) {
+      const uint64_t bit = 1ULL << (i - groupFirst);
+      if (doneMask & bit) continue;
+      if (pollStep(i, elapsed)) {
+        doneMask |= bit;
+        elapsedMs[i] = elapsed;
+        if (i != groupHead) TRACE_INSTANT(TRACE_TRACK_MISSION, steps[i].name);
+      } else {
+        allDone = false;
+      }
+    }
+    if (!allDone) return;
+
+    elapsedMs[groupHead] = elapsed;
+    groupActive = false;
+    TRACE_END(TRACE_TRACK_MISSION, steps[groupHead].name);
+    groupHead = groupEnd;
+    if (groupHead >= numSteps) {
+      state = FINISHED;
+    }
+  }
+}
+
+/**
+ * @brief Gets the name of the step currently executing.
+ * @return The step name, or nullptr if no step is executing.
+ */
+const char *MissionHandler::GetStepName() const {
+  if (state == RUNNING) {
+    return steps[groupHead].name;
+  }
+  return nullptr;
+}
+
+/**
+ * @brief Gets the time spent in a step.
+ * @param index Step index in the mission table.
+ * @return Milliseconds from the start of the step's group to its completion. For the step that
+ * is executing, the time so far. 0 if the step has not been reached or the index is invalid.
+ */
+uint32_t MissionHandler::GetStepElapsedMs(int index) const {
+  if (index < 0 || index >= numSteps) return 0;
+  if (state == RUNNING && groupActive && index >= groupHead && index < groupEnd &&
+      (index == groupHead || !(doneMask & (1ULL << (index - groupFirst))))) {
+    return millis() - groupStartMs;
+  }
+  return elapsedMs[index];
+}
+
+/**
+ * @brief Starts every step in the group beginning at groupHead.
+ *  The group is traced as one span named after its head step; steps inside a parallel group are
+ * marked as they finish.
+ * @param nowMs Current time in milliseconds.
+ */
+void MissionHandler::startGroup(uint32_t nowMs) {
+  const MissionStep &head = steps[groupHead];
+  if (head.type == StepType::PARALLEL) {
+    groupFirst = groupHead + 1;
+    groupEnd = min(groupFirst + static_cast<int>(head.groupSize), numSteps);
+  } else {
+    groupFirst = groupHead;
+    groupEnd = groupHead + 1;
+  }
+  doneMask = 0;
+  groupStartMs = nowMs;
+  groupActive = true;
+  TRACE_BEGIN(TRACE_TRACK_MISSION, head.name);
+  for (int i = groupFirst; i < groupEnd; i++) {
+    startStep(steps[i]);
+  }
+}
+
+/**
+ * @brief Performs the one-time start work of a step.
+ * @param step Step to start.
+ */
+void MissionHandler::startStep(const MissionStep &step) {
+  switch (step.type) {
+    case StepType::PATH:
+      paths.clearPath();
+      if (step.path != nullptr) {
+        paths.addWaypoints(*step.path);
+      }
+      break;
+    case StepType::ACTION:
+      if (step.action != nullptr) {
+        step.action();
+      }
+      break;
+    default:
+      break;
+  }
+}
+
+/**
+ * @brief Checks whether a started step has finished.
+ * @param index Step index in the mission table.
+ * @param elapsed Milliseconds since the step's group started.
+ * @return True if the step is finished.
+ */
+bool MissionHandler::pollStep(int index, uint32_t elapsed) {
+  const MissionStep &step = steps[index];
+  switch (step.type) {
+    case StepType::PATH:
+      return paths.executePath();
+    case StepType::DWELL:
+      return elapsed >= step.durationMs;
+    case StepType::WAIT_UNTIL:
+      if (step.condition != nullptr && step.condition()) {
+        return true;
+      }
+      if (step.durationMs > 0 && elapsed >= step.durationMs) {
+        LOG_WARN("Mission step ", index, " timed out. Moving to next step.");
+        return true;
+      }
+      return false;
+    default:
+      return true;  // ACTION steps finish as soon as they start; nested groups are not run
+  }
+}
+
+/**
+ * @brief Prints the mission table or the execution status.
+ * @param output Output stream for logging.
+ * @param printConfig If true, prints every step; otherwise, prints the current step and the
+ * time spent in each completed step.
+ */
+void MissionHandler::PrintInfo(Print &output, bool printConfig) const {
+  static const char *const typeNames[] = {"PATH", "DWELL", "ACTION", "WAIT_UNTIL", "PARALLEL"};
+  if (printConfig) {
+    output.print(F("Mission Configuration ("));
+    output.print(numSteps);
+    output.println(F(" steps):"));
+    for (int i = 0; i < numSteps; i++) {
+      output.print(F("  "));
+      output.print(i);
+      output.print(F(": "));
+      output.print(typeNames[static_cast<uint8_t>(steps[i].type)]);
+      output.print(F(" "));
+      output.println(steps[i].name);
+    }
+  } else {
+    output.print(F("Mission: "));
+    if (state == IDLE) {
+      output.println(F("idle"));
+    } else if (state == FINISHED) {
+      output.println(F("finished"));
+    } else {
+      output.print(F("step "));
+      output.print(groupHead);
+      output.print(F(" ("));
+      output.print(steps[groupHead].name);
+      output.print(F(") "));
+      output.print(GetStepElapsedMs(groupHead));
+      output.println(F(" ms"));
+    }
+    output.print(F("Step Times (ms): "));
+    const int last = (state == FINISHED) ? numSteps : groupHead;
+    for (int i = 0; i < last; i++) {
+      output.print(elapsedMs[i]);
+      if (i < last - 1) {
+        output.print(F(", "));
+      }
+    }
+    output.println();
+  }
+}
+
+/**
+ * @brief Overloaded stream operator for printing mission status.
+ * @param output Output stream.
+ * @param handler MissionHandler instance.
+ * @return Modified output stream.
+ */
+Print &operator<<(Print &output, const MissionHandler &handler) {
+  handler.PrintInfo(output, false);
+  return output;
+}
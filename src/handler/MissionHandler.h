@@ -0,0 +1,112 @@
+/**
+ * @file MissionHandler.h
+ * @author Aldem Pido
+ * @brief Defines the MissionHandler class for running table-driven autonomous missions.
+ * @ingroup navigation
+ */
+
+#ifndef MISSIONHANDLER_H
+#define MISSIONHANDLER_H
+
+#include <Arduino.h>
+#include <Print.h>
+
+#include <vector>
+
+#include "../drive/math/Pose2D.h"
+#include "PathHandler.h"
+
+#define MISSION_MAX_STEPS 64  ///< Maximum number of steps in one mission table.
+
+typedef void (*StepAction)();     ///< Actuator command run once when a step starts.
+typedef bool (*StepCondition)();  ///< Returns true once a wait-for-condition step may finish.
+
+/**
+ * @brief Kinds of mission step.
+ */
+enum class StepType : uint8_t {
+  PATH,        ///< Drive through a waypoint list. Finishes when PathHandler reports done.
+  DWELL,       ///< Hold for a fixed time while everything else keeps running.
+  ACTION,      ///< Run an actuator command once. Finishes immediately.
+  WAIT_UNTIL,  ///< Wait until a condition holds, or until an optional timeout.
+  PARALLEL     ///< Run the next `groupSize` steps together. Finishes when all of them have.
+};
+
+/**
+ * @struct MissionStep
+ * @ingroup navigation
+ * @brief Declarative record for one step of a mission table.
+ *  Use the PathStep(), DwellStep(), ActionStep(), WaitUntilStep() and ParallelStep() helpers to
+ * build tables instead of filling the fields directly.
+ */
+struct MissionStep {
+  StepType type = StepType::ACTION;           ///< Kind of step.
+  const char *name = "";                      ///< Name used in status output.
+  const std::vector<Pose2D> *path = nullptr;  ///< Waypoints for PATH steps.
+  StepAction action = nullptr;                ///< Command for ACTION steps.
+  StepCondition condition = nullptr;          ///< Condition for WAIT_UNTIL steps.
+  uint32_t durationMs = 0;                    ///< DWELL time, or WAIT_UNTIL timeout (0 = none).
+  uint8_t groupSize = 0;                      ///< Number of following steps in a PARALLEL group.
+};
+
+MissionStep PathStep(const char *name, const std::vector<Pose2D> &path);
+MissionStep DwellStep(const char *name, uint32_t durationMs);
+MissionStep ActionStep(const char *name, StepAction action);
+MissionStep WaitUntilStep(const char *name, StepCondition condition, uint32_t timeoutMs = 0);
+MissionStep ParallelStep(const char *name, uint8_t groupSize);
+
+/**
+ * @class MissionHandler
+ * @ingroup navigation
+ * @brief Runs a mission table as a non-blocking state machine.
+ *  Update() is called at the control rate. Each call starts the current step (or PARALLEL
+ * group), polls it, and moves on when it is finished. Steps that finish immediately, such as
+ * ACTION steps, are chained within the same call. Nothing in the executor waits, so the drive,
+ * sensors and subsystems keep running during dwells and waits. The time spent in every step is
+ * recorded for status output.
+ */
+class MissionHandler {
+ public:
+  /**
+   * @brief Execution state of the loaded mission.
+   */
+  enum State : uint8_t {
+    IDLE,     ///< Loaded but not started.
+    RUNNING,  ///< Steps are being executed.
+    FINISHED  ///< Every step has completed.
+  };
+
+  MissionHandler(PathHandler &paths);
+
+  bool Load(const MissionStep *steps, int numSteps);
+  void Start();
+  void Update();
+
+  State GetState() const { return state; }
+  bool IsFinished() const { return state == FINISHED; }
+  int GetStepIndex() const { return groupHead; }
+  const char *GetStepName() const;
+  uint32_t GetStepElapsedMs(int index) const;
+
+  void PrintInfo(Print &output, bool printConfig = false) const;
+  friend Print &operator<<(Print &output, const MissionHandler &handler);
+
+ private:
+  PathHandler &paths;                     ///< Path follower used by PATH steps.
+  const MissionStep *steps;               ///< Loaded mission table.
+  int numSteps;                           ///< Number of steps in the table.
+  State state;                            ///< Execution state.
+  int groupHead;                          ///< Index of the current step or PARALLEL header.
+  int groupFirst;                         ///< First step executed in the current group.
+  int groupEnd;                           ///< One past the last step in the current group.
+  bool groupActive;                       ///< True once the current group has been started.
+  uint64_t doneMask;                      ///< Bit per step in the group that has finished.
+  uint32_t groupStartMs;                  ///< millis() when the current group started.
+  uint32_t elapsedMs[MISSION_MAX_STEPS];  ///< Time spent in each step, 0 if not reached.
+
+  void startGroup(uint32_t nowMs);
+  void startStep(const MissionStep &step);
+  bool pollStep(int index, uint32_t elapsed);
+};
+
+#endif  // MISSIONHANDLER_H
@@ -7,7 +7,9 @@
  */
 #include "PathHandler.h"
 
-#include <Arduino.h>  // Required for millis() and Serial
+#include <Arduino.h>  // Required for millis()
+
+#include "../util/Logger.h"
 
 /**
  * @brief Constructs a PathHandler object.
@@ -104,9 +106,7 @@ bool PathHandler::executePath() {
     }
   } else if (hasTimedOut()) {
     // Handle waypoint timeout
-    Serial.print("Waypoint ");
-    Serial.print(currentPathIndex);
-    Serial.println(" timed out. Moving to next waypoint.");
+    LOG_WARN("Waypoint ", currentPathIndex, " timed out. Moving to next waypoint.");
 
     currentPathIndex++;     // Move to the next waypoint
     lastWaypointTime = 0;   // Reset pause timer
@@ -140,6 +140,9 @@ void PathHandler::skipToNextPath() {
  * with the target waypoint's pose. The waypoint is considered reached if the
  * Euclidean distance in the XY plane is within INTOLERANCEREACHED and the
  * absolute difference in orientation (theta) is within INRADIANSREACHED.
+ * The distance tolerance widens to INTOLERANCESIGMAS position standard deviations
+ * of the drive's estimate, up to INTOLERANCEMAX, since the pose cannot be held
+ * to better than it is known.
  * Theta values are fixed to ensure correct comparison, e.g., by normalizing angles.
  * @param target The 2D pose (Pose2D) of the target waypoint.
  * @return True if the robot is within the defined tolerance (distance and orientation)
@@ -154,7 +157,9 @@ bool PathHandler::hasReachedWaypoint(const Pose2D &target) {
   // Ensure deltatheta is the shortest angle, e.g. by taking abs(fixTheta(deltatheta))
   // or ensuring fixTheta handles this appropriately. The provided snippet uses
   // delta.fixTheta().getTheta() which implies fixTheta normalizes to a range like -PI to PI.
-  return ((deltaxy <= INTOLERANCEREACHED) && (abs(deltatheta) <= INRADIANSREACHED));
+  const float tolerance = constrain(INTOLERANCESIGMAS * drive.GetEstimate().GetPositionSigma(),
+                                    INTOLERANCEREACHED, INTOLERANCEMAX);
+  return ((deltaxy <= tolerance) && (abs(deltatheta) <= INRADIANSREACHED));
 }
 
 /**
@@ -20,6 +20,10 @@
 // Define constants for waypoint tracking
 #define INTOLERANCEREACHED \
   2.5f  ///< Distance tolerance in units (e.g., cm) for considering a waypoint reached.
+#define INTOLERANCESIGMAS \
+  2.0f  ///< Position standard deviations the distance tolerance widens to when less certain.
+#define INTOLERANCEMAX \
+  5.0f  ///< Widest distance tolerance, however uncertain the pose.
 #define INRADIANSREACHED \
   0.1f  ///< Orientation tolerance in radians for considering a waypoint reached.
 #define MINTIMEPAUSE \
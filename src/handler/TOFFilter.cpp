@@ -0,0 +1,190 @@
+/**
+ * @file TOFFilter.cpp
+ * @author Aldem Pido
+ * @brief Implements the TOFFilter class for VL53L0X reading validation and smoothing.
+ */
+#include "TOFFilter.h"
+
+#include <Arduino.h>  // For Print, F()
+
+/**
+ * @brief Constructs a TOFFilter with the default configuration and no readings.
+ */
+TOFFilter::TOFFilter() { Reset(); }
+
+/**
+ * @brief Changes the filter settings. The window size is clamped and the filter is reset.
+ * @param config New settings.
+ */
+void TOFFilter::Configure(const TOFFilterConfig &config) {
+  this->config = config;
+  this->config.medianWindow = constrain(config.medianWindow, 1, TOF_FILTER_MAX_WINDOW);
+  Reset();
+}
+
+/**
+ * @brief Forgets every reading, e.g. after the sensor was restarted.
+ */
+void TOFFilter::Reset() {
+  windowCount = 0;
+  windowNext = 0;
+  estimate = 0;
+  rate = 0;
+  confidence = 0;
+  seeded = false;
+  lastTimeUs = 0;
+  raw = 0;
+  lastKind = TOF_READING_NO_TARGET;
+  outliers = 0;
+  rejected = 0;
+}
+
+/**
+ * @brief Classifies a raw reading.
+ *  The device range status is bits 6:3 of the RESULT_RANGE_STATUS register. 11 is a complete
+ * measurement and 7 a sigma (noise) failure that is still roughly right. Phase, signal and
+ * algorithm failures mean there was no usable target, and the rest are hardware failures.
+ * @param rawMm Range register value in mm.
+ * @param rangeStatus RESULT_RANGE_STATUS register value.
+ * @param config Range limits.
+ * @return Kind of reading. Never TOF_READING_OUTLIER, which only Update() decides.
+ */
+TOFReadingKind TOFFilter::Classify(uint16_t rawMm, uint8_t rangeStatus,
+                                   const TOFFilterConfig &config) {
+  const uint8_t deviceStatus = (rangeStatus & 0x78) >> 3;
+  if (rawMm >= TOF_RANGE_OUT_OF_RANGE || rawMm > config.maxRange) {
+    return TOF_READING_NO_TARGET;
+  }
+  switch (deviceStatus) {
+    case TOF_RANGE_STATUS_VALID:
+      break;
+    case TOF_RANGE_STATUS_SIGMA:
+      return rawMm < config.minRange ? TOF_READING_ERROR : TOF_READING_WEAK;
+    case 4:   // MSRC no target
+    case 6:   // Range phase check
+    case 9:   // Phase consistency
+    case 10:  // Min clip
+    case 12:  // Algo underflow
+    case 13:  // Algo overflow
+    case 14:  // Range ignore threshold
+      return TOF_READING_NO_TARGET;
+    default:  // VCSEL continuity/watchdog, no VHV, SNR, TCC
+      return TOF_READING_ERROR;
+  }
+  return rawMm < config.minRange ? TOF_READING_ERROR : TOF_READING_VALID;
+}
+
+/**
+ * @brief Filters one reading.
+ * @param rawMm Range register value in mm.
+ * @param rangeStatus RESULT_RANGE_STATUS register value.
+ * @param timeUs micros() at which the reading was taken.
+ * @return What was done with the reading.
+ */
+TOFReadingKind TOFFilter::Update(uint16_t rawMm, uint8_t rangeStatus, uint32_t timeUs) {
+  raw = rawMm;
+  TOFReadingKind kind = Classify(rawMm, rangeStatus, config);
+  if (kind == TOF_READING_NO_TARGET || kind == TOF_READING_ERROR) {
+    confidence -= TOF_CONFIDENCE_RATE * confidence;
+    if (confidence < config.minConfidence) {
+      seeded = false;  // Start afresh when a target comes back
+      windowCount = 0;
+      windowNext = 0;
+    }
+    lastKind = kind;
+    return kind;
+  }
+
+  window[windowNext] = rawMm;
+  windowNext = (windowNext + 1) % config.medianWindow;
+  if (windowCount < config.medianWindow) windowCount++;
+  const float measured = median();
+  const float target = kind == TOF_READING_VALID ? 1.0f : TOF_WEAK_CONFIDENCE;
+
+  if (!seeded) {
+    seed(measured, timeUs);
+    confidence = max(confidence, target);  // A new target is as good as its first reading
+  } else {
+    const float dt = (timeUs - lastTimeUs) * 1e-6f;
+    const float predicted = estimate + rate * dt;
+    const float residual = measured - predicted;
+    const bool jumped = fabsf(residual) > config.maxJump;
+    if (jumped && windowCount < TOF_SPIKE_PROOF_WINDOW && ++outliers < config.maxOutliers) {
+      rejected++;
+      confidence -= TOF_CONFIDENCE_RATE * confidence;
+      lastKind = TOF_READING_OUTLIER;
+      return TOF_READING_OUTLIER;
+    }
+    if (jumped) {
+      seed(measured, timeUs);  // The target really moved
+    } else {
+      estimate = predicted + config.alpha * residual;
+      if (dt > 0) rate += config.beta * residual / dt;
+      lastTimeUs = timeUs;
+    }
+  }
+  outliers = 0;
+
+  confidence += TOF_CONFIDENCE_RATE * (target - confidence);
+  lastKind = kind;
+  return kind;
+}
+
+/**
+ * @brief Restarts the alpha-beta state at a distance with zero rate.
+ * @param distance Distance in mm.
+ * @param timeUs Time of the reading.
+ */
+void TOFFilter::seed(float distance, uint32_t timeUs) {
+  estimate = distance;
+  rate = 0;
+  lastTimeUs = timeUs;
+  seeded = true;
+}
+
+/**
+ * @brief Median of the readings in the window.
+ * @return The middle value, or the mean of the two middle values for an even count.
+ */
+float TOFFilter::median() const {
+  uint16_t sorted[TOF_FILTER_MAX_WINDOW];
+  for (uint8_t i = 0; i < windowCount; i++) {
+    uint16_t value = window[i];
+    uint8_t j = i;
+    for (; j > 0 && sorted[j - 1] > value; j--) sorted[j] = sorted[j - 1];
+    sorted[j] = value;
+  }
+  if (windowCount % 2 == 1) return sorted[windowCount / 2];
+  return 0.5f * (sorted[windowCount / 2 - 1] + sorted[windowCount / 2]);
+}
+
+/**
+ * @brief Prints the filter settings or its state.
+ * @param output Output stream for logging.
+ * @param printConfig If true, prints the settings; otherwise, prints the state.
+ */
+void TOFFilter::PrintInfo(Print &output, bool printConfig) const {
+  if (printConfig) {
+    output.print(F("median "));
+    output.print(config.medianWindow);
+    output.print(F(", alpha "));
+    output.print(config.alpha);
+    output.print(F(", beta "));
+    output.print(config.beta);
+    output.print(F(", max jump "));
+    output.print(config.maxJump);
+    output.print(F(" mm, range "));
+    output.print(config.minRange);
+    output.print('-');
+    output.println(config.maxRange);
+  } else {
+    output.print(GetDistance());
+    output.print(F(" mm (raw "));
+    output.print(raw);
+    output.print(F(", conf "));
+    output.print(confidence);
+    output.print(F(", rejected "));
+    output.print(rejected);
+    output.print(')');
+  }
+}
@@ -0,0 +1,107 @@
+/**
+ * @file TOFFilter.h
+ * @author Aldem Pido
+ * @brief Defines the TOFFilter class, which cleans up the readings of one VL53L0X.
+ * @ingroup sensors
+ */
+
+#ifndef TOFFILTER_H
+#define TOFFILTER_H
+
+#include <Arduino.h>
+
+#define TOF_FILTER_MAX_WINDOW 5      ///< Largest median window.
+#define TOF_RANGE_OUT_OF_RANGE 8190  ///< Raw reading at or above which there is no target.
+#define TOF_RANGE_STATUS_VALID 11    ///< Device range status of a complete, valid measurement.
+#define TOF_RANGE_STATUS_SIGMA 7     ///< Device range status of a noisy (sigma fail) measurement.
+#define TOF_CONFIDENCE_RATE 0.3f     ///< Step toward 1 per good reading, toward 0 per bad one.
+#define TOF_WEAK_CONFIDENCE 0.5f     ///< Confidence a stream of sigma-fail readings settles at.
+#define TOF_SPIKE_PROOF_WINDOW 3     ///< Readings after which the median removes single spikes.
+
+/**
+ * @enum TOFReadingKind
+ * @ingroup sensors
+ * @brief What a raw reading means, from its range status and value.
+ */
+enum TOFReadingKind : uint8_t {
+  TOF_READING_VALID,      ///< Complete measurement.
+  TOF_READING_WEAK,       ///< Measurement flagged noisy; used with less confidence.
+  TOF_READING_NO_TARGET,  ///< Nothing in range; not a distance.
+  TOF_READING_ERROR,      ///< Hardware or algorithm failure; not a distance.
+  TOF_READING_OUTLIER,    ///< Rejected by the filter as a single-sample spike.
+};
+
+/**
+ * @struct TOFFilterConfig
+ * @ingroup sensors
+ * @brief Filter settings for one sensor.
+ */
+struct TOFFilterConfig {
+  uint8_t medianWindow = 3;    ///< Readings in the median, 1 (off) to TOF_FILTER_MAX_WINDOW.
+  float alpha = 0.5f;          ///< Alpha-beta position gain, 0 to 1. 1 follows the median.
+  float beta = 0.05f;          ///< Alpha-beta rate gain. 0 disables rate tracking.
+  int16_t maxJump = 150;       ///< Step (mm) from the prediction that re-seeds, not smooths.
+  uint8_t maxOutliers = 3;     ///< Jumps in a row accepted without a full median; 1 takes all.
+  int16_t minRange = 20;       ///< Readings below this (mm) are treated as errors.
+  int16_t maxRange = 2000;     ///< Readings above this (mm) count as no target.
+  float minConfidence = 0.4f;  ///< Confidence needed for IsValid().
+};
+
+/**
+ * @class TOFFilter
+ * @ingroup sensors
+ * @brief Turns raw VL53L0X readings into a filtered distance with a validity flag.
+ *  Each reading is classified from the device range status and its value. Usable readings go
+ * through a short median, which removes single-sample spikes, then an alpha-beta filter, which
+ * smooths the distance and tracks its rate. Once the window holds three readings, the median has
+ * already removed single spikes, so a median further than maxJump from the alpha-beta prediction
+ * means the target really moved and the filter re-seeds at once. With fewer readings, including a
+ * medianWindow of 1, such a jump is rejected until maxOutliers of them arrive in a row. A new
+ * target starts at the confidence of its first reading, which then rises with good readings and
+ * decays with bad ones; the distance is valid while it stays above minConfidence. Update() is pure
+ * arithmetic.
+ */
+class TOFFilter {
+ public:
+  TOFFilter();
+
+  void Configure(const TOFFilterConfig &config);
+  const TOFFilterConfig &GetConfig() const { return config; }
+  void Reset();
+  TOFReadingKind Update(uint16_t rawMm, uint8_t rangeStatus, uint32_t timeUs);
+
+  bool IsValid() const { return confidence >= config.minConfidence && seeded; }
+  int GetDistance() const { return IsValid() ? static_cast<int>(estimate + 0.5f) : -1; }
+  float GetRate() const { return rate; }
+  float GetConfidence() const { return confidence; }
+  uint16_t GetRaw() const { return raw; }
+  TOFReadingKind GetLastKind() const { return lastKind; }
+  uint32_t GetRejectedCount() const { return rejected; }
+
+  static TOFReadingKind Classify(uint16_t rawMm, uint8_t rangeStatus,
+                                 const TOFFilterConfig &config);
+
+  void PrintInfo(Print &output, bool printConfig = false) const;
+
+ private:
+  TOFFilterConfig config;  ///< Filter settings.
+
+  uint16_t window[TOF_FILTER_MAX_WINDOW];  ///< Recent usable readings, oldest overwritten.
+  uint8_t windowCount;                     ///< Readings in the window.
+  uint8_t windowNext;                      ///< Slot the next reading goes in.
+
+  float estimate;           ///< Filtered distance in mm.
+  float rate;               ///< Filtered rate of change in mm/s.
+  float confidence;         ///< 0 to 1.
+  bool seeded;              ///< Set once the alpha-beta state holds a reading.
+  uint32_t lastTimeUs;      ///< Time of the last accepted reading.
+  uint16_t raw;             ///< Last raw reading.
+  TOFReadingKind lastKind;  ///< Classification of the last reading.
+  uint8_t outliers;         ///< Readings rejected in a row.
+  uint32_t rejected;        ///< Readings rejected since Reset().
+
+  float median() const;
+  void seed(float distance, uint32_t timeUs);
+};
+
+#endif  // TOFFILTER_H
@@ -6,21 +6,40 @@
  */
 #include "TOFHandler.h"
 
-#include <Arduino.h>  // For Serial, F()
+#include <Arduino.h>  // For F()
+
+#include "../util/Logger.h"
 
 /**
  * @brief Constructs a TOFHandler object.
  *  Stores the I2C multiplexer channel assignments and the number of sensors.
  * Dynamically allocates memory for sensor objects and distance readings.
+ * @param bus I2C bus the sensors and their multiplexer are on.
  * @param multiplexerChannels Pointer to an array of integers, where each integer is the
  * I2C multiplexer channel for the corresponding sensor.
  * @param numSensors The total number of VL53L0X sensors to manage.
  */
-TOFHandler::TOFHandler(int *multiplexerChannels, int numSensors) {
+TOFHandler::TOFHandler(I2CBus &bus, int *multiplexerChannels, int numSensors) : bus(bus) {
   this->i2cMultiplexerChannels = multiplexerChannels;
   this->numManagedSensors = numSensors;
   tofSensors = new VL53L0X[numManagedSensors];
+  health = new I2CDeviceHealth[numManagedSensors];
+  filters = new TOFFilter[numManagedSensors];
+  settings = new TOFSetting[numManagedSensors];
+  applied = new TOFSetting[numManagedSensors];
+  pollTimes = new uint32_t[numManagedSensors];
   measuredDistances = new int[numManagedSensors];
+  sampleTimes = new uint32_t[numManagedSensors];
+  activeTimes = new uint32_t[numManagedSensors];
+  for (int i = 0; i < numManagedSensors; i++) {
+    measuredDistances[i] = -1;
+    sampleTimes[i] = 0;
+    activeTimes[i] = 0;
+    pollTimes[i] = 0;
+  }
+  nextSensor = 0;
+  reinitSensor = -1;
+  reinitStep = 0;
 }
 
 /**
@@ -30,55 +49,365 @@ TOFHandler::TOFHandler(int *multiplexerChannels, int numSensors) {
  */
 TOFHandler::~TOFHandler() {
   delete[] tofSensors;
+  delete[] health;
+  delete[] filters;
+  delete[] settings;
+  delete[] applied;
+  delete[] pollTimes;
   delete[] measuredDistances;
+  delete[] sampleTimes;
+  delete[] activeTimes;
 }
 
 /**
  * @brief Initializes all configured VL53L0X sensors.
- *  Iterates through each sensor, selects its I2C multiplexer channel,
- * sets the I2C bus (Wire1), and initializes the sensor. Configures sensor
- * parameters like signal rate limit, measurement timing budget, and VCSEL pulse periods.
- * Starts continuous measurement mode for all sensors.
- * @return True if all sensors were successfully initialized, false if any sensor fails.
+ *  Calls BeginSensor() for every sensor that is not ready yet. For a faster boot, call
+ * BeginSensor() for one sensor at a time from the main loop instead.
+ * @return True if all sensors are ready, false if any sensor failed.
  */
 bool TOFHandler::Begin() {
-  bool success = true;
   for (int i = 0; i < numManagedSensors; i++) {
-    i2cmux::tcaselect(i2cMultiplexerChannels[i]);  // Select I2C mux channel
-    tofSensors[i].setBus(&Wire1);                  // Assuming sensors are on I2C bus Wire1
-    // sensors[i].setTimeout(500); // Optional: set sensor timeout
-    if (!tofSensors[i].init()) {
-      Serial.print(F("Failed to detect and initialize sensor at mux channel "));
-      Serial.println(i2cMultiplexerChannels[i]);
-      success = false;  // Mark as failed but continue trying others
+    if (!health[i].Usable()) {
+      BeginSensor(i);
+    }
+  }
+  return GetReadyCount() == numManagedSensors;
+}
+
+/**
+ * @brief Initializes one VL53L0X sensor.
+ *  Sets the sensor's I2C bus and initializes the sensor. Configures sensor parameters like signal
+ * rate limit, measurement timing budget, and VCSEL pulse periods, then starts continuous
+ * measurement mode. Update() skips the sensor until this succeeds, so a failed sensor can be
+ * retried later. Runs every step of initStep() at once through I2CBus::Run(), so the traffic is
+ * counted in the bus statistics and failures feed the bus recovery. A failure also counts against
+ * the sensor's health, and pushes back the next background re-init of a failed sensor.
+ * @param index The index of the sensor (0 to numManagedSensors-1).
+ * @return True if the sensor is ready.
+ */
+bool TOFHandler::BeginSensor(int index) {
+  if (index < 0 || index >= numManagedSensors) {
+    return false;
+  }
+  if (!bus.Run(i2cMultiplexerChannels[index], "tof init", beginSensorTransaction, this, index)) {
+    health[index].errors++;
+    if (health[index].state == I2C_HEALTH_FAILED) {
+      health[index].Fail();
+    }
+    LOG_ERROR(F("Failed to detect and initialize sensor at mux channel "),
+              i2cMultiplexerChannels[index]);
+    return false;
+  }
+  return true;
+}
+
+/**
+ * @brief I2CBus transaction that runs every init step; the channel is already selected.
+ * @param context The TOFHandler.
+ * @param index The index of the sensor.
+ * @return False if a step failed.
+ */
+bool TOFHandler::beginSensorTransaction(void *context, uint8_t index) {
+  TOFHandler *handler = static_cast<TOFHandler *>(context);
+  for (uint8_t step = 0; step < TOF_INIT_STEPS; step++) {
+    if (!handler->initStep(index, step, TOF_INIT_TIMEOUT_MS)) {
+      return false;
     }
-    // Configure sensor parameters for potentially better performance/accuracy
-    tofSensors[i].setSignalRateLimit(0.10f);          // Set signal rate limit
-    tofSensors[i].setMeasurementTimingBudget(20000);  // Set timing budget in microseconds
-    tofSensors[i].setVcselPulsePeriod(VL53L0X::VcselPeriodPreRange,
-                                      18);  // Set VCSEL pre-range pulse period
-    tofSensors[i].setVcselPulsePeriod(VL53L0X::VcselPeriodFinalRange,
-                                      14);  // Set VCSEL final-range pulse period
-    tofSensors[i].startContinuous();        // Start continuous ranging mode
   }
-  return success;
+  handler->tofSensors[index].setTimeout(TOF_IO_TIMEOUT_MS);  // For driver calls from Update()
+  return true;
+}
+
+/**
+ * @brief Runs one step of sensor initialization; the channel must already be selected.
+ *  init() and each VCSEL change run a reference calibration, so they get their own steps to keep
+ * a background re-init from stalling the loop.
+ * @param index The index of the sensor (0 to numManagedSensors-1).
+ * @param step Step to run, 0 to TOF_INIT_STEPS-1. The last step starts ranging.
+ * @param timeoutMs Bound on each of the driver's polling loops, e.g. a calibration that never
+ * completes on a wedged sensor. Set in step 0.
+ * @return False if the step failed.
+ */
+bool TOFHandler::initStep(int index, uint8_t step, uint16_t timeoutMs) {
+  VL53L0X &sensor = tofSensors[index];
+  switch (step) {
+    case 0:
+      sensor.setBus(&bus.GetWire());
+      sensor.setTimeout(timeoutMs);  // Without a timeout init() can spin forever
+      return sensor.init();
+    case 1:
+      // Configure sensor parameters for potentially better performance/accuracy
+      return sensor.setSignalRateLimit(0.10f) &&                      // Set signal rate limit
+             sensor.setMeasurementTimingBudget(settings[index].budgetUs);  // Timing budget (us)
+    case 2:
+      return sensor.setVcselPulsePeriod(VL53L0X::VcselPeriodPreRange, 18);  // Pre-range period
+    case 3:
+      return sensor.setVcselPulsePeriod(VL53L0X::VcselPeriodFinalRange, 14);  // Final-range period
+    default:
+      applied[index].budgetUs = settings[index].budgetUs;
+      startRanging(index);
+      if (sensor.last_status != 0) return false;
+      health[index].Ok();
+      return true;
+  }
+}
+
+/**
+ * @brief Starts ranging as the sensor's setting asks; the channel must already be selected.
+ *  Idle sensors use timed mode so they measure, and interfere with the others, less often.
+ * @param index The index of the sensor (0 to numManagedSensors-1).
+ */
+void TOFHandler::startRanging(int index) {
+  const TOFPriority priority = settings[index].priority;
+  if (priority == TOF_PRIORITY_IDLE) {
+    tofSensors[index].startContinuous(TOF_IDLE_PERIOD_MS);
+  } else if (priority != TOF_PRIORITY_OFF) {
+    tofSensors[index].startContinuous();  // Back to back, one result per budget
+  }
+  applied[index].priority = priority;
+  filters[index].Reset();
+  measuredDistances[index] = -1;
+  sampleTimes[index] = 0;
+  activeTimes[index] = micros();
+}
+
+/**
+ * @brief Checks whether a sensor has been initialized.
+ * @param index The index of the sensor (0 to numManagedSensors-1).
+ * @return True if BeginSensor() succeeded for the sensor and it has not failed since. False for
+ * an invalid index.
+ */
+bool TOFHandler::IsSensorReady(int index) const {
+  return index >= 0 && index < numManagedSensors && health[index].Usable();
+}
+
+/**
+ * @brief Counts the initialized sensors.
+ * @return Number of sensors for which BeginSensor() succeeded.
+ */
+int TOFHandler::GetReadyCount() const {
+  int count = 0;
+  for (int i = 0; i < numManagedSensors; i++) {
+    if (health[i].Usable()) count++;
+  }
+  return count;
 }
 
 /**
- * @brief Updates distance readings from all sensors.
- *  For each sensor, selects its I2C multiplexer channel and reads the
- * latest distance measurement in continuous mode. Stores the reading in millimeters.
- * If a timeout occurs during a read, a message is printed to Serial.
+ * @brief Queues a check for new distances on the I2C bus.
+ *  Queues up to TOF_POLLS_PER_UPDATE running sensors: HIGH sensors first, then NORMAL and due
+ * IDLE sensors in turn, continuing from where the last call stopped. The readings arrive when the
+ * bus runs its queue. A sensor without a new result is left for a later call instead of being
+ * waited on. Sensors that are not ready are skipped and keep their last reading (-1 if they have
+ * never been read). Also advances any background re-init or setting change.
  */
 void TOFHandler::Update() {
+  updateReinit();
+  updateSettings();
+  const uint32_t now = micros();
   for (int i = 0; i < numManagedSensors; i++) {
-    i2cmux::tcaselect(i2cMultiplexerChannels[i]);
-    measuredDistances[i] = tofSensors[i].readRangeContinuousMillimeters();
-    if (tofSensors[i].timeoutOccurred()) {
-      Serial.print(F("TOF Sensor Timeout: Mux Channel "));
-      Serial.println(i2cMultiplexerChannels[i]);
+    if (!health[i].Usable() || applied[i].priority == TOF_PRIORITY_OFF) continue;
+    if (now - activeTimes[i] > TOF_STALE_US) {
+      LOG_WARN(F("TOF stopped reporting: Mux Channel "), i2cMultiplexerChannels[i]);
+      markFailed(i);
     }
   }
+
+  int polled = 0;
+  for (int i = 0; i < numManagedSensors && polled < TOF_POLLS_PER_UPDATE; i++) {
+    if (!health[i].Usable() || applied[i].priority != TOF_PRIORITY_HIGH) continue;
+    bus.Submit(i2cMultiplexerChannels[i], "tof", pollSensor, this, i);
+    pollTimes[i] = now;
+    polled++;
+  }
+  for (int checked = 0; checked < numManagedSensors && polled < TOF_POLLS_PER_UPDATE; checked++) {
+    const int index = nextSensor;
+    nextSensor = (nextSensor + 1) % numManagedSensors;
+    if (!health[index].Usable()) continue;
+    const TOFPriority priority = applied[index].priority;
+    if (priority == TOF_PRIORITY_OFF || priority == TOF_PRIORITY_HIGH) continue;
+    if (priority == TOF_PRIORITY_IDLE && now - pollTimes[index] < TOF_IDLE_POLL_US) continue;
+    bus.Submit(i2cMultiplexerChannels[index], "tof", pollSensor, this, index);
+    pollTimes[index] = now;
+    polled++;
+  }
+}
+
+/**
+ * @brief Changes the sampling priority and timing budget of one sensor.
+ *  Takes effect in the background on a later Update(), or when the sensor is next started.
+ * @param index The index of the sensor (0 to numManagedSensors-1).
+ * @param priority Sampling priority.
+ * @param budgetUs Measurement timing budget, at least TOF_MIN_BUDGET_US.
+ */
+void TOFHandler::SetSetting(int index, TOFPriority priority, uint32_t budgetUs) {
+  if (index < 0 || index >= numManagedSensors) return;
+  settings[index].priority = priority;
+  settings[index].budgetUs = max(budgetUs, (uint32_t)TOF_MIN_BUDGET_US);
+}
+
+/**
+ * @brief Changes the settings of every sensor, e.g. when the mission phase changes.
+ * @param profile One setting per sensor.
+ */
+void TOFHandler::ApplyProfile(const TOFSetting *profile) {
+  for (int i = 0; i < numManagedSensors; i++) {
+    SetSetting(i, profile[i].priority, profile[i].budgetUs);
+  }
+}
+
+/**
+ * @brief Queues a setting change for the first running sensor whose setting differs.
+ */
+void TOFHandler::updateSettings() {
+  for (int i = 0; i < numManagedSensors; i++) {
+    if (!health[i].Usable()) continue;
+    if (applied[i].priority != settings[i].priority ||
+        applied[i].budgetUs != settings[i].budgetUs) {
+      bus.Submit(i2cMultiplexerChannels[i], "tof config", applySetting, this, i);
+      return;
+    }
+  }
+}
+
+/**
+ * @brief I2CBus transaction that writes a sensor's new setting; the channel is already selected.
+ *  Ranging is stopped while the budget changes, then restarted in the mode the priority asks for.
+ * @param context The TOFHandler.
+ * @param index The index of the sensor.
+ * @return False on a bus error.
+ */
+bool TOFHandler::applySetting(void *context, uint8_t index) {
+  TOFHandler *handler = static_cast<TOFHandler *>(context);
+  if (!handler->health[index].Usable()) return true;  // Re-init applies it instead
+  VL53L0X &sensor = handler->tofSensors[index];
+  const TOFSetting &setting = handler->settings[index];
+  sensor.stopContinuous();
+  if (handler->applied[index].budgetUs != setting.budgetUs) {
+    if (!sensor.setMeasurementTimingBudget(setting.budgetUs)) {
+      handler->health[index].Error();
+      return false;  // Retried on the next Update()
+    }
+    handler->applied[index].budgetUs = setting.budgetUs;
+  }
+  handler->startRanging(index);
+  if (sensor.last_status != 0) {
+    handler->health[index].Error();
+    return false;
+  }
+  return true;
+}
+
+/**
+ * @brief I2CBus transaction that polls one sensor; the channel is already selected.
+ * @param context The TOFHandler.
+ * @param index The index of the sensor.
+ * @return False on a bus error.
+ */
+bool TOFHandler::pollSensor(void *context, uint8_t index) {
+  TOFHandler *handler = static_cast<TOFHandler *>(context);
+  if (!handler->health[index].Usable()) return true;  // Failed while queued
+  const bool ok = handler->readIfReady(index);
+  if (ok) {
+    handler->health[index].Ok();
+  } else {
+    handler->health[index].Error();
+    if (handler->health[index].state == I2C_HEALTH_FAILED) {
+      LOG_WARN(F("TOF failed: Mux Channel "), handler->i2cMultiplexerChannels[index]);
+      handler->markFailed(index);
+    }
+  }
+  return ok;
+}
+
+/**
+ * @brief Marks a sensor failed so it is re-initialized, and clears its distance.
+ * @param index The index of the sensor (0 to numManagedSensors-1).
+ */
+void TOFHandler::markFailed(int index) {
+  if (health[index].state != I2C_HEALTH_FAILED) {
+    health[index].Fail();
+  }
+  filters[index].Reset();
+  measuredDistances[index] = -1;
+  sampleTimes[index] = 0;
+}
+
+/**
+ * @brief Queues the next step of a background re-init, choosing a sensor if none is in progress.
+ */
+void TOFHandler::updateReinit() {
+  if (reinitSensor < 0) {
+    for (int i = 0; i < numManagedSensors; i++) {
+      if (health[i].RetryDue()) {
+        reinitSensor = i;
+        reinitStep = 0;
+        break;
+      }
+    }
+    if (reinitSensor < 0) return;
+  }
+  bus.Submit(i2cMultiplexerChannels[reinitSensor], "tof init", reinitStepTransaction, this,
+             reinitSensor);
+}
+
+/**
+ * @brief I2CBus transaction that runs one re-init step; the channel is already selected.
+ *  A failed step ends the attempt and pushes the next one back. The last step makes the sensor
+ * usable again. A wedged sensor stalls the step for at most TOF_IO_TIMEOUT_MS, once per attempt.
+ * @param context The TOFHandler.
+ * @param index The index of the sensor.
+ * @return False if the step failed.
+ */
+bool TOFHandler::reinitStepTransaction(void *context, uint8_t index) {
+  TOFHandler *handler = static_cast<TOFHandler *>(context);
+  if (handler->reinitSensor != index) return true;  // Already handled, e.g. by BeginSensor()
+  if (handler->health[index].state != I2C_HEALTH_FAILED) {
+    handler->reinitSensor = -1;
+    return true;
+  }
+  const bool ok = handler->initStep(index, handler->reinitStep, TOF_IO_TIMEOUT_MS);
+  if (!ok) {
+    handler->health[index].errors++;
+    handler->health[index].Fail();
+    handler->reinitSensor = -1;
+  } else if (++handler->reinitStep >= TOF_INIT_STEPS) {
+    LOG_INFO(F("TOF restarted: Mux Channel "), handler->i2cMultiplexerChannels[index]);
+    handler->reinitSensor = -1;
+  }
+  return ok;
+}
+
+/**
+ * @brief Reads one sensor's distance if its measurement is complete.
+ *  Does what readRangeContinuousMillimeters() does after its busy-wait: checks the interrupt
+ * status, reads the range and clears the interrupt so the sensor can report the next result. The
+ * range status is read in the same transfer and passed to the sensor's filter with the range.
+ * @param index The index of the sensor (0 to numManagedSensors-1).
+ * @return False if a transfer failed; true whether or not a new distance was ready.
+ */
+bool TOFHandler::readIfReady(int index) {
+  VL53L0X &sensor = tofSensors[index];
+  const uint8_t status = sensor.readReg(VL53L0X::RESULT_INTERRUPT_STATUS);
+  if (sensor.last_status != 0) {
+    return false;
+  }
+  if ((status & 0x07) == 0) {
+    return true;
+  }
+  uint8_t result[12];  // RESULT_RANGE_STATUS block: status first, range at offset 10
+  sensor.readMulti(VL53L0X::RESULT_RANGE_STATUS, result, sizeof(result));
+  if (sensor.last_status != 0) {
+    return false;
+  }
+  sensor.writeReg(VL53L0X::SYSTEM_INTERRUPT_CLEAR, 0x01);
+  const uint32_t now = micros();
+  const uint16_t range = (static_cast<uint16_t>(result[10]) << 8) | result[11];
+  filters[index].Update(range, result[0], now);
+  measuredDistances[index] = filters[index].GetDistance();
+  sampleTimes[index] = now ? now : 1;
+  activeTimes[index] = now;
+  return sensor.last_status == 0;
 }
 
 /**
@@ -91,10 +420,10 @@ const int *TOFHandler::GetDistances() const { return measuredDistances; }
 
 /**
  * @brief Gets the distance reading for a specific sensor by its index.
- *  Retrieves the last measured distance for the sensor at the given index.
+ *  Retrieves the last filtered distance for the sensor at the given index.
  * @param index The index of the sensor (0 to numManagedSensors-1).
  * @return The distance in millimeters for the specified sensor. Returns -1 if the
- * index is out of bounds.
+ * index is out of bounds or the sensor has no valid distance.
  */
 int TOFHandler::GetDistanceAtIndex(int index) const {
   if (index >= 0 && index < numManagedSensors) {
@@ -103,6 +432,55 @@ int TOFHandler::GetDistanceAtIndex(int index) const {
   return -1;  // Indicate an error or out-of-bounds index
 }
 
+/**
+ * @brief Gets the unfiltered range register value of a sensor's last reading.
+ *  Includes readings the filter rejected, e.g. 8190 for no target.
+ * @param index The index of the sensor (0 to numManagedSensors-1).
+ * @return The raw reading in millimeters, or -1 if never read or the index is out of bounds.
+ */
+int TOFHandler::GetRawDistance(int index) const {
+  if (index >= 0 && index < numManagedSensors && sampleTimes[index] != 0) {
+    return filters[index].GetRaw();
+  }
+  return -1;
+}
+
+/**
+ * @brief Changes the filter settings of one sensor and resets its filter.
+ * @param index The index of the sensor (0 to numManagedSensors-1).
+ * @param config New filter settings.
+ */
+void TOFHandler::SetFilterConfig(int index, const TOFFilterConfig &config) {
+  if (index >= 0 && index < numManagedSensors) {
+    filters[index].Configure(config);
+    measuredDistances[index] = -1;
+  }
+}
+
+/**
+ * @brief Gets the time a sensor's distance was read.
+ * @param index The index of the sensor (0 to numManagedSensors-1).
+ * @return micros() at which the reading was taken, or 0 if the sensor has never been read.
+ */
+uint32_t TOFHandler::GetSampleTime(int index) const {
+  if (index >= 0 && index < numManagedSensors) {
+    return sampleTimes[index];
+  }
+  return 0;
+}
+
+/**
+ * @brief Gets how old a sensor's distance is.
+ *  A sensor that stops reporting keeps its last distance, so check the age before trusting it.
+ * @param index The index of the sensor (0 to numManagedSensors-1).
+ * @return Age of the reading in microseconds, or TOF_NO_SAMPLE if there is none.
+ */
+uint32_t TOFHandler::GetSampleAge(int index) const {
+  const uint32_t time = GetSampleTime(index);
+  if (time == 0) return TOF_NO_SAMPLE;
+  return micros() - time;
+}
+
 /**
  * @brief Prints TOFHandler configuration or current distance readings.
  *  If `printConfig` is true, outputs the number of channels and their
@@ -124,6 +502,30 @@ void TOFHandler::PrintInfo(Print &output, bool printConfig) const {
       }
     }
     output.println();
+    output.print(F("  Sensors Polled per Update: "));
+    output.println(TOF_POLLS_PER_UPDATE);
+    for (int i = 0; i < numManagedSensors; i++) {
+      output.print(F("  Filter "));
+      output.print(i);
+      output.print(F(": "));
+      filters[i].PrintInfo(output, true);
+    }
+    output.print(F("  Priority/budget (us): "));
+    for (int i = 0; i < numManagedSensors; i++) {
+      static const char priorities[] = {'-', 'I', 'N', 'H'};
+      output.print(priorities[settings[i].priority]);
+      output.print('/');
+      output.print(settings[i].budgetUs);
+      if (i < numManagedSensors - 1) {
+        output.print(F(", "));
+      }
+    }
+    output.println();
+    output.print(F("  Re-init after: "));
+    output.print(I2C_FAIL_AFTER_ERRORS);
+    output.print(F(" errors or "));
+    output.print(TOF_STALE_US / 1000);
+    output.println(F(" ms without a result"));
   } else {
     output.print(F("TOF Distances (mm): ["));
     for (int i = 0; i < numManagedSensors; i++) {
@@ -133,6 +535,42 @@ void TOFHandler::PrintInfo(Print &output, bool printConfig) const {
       }
     }
     output.println(F("]"));
+    output.print(F("TOF Raw (mm, confidence): ["));
+    for (int i = 0; i < numManagedSensors; i++) {
+      output.print(GetRawDistance(i));
+      output.print(' ');
+      output.print(filters[i].GetConfidence());
+      if (i < numManagedSensors - 1) {
+        output.print(F(", "));
+      }
+    }
+    output.println(F("]"));
+    output.print(F("TOF Health (errors/re-inits): ["));
+    for (int i = 0; i < numManagedSensors; i++) {
+      static const char states[] = {'-', 'O', 'D', 'F'};
+      output.print(states[health[i].state]);
+      output.print(' ');
+      output.print(health[i].errors);
+      output.print('/');
+      output.print(health[i].reinits);
+      if (i < numManagedSensors - 1) {
+        output.print(F(", "));
+      }
+    }
+    output.println(F("]"));
+    output.print(F("TOF Ages (ms): ["));
+    for (int i = 0; i < numManagedSensors; i++) {
+      const uint32_t age = GetSampleAge(i);
+      if (age == TOF_NO_SAMPLE) {
+        output.print('-');
+      } else {
+        output.print(age / 1000);
+      }
+      if (i < numManagedSensors - 1) {
+        output.print(F(", "));
+      }
+    }
+    output.println(F("]"));
   }
 }
 
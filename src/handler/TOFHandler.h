@@ -16,7 +16,42 @@
 #include <VL53L0X.h>  // Adafruit VL53L0X library
 #include <Wire.h>     // Required for I2C communication
 
-#include "i2cmux.h"  // Custom I2C multiplexer library (ensure path is correct)
+#include "I2CBus.h"
+#include "TOFFilter.h"
+
+#define TOF_POLLS_PER_UPDATE 2       ///< Data-ready checks per Update(), to bound its I2C time.
+#define TOF_NO_SAMPLE UINT32_MAX     ///< Sample age of a sensor that has never been read.
+#define TOF_INIT_TIMEOUT_MS 50       ///< Bound on the driver's polling loops in BeginSensor().
+#define TOF_IO_TIMEOUT_MS 10         ///< The same bound once running and in background re-inits.
+#define TOF_STALE_US 250000          ///< A running sensor with no result for this long restarts.
+#define TOF_INIT_STEPS 5             ///< Steps of a background re-init, one per Update().
+#define TOF_DEFAULT_BUDGET_US 20000  ///< Measurement timing budget until a setting changes it.
+#define TOF_MIN_BUDGET_US 20000      ///< Shortest timing budget accepted.
+#define TOF_IDLE_PERIOD_MS 100       ///< Time between measurements of an idle sensor.
+#define TOF_IDLE_POLL_US 50000       ///< Time between data-ready checks of an idle sensor.
+
+/**
+ * @enum TOFPriority
+ * @ingroup sensors
+ * @brief How much a sensor matters right now.
+ */
+enum TOFPriority : uint8_t {
+  TOF_PRIORITY_OFF,     ///< Ranging stopped; distance reads -1.
+  TOF_PRIORITY_IDLE,    ///< Measures every TOF_IDLE_PERIOD_MS and is checked rarely.
+  TOF_PRIORITY_NORMAL,  ///< Measures back to back and shares the remaining polls in turn.
+  TOF_PRIORITY_HIGH,    ///< Measures back to back and is checked on every Update().
+};
+
+/**
+ * @struct TOFSetting
+ * @ingroup sensors
+ * @brief Sampling priority and measurement timing budget of one sensor.
+ *  A table of one setting per sensor is a profile, switched with ApplyProfile().
+ */
+struct TOFSetting {
+  TOFPriority priority = TOF_PRIORITY_NORMAL;  ///< Sampling priority.
+  uint32_t budgetUs = TOF_DEFAULT_BUDGET_US;   ///< Longer is more accurate, shorter is faster.
+};
 
 /**
  * @class TOFHandler
@@ -24,26 +59,71 @@
  * @brief Manages multiple VL53L0X Time-of-Flight distance sensors using an I2C multiplexer.
  *  This class handles the initialization, update, and data retrieval for an array of
  * VL53L0X sensors, each connected to a different channel of an I2C multiplexer.
+ *  Update() never waits for a measurement. It queues a data-ready check for up to
+ * TOF_POLLS_PER_UPDATE sensors on the I2CBus, and the check reads only sensors with a new result,
+ * so each costs at most a few I2C transactions. Call Update() several times per timing budget.
+ *  Each reading passes through the sensor's TOFFilter, so GetDistanceAtIndex() returns a filtered
+ * distance, or -1 when there is no target or the readings cannot be trusted.
+ *  Each sensor has a TOFSetting. HIGH sensors are checked on every call, NORMAL sensors share the
+ * remaining polls, and IDLE sensors measure slowly and are checked rarely, so the sensors the
+ * current phase needs run at their full rate. A changed setting is written to the sensor in the
+ * background, one sensor per Update().
+ *  A sensor that keeps failing, or stops producing results, is marked failed and re-initialized
+ * in the background: one init step per Update(), at most one sensor at a time, with a growing
+ * delay between attempts. Its distance reads -1 until it is back.
  */
 class TOFHandler {
  public:
-  TOFHandler(int *multiplexerChannels, int numSensors);  // Renamed params for clarity
+  TOFHandler(I2CBus &bus, int *multiplexerChannels, int numSensors);
   ~TOFHandler();
 
   bool Begin();
+  bool BeginSensor(int index);
+  bool IsSensorReady(int index) const;
+  int GetReadyCount() const;
   void Update();
   const int *GetDistances() const;          // Renamed for clarity
   int GetDistanceAtIndex(int index) const;  // Renamed for clarity
+  uint32_t GetSampleTime(int index) const;
+  uint32_t GetSampleAge(int index) const;
+  const I2CDeviceHealth &GetHealth(int index) const { return health[index]; }
+  int GetRawDistance(int index) const;
+  const TOFFilter &GetFilter(int index) const { return filters[index]; }
+  void SetFilterConfig(int index, const TOFFilterConfig &config);
+  void SetSetting(int index, TOFPriority priority, uint32_t budgetUs = TOF_DEFAULT_BUDGET_US);
+  void ApplyProfile(const TOFSetting *profile);
+  const TOFSetting &GetSetting(int index) const { return settings[index]; }
 
   void PrintInfo(Print &output, bool printConfig = false) const;
   friend Print &operator<<(Print &output, const TOFHandler &handler);
 
  private:
+  I2CBus &bus;                  ///< Bus the sensors are on, which selects their mux channels.
   int *i2cMultiplexerChannels;  ///< Array of I2C multiplexer channel numbers for each sensor.
   int numManagedSensors;        ///< The number of TOF sensors being managed.
   VL53L0X *tofSensors;          ///< Dynamically allocated array of VL53L0X sensor objects.
-  int *measuredDistances;  ///< Dynamically allocated array to store the latest distance from each
-                           ///< sensor.
+  I2CDeviceHealth *health;      ///< Per-sensor health; usable once BeginSensor() succeeds.
+  TOFFilter *filters;           ///< Per-sensor validation and smoothing.
+  TOFSetting *settings;         ///< Requested priority and budget of each sensor.
+  TOFSetting *applied;          ///< Priority and budget each sensor is running with.
+  uint32_t *pollTimes;          ///< micros() of each sensor's last queued data-ready check.
+  int *measuredDistances;       ///< Latest filtered distance of each sensor, -1 if not valid.
+  uint32_t *sampleTimes;        ///< micros() at which each sensor's distance was read, 0 if never.
+  uint32_t *activeTimes;        ///< micros() of each sensor's last result or start, for staleness.
+  int nextSensor;               ///< Sensor Update() checks first on its next call.
+  int reinitSensor;             ///< Sensor being re-initialized in the background, -1 if none.
+  uint8_t reinitStep;           ///< Next init step of reinitSensor.
+
+  bool readIfReady(int index);
+  bool initStep(int index, uint8_t step, uint16_t timeoutMs);
+  void markFailed(int index);
+  void updateReinit();
+  void updateSettings();
+  void startRanging(int index);
+  static bool pollSensor(void *context, uint8_t index);
+  static bool beginSensorTransaction(void *context, uint8_t index);
+  static bool reinitStepTransaction(void *context, uint8_t index);
+  static bool applySetting(void *context, uint8_t index);
 };
 
 #endif  // TOFHANDLER_H
\ No newline at end of file
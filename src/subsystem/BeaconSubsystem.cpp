@@ -16,7 +16,7 @@
  * @param servos Reference to the ServoHandler instance.
  */
 BeaconSubsystem::BeaconSubsystem(int servoIndex, ServoHandler &servos)
-    : indexBeacon(servoIndex), servos(servos) {}
+    : indexBeacon(servoIndex), servos(servos), config() {}
 
 /**
  * @brief Initializes the beacon subsystem.
@@ -25,27 +25,52 @@ BeaconSubsystem::BeaconSubsystem(int servoIndex, ServoHandler &servos)
 void BeaconSubsystem::Begin() { MoveUp(); }
 
 /**
- * @brief Moves the beacon to the fully up/deployed position.
- *  Commands the beacon servo to the predefined `UP` angle.
+ * @brief Initializes the beacon subsystem with tuned servo angles.
+ * @param config Servo angles to use from now on.
  */
-void BeaconSubsystem::MoveUp() {
-  servos.WriteServoAngle(indexBeacon, BeaconSubsystem::Positions::UP);
+void BeaconSubsystem::Begin(const Config &config) {
+  this->config = config;
+  Begin();
 }
 
+/**
+ * @brief Moves the beacon to the fully up/deployed position.
+ *  Commands the beacon servo to the configured `up` angle.
+ */
+void BeaconSubsystem::MoveUp() { servos.WriteServoAngle(indexBeacon, config.up); }
+
 /**
  * @brief Moves the beacon to the fully down/retracted position with an optional offset.
- *  Commands the beacon servo through a sequence of predefined `DOWN1` and `DOWN2`
- * positions with delays, then to the final `DOWN` position plus any specified offset.
+ *  Commands the beacon servo through the configured `down1` and `down2`
+ * positions with delays, then to the final `down` position plus any specified offset.
  * This staged movement can be for mechanical reasons or smoother operation.
- * @param offset An optional offset angle (in degrees) to add to the final `DOWN` position.
+ * @param offset An optional offset angle (in degrees) to add to the final `down` position.
  * Defaults to 0.
  */
 void BeaconSubsystem::MoveDown(int offset) {
-  servos.WriteServoAngle(indexBeacon, BeaconSubsystem::Positions::DOWN1);
+  MoveDown1();
   delay(200);  // Wait for servo to reach intermediate position
-  servos.WriteServoAngle(indexBeacon, BeaconSubsystem::Positions::DOWN2);
+  MoveDown2();
   delay(200);  // Wait for servo to reach another intermediate position
-  servos.WriteServoAngle(indexBeacon, BeaconSubsystem::Positions::DOWN + offset);
+  MoveDownFinal(offset);
+}
+
+/**
+ * @brief Moves the beacon to the first stage of retraction, the configured `down1` angle.
+ */
+void BeaconSubsystem::MoveDown1() { servos.WriteServoAngle(indexBeacon, config.down1); }
+
+/**
+ * @brief Moves the beacon to the second stage of retraction, the configured `down2` angle.
+ */
+void BeaconSubsystem::MoveDown2() { servos.WriteServoAngle(indexBeacon, config.down2); }
+
+/**
+ * @brief Moves the beacon to the configured `down` angle plus an optional offset.
+ * @param offset An optional offset angle (in degrees) to add to the `down` position.
+ */
+void BeaconSubsystem::MoveDownFinal(int offset) {
+  servos.WriteServoAngle(indexBeacon, config.down + offset);
 }
 
 /**
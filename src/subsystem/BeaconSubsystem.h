@@ -19,29 +19,36 @@
  * @ingroup subsystems
  * @brief Controls a servo-actuated beacon mechanism.
  * Manages the movement of a beacon, typically to deploy (up) or retract (down) it,
- * using predefined servo positions.
+ * using the servo positions in Config. MoveDown() steps through the stages with blocking delays;
+ * a mission can instead call MoveDown1(), MoveDown2() and MoveDownFinal() with its own dwells.
  */
 class BeaconSubsystem {
  public:
   /**
-   * @brief Predefined servo angle positions for the beacon.
+   * @brief Tunable servo angles. Stored by ConfigStore.
    */
-  enum Positions : uint8_t {
-    UP = 0,      ///< Servo angle for beacon fully up/deployed.
-    DOWN1 = 20,  ///< Intermediate servo angle for first stage of beacon retraction.
-    DOWN2 = 40,  ///< Intermediate servo angle for second stage of beacon retraction.
-    DOWN = 53    ///< Servo angle for beacon fully down/retracted.
+  struct Config {
+    uint8_t up = 0;      ///< Servo angle for beacon fully up/deployed.
+    uint8_t down1 = 20;  ///< First intermediate angle when retracting.
+    uint8_t down2 = 40;  ///< Second intermediate angle when retracting.
+    uint8_t down = 53;   ///< Servo angle for beacon fully down/retracted.
   };
 
   BeaconSubsystem(int servoIndex, ServoHandler &servos);
   void Begin();
+  void Begin(const Config &config);
+  const Config &GetConfig() const { return config; }
   void MoveUp();
   void MoveDown(int offset = 0);
+  void MoveDown1();
+  void MoveDown2();
+  void MoveDownFinal(int offset = 0);
   void WriteAngle(int angle);
 
  private:
   int indexBeacon;       ///< Index of the beacon servo within the ServoHandler.
   ServoHandler &servos;  ///< Reference to the ServoHandler for controlling the servo.
+  Config config;         ///< Servo angles in use.
 };
 
 #endif  // BEACONSUBSYSTEM_H
\ No newline at end of file
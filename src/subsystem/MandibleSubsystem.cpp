@@ -17,7 +17,8 @@ a/**
 MandibleSubsystem::MandibleSubsystem(int leftServoIndex, int rightServoIndex, ServoHandler &servos)
     : indexLeft(leftServoIndex),
       indexRight(rightServoIndex),
-      servos(servos) {
+      servos(servos),
+      config() {
 }
 
 /**
@@ -29,36 +30,45 @@ void MandibleSubsystem::Begin() {
   CloseRight();
 }
 
+/**
+ * @brief Initializes the mandible subsystem with tuned servo angles.
+ * @param config Servo angles to use from now on.
+ */
+void MandibleSubsystem::Begin(const Config &config) {
+  this->config = config;
+  Begin();
+}
+
 /**
  * @brief Opens the left mandible.
- *  Commands the left mandible servo to its predefined `LEFT_OPEN` position.
+ *  Commands the left mandible servo to its configured `leftOpen` angle.
  */
 void MandibleSubsystem::OpenLeft() {
-  servos.WriteServoAngle(indexLeft, MandibleSubsystem::Positions::LEFT_OPEN);
+  servos.WriteServoAngle(indexLeft, config.leftOpen);
 }
 
 /**
  * @brief Opens the right mandible.
- *  Commands the right mandible servo to its predefined `RIGHT_OPEN` position.
+ *  Commands the right mandible servo to its configured `rightOpen` angle.
  */
 void MandibleSubsystem::OpenRight() {
-  servos.WriteServoAngle(indexRight, MandibleSubsystem::Positions::RIGHT_OPEN);
+  servos.WriteServoAngle(indexRight, config.rightOpen);
 }
 
 /**
  * @brief Closes the left mandible.
- *  Commands the left mandible servo to its predefined `LEFT_CLOSE` position.
+ *  Commands the left mandible servo to its configured `leftClose` angle.
  */
 void MandibleSubsystem::CloseLeft() {
-  servos.WriteServoAngle(indexLeft, MandibleSubsystem::Positions::LEFT_CLOSE);
+  servos.WriteServoAngle(indexLeft, config.leftClose);
 }
 
 /**
  * @brief Closes the right mandible.
- *  Commands the right mandible servo to its predefined `RIGHT_CLOSE` position.
+ *  Commands the right mandible servo to its configured `rightClose` angle.
  */
 void MandibleSubsystem::CloseRight() {
-  servos.WriteServoAngle(indexRight, MandibleSubsystem::Positions::RIGHT_CLOSE);
+  servos.WriteServoAngle(indexRight, config.rightClose);
 }
 
 // Note: The SetState() method declared in MandibleSubsystem.h is not implemented in
@@ -31,8 +31,20 @@ class MandibleSubsystem {
     RIGHT_CLOSE = 55   ///< Servo angle for the right mandible when fully closed.
   };
 
+  /**
+   * @brief Tunable servo angles, defaulting to Positions. Stored by ConfigStore.
+   */
+  struct Config {
+    uint8_t leftOpen = LEFT_OPEN;      ///< Left mandible fully open.
+    uint8_t leftClose = LEFT_CLOSE;    ///< Left mandible fully closed.
+    uint8_t rightOpen = RIGHT_OPEN;    ///< Right mandible fully open.
+    uint8_t rightClose = RIGHT_CLOSE;  ///< Right mandible fully closed.
+  };
+
   MandibleSubsystem(int leftServoIndex, int rightServoIndex, ServoHandler &servos);
   void Begin();
+  void Begin(const Config &config);
+  const Config &GetConfig() const { return config; }
   // void Update(); // Commented out in original, kept here for consistency if it might be added
   void OpenLeft();
   void CloseLeft();
@@ -44,6 +56,7 @@ class MandibleSubsystem {
   int indexLeft;         ///< Index of the left mandible servo within the ServoHandler.
   int indexRight;        ///< Index of the right mandible servo within the ServoHandler.
   ServoHandler &servos;  ///< Reference to the ServoHandler for controlling the servos.
+  Config config;         ///< Servo angles in use.
 };
 
 #endif  // MANDIBLESUBSYSTEM_H
\ No newline at end of file
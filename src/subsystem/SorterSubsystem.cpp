@@ -34,7 +34,10 @@ SorterSubsystem::SorterSubsystem(int tofSensorIndex, int numHallSensors, int ser
       rgb(rgb),
       _state(0),  // Initial state
       _baseReadings(nullptr),
-      objectMagnet(false) {}
+      objectMagnet(false),
+      transferOverride(false),
+      transferOverrideSpeed(0),
+      config() {}
 
 /**
  * @brief Destructor for SorterSubsystem.
@@ -62,12 +65,22 @@ void SorterSubsystem::Begin() {
   MoveCenter();
 }
 
+/**
+ * @brief Initializes the sorter subsystem with tuned angles and threshold.
+ * @param config Servo angles and detection threshold to use from now on.
+ */
+void SorterSubsystem::Begin(const Config &config) {
+  this->config = config;
+  Begin();
+}
+
 /**
  * @brief Updates the sorter subsystem's logic.
  *  This function is intended to be called repeatedly.
  * It currently checks for object presence using the TOF sensor. If an object is within
- * `OBJECT_RANGE`, it stops the transfer motor; otherwise, it runs the transfer motor
- * at a set speed.
+ * the configured `objectRange`, it stops the transfer motor; otherwise, it runs the transfer motor
+ * at a set speed. While a transfer override is active, the motor runs at the override speed
+ * instead.
  * The commented-out state machine logic suggests more complex behavior is intended.
  * States:
  * 0: No object detected. Run transferMotor.
@@ -81,7 +94,9 @@ void SorterSubsystem::Update() {
   int range = tofs.GetDistanceAtIndex(iTOF);  // Use GetDistanceAtIndex
 
   // Basic object detection and transfer motor control
-  if (range < OBJECT_RANGE && range != -1) {  // range == -1 might indicate error
+  if (transferOverride) {
+    transferMotor.Set(transferOverrideSpeed);  // Commanded speed, e.g. dumping the hopper
+  } else if (range < config.objectRange && range != -1) {  // range == -1 might indicate error
     transferMotor.Set(0);                     // Stop motor if object is close
   } else {
     transferMotor.Set(50);  // Run motor if no object or object is far
@@ -92,44 +107,60 @@ void SorterSubsystem::Update() {
   // switch(_state) { ... }
 }
 
+/**
+ * @brief Runs the transfer motor at a fixed speed, ignoring object detection.
+ *  The override is applied on every Update() until ClearTransferOverride() is called, so the
+ * transfer can be run for a timed period without blocking the main loop.
+ * @param speed Transfer motor speed.
+ */
+void SorterSubsystem::SetTransferOverride(int speed) {
+  transferOverride = true;
+  transferOverrideSpeed = speed;
+}
+
+/**
+ * @brief Returns transfer motor control to object detection.
+ */
+void SorterSubsystem::ClearTransferOverride() { transferOverride = false; }
+
 /**
  * @brief Moves the sorter servo to the center position.
- *  Commands the sorting servo to the predefined `CENTER` angle.
+ *  Commands the sorting servo to the configured `center` angle.
  */
 void SorterSubsystem::MoveCenter() {
-  servos.WriteServoAngle(iServo, SorterSubsystem::ServoPositions::CENTER);
+  servos.WriteServoAngle(iServo, config.center);
 }
 
 /**
  * @brief Moves the sorter servo to the left sorting position.
- *  Commands the sorting servo to the predefined `LEFT` angle.
+ *  Commands the sorting servo to the configured `left` angle.
  */
 void SorterSubsystem::MoveLeft() {
-  servos.WriteServoAngle(iServo, SorterSubsystem::ServoPositions::LEFT);
+  servos.WriteServoAngle(iServo, config.left);
 }
 
 /**
  * @brief Moves the sorter servo to the right sorting position.
- *  Commands the sorting servo to the predefined `RIGHT` angle.
+ *  Commands the sorting servo to the configured `right` angle.
  */
 void SorterSubsystem::MoveRight() {
-  servos.WriteServoAngle(iServo, SorterSubsystem::ServoPositions::RIGHT);
+  servos.WriteServoAngle(iServo, config.right);
 }
 
 /**
  * @brief Moves the sorter servo to the soft left sorting position.
- *  Commands the sorting servo to the predefined `SOFTLEFT` angle.
+ *  Commands the sorting servo to the configured `softLeft` angle.
  */
 void SorterSubsystem::MoveSoftLeft() {
-  servos.WriteServoAngle(iServo, SorterSubsystem::ServoPositions::SOFTLEFT);
+  servos.WriteServoAngle(iServo, config.softLeft);
 }
 
 /**
  * @brief Moves the sorter servo to the soft right sorting position.
- *  Commands the sorting servo to the predefined `SOFTRIGHT` angle.
+ *  Commands the sorting servo to the configured `softRight` angle.
  */
 void SorterSubsystem::MoveSoftRight() {
-  servos.WriteServoAngle(iServo, SorterSubsystem::ServoPositions::SOFTRIGHT);
+  servos.WriteServoAngle(iServo, config.softRight);
 }
 
 /**
@@ -156,8 +187,19 @@ void SorterSubsystem::PrintInfo(Print &output, bool printConfig) const {
   output.println();
 
   if (printConfig) {
-    // output.println(F("Sorter Configuration Details:")); // Example
-    // Add more config-specific details if necessary
+    output.print(F("Sorter Configuration: angles "));
+    output.print(config.left);
+    output.print(F("/"));
+    output.print(config.softLeft);
+    output.print(F("/"));
+    output.print(config.center);
+    output.print(F("/"));
+    output.print(config.softRight);
+    output.print(F("/"));
+    output.print(config.right);
+    output.print(F(", object range "));
+    output.print(config.objectRange);
+    output.println(F(" mm"));
   } else {
     output.print(F("Sorter State: "));
     output.println(_state);
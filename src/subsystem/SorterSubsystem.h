@@ -44,12 +44,26 @@ class SorterSubsystem {
     RIGHT = 140       ///< Servo angle for sorting to the right.
   };
 
+  /**
+   * @brief Tunable servo angles and detection threshold. Stored by ConfigStore.
+   */
+  struct Config {
+    uint8_t left = LEFT;                 ///< Servo angle for sorting to the left.
+    uint8_t softLeft = SOFTLEFT;         ///< Servo angle for a soft sort to the left.
+    uint8_t center = CENTER;             ///< Servo angle for the neutral position.
+    uint8_t softRight = SOFTRIGHT;       ///< Servo angle for a soft sort to the right.
+    uint8_t right = RIGHT;               ///< Servo angle for sorting to the right.
+    int16_t objectRange = OBJECT_RANGE;  ///< TOF range (mm) below which an object is present.
+  };
+
   SorterSubsystem(int tofSensorIndex, int numHallSensors, int servoMotorIndex, TOFHandler &tofs,
                   HallHandler &halls, ServoHandler &servos, DriveMotor &transferMotor,
                   RGBHandler &rgb);
   ~SorterSubsystem();  // Destructor to free _baseReadings
 
   void Begin();
+  void Begin(const Config &config);
+  const Config &GetConfig() const { return config; }
   void Update();
 
   void MoveCenter();
@@ -61,6 +75,8 @@ class SorterSubsystem {
   void SetState(int newState) {
     this->_state = newState;
   }  ///< Sets the internal state of the sorter.
+  void SetTransferOverride(int speed);
+  void ClearTransferOverride();
 
   void PrintInfo(Print &output, bool printConfig = false) const;
   friend Print &operator<<(Print &output, const SorterSubsystem &subsystem);
@@ -77,9 +93,12 @@ class SorterSubsystem {
   RGBHandler &rgb;            ///< Reference to RGBHandler for visual feedback.
 
   // State variables
-  int _state;          ///< Current operational state of the sorter's state machine.
-  int *_baseReadings;  ///< Array to store baseline readings from Hall sensors.
-  bool objectMagnet;   ///< Flag indicating if the currently detected object is magnetic.
+  int _state;                 ///< Current operational state of the sorter's state machine.
+  int *_baseReadings;         ///< Array to store baseline readings from Hall sensors.
+  bool objectMagnet;          ///< Flag indicating if the currently detected object is magnetic.
+  bool transferOverride;      ///< If true, Update() drives the transfer motor at a fixed speed.
+  int transferOverrideSpeed;  ///< Transfer motor speed used while the override is active.
+  Config config;              ///< Servo angles and detection threshold in use.
 };
 
 #endif  // SORTERSUBSYSTEM_H
\ No newline at end of file
@@ -0,0 +1,291 @@
+/**
+ * @file ConfigStore.cpp
+ * @author Aldem Pido
+ * @brief Implements the ConfigStore class for persisted tuning constants.
+ */
+#include "ConfigStore.h"
+
+#include <Arduino.h>  // For Print, F()
+#include <EEPROM.h>
+
+#include "Logger.h"
+#include "Telemetry.h"  // For Crc16()
+
+/**
+ * @brief Constructs a ConfigStore holding the defaults. Call Load() to read EEPROM.
+ * @param defaults Compiled-in configuration used when nothing valid is stored.
+ */
+ConfigStore::ConfigStore(const RobotConfig &defaults)
+    : defaults(defaults),
+      config(defaults),
+      staging(defaults),
+      source(CONFIG_FROM_DEFAULTS),
+      storedVersion(0) {}
+
+/**
+ * @brief Reads the configuration from EEPROM.
+ *  An older blob is upgraded and saved back so the next boot loads it directly.
+ * @return True if a stored configuration was loaded. False if the defaults are in use.
+ */
+bool ConfigStore::Load() {
+  config = defaults;
+  source = CONFIG_FROM_DEFAULTS;
+  storedVersion = 0;
+
+  ConfigHeader header;
+  EEPROM.get(CONFIG_EEPROM_ADDRESS, header);
+  if (header.magic != CONFIG_MAGIC) {
+    LOG_INFO("Config: nothing stored, using defaults");
+    return false;
+  }
+  if (header.version > CONFIG_VERSION || header.size > sizeof(RobotConfig) ||
+      (header.version == CONFIG_VERSION && header.size != sizeof(RobotConfig))) {
+    LOG_WARN("Config: unsupported version ", header.version, " size ", header.size,
+             ", using defaults");
+    return false;
+  }
+
+  RobotConfig loaded = defaults;
+  uint8_t *bytes = reinterpret_cast<uint8_t *>(&loaded);
+  for (uint16_t i = 0; i < header.size; i++) {
+    bytes[i] = EEPROM.read(CONFIG_EEPROM_ADDRESS + sizeof(ConfigHeader) + i);
+  }
+  if (Telemetry::Crc16(bytes, header.size) != header.crc) {
+    LOG_ERROR("Config: CRC mismatch, using defaults");
+    return false;
+  }
+
+  storedVersion = header.version;
+  config = loaded;
+  if (header.version < CONFIG_VERSION) {
+    migrate(header.version, config);
+    source = CONFIG_MIGRATED;
+    LOG_INFO("Config: migrated from version ", header.version);
+    Save();
+  } else {
+    source = CONFIG_FROM_EEPROM;
+  }
+  return true;
+}
+
+/**
+ * @brief Upgrades a configuration read from an older version.
+ *  Fields added since fromVersion already hold their defaults. Add a case here only when a
+ * version changes the meaning or units of an existing field.
+ * @param fromVersion Version the blob was saved with.
+ * @param config Configuration to upgrade in place.
+ */
+void ConfigStore::migrate(uint16_t fromVersion, RobotConfig &config) {
+  for (uint16_t version = fromVersion; version < CONFIG_VERSION; version++) {
+    switch (version) {
+      default:  // No field has been reinterpreted yet
+        break;
+    }
+  }
+}
+
+/**
+ * @brief Writes the active configuration to EEPROM.
+ *  Only bytes that differ are written, which saves flash wear.
+ * @return True if the bytes read back match what was written.
+ */
+bool ConfigStore::Save() {
+  const uint8_t *bytes = reinterpret_cast<const uint8_t *>(&config);
+  ConfigHeader header;
+  header.magic = CONFIG_MAGIC;
+  header.version = CONFIG_VERSION;
+  header.size = sizeof(RobotConfig);
+  header.crc = Telemetry::Crc16(bytes, sizeof(RobotConfig));
+  header.reserved = 0;
+
+  const uint8_t *headerBytes = reinterpret_cast<const uint8_t *>(&header);
+  for (size_t i = 0; i < sizeof(ConfigHeader); i++) {
+    EEPROM.update(CONFIG_EEPROM_ADDRESS + i, headerBytes[i]);
+  }
+  bool verified = true;
+  for (size_t i = 0; i < sizeof(RobotConfig); i++) {
+    const int address = CONFIG_EEPROM_ADDRESS + sizeof(ConfigHeader) + i;
+    EEPROM.update(address, bytes[i]);
+    verified = verified && (EEPROM.read(address) == bytes[i]);
+  }
+  if (!verified) {
+    LOG_ERROR("Config: EEPROM verify failed");
+    return false;
+  }
+  if (source == CONFIG_FROM_HOST) {
+    source = CONFIG_FROM_EEPROM;
+  }
+  storedVersion = CONFIG_VERSION;
+  return true;
+}
+
+/**
+ * @brief Makes the compiled-in defaults active. EEPROM is unchanged until Save().
+ */
+void ConfigStore::RestoreDefaults() {
+  config = defaults;
+  source = CONFIG_FROM_DEFAULTS;
+}
+
+/**
+ * @brief Writes the active configuration as hex lines for the host tool.
+ *  Format: `CFG V <version> <size> <crc>`, then `CFG D <offset> <hex>` for every
+ * CONFIG_CHUNK_BYTES bytes, then `CFG E`. Numbers are decimal except crc and hex.
+ * @param output Output stream, usually the logger.
+ */
+void ConfigStore::Dump(Print &output) const {
+  const uint8_t *bytes = reinterpret_cast<const uint8_t *>(&config);
+  output.print(F("CFG V "));
+  output.print(CONFIG_VERSION);
+  output.print(' ');
+  output.print(sizeof(RobotConfig));
+  output.print(' ');
+  output.println(Telemetry::Crc16(bytes, sizeof(RobotConfig)), HEX);
+  for (size_t offset = 0; offset < sizeof(RobotConfig); offset += CONFIG_CHUNK_BYTES) {
+    output.print(F("CFG D "));
+    output.print(offset);
+    output.print(' ');
+    for (size_t i = offset; i < offset + CONFIG_CHUNK_BYTES && i < sizeof(RobotConfig); i++) {
+      if (bytes[i] < 0x10) output.print('0');
+      output.print(bytes[i], HEX);
+    }
+    output.println();
+  }
+  output.println(F("CFG E"));
+}
+
+/**
+ * @brief Starts a host write by copying the active configuration into the staging area.
+ */
+void ConfigStore::BeginWrite() { staging = config; }
+
+/**
+ * @brief Copies hex-encoded bytes from the host into the staging area.
+ * @param offset Byte offset into RobotConfig.
+ * @param hex Pairs of hex digits, at most CONFIG_CHUNK_BYTES bytes.
+ * @return False if the hex is malformed or runs past the end of RobotConfig.
+ */
+bool ConfigStore::WriteChunk(uint16_t offset, const char *hex) {
+  const size_t length = strlen(hex);
+  if (length % 2 != 0 || length / 2 > CONFIG_CHUNK_BYTES ||
+      offset + length / 2 > sizeof(RobotConfig)) {
+    return false;
+  }
+  uint8_t chunk[CONFIG_CHUNK_BYTES];
+  for (size_t i = 0; i < length / 2; i++) {
+    char pair[3] = {hex[2 * i], hex[2 * i + 1], '\0'};
+    char *end = nullptr;
+    chunk[i] = static_cast<uint8_t>(strtoul(pair, &end, 16));
+    if (end != pair + 2) return false;
+  }
+  memcpy(reinterpret_cast<uint8_t *>(&staging) + offset, chunk, length / 2);
+  return true;
+}
+
+/**
+ * @brief Makes the staged bytes active if they arrived intact.
+ *  The caller is responsible for pushing the new values to the handlers and for calling
+ * Save() to keep them across a reboot.
+ * @param crc CRC-16/CCITT-FALSE of the complete RobotConfig computed by the host.
+ * @return False if the CRC does not match, in which case nothing changes.
+ */
+bool ConfigStore::CommitWrite(uint16_t crc) {
+  const uint8_t *bytes = reinterpret_cast<const uint8_t *>(&staging);
+  if (Telemetry::Crc16(bytes, sizeof(RobotConfig)) != crc) {
+    return false;
+  }
+  config = staging;
+  source = CONFIG_FROM_HOST;
+  return true;
+}
+
+/**
+ * @brief Prints one PID block of the configuration.
+ * @param output Output stream for logging.
+ * @param name Axis name.
+ * @param pid Gains to print.
+ */
+void ConfigStore::printPID(Print &output, const char *name, const PIDConfig &pid) {
+  output.print(F("  "));
+  output.print(name);
+  output.print(F(" PID: kp "));
+  output.print(pid.kp, 3);
+  output.print(F(", ki "));
+  output.print(pid.ki, 3);
+  output.print(F(", kd "));
+  output.print(pid.kd, 3);
+  output.print(F(", kaw "));
+  output.print(pid.kaw, 3);
+  output.print(F(", tc "));
+  output.print(pid.timeConst, 3);
+  output.print(F(", max "));
+  output.print(pid.max, 3);
+  output.print(F(", rate "));
+  output.println(pid.maxRate, 3);
+}
+
+/**
+ * @brief Prints the active values or where they came from.
+ * @param output Output stream for logging.
+ * @param printConfig If true, prints every field; otherwise, prints the source and version.
+ */
+void ConfigStore::PrintInfo(Print &output, bool printConfig) const {
+  static const char *sources[] = {"defaults", "EEPROM", "migrated", "host (unsaved)"};
+  output.print(F("Config: version "));
+  output.print(CONFIG_VERSION);
+  output.print(F(", "));
+  output.print(sizeof(RobotConfig));
+  output.print(F(" bytes, from "));
+  output.print(sources[source]);
+  if (storedVersion != 0) {
+    output.print(F(", stored version "));
+    output.print(storedVersion);
+  }
+  output.println();
+  if (printConfig) {
+    printPID(output, "x", config.xPID);
+    printPID(output, "y", config.yPID);
+    printPID(output, "theta", config.thetaPID);
+    output.print(F("  Wheel diameter: "));
+    output.println(config.wheelDiameter, 4);
+    output.print(F("  Sorter: "));
+    output.print(config.sorter.left);
+    output.print(F("/"));
+    output.print(config.sorter.softLeft);
+    output.print(F("/"));
+    output.print(config.sorter.center);
+    output.print(F("/"));
+    output.print(config.sorter.softRight);
+    output.print(F("/"));
+    output.print(config.sorter.right);
+    output.print(F(", object range "));
+    output.println(config.sorter.objectRange);
+    output.print(F("  Mandibles: left "));
+    output.print(config.mandibles.leftOpen);
+    output.print(F("/"));
+    output.print(config.mandibles.leftClose);
+    output.print(F(", right "));
+    output.print(config.mandibles.rightOpen);
+    output.print(F("/"));
+    output.println(config.mandibles.rightClose);
+    output.print(F("  Beacon: "));
+    output.print(config.beacon.up);
+    output.print(F("/"));
+    output.print(config.beacon.down1);
+    output.print(F("/"));
+    output.print(config.beacon.down2);
+    output.print(F("/"));
+    output.println(config.beacon.down);
+  }
+}
+
+/**
+ * @brief Overloaded stream operator for printing where the configuration came from.
+ * @param output Output stream.
+ * @param store ConfigStore instance.
+ * @return Modified output stream.
+ */
+Print &operator<<(Print &output, const ConfigStore &store) {
+  store.PrintInfo(output, false);
+  return output;
+}
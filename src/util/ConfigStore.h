@@ -0,0 +1,111 @@
+/**
+ * @file ConfigStore.h
+ * @author Aldem Pido
+ * @brief Defines the ConfigStore class, a versioned tuning blob persisted to EEPROM.
+ * @ingroup util
+ */
+
+#ifndef CONFIGSTORE_H
+#define CONFIGSTORE_H
+
+#include <Arduino.h>
+#include <Print.h>
+
+#include "../drive/PID.h"
+#include "../subsystem/BeaconSubsystem.h"
+#include "../subsystem/MandibleSubsystem.h"
+#include "../subsystem/SorterSubsystem.h"
+
+#define CONFIG_MAGIC 0x31434553UL  ///< "SEC1" in little-endian byte order.
+#define CONFIG_VERSION 1           ///< Bump when RobotConfig changes.
+#define CONFIG_EEPROM_ADDRESS 0    ///< EEPROM offset of the ConfigHeader.
+#define CONFIG_CHUNK_BYTES 16      ///< Bytes per line in Dump() and per WriteChunk() call.
+
+/**
+ * @struct RobotConfig
+ * @ingroup util
+ * @brief Every tunable constant that is stored in EEPROM.
+ *  Fields must only ever be appended; Load() relies on this to read blobs written by older
+ * firmware. tools/config_tool.py mirrors this layout, so update it at the same time.
+ */
+struct RobotConfig {
+  PIDConfig xPID;                       ///< X-axis position PID.
+  PIDConfig yPID;                       ///< Y-axis position PID.
+  PIDConfig thetaPID;                   ///< Heading PID.
+  float wheelDiameter;                  ///< Odometry wheel diameter in inches.
+  SorterSubsystem::Config sorter;       ///< Sorter servo angles and object threshold.
+  MandibleSubsystem::Config mandibles;  ///< Mandible servo angles.
+  BeaconSubsystem::Config beacon;       ///< Beacon servo angles.
+};
+
+static_assert(sizeof(RobotConfig) == 240, "RobotConfig layout changed; update config_tool.py");
+
+/**
+ * @struct ConfigHeader
+ * @ingroup util
+ * @brief Stored in front of the RobotConfig bytes in EEPROM.
+ */
+struct ConfigHeader {
+  uint32_t magic;     ///< CONFIG_MAGIC if a configuration has been saved.
+  uint16_t version;   ///< CONFIG_VERSION of the firmware that saved it.
+  uint16_t size;      ///< sizeof(RobotConfig) of the firmware that saved it.
+  uint16_t crc;       ///< CRC-16/CCITT-FALSE of the stored RobotConfig bytes.
+  uint16_t reserved;  ///< Always 0.
+};
+
+/**
+ * @enum ConfigSource
+ * @brief Where the active configuration came from.
+ */
+enum ConfigSource : uint8_t {
+  CONFIG_FROM_DEFAULTS,  ///< Nothing valid was stored; compiled-in defaults are active.
+  CONFIG_FROM_EEPROM,    ///< Loaded unchanged from EEPROM.
+  CONFIG_MIGRATED,       ///< Loaded from an older version and upgraded.
+  CONFIG_FROM_HOST,      ///< Written over Serial and not saved yet.
+};
+
+/**
+ * @class ConfigStore
+ * @ingroup util
+ * @brief Holds the active RobotConfig and persists it to the Teensy EEPROM emulation.
+ *  The blob is checked with a magic number, schema version, size and CRC. A blob from an older
+ * version is read over the defaults, so fields added since keep their default values, and then
+ * upgraded by migrate(). Anything unreadable falls back to the compiled-in defaults.
+ *
+ *  A host tool reads the blob with Dump() and replaces it with BeginWrite(), WriteChunk() and
+ * CommitWrite(), which only applies the new bytes if their CRC matches.
+ * Single fields may also be changed in place through Edit(); call MarkEdited() afterwards so the
+ * change is reported as unsaved.
+ */
+class ConfigStore {
+ public:
+  ConfigStore(const RobotConfig &defaults);
+
+  bool Load();
+  bool Save();
+  void RestoreDefaults();
+  const RobotConfig &Get() const { return config; }
+  ConfigSource GetSource() const { return source; }
+  RobotConfig &Edit() { return config; }
+  void MarkEdited() { source = CONFIG_FROM_HOST; }
+
+  void Dump(Print &output) const;
+  void BeginWrite();
+  bool WriteChunk(uint16_t offset, const char *hex);
+  bool CommitWrite(uint16_t crc);
+
+  void PrintInfo(Print &output, bool printConfig = false) const;
+  friend Print &operator<<(Print &output, const ConfigStore &store);
+
+ private:
+  const RobotConfig defaults;  ///< Compiled-in values.
+  RobotConfig config;          ///< Active values.
+  RobotConfig staging;         ///< Bytes received from the host before CommitWrite().
+  ConfigSource source;         ///< Where config came from.
+  uint16_t storedVersion;      ///< Version found in EEPROM by Load(), 0 if none.
+
+  static void migrate(uint16_t fromVersion, RobotConfig &config);
+  static void printPID(Print &output, const char *name, const PIDConfig &pid);
+};
+
+#endif  // CONFIGSTORE_H
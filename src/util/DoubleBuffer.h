@@ -0,0 +1,67 @@
+/**
+ * @file DoubleBuffer.h
+ * @author Aldem Pido
+ * @brief Defines the DoubleBuffer class template for passing snapshots between an ISR and loop().
+ * @ingroup util
+ */
+
+#ifndef DOUBLEBUFFER_H
+#define DOUBLEBUFFER_H
+
+#include <stdint.h>
+
+/**
+ * @class DoubleBuffer
+ * @ingroup util
+ * @brief Single-writer, single-reader snapshot exchange that never blocks the writer.
+ *  The writer fills the back slot and then publishes it by incrementing a sequence number, so
+ * the reader always sees a complete value. If the reader is interrupted by two writes during a
+ * copy, the sequence number changes and the copy is retried. Because an interrupt always runs
+ * to completion, a reader inside an ISR never has to retry, so it is safe in both directions:
+ * loop() to ISR for sensor inputs and ISR to loop() for results.
+ * @tparam T Snapshot type. Must be copy assignable.
+ */
+template <typename T>
+class DoubleBuffer {
+ public:
+  DoubleBuffer() : slots{T(), T()}, sequence(0) {}
+
+  /**
+   * @brief Publishes a new value. Call from the writer side only.
+   * @param value Value to publish.
+   */
+  void Write(const T &value) {
+    const uint32_t next = sequence + 1;
+    slots[next & 1] = value;
+    __asm__ volatile("" ::: "memory");  // Slot contents before the sequence number
+    sequence = next;
+  }
+
+  /**
+   * @brief Copies the most recently published value. Call from the reader side only.
+   * @return The latest value.
+   */
+  T Read() const {
+    uint32_t seq;
+    T value;
+    do {
+      seq = sequence;
+      __asm__ volatile("" ::: "memory");
+      value = slots[seq & 1];
+      __asm__ volatile("" ::: "memory");
+    } while (seq != sequence);
+    return value;
+  }
+
+  /**
+   * @brief Gets the number of values published so far.
+   *  A reader can compare this against a saved count to tell whether anything new arrived.
+   */
+  uint32_t GetSequence() const { return sequence; }
+
+ private:
+  T slots[2];                  ///< Front and back copies; the front is slots[sequence & 1].
+  volatile uint32_t sequence;  ///< Number of writes; incremented after each slot is filled.
+};
+
+#endif  // DOUBLEBUFFER_H
@@ -0,0 +1,128 @@
+/**
+ * @file Logger.cpp
+ * @author Aldem Pido
+ * @brief Implements the Logger class for non-blocking buffered logging.
+ */
+#include "Logger.h"
+
+#include <Arduino.h>  // For Serial, Print, F()
+
+Logger Log(Serial);
+
+/**
+ * @brief Constructs a Logger.
+ * @param sink Stream the buffered text is forwarded to, e.g. Serial.
+ */
+Logger::Logger(Print &sink)
+    : sink(sink), minLevel(LOG_LEVEL), droppedLines(0), droppedBytes(0) {}
+
+/**
+ * @brief Queues one byte, dropping the oldest line first if the buffer is full.
+ * @param c Byte to queue.
+ * @return Always 1; the byte is never refused.
+ */
+size_t Logger::write(uint8_t c) {
+  if (buffer.Full()) {
+    dropOldestLine();
+  }
+  buffer.Push(c);
+  return 1;
+}
+
+/**
+ * @brief Queues a block of bytes.
+ * @param data Bytes to queue.
+ * @param size Number of bytes.
+ * @return The number of bytes queued, which is always `size`.
+ */
+size_t Logger::write(const uint8_t *data, size_t size) {
+  for (size_t i = 0; i < size; i++) {
+    write(data[i]);
+  }
+  return size;
+}
+
+/**
+ * @brief Forwards as much queued text as the sink can take without blocking.
+ *  This function is intended to be called regularly from the main loop.
+ */
+void Logger::Drain() {
+  int space = sink.availableForWrite();
+  uint8_t chunk[LOGGER_DRAIN_CHUNK];
+  while (space > 0 && !buffer.Empty()) {
+    size_t length = 0;
+    while (length < sizeof(chunk) && length < static_cast<size_t>(space) &&
+           buffer.Pop(chunk[length])) {
+      length++;
+    }
+    sink.write(chunk, length);
+    space -= length;
+  }
+}
+
+/**
+ * @brief Starts a leveled message by writing its severity prefix.
+ * @param level LOG_LEVEL_* severity of the message.
+ * @return False if the level is filtered out at runtime, in which case nothing is written and
+ * the caller should skip the message.
+ */
+bool Logger::Begin(uint8_t level) {
+  if (level < minLevel) return false;
+  static const char prefixes[] = {'D', 'I', 'W', 'E'};
+  write('[');
+  write(prefixes[constrain(level, LOG_LEVEL_DEBUG, LOG_LEVEL_ERROR)]);
+  write(']');
+  write(' ');
+  return true;
+}
+
+/**
+ * @brief Discards queued bytes up to and including the oldest newline.
+ *  A partial line at the front of the buffer is dropped together with its terminator so the
+ * output stays line aligned.
+ */
+void Logger::dropOldestLine() {
+  uint8_t c = 0;
+  while (buffer.Pop(c)) {
+    droppedBytes++;
+    if (c == '\n') break;
+  }
+  droppedLines++;
+}
+
+/**
+ * @brief Prints the logger configuration or its drop counters.
+ *  Printing to the logger itself is allowed; the text is queued like any other.
+ * @param output Output stream for logging.
+ * @param printConfig If true, prints the level and buffer size; otherwise, prints counters.
+ */
+void Logger::PrintInfo(Print &output, bool printConfig) const {
+  if (printConfig) {
+    output.print(F("Logger Configuration: level "));
+    output.print(minLevel);
+    output.print(F(" (compiled "));
+    output.print(LOG_LEVEL);
+    output.print(F("), buffer "));
+    output.print(LOGGER_BUFFER_SIZE);
+    output.println(F(" bytes"));
+  } else {
+    output.print(F("Logger: pending "));
+    output.print(buffer.Size());
+    output.print(F(" bytes, dropped "));
+    output.print(droppedLines);
+    output.print(F(" lines ("));
+    output.print(droppedBytes);
+    output.println(F(" bytes)"));
+  }
+}
+
+/**
+ * @brief Overloaded stream operator for printing logger counters.
+ * @param output Output stream.
+ * @param logger Logger instance.
+ * @return Modified output stream.
+ */
+Print &operator<<(Print &output, const Logger &logger) {
+  logger.PrintInfo(output, false);
+  return output;
+}
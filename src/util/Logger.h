@@ -0,0 +1,109 @@
+/**
+ * @file Logger.h
+ * @author Aldem Pido
+ * @brief Defines the Logger class, a non-blocking buffered log stream, and the LOG_* macros.
+ * @ingroup util
+ */
+
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <Arduino.h>
+#include <Print.h>
+
+#include "RingBuffer.h"
+
+#define LOG_LEVEL_DEBUG 0  ///< Verbose diagnostics.
+#define LOG_LEVEL_INFO 1   ///< Normal status messages.
+#define LOG_LEVEL_WARN 2   ///< Recoverable problems such as timeouts.
+#define LOG_LEVEL_ERROR 3  ///< Failures that disable a device or feature.
+#define LOG_LEVEL_NONE 4   ///< Disables all leveled messages.
+
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO  ///< Messages below this level are compiled out.
+#endif
+
+#define LOGGER_BUFFER_SIZE 4096  ///< Bytes of log text held while the host is not reading.
+#define LOGGER_DRAIN_CHUNK 64    ///< Bytes copied to the sink per write call while draining.
+
+/**
+ * @class Logger
+ * @ingroup util
+ * @brief Print stream that buffers text in RAM and forwards it without blocking.
+ *  Anything that prints to a Print& (PrintInfo(), operator<<) can print to the logger instead of
+ * Serial. Text is queued in a ring buffer and Drain() forwards only as much as the sink reports
+ * it can accept, so a slow or absent USB host never stalls the caller. When the buffer is full
+ * the oldest complete lines are dropped to make room and counted.
+ */
+class Logger : public Print {
+ public:
+  Logger(Print &sink);
+
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t *buffer, size_t size) override;
+  using Print::write;
+
+  void Drain();
+  bool Begin(uint8_t level);
+  void SetLevel(uint8_t level) { minLevel = level; }
+  uint8_t GetLevel() const { return minLevel; }
+
+  /**
+   * @brief Writes one leveled line made of every argument printed in order.
+   * @param level LOG_LEVEL_* severity of the line.
+   * @param args Values accepted by Print::print().
+   */
+  template <typename... Args>
+  void Line(uint8_t level, const Args &...args) {
+    if (!Begin(level)) return;
+    printAll(args...);
+    println();
+  }
+
+  uint32_t GetDroppedLines() const { return droppedLines; }
+  uint32_t GetDroppedBytes() const { return droppedBytes; }
+  size_t GetPending() const { return buffer.Size(); }
+
+  void PrintInfo(Print &output, bool printConfig = false) const;
+  friend Print &operator<<(Print &output, const Logger &logger);
+
+ private:
+  Print &sink;                                     ///< Stream text is forwarded to.
+  RingBuffer<uint8_t, LOGGER_BUFFER_SIZE> buffer;  ///< Text waiting to be forwarded.
+  uint8_t minLevel;                                ///< Runtime level filter.
+  uint32_t droppedLines;                           ///< Lines discarded because the buffer was full.
+  uint32_t droppedBytes;                           ///< Bytes discarded because the buffer was full.
+
+  void dropOldestLine();
+  void printAll() {}
+  template <typename T, typename... Rest>
+  void printAll(const T &first, const Rest &...rest) {
+    print(first);
+    printAll(rest...);
+  }
+};
+
+extern Logger Log;  ///< Shared logger forwarding to Serial.
+
+#if LOG_LEVEL <= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(...) Log.Line(LOG_LEVEL_DEBUG, __VA_ARGS__)  ///< Logs a debug line.
+#else
+#define LOG_DEBUG(...) ((void)0)
+#endif
+#if LOG_LEVEL <= LOG_LEVEL_INFO
+#define LOG_INFO(...) Log.Line(LOG_LEVEL_INFO, __VA_ARGS__)  ///< Logs an info line.
+#else
+#define LOG_INFO(...) ((void)0)
+#endif
+#if LOG_LEVEL <= LOG_LEVEL_WARN
+#define LOG_WARN(...) Log.Line(LOG_LEVEL_WARN, __VA_ARGS__)  ///< Logs a warning line.
+#else
+#define LOG_WARN(...) ((void)0)
+#endif
+#if LOG_LEVEL <= LOG_LEVEL_ERROR
+#define LOG_ERROR(...) Log.Line(LOG_LEVEL_ERROR, __VA_ARGS__)  ///< Logs an error line.
+#else
+#define LOG_ERROR(...) ((void)0)
+#endif
+
+#endif  // LOGGER_H
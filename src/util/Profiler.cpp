@@ -0,0 +1,218 @@
+/**
+ * @file Profiler.cpp
+ * @author Aldem Pido
+ * @brief Implements the Profiler class for cycle-accurate zone timing.
+ */
+#include "Profiler.h"
+
+#include <Arduino.h>  // For F_CPU_ACTUAL, ARM_DWT_CYCCNT, Print, F()
+
+#include "Tracer.h"
+
+#if !defined(__IMXRT1062__)
+#include <chrono>
+#endif
+
+/**
+ * @brief Constructs a Profiler with no zones.
+ */
+Profiler::Profiler()
+    : numZones(0),
+      cyclesPerUs(1),
+      depth(0),
+      busyStartCycles(0),
+      busyCycles(0),
+      lastCycles(0),
+      elapsedCycles(0) {}
+
+/**
+ * @brief Enables the cycle counter and clears all counters.
+ */
+void Profiler::Begin() {
+#if defined(__IMXRT1062__)
+  ARM_DEMCR |= ARM_DEMCR_TRCENA;
+  ARM_DWT_CTRL |= ARM_DWT_CTRL_CYCCNTENA;
+  cyclesPerUs = F_CPU_ACTUAL / 1000000;
+#else
+  cyclesPerUs = 1000;  // steady_clock nanoseconds
+#endif
+  Reset();
+}
+
+/**
+ * @brief Reads the cycle counter.
+ * @return Current cycle count. Wraps every 2^32 cycles (about 7 s at 600 MHz).
+ */
+uint32_t Profiler::Cycles() {
+#if defined(__IMXRT1062__)
+  return ARM_DWT_CYCCNT;
+#else
+  return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                   std::chrono::steady_clock::now().time_since_epoch())
+                                   .count());
+#endif
+}
+
+/**
+ * @brief Registers a named zone.
+ *  Zones can be registered at static initialization time, before Begin().
+ * @param name Name used in output. Must outlive the profiler.
+ * @return The zone id, or -1 if the zone table is full.
+ */
+int Profiler::AddZone(const char *name) {
+  if (numZones >= PROFILER_MAX_ZONES) {
+    return -1;
+  }
+  zones[numZones].name = name;
+  zones[numZones].stats = ZoneStats();
+  return numZones++;
+}
+
+/**
+ * @brief Opens a measurement of a zone.
+ *  Zones may nest, but a zone must not be opened again before it is stopped. The zone is also
+ * recorded as a span on the trace's loop track.
+ * @param id Zone id returned by AddZone().
+ */
+void Profiler::Start(int id) {
+  const uint32_t now = Cycles();
+  if (depth++ == 0) {
+    busyStartCycles = now;
+  }
+  if (id >= 0 && id < numZones) {
+    zones[id].startCycles = now;
+    TRACE_BEGIN(TRACE_TRACK_LOOP, zones[id].name);
+  }
+}
+
+/**
+ * @brief Closes the open measurement of a zone and records it.
+ * @param id Zone id returned by AddZone().
+ */
+void Profiler::Stop(int id) {
+  const uint32_t now = Cycles();
+  if (id >= 0 && id < numZones) {
+    TRACE_END(TRACE_TRACK_LOOP, zones[id].name);
+    ZoneStats &stats = zones[id].stats;
+    const uint32_t cycles = now - zones[id].startCycles;
+    stats.count++;
+    stats.totalCycles += cycles;
+    if (cycles < stats.minCycles) stats.minCycles = cycles;
+    if (cycles > stats.maxCycles) stats.maxCycles = cycles;
+
+    uint32_t us = cycles / cyclesPerUs;
+    int bin = 0;
+    while (us > 0 && bin < PROFILER_HISTOGRAM_BINS - 1) {
+      us >>= 1;
+      bin++;
+    }
+    stats.histogram[bin]++;
+  }
+  if (depth > 0 && --depth == 0) {
+    busyCycles += now - busyStartCycles;
+    updateElapsed(now);
+  }
+}
+
+/**
+ * @brief Clears every zone's counters and restarts the utilization window.
+ */
+void Profiler::Reset() {
+  for (int i = 0; i < numZones; i++) {
+    zones[i].stats = ZoneStats();
+  }
+  busyCycles = 0;
+  elapsedCycles = 0;
+  lastCycles = Cycles();
+}
+
+/**
+ * @brief Gets the timing counters of a zone.
+ * @param id Zone id returned by AddZone().
+ * @return The zone's statistics. Returns an all-zero record if the id is out of bounds.
+ */
+const ZoneStats &Profiler::GetStats(int id) const {
+  static const ZoneStats empty;
+  if (id >= 0 && id < numZones) {
+    return zones[id].stats;
+  }
+  return empty;
+}
+
+/**
+ * @brief Gets the fraction of wall time spent inside outermost zones since Reset().
+ * @return Utilization from 0 to 1. Only time inside zones counts as busy.
+ */
+float Profiler::GetUtilization() const {
+  if (elapsedCycles == 0) return 0.0f;
+  return static_cast<float>(busyCycles) / static_cast<float>(elapsedCycles);
+}
+
+/**
+ * @brief Accumulates wall time since the last update.
+ *  Called whenever the outermost zone closes, which must happen at least once per counter
+ * wrap period for the total to stay correct.
+ * @param now Current cycle count.
+ */
+void Profiler::updateElapsed(uint32_t now) {
+  elapsedCycles += now - lastCycles;
+  lastCycles = now;
+}
+
+/**
+ * @brief Prints the zone table or per-zone timing statistics.
+ * @param output Output stream for logging.
+ * @param printConfig If true, prints zone names and the counter rate; otherwise, prints
+ * min/mean/max in microseconds, histograms and CPU utilization.
+ */
+void Profiler::PrintInfo(Print &output, bool printConfig) const {
+  if (printConfig) {
+    output.print(F("Profiler Configuration: "));
+    output.print(cyclesPerUs);
+    output.print(F(" cycles/us, zones: "));
+    for (int i = 0; i < numZones; i++) {
+      output.print(zones[i].name);
+      if (i < numZones - 1) {
+        output.print(F(", "));
+      }
+    }
+    output.println();
+    return;
+  }
+
+  output.print(F("Profiler (CPU "));
+  output.print(GetUtilization() * 100.0f, 1);
+  output.println(F("%):"));
+  for (int i = 0; i < numZones; i++) {
+    const ZoneStats &stats = zones[i].stats;
+    output.print(F("  "));
+    output.print(zones[i].name);
+    output.print(F(": n "));
+    output.print(stats.count);
+    if (stats.count > 0) {
+      output.print(F(", min/mean/max "));
+      output.print(static_cast<float>(stats.minCycles) / cyclesPerUs, 2);
+      output.print(F("/"));
+      output.print(static_cast<float>(stats.totalCycles) / stats.count / cyclesPerUs, 2);
+      output.print(F("/"));
+      output.print(static_cast<float>(stats.maxCycles) / cyclesPerUs, 2);
+      output.print(F(" us, hist"));
+      for (int b = 0; b < PROFILER_HISTOGRAM_BINS; b++) {
+        output.print(F(" "));
+        output.print(stats.histogram[b]);
+      }
+    }
+    output.println();
+  }
+}
+
+/**
+ * @brief Overloaded stream operator for printing profiler statistics.
+ * @param output Output stream.
+ * @param profiler Profiler instance.
+ * @return Modified output stream.
+ */
+Print &operator<<(Print &output, const Profiler &profiler) {
+  profiler.PrintInfo(output, false);
+  return output;
+}
@@ -0,0 +1,109 @@
+/**
+ * @file Profiler.h
+ * @author Aldem Pido
+ * @brief Defines the Profiler class for measuring time spent in named code zones.
+ * @ingroup util
+ */
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <Arduino.h>
+#include <Print.h>
+
+#ifndef PROFILER_ENABLED
+#define PROFILER_ENABLED 1  ///< Set to 0 to compile PROFILE_ZONE() out entirely.
+#endif
+
+#define PROFILER_MAX_ZONES 24       ///< Maximum number of zones that can be registered.
+#define PROFILER_HISTOGRAM_BINS 16  ///< Bin k holds [2^(k-1), 2^k) us; the last bin is overflow.
+
+/**
+ * @struct ZoneStats
+ * @ingroup util
+ * @brief Timing counters kept for every profiled zone.
+ */
+struct ZoneStats {
+  uint32_t count = 0;                                 ///< Number of completed measurements.
+  uint32_t minCycles = UINT32_MAX;                    ///< Shortest measurement.
+  uint32_t maxCycles = 0;                             ///< Longest measurement.
+  uint64_t totalCycles = 0;                           ///< Sum of all measurements.
+  uint32_t histogram[PROFILER_HISTOGRAM_BINS] = {0};  ///< Counts per log2 microsecond bin.
+};
+
+/**
+ * @class Profiler
+ * @ingroup util
+ * @brief Measures execution time of named zones with the cycle counter.
+ *  On the Teensy 4.x the Cortex-M7 DWT cycle counter is used, giving single-cycle resolution.
+ * Host builds fall back to std::chrono::steady_clock at nanosecond resolution. Each zone keeps
+ * min/mean/max and a log2 histogram. Time spent inside outermost zones is also accumulated
+ * against wall time to give a CPU utilization figure.
+ */
+class Profiler {
+ public:
+  Profiler();
+
+  void Begin();
+  int AddZone(const char *name);
+  void Start(int id);
+  void Stop(int id);
+  void Reset();
+
+  const ZoneStats &GetStats(int id) const;
+  float GetUtilization() const;
+  uint32_t GetCyclesPerMicro() const { return cyclesPerUs; }
+
+  void PrintInfo(Print &output, bool printConfig = false) const;
+  friend Print &operator<<(Print &output, const Profiler &profiler);
+
+  static uint32_t Cycles();
+
+ private:
+  /**
+   * @struct Zone
+   * @brief Name, open measurement and counters of one zone.
+   */
+  struct Zone {
+    const char *name = nullptr;  ///< Name used in output.
+    uint32_t startCycles = 0;    ///< Cycle count when the open measurement started.
+    ZoneStats stats;             ///< Timing counters.
+  };
+
+  Zone zones[PROFILER_MAX_ZONES];  ///< Registered zones.
+  int numZones;                    ///< Number of registered zones.
+  uint32_t cyclesPerUs;            ///< Cycle counter ticks per microsecond.
+  int depth;                       ///< Number of zones currently open.
+  uint32_t busyStartCycles;        ///< Cycle count when the outermost open zone started.
+  uint64_t busyCycles;             ///< Time spent inside outermost zones since Reset().
+  uint32_t lastCycles;             ///< Cycle count at the last wall time update.
+  uint64_t elapsedCycles;          ///< Wall time since Reset().
+
+  void updateElapsed(uint32_t now);
+};
+
+/**
+ * @class ProfileZone
+ * @ingroup util
+ * @brief Measures one zone for as long as it is in scope.
+ */
+class ProfileZone {
+ public:
+  ProfileZone(Profiler &profiler, int id) : profiler(profiler), id(id) { profiler.Start(id); }
+  ~ProfileZone() { profiler.Stop(id); }
+
+ private:
+  Profiler &profiler;  ///< Profiler that owns the zone.
+  int id;              ///< Zone id returned by AddZone().
+};
+
+#if PROFILER_ENABLED
+#define PROFILER_CONCAT_(a, b) a##b
+#define PROFILER_CONCAT(a, b) PROFILER_CONCAT_(a, b)
+/// Profiles the rest of the enclosing scope as zone `id`.
+#define PROFILE_ZONE(profiler, id) ProfileZone PROFILER_CONCAT(profileZone_, __LINE__)(profiler, id)
+#else
+#define PROFILE_ZONE(profiler, id)
+#endif
+
+#endif  // PROFILER_H
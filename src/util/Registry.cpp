@@ -0,0 +1,360 @@
+/**
+ * @file Registry.cpp
+ * @author Aldem Pido
+ * @brief Implements the Registry class for named runtime values.
+ */
+#include "Registry.h"
+
+#include <Arduino.h>  // For micros(), millis(), Print, F()
+
+/**
+ * @brief Constructs an empty Registry.
+ * @param output Destination of subscription lines, usually the logger.
+ */
+Registry::Registry(Print &output)
+    : output(output), numEntries(0), rejected(0), numSubscriptions(0), linesSent(0) {}
+
+/**
+ * @brief Registers a variable, reporting on the output if it cannot.
+ * @return The entry id, or -1 if the table is full or the name is already taken.
+ */
+int Registry::add(const char *name, RegistryType type, void *value, bool writable,
+                  RegistryCallback onSet) {
+  if (numEntries >= REGISTRY_MAX_ENTRIES || name == nullptr || Find(name) >= 0) {
+    rejected++;
+    output.print(F("Registry: cannot add "));
+    output.print(name != nullptr ? name : "(null)");
+    output.println(numEntries >= REGISTRY_MAX_ENTRIES ? F(", table full") : F(", name taken"));
+    return -1;
+  }
+  Entry &entry = entries[numEntries];
+  entry.name = name;
+  entry.type = type;
+  entry.writable = writable && type != REGISTRY_GETTER;
+  entry.index = 0;
+  entry.value = value;
+  entry.getter = nullptr;
+  entry.onSet = onSet;
+  return numEntries++;
+}
+
+/**
+ * @brief Registers a variable by pointer.
+ * @param name Dotted name. Must outlive the registry.
+ * @param value Variable to read and write. Must outlive the registry.
+ * @param writable True to allow Set().
+ * @param onSet Called after a successful Set(), e.g. to push a gain to a controller.
+ * @return The entry id, or -1 if the table is full or the name is already taken.
+ */
+int Registry::Add(const char *name, bool *value, bool writable, RegistryCallback onSet) {
+  return add(name, REGISTRY_BOOL, value, writable, onSet);
+}
+
+int Registry::Add(const char *name, uint8_t *value, bool writable, RegistryCallback onSet) {
+  return add(name, REGISTRY_UINT8, value, writable, onSet);
+}
+
+int Registry::Add(const char *name, int16_t *value, bool writable, RegistryCallback onSet) {
+  return add(name, REGISTRY_INT16, value, writable, onSet);
+}
+
+int Registry::Add(const char *name, int32_t *value, bool writable, RegistryCallback onSet) {
+  return add(name, REGISTRY_INT32, value, writable, onSet);
+}
+
+int Registry::Add(const char *name, uint32_t *value, bool writable, RegistryCallback onSet) {
+  return add(name, REGISTRY_UINT32, value, writable, onSet);
+}
+
+int Registry::Add(const char *name, float *value, bool writable, RegistryCallback onSet) {
+  return add(name, REGISTRY_FLOAT, value, writable, onSet);
+}
+
+int Registry::Add(const char *name, double *value, bool writable, RegistryCallback onSet) {
+  return add(name, REGISTRY_DOUBLE, value, writable, onSet);
+}
+
+/**
+ * @brief Registers a read-only value computed by a function.
+ *  Use this for values that live inside a class or are shared with an interrupt, so the getter
+ * can go through the owner's accessor.
+ * @param name Dotted name. Must outlive the registry.
+ * @param getter Function returning the value.
+ * @param index Passed to the getter, so one function can serve every element of an array.
+ * @return The entry id, or -1 if the table is full or the name is already taken.
+ */
+int Registry::Add(const char *name, RegistryGetter getter, uint8_t index) {
+  if (getter == nullptr) return -1;
+  const int id = add(name, REGISTRY_GETTER, nullptr, false, nullptr);
+  if (id >= 0) {
+    entries[id].getter = getter;
+    entries[id].index = index;
+  }
+  return id;
+}
+
+/**
+ * @brief Looks up an entry by its exact name.
+ * @return The entry id, or -1 if no entry has that name.
+ */
+int Registry::Find(const char *name) const {
+  for (int i = 0; i < numEntries; i++) {
+    if (strcmp(entries[i].name, name) == 0) return i;
+  }
+  return -1;
+}
+
+/**
+ * @brief Reads an entry as a double.
+ * @param id Entry id.
+ * @param value Set to the current value.
+ * @return False for an invalid id.
+ */
+bool Registry::Get(int id, double &value) const {
+  if (id < 0 || id >= numEntries) return false;
+  const Entry &entry = entries[id];
+  switch (entry.type) {
+    case REGISTRY_BOOL:
+      value = *static_cast<const bool *>(entry.value) ? 1 : 0;
+      break;
+    case REGISTRY_UINT8:
+      value = *static_cast<const uint8_t *>(entry.value);
+      break;
+    case REGISTRY_INT16:
+      value = *static_cast<const int16_t *>(entry.value);
+      break;
+    case REGISTRY_INT32:
+      value = *static_cast<const int32_t *>(entry.value);
+      break;
+    case REGISTRY_UINT32:
+      value = *static_cast<const uint32_t *>(entry.value);
+      break;
+    case REGISTRY_FLOAT:
+      value = *static_cast<const float *>(entry.value);
+      break;
+    case REGISTRY_DOUBLE:
+      value = *static_cast<const double *>(entry.value);
+      break;
+    case REGISTRY_GETTER:
+      value = entry.getter(entry.index);
+      break;
+  }
+  return true;
+}
+
+/**
+ * @brief Writes an entry and calls its onSet callback.
+ *  Integer values are rounded and clamped to the range of the variable's type.
+ * @param id Entry id.
+ * @param value New value.
+ * @return False for an invalid id or a read-only entry.
+ */
+bool Registry::Set(int id, double value) {
+  if (!IsWritable(id)) return false;
+  const Entry &entry = entries[id];
+  const double rounded = round(value);
+  switch (entry.type) {
+    case REGISTRY_BOOL:
+      *static_cast<bool *>(entry.value) = value != 0;
+      break;
+    case REGISTRY_UINT8:
+      *static_cast<uint8_t *>(entry.value) = constrain(rounded, 0.0, 255.0);
+      break;
+    case REGISTRY_INT16:
+      *static_cast<int16_t *>(entry.value) = constrain(rounded, -32768.0, 32767.0);
+      break;
+    case REGISTRY_INT32:
+      *static_cast<int32_t *>(entry.value) = constrain(rounded, -2147483648.0, 2147483647.0);
+      break;
+    case REGISTRY_UINT32:
+      *static_cast<uint32_t *>(entry.value) = constrain(rounded, 0.0, 4294967295.0);
+      break;
+    case REGISTRY_FLOAT:
+      *static_cast<float *>(entry.value) = value;
+      break;
+    case REGISTRY_DOUBLE:
+      *static_cast<double *>(entry.value) = value;
+      break;
+    case REGISTRY_GETTER:
+      return false;
+  }
+  if (entry.onSet != nullptr) entry.onSet();
+  return true;
+}
+
+/**
+ * @brief Checks whether an entry exists and may be written.
+ */
+bool Registry::IsWritable(int id) const {
+  return id >= 0 && id < numEntries && entries[id].writable;
+}
+
+/**
+ * @brief Checks a name against a pattern.
+ * @param pattern Exact name, a prefix followed by '*', or "*" for everything.
+ */
+bool Registry::matches(const char *name, const char *pattern) {
+  const size_t length = strlen(pattern);
+  if (length > 0 && pattern[length - 1] == '*') {
+    return strncmp(name, pattern, length - 1) == 0;
+  }
+  return strcmp(name, pattern) == 0;
+}
+
+/**
+ * @brief Streams every matching entry at a fixed rate. An entry already streamed gets the new
+ * rate.
+ * @param pattern Exact name or prefix followed by '*'.
+ * @param rateHz Samples per second, 1 to REGISTRY_MAX_RATE_HZ.
+ * @return Number of entries subscribed, or -1 if the rate is out of range or the subscription
+ * table filled up part way.
+ */
+int Registry::Subscribe(const char *pattern, uint16_t rateHz) {
+  if (rateHz == 0 || rateHz > REGISTRY_MAX_RATE_HZ) return -1;
+  const uint32_t periodUs = 1000000UL / rateHz;
+  const uint32_t nowUs = micros();
+  int count = 0;
+  for (int id = 0; id < numEntries; id++) {
+    if (!matches(entries[id].name, pattern)) continue;
+    int slot = 0;
+    while (slot < numSubscriptions && subscriptions[slot].id != id) slot++;
+    if (slot == numSubscriptions) {
+      if (numSubscriptions >= REGISTRY_MAX_SUBSCRIPTIONS) return -1;
+      numSubscriptions++;
+    }
+    subscriptions[slot] = {id, periodUs, nowUs};
+    count++;
+  }
+  return count;
+}
+
+/**
+ * @brief Stops streaming every matching entry.
+ * @param pattern Exact name or prefix followed by '*'. "*" stops everything.
+ * @return Number of subscriptions removed.
+ */
+int Registry::Unsubscribe(const char *pattern) {
+  int count = 0;
+  for (int slot = 0; slot < numSubscriptions;) {
+    if (matches(entries[subscriptions[slot].id].name, pattern)) {
+      subscriptions[slot] = subscriptions[--numSubscriptions];
+      count++;
+    } else {
+      slot++;
+    }
+  }
+  return count;
+}
+
+/**
+ * @brief Prints one line holding every subscription that is due.
+ *  This function is intended to be called regularly from the main loop, at least as often as
+ * the fastest subscription. A subscription that falls more than one period behind skips the
+ * missed samples instead of bursting.
+ */
+void Registry::Update() {
+  if (numSubscriptions == 0) return;
+  const uint32_t nowUs = micros();
+  bool started = false;
+  for (int slot = 0; slot < numSubscriptions; slot++) {
+    Subscription &sub = subscriptions[slot];
+    if (static_cast<int32_t>(nowUs - sub.nextUs) < 0) continue;
+    sub.nextUs += sub.periodUs;
+    if (static_cast<int32_t>(nowUs - sub.nextUs) >= 0) sub.nextUs = nowUs + sub.periodUs;
+    if (!started) {
+      output.print(F("SUB "));
+      output.print(millis());
+      started = true;
+    }
+    output.print(' ');
+    PrintValue(output, sub.id);
+  }
+  if (started) {
+    output.println();
+    linesSent++;
+  }
+}
+
+/**
+ * @brief Prints an entry as `name=value`.
+ * @param output Output stream for logging.
+ * @param id Entry id.
+ */
+void Registry::PrintValue(Print &output, int id) const {
+  double value = 0;
+  if (!Get(id, value)) return;
+  const Entry &entry = entries[id];
+  output.print(entry.name);
+  output.print('=');
+  switch (entry.type) {
+    case REGISTRY_FLOAT:
+    case REGISTRY_DOUBLE:
+    case REGISTRY_GETTER:
+      output.print(value, 4);
+      break;
+    case REGISTRY_UINT32:
+      output.print(static_cast<uint32_t>(value));
+      break;
+    default:
+      output.print(static_cast<int32_t>(value));
+      break;
+  }
+}
+
+/**
+ * @brief Prints every matching entry with its type, access and current value.
+ * @param output Output stream for logging.
+ * @param pattern Exact name or prefix followed by '*'.
+ */
+void Registry::List(Print &output, const char *pattern) const {
+  static const char *types[] = {"bool", "u8", "i16", "i32", "u32", "f32", "f64", "f32"};
+  for (int id = 0; id < numEntries; id++) {
+    if (!matches(entries[id].name, pattern)) continue;
+    output.print(entries[id].writable ? F("rw ") : F("r  "));
+    output.print(types[entries[id].type]);
+    output.print(' ');
+    PrintValue(output, id);
+    output.println();
+  }
+}
+
+/**
+ * @brief Prints the registry size or the active subscriptions.
+ * @param output Output stream for logging.
+ * @param printConfig If true, prints the number of entries; otherwise, prints the subscriptions.
+ */
+void Registry::PrintInfo(Print &output, bool printConfig) const {
+  if (printConfig) {
+    output.print(F("Registry: "));
+    output.print(numEntries);
+    output.print(F("/"));
+    output.print(REGISTRY_MAX_ENTRIES);
+    output.print(F(" entries, "));
+    output.print(rejected);
+    output.println(F(" rejected"));
+  } else {
+    output.print(F("Registry: "));
+    output.print(numSubscriptions);
+    output.print(F(" subscriptions, "));
+    output.print(linesSent);
+    output.println(F(" lines sent"));
+    for (int slot = 0; slot < numSubscriptions; slot++) {
+      output.print(F("  "));
+      output.print(entries[subscriptions[slot].id].name);
+      output.print(F(" @ "));
+      output.print(1000000UL / subscriptions[slot].periodUs);
+      output.println(F(" Hz"));
+    }
+  }
+}
+
+/**
+ * @brief Overloaded stream operator for printing the active subscriptions.
+ * @param output Output stream.
+ * @param registry Registry instance.
+ * @return Modified output stream.
+ */
+Print &operator<<(Print &output, const Registry &registry) {
+  registry.PrintInfo(output, false);
+  return output;
+}
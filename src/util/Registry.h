@@ -0,0 +1,124 @@
+/**
+ * @file Registry.h
+ * @author Aldem Pido
+ * @brief Defines the Registry class, a table of named runtime values for get, set and streaming.
+ * @ingroup util
+ */
+
+#ifndef REGISTRY_H
+#define REGISTRY_H
+
+#include <Arduino.h>
+#include <Print.h>
+
+#define REGISTRY_MAX_ENTRIES 128      ///< Maximum number of registered values.
+#define REGISTRY_MAX_SUBSCRIPTIONS 8  ///< Maximum number of values streamed at once.
+#define REGISTRY_MAX_RATE_HZ 500      ///< Fastest accepted subscription rate.
+
+/**
+ * @enum RegistryType
+ * @brief Storage type of a registered value.
+ */
+enum RegistryType : uint8_t {
+  REGISTRY_BOOL,
+  REGISTRY_UINT8,
+  REGISTRY_INT16,
+  REGISTRY_INT32,
+  REGISTRY_UINT32,
+  REGISTRY_FLOAT,
+  REGISTRY_DOUBLE,
+  REGISTRY_GETTER,  ///< Computed by a function on every read. Always read-only.
+};
+
+typedef float (*RegistryGetter)(uint8_t index);  ///< Computes a value; index selects an element.
+typedef void (*RegistryCallback)();              ///< Called after a value is set.
+
+/**
+ * @class Registry
+ * @ingroup util
+ * @brief Lets handlers, the drive and subsystems expose named values such as `pid.x.kp`.
+ *  Each entry points at a variable, or at a getter function for values that must be computed or
+ * copied safely, and carries its type and whether it may be written. Names and pointers are not
+ * copied, so they must outlive the registry. A value that cannot be added, because the table is
+ * full or the name is taken, is reported on the output and counted by GetRejectedCount().
+ *
+ *  Subscribed values are printed by Update() as one `SUB <ms> name=value ...` line per due
+ * sample, so only the signals under investigation are streamed, each at its own rate. A pattern
+ * ending in '*' matches every name with that prefix.
+ */
+class Registry {
+ public:
+  Registry(Print &output);
+
+  int Add(const char *name, bool *value, bool writable = false, RegistryCallback onSet = nullptr);
+  int Add(const char *name, uint8_t *value, bool writable = false,
+          RegistryCallback onSet = nullptr);
+  int Add(const char *name, int16_t *value, bool writable = false,
+          RegistryCallback onSet = nullptr);
+  int Add(const char *name, int32_t *value, bool writable = false,
+          RegistryCallback onSet = nullptr);
+  int Add(const char *name, uint32_t *value, bool writable = false,
+          RegistryCallback onSet = nullptr);
+  int Add(const char *name, float *value, bool writable = false,
+          RegistryCallback onSet = nullptr);
+  int Add(const char *name, double *value, bool writable = false,
+          RegistryCallback onSet = nullptr);
+  int Add(const char *name, RegistryGetter getter, uint8_t index = 0);
+
+  int GetCount() const { return numEntries; }
+  int GetRejectedCount() const { return rejected; }
+  int Find(const char *name) const;
+  bool Get(int id, double &value) const;
+  bool Set(int id, double value);
+  bool IsWritable(int id) const;
+
+  int Subscribe(const char *pattern, uint16_t rateHz);
+  int Unsubscribe(const char *pattern);
+  int GetSubscriptionCount() const { return numSubscriptions; }
+  void Update();
+
+  void List(Print &output, const char *pattern) const;
+  void PrintValue(Print &output, int id) const;
+
+  void PrintInfo(Print &output, bool printConfig = false) const;
+  friend Print &operator<<(Print &output, const Registry &registry);
+
+ private:
+  /**
+   * @struct Entry
+   * @brief One registered value.
+   */
+  struct Entry {
+    const char *name;        ///< Dotted name, e.g. "drive.pose.x".
+    RegistryType type;       ///< Type that value points to.
+    bool writable;           ///< Whether Set() is allowed.
+    uint8_t index;           ///< Passed to getter.
+    void *value;             ///< Variable, or nullptr for a getter.
+    RegistryGetter getter;   ///< Function for REGISTRY_GETTER entries.
+    RegistryCallback onSet;  ///< Called after Set(), may be nullptr.
+  };
+
+  /**
+   * @struct Subscription
+   * @brief One streamed value and when it is next due.
+   */
+  struct Subscription {
+    int id;             ///< Entry id.
+    uint32_t periodUs;  ///< Time between samples.
+    uint32_t nextUs;    ///< micros() when the next sample is due.
+  };
+
+  Print &output;                                           ///< Destination of subscription lines.
+  Entry entries[REGISTRY_MAX_ENTRIES];                     ///< Registered values.
+  int numEntries;                                          ///< Number of registered values.
+  int rejected;                                            ///< Values that could not be added.
+  Subscription subscriptions[REGISTRY_MAX_SUBSCRIPTIONS];  ///< Active subscriptions.
+  int numSubscriptions;                                    ///< Number of active subscriptions.
+  uint32_t linesSent;                                      ///< Subscription lines printed.
+
+  int add(const char *name, RegistryType type, void *value, bool writable,
+          RegistryCallback onSet);
+  static bool matches(const char *name, const char *pattern);
+};
+
+#endif  // REGISTRY_H
@@ -0,0 +1,79 @@
+/**
+ * @file RingBuffer.h
+ * @author Aldem Pido
+ * @brief Defines the RingBuffer class template, a fixed-size FIFO queue.
+ * @ingroup util
+ */
+
+#ifndef RINGBUFFER_H
+#define RINGBUFFER_H
+
+#include <stddef.h>
+
+/**
+ * @class RingBuffer
+ * @ingroup util
+ * @brief Fixed-capacity first-in first-out queue with no dynamic allocation.
+ *  Push() fails when the buffer is full; callers choose whether to drop the new element or
+ * Pop() the oldest to make room.
+ * @tparam T Element type. Must be copy assignable.
+ * @tparam N Capacity in elements.
+ */
+template <typename T, size_t N>
+class RingBuffer {
+ public:
+  RingBuffer() : head(0), count(0) {}
+
+  /**
+   * @brief Appends an element.
+   * @param value Element to append.
+   * @return False if the buffer is full and nothing was stored.
+   */
+  bool Push(const T &value) {
+    if (count == N) return false;
+    data[(head + count) % N] = value;
+    count++;
+    return true;
+  }
+
+  /**
+   * @brief Removes the oldest element.
+   * @param value Receives the removed element.
+   * @return False if the buffer is empty.
+   */
+  bool Pop(T &value) {
+    if (count == 0) return false;
+    value = data[head];
+    head = (head + 1) % N;
+    count--;
+    return true;
+  }
+
+  /**
+   * @brief Gets an element without removing it.
+   * @param index Position from the oldest element, 0 being the oldest.
+   * @return Reference to the element. The index must be less than Size().
+   */
+  const T &Peek(size_t index = 0) const { return data[(head + index) % N]; }
+
+  /**
+   * @brief Gets an element counted from the newest.
+   * @param age 0 for the newest element, 1 for the one before it, and so on.
+   * @return Reference to the element. The age must be less than Size().
+   */
+  const T &PeekNewest(size_t age = 0) const { return data[(head + count - 1 - age) % N]; }
+
+  void Clear() { head = count = 0; }                ///< Removes every element.
+  size_t Size() const { return count; }             ///< Number of stored elements.
+  size_t Free() const { return N - count; }         ///< Number of elements that can be pushed.
+  bool Empty() const { return count == 0; }         ///< True if no elements are stored.
+  bool Full() const { return count == N; }          ///< True if Push() would fail.
+  static constexpr size_t Capacity() { return N; }  ///< Maximum number of elements.
+
+ private:
+  T data[N];     ///< Element storage.
+  size_t head;   ///< Index of the oldest element.
+  size_t count;  ///< Number of stored elements.
+};
+
+#endif  // RINGBUFFER_H
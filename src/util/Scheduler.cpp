@@ -0,0 +1,316 @@
+/**
+ * @file Scheduler.cpp
+ * @author Aldem Pido
+ * @brief Implements the Scheduler class for fixed-rate cooperative task execution.
+ */
+#include "Scheduler.h"
+
+#include <Arduino.h>  // For micros(), Print, F()
+
+static_assert(SCHEDULER_MAX_TASKS <= 32, "Update() marks visited tasks in a uint32_t");
+
+/**
+ * @brief Constructs a Scheduler with no registered tasks.
+ * @param clock Microsecond time source. Defaults to micros(); a host test can pass a
+ * synthetic clock instead.
+ */
+Scheduler::Scheduler(SchedulerClock clock)
+    : numTasks(0), maxTasksPerUpdate(0), maxUpdateUs(0), clock(clock) {}
+
+/**
+ * @brief Registers a periodic task.
+ *  Tasks should be registered before Begin(). The first release happens `phaseUs`
+ * after Begin().
+ * @param name Name used in statistics output. Must outlive the scheduler.
+ * @param callback Function called on every release.
+ * @param periodUs Release period in microseconds. Must be non-zero.
+ * @param phaseUs Offset of the first release in microseconds. Reduced modulo the period.
+ * @param priority Tasks with higher priority run first when several are due in one Update().
+ * @return The task id, or -1 if the task table is full or the period is zero.
+ */
+int Scheduler::AddTask(const char *name, TaskCallback callback, uint32_t periodUs,
+                       uint32_t phaseUs, uint8_t priority) {
+  if (numTasks >= SCHEDULER_MAX_TASKS || periodUs == 0 || callback == nullptr) {
+    return -1;
+  }
+  Task &task = tasks[numTasks];
+  task.name = name;
+  task.callback = callback;
+  task.periodUs = periodUs;
+  task.phaseUs = phaseUs % periodUs;
+  task.priority = priority;
+  task.enabled = true;
+  task.nextReleaseUs = clock() + task.phaseUs;
+  task.stats = TaskStats();
+  return numTasks++;
+}
+
+/**
+ * @brief Enables or disables a task.
+ *  A disabled task keeps its release schedule so it resumes in phase when re-enabled.
+ * @param id Task id returned by AddTask().
+ * @param enabled True to run the task, false to skip it.
+ */
+void Scheduler::SetEnabled(int id, bool enabled) {
+  if (id >= 0 && id < numTasks) {
+    tasks[id].enabled = enabled;
+  }
+}
+
+/**
+ * @brief Chooses phase offsets that minimize how many tasks overlap in any time slot.
+ *  The hyperperiod (least common multiple of all periods, capped) is split into at most
+ * SCHEDULER_SPREAD_SLOTS slots. Each release of a task covers as many slots as its measured
+ * worst-case execution time, or one common-divisor period if it has not run yet. Tasks are
+ * placed shortest period first, each at the offset whose releases overlap the fewest tasks
+ * already placed. Calling this again after the tasks have run uses the measured execution times.
+ * Call Begin() afterwards to re-anchor the releases.
+ */
+void Scheduler::SpreadPhases() {
+  if (numTasks == 0) return;
+
+  uint32_t hyperUs = tasks[0].periodUs;
+  uint32_t coarseUs = tasks[0].periodUs;
+  for (int i = 1; i < numTasks; i++) {
+    const uint32_t period = tasks[i].periodUs;
+    coarseUs = gcd(coarseUs, period);
+    const uint64_t lcm = static_cast<uint64_t>(hyperUs) / gcd(hyperUs, period) * period;
+    hyperUs = (lcm > SCHEDULER_MAX_HYPERPERIOD) ? SCHEDULER_MAX_HYPERPERIOD : lcm;
+  }
+  uint32_t slotUs = coarseUs;
+  while (hyperUs / slotUs > SCHEDULER_SPREAD_SLOTS) {
+    slotUs *= 2;
+  }
+  while (slotUs % 2 == 0 && hyperUs / (slotUs / 2) <= SCHEDULER_SPREAD_SLOTS) {
+    slotUs /= 2;  // Use finer slots when the table has room so short tasks can interleave
+  }
+  const uint32_t numSlots = (hyperUs + slotUs - 1) / slotUs;
+
+  // A hyperperiod that is not a multiple of the slot ends in a partial slot past the last full one
+  uint8_t load[SCHEDULER_SPREAD_SLOTS + 1] = {0};
+  bool placed[SCHEDULER_MAX_TASKS] = {false};
+
+  for (int n = 0; n < numTasks; n++) {
+    // Pick the unplaced task with the shortest period, breaking ties by priority
+    int next = -1;
+    for (int i = 0; i < numTasks; i++) {
+      if (placed[i]) continue;
+      const Task &candidate = tasks[i];
+      if (next == -1 || candidate.periodUs < tasks[next].periodUs ||
+          (candidate.periodUs == tasks[next].periodUs &&
+           candidate.priority > tasks[next].priority)) {
+        next = i;
+      }
+    }
+    Task &task = tasks[next];
+    placed[next] = true;
+
+    uint32_t span = (task.stats.maxExecUs > 0) ? (task.stats.maxExecUs + slotUs - 1) / slotUs
+                                               : coarseUs / slotUs;
+    span = constrain(span, 1UL, numSlots);
+    const uint32_t releases = (hyperUs + task.periodUs - 1) / task.periodUs;
+
+    uint32_t bestOffset = 0;
+    uint32_t bestCost = UINT32_MAX;
+    for (uint32_t offset = 0; offset < task.periodUs && offset < hyperUs; offset += slotUs) {
+      uint32_t cost = 0;
+      for (uint32_t r = 0; r < releases; r++) {
+        const uint32_t first = ((offset + r * task.periodUs) % hyperUs) / slotUs;
+        for (uint32_t k = 0; k < span; k++) {
+          const uint32_t slot = (first + k) % numSlots;
+          if (load[slot] > cost) cost = load[slot];
+        }
+      }
+      if (cost < bestCost) {
+        bestCost = cost;
+        bestOffset = offset;
+      }
+    }
+
+    task.phaseUs = bestOffset;
+    for (uint32_t r = 0; r < releases; r++) {
+      const uint32_t first = ((bestOffset + r * task.periodUs) % hyperUs) / slotUs;
+      for (uint32_t k = 0; k < span; k++) {
+        load[(first + k) % numSlots]++;
+      }
+    }
+  }
+}
+
+/**
+ * @brief Anchors every task's first release to the current time plus its phase offset.
+ */
+void Scheduler::Begin() {
+  const uint32_t nowUs = clock();
+  for (int i = 0; i < numTasks; i++) {
+    tasks[i].nextReleaseUs = nowUs + tasks[i].phaseUs;
+  }
+}
+
+/**
+ * @brief Runs every task that is due, highest priority first.
+ *  This function is intended to be called on every loop iteration. Each task's next
+ * release is advanced by exactly one period so rates do not drift. If a task is more than a
+ * period late, the missed releases are dropped and counted as skipped rather than run back to
+ * back. Each task runs at most once per call so one slow task cannot starve the loop.
+ * @return The number of tasks run.
+ */
+int Scheduler::Update() {
+  const uint32_t startUs = clock();
+  uint32_t visited = 0;  // Bit per task already handled in this call
+  int ran = 0;
+
+  while (maxTasksPerUpdate == 0 || ran < maxTasksPerUpdate) {
+    const uint32_t nowUs = clock();
+
+    // Select the due task with the highest priority, then the earliest release
+    int next = -1;
+    for (int i = 0; i < numTasks; i++) {
+      const Task &task = tasks[i];
+      if ((visited & (1UL << i)) || !isDue(task, nowUs)) continue;
+      if (next == -1 || task.priority > tasks[next].priority ||
+          (task.priority == tasks[next].priority &&
+           static_cast<int32_t>(task.nextReleaseUs - tasks[next].nextReleaseUs) < 0)) {
+        next = i;
+      }
+    }
+    if (next == -1) break;
+
+    visited |= 1UL << next;
+    Task &task = tasks[next];
+    const uint32_t releaseUs = task.nextReleaseUs;
+    const uint32_t deadlineUs = releaseUs + task.periodUs;
+    const uint32_t jitterUs = nowUs - releaseUs;
+
+    if (task.enabled) {
+      task.callback();
+      const uint32_t endUs = clock();
+
+      TaskStats &stats = task.stats;
+      stats.runs++;
+      stats.lastJitterUs = jitterUs;
+      if (jitterUs > stats.maxJitterUs) stats.maxJitterUs = jitterUs;
+      stats.lastExecUs = endUs - nowUs;
+      if (stats.lastExecUs > stats.maxExecUs) stats.maxExecUs = stats.lastExecUs;
+      if (static_cast<int32_t>(endUs - deadlineUs) > 0) stats.overruns++;
+      ran++;
+    }
+
+    // Advance by whole periods, dropping any releases that have already passed
+    task.nextReleaseUs = deadlineUs;
+    const uint32_t lateUs = clock() - task.nextReleaseUs;
+    if (static_cast<int32_t>(lateUs) >= static_cast<int32_t>(task.periodUs)) {
+      const uint32_t missed = lateUs / task.periodUs;
+      task.nextReleaseUs += missed * task.periodUs;
+      if (task.enabled) task.stats.skipped += missed;
+    }
+  }
+
+  const uint32_t elapsedUs = clock() - startUs;
+  if (elapsedUs > maxUpdateUs) maxUpdateUs = elapsedUs;
+  return ran;
+}
+
+/**
+ * @brief Gets the name of a task.
+ * @param id Task id returned by AddTask().
+ * @return The task name, or nullptr if the id is out of bounds.
+ */
+const char *Scheduler::GetTaskName(int id) const {
+  if (id >= 0 && id < numTasks) {
+    return tasks[id].name;
+  }
+  return nullptr;
+}
+
+/**
+ * @brief Gets the timing counters of a task.
+ * @param id Task id returned by AddTask().
+ * @return The task's statistics. Returns an all-zero record if the id is out of bounds.
+ */
+const TaskStats &Scheduler::GetStats(int id) const {
+  static const TaskStats empty;
+  if (id >= 0 && id < numTasks) {
+    return tasks[id].stats;
+  }
+  return empty;
+}
+
+/**
+ * @brief Clears the timing counters of every task and the worst-case Update() time.
+ */
+void Scheduler::ResetStats() {
+  for (int i = 0; i < numTasks; i++) {
+    tasks[i].stats = TaskStats();
+  }
+  maxUpdateUs = 0;
+}
+
+/**
+ * @brief Computes the greatest common divisor of two periods.
+ */
+uint32_t Scheduler::gcd(uint32_t a, uint32_t b) {
+  while (b != 0) {
+    const uint32_t t = a % b;
+    a = b;
+    b = t;
+  }
+  return a;
+}
+
+/**
+ * @brief Prints the task table or per-task timing counters.
+ * @param output Output stream for logging.
+ * @param printConfig If true, prints period, phase and priority; otherwise, prints counters.
+ */
+void Scheduler::PrintInfo(Print &output, bool printConfig) const {
+  if (printConfig) {
+    output.println(F("Scheduler Configuration:"));
+    for (int i = 0; i < numTasks; i++) {
+      const Task &task = tasks[i];
+      output.print(F("  "));
+      output.print(task.name);
+      output.print(F(": period "));
+      output.print(task.periodUs);
+      output.print(F(" us, phase "));
+      output.print(task.phaseUs);
+      output.print(F(" us, priority "));
+      output.println(task.priority);
+    }
+  } else {
+    output.print(F("Scheduler (max update "));
+    output.print(maxUpdateUs);
+    output.println(F(" us):"));
+    for (int i = 0; i < numTasks; i++) {
+      const Task &task = tasks[i];
+      output.print(F("  "));
+      output.print(task.name);
+      output.print(F(": runs "));
+      output.print(task.stats.runs);
+      output.print(F(", overruns "));
+      output.print(task.stats.overruns);
+      output.print(F(", skipped "));
+      output.print(task.stats.skipped);
+      output.print(F(", jitter "));
+      output.print(task.stats.lastJitterUs);
+      output.print(F("/"));
+      output.print(task.stats.maxJitterUs);
+      output.print(F(" us, exec "));
+      output.print(task.stats.lastExecUs);
+      output.print(F("/"));
+      output.print(task.stats.maxExecUs);
+      output.println(F(" us"));
+    }
+  }
+}
+
+/**
+ * @brief Overloaded stream operator for printing scheduler statistics.
+ * @param output Output stream.
+ * @param scheduler Scheduler instance.
+ * @return Modified output stream.
+ */
+Print &operator<<(Print &output, const Scheduler &scheduler) {
+  scheduler.PrintInfo(output, false);
+  return output;
+}
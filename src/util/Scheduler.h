@@ -0,0 +1,96 @@
+/**
+ * @file Scheduler.h
+ * @author Aldem Pido
+ * @brief Defines the Scheduler class, a fixed-rate cooperative task scheduler.
+ * @defgroup util Utilities
+ * This group contains timing, diagnostics, and infrastructure shared by the handlers, drive,
+ * and subsystems.
+ */
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <Arduino.h>
+#include <Print.h>
+
+#define SCHEDULER_MAX_TASKS 24               ///< Maximum number of tasks that can be registered.
+#define SCHEDULER_SPREAD_SLOTS 200           ///< Time slots used when spreading task phases.
+#define SCHEDULER_MAX_HYPERPERIOD 1000000UL  ///< Cap (us) on the hyperperiod used for spreading.
+
+typedef void (*TaskCallback)();        ///< Periodic task body.
+typedef uint32_t (*SchedulerClock)();  ///< Microsecond time source.
+
+/**
+ * @struct TaskStats
+ * @ingroup util
+ * @brief Timing counters kept for every registered task.
+ */
+struct TaskStats {
+  uint32_t runs = 0;          ///< Number of times the task has run.
+  uint32_t overruns = 0;      ///< Runs that finished after their deadline (the next release).
+  uint32_t skipped = 0;       ///< Releases dropped because the task was more than a period late.
+  uint32_t lastJitterUs = 0;  ///< Start time minus release time of the last run.
+  uint32_t maxJitterUs = 0;   ///< Largest start time minus release time seen.
+  uint32_t lastExecUs = 0;    ///< Execution time of the last run.
+  uint32_t maxExecUs = 0;     ///< Largest execution time seen.
+};
+
+/**
+ * @class Scheduler
+ * @ingroup util
+ * @brief Runs registered periodic tasks at fixed rates from the main loop.
+ *  Each task has a period, a phase offset, and a priority. Releases are anchored to the
+ * start time so they do not drift, and due tasks are run highest priority first. Phase offsets
+ * can be spread automatically so that tasks sharing a rate do not all land in the same loop
+ * iteration.
+ */
+class Scheduler {
+ public:
+  Scheduler(SchedulerClock clock = micros);
+
+  int AddTask(const char *name, TaskCallback callback, uint32_t periodUs, uint32_t phaseUs = 0,
+              uint8_t priority = 0);
+  void SetEnabled(int id, bool enabled);
+  void SetMaxTasksPerUpdate(int maxTasks) { maxTasksPerUpdate = maxTasks; }
+  void SpreadPhases();
+  void Begin();
+  int Update();
+
+  int GetTaskCount() const { return numTasks; }
+  const char *GetTaskName(int id) const;
+  const TaskStats &GetStats(int id) const;
+  uint32_t GetMaxUpdateUs() const { return maxUpdateUs; }
+  void ResetStats();
+
+  void PrintInfo(Print &output, bool printConfig = false) const;
+  friend Print &operator<<(Print &output, const Scheduler &scheduler);
+
+ private:
+  /**
+   * @struct Task
+   * @brief Registration and release state for one periodic task.
+   */
+  struct Task {
+    const char *name = nullptr;       ///< Name used in statistics output.
+    TaskCallback callback = nullptr;  ///< Function run on every release.
+    uint32_t periodUs = 0;            ///< Release period in microseconds.
+    uint32_t phaseUs = 0;             ///< Offset of the first release from Begin().
+    uint8_t priority = 0;             ///< Higher values run first when several tasks are due.
+    bool enabled = true;              ///< Disabled tasks keep their phase but never run.
+    uint32_t nextReleaseUs = 0;       ///< Absolute time of the next release.
+    TaskStats stats;                  ///< Timing counters.
+  };
+
+  Task tasks[SCHEDULER_MAX_TASKS];  ///< Registered tasks.
+  int numTasks;                     ///< Number of registered tasks.
+  int maxTasksPerUpdate;            ///< Limit on tasks run per Update(), 0 for no limit.
+  uint32_t maxUpdateUs;             ///< Longest Update() call seen.
+  SchedulerClock clock;             ///< Time source, micros() on target.
+
+  static bool isDue(const Task &task, uint32_t nowUs) {
+    return static_cast<int32_t>(nowUs - task.nextReleaseUs) >= 0;
+  }
+  static uint32_t gcd(uint32_t a, uint32_t b);
+};
+
+#endif  // SCHEDULER_H
@@ -0,0 +1,165 @@
+/**
+ * @file StartupSequencer.cpp
+ * @author Aldem Pido
+ * @brief Implements the StartupSequencer class for incremental device bring-up.
+ */
+#include "StartupSequencer.h"
+
+#include <Arduino.h>  // For millis(), micros(), Print, F()
+
+/**
+ * @brief Constructs a StartupSequencer with no registered stages.
+ */
+StartupSequencer::StartupSequencer()
+    : numStages(0), current(-1), requiredDoneMs(0), doneMs(0) {}
+
+/**
+ * @brief Registers a bring-up stage.
+ * @param name Name used in status output. Must outlive the sequencer.
+ * @param begin Function that performs one bounded step of the bring-up.
+ * @param required True if the robot must not arm until this stage is done.
+ * @return The stage id, or -1 if the stage table is full.
+ */
+int StartupSequencer::AddStage(const char *name, StageFunction begin, bool required) {
+  if (numStages >= STARTUP_MAX_STAGES || begin == nullptr) {
+    return -1;
+  }
+  Stage &stage = stages[numStages];
+  stage = Stage();
+  stage.name = name;
+  stage.begin = begin;
+  stage.required = required;
+  stage.retryMs = STARTUP_RETRY_MS;
+  doneMs = 0;
+  if (required) requiredDoneMs = 0;
+  return numStages++;
+}
+
+/**
+ * @brief Makes at most one stage call.
+ *  A stage that returned STAGE_PENDING is continued first. Otherwise the first unfinished stage
+ * whose retry delay has passed is called. This function is intended to be called regularly from
+ * the main loop.
+ */
+void StartupSequencer::Update() {
+  const uint32_t nowMs = millis();
+  int id = current;
+  if (id < 0) {
+    for (int i = 0; i < numStages; i++) {
+      if (!stages[i].done && static_cast<int32_t>(nowMs - stages[i].nextAttemptMs) >= 0) {
+        id = i;
+        break;
+      }
+    }
+    if (id < 0) return;
+    stages[id].attempts++;
+  }
+
+  Stage &stage = stages[id];
+  const uint32_t startUs = micros();
+  const StageResult result = stage.begin();
+  stage.busyUs += micros() - startUs;
+
+  switch (result) {
+    case STAGE_DONE:
+      stage.done = true;
+      stage.doneMs = millis();
+      current = -1;
+      updateTotals(stage.doneMs);
+      break;
+    case STAGE_PENDING:
+      current = id;
+      break;
+    case STAGE_FAILED:
+      stage.nextAttemptMs = millis() + stage.retryMs;
+      stage.retryMs = min(stage.retryMs * 2, static_cast<uint32_t>(STARTUP_MAX_RETRY_MS));
+      current = -1;
+      break;
+  }
+}
+
+/**
+ * @brief Records when all required stages, and then all stages, first became done.
+ * @param nowMs Time the latest stage finished.
+ */
+void StartupSequencer::updateTotals(uint32_t nowMs) {
+  if (requiredDoneMs == 0 && IsRequiredDone()) requiredDoneMs = nowMs;
+  if (doneMs == 0 && IsDone()) doneMs = nowMs;
+}
+
+/**
+ * @brief Checks whether a stage has finished.
+ * @param id Stage id returned by AddStage().
+ * @return True if the stage returned STAGE_DONE. False for an invalid id.
+ */
+bool StartupSequencer::IsStageDone(int id) const {
+  return id >= 0 && id < numStages && stages[id].done;
+}
+
+/**
+ * @brief Checks whether every stage registered as required has finished.
+ */
+bool StartupSequencer::IsRequiredDone() const {
+  for (int i = 0; i < numStages; i++) {
+    if (stages[i].required && !stages[i].done) return false;
+  }
+  return true;
+}
+
+/**
+ * @brief Checks whether every stage has finished.
+ */
+bool StartupSequencer::IsDone() const {
+  for (int i = 0; i < numStages; i++) {
+    if (!stages[i].done) return false;
+  }
+  return true;
+}
+
+/**
+ * @brief Prints the registered stages or their progress and timings.
+ * @param output Output stream for logging.
+ * @param printConfig If true, prints the stage list; otherwise, prints per-stage progress.
+ */
+void StartupSequencer::PrintInfo(Print &output, bool printConfig) const {
+  if (printConfig) {
+    output.println(F("StartupSequencer Configuration:"));
+    for (int i = 0; i < numStages; i++) {
+      output.print(F("  "));
+      output.print(stages[i].name);
+      output.println(stages[i].required ? F(" (required)") : F(""));
+    }
+  } else {
+    output.print(F("Startup: required done at "));
+    output.print(requiredDoneMs);
+    output.print(F(" ms, all done at "));
+    output.print(doneMs);
+    output.println(F(" ms"));
+    for (int i = 0; i < numStages; i++) {
+      const Stage &stage = stages[i];
+      output.print(F("  "));
+      output.print(stage.name);
+      output.print(stage.done ? F(": done at ") : F(": pending, "));
+      if (stage.done) {
+        output.print(stage.doneMs);
+        output.print(F(" ms, "));
+      }
+      output.print(F("attempts "));
+      output.print(stage.attempts);
+      output.print(F(", busy "));
+      output.print(stage.busyUs);
+      output.println(F(" us"));
+    }
+  }
+}
+
+/**
+ * @brief Overloaded stream operator for printing startup progress.
+ * @param output Output stream.
+ * @param sequencer StartupSequencer instance.
+ * @return Modified output stream.
+ */
+Print &operator<<(Print &output, const StartupSequencer &sequencer) {
+  sequencer.PrintInfo(output, false);
+  return output;
+}
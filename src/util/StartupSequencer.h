@@ -0,0 +1,82 @@
+/**
+ * @file StartupSequencer.h
+ * @author Aldem Pido
+ * @brief Defines the StartupSequencer class for bringing up slow devices from the main loop.
+ * @ingroup util
+ */
+
+#ifndef STARTUPSEQUENCER_H
+#define STARTUPSEQUENCER_H
+
+#include <Arduino.h>
+#include <Print.h>
+
+#define STARTUP_MAX_STAGES 12      ///< Maximum number of stages that can be registered.
+#define STARTUP_RETRY_MS 500       ///< Delay before the first retry of a failed stage.
+#define STARTUP_MAX_RETRY_MS 8000  ///< Cap on the retry delay, which doubles after each failure.
+
+/**
+ * @enum StageResult
+ * @brief Value returned by a stage function after one call.
+ */
+enum StageResult : uint8_t {
+  STAGE_DONE,     ///< The device is ready. The stage is not called again.
+  STAGE_PENDING,  ///< Progress was made; call again on the next Update().
+  STAGE_FAILED,   ///< The attempt failed; retry after a back-off delay.
+};
+
+typedef StageResult (*StageFunction)();  ///< One bounded step of a device bring-up.
+
+/**
+ * @class StartupSequencer
+ * @ingroup util
+ * @brief Runs device bring-up in small steps so the rest of the robot is live during boot.
+ *  Each call to Update() makes at most one call to one stage function, so a slow bring-up such
+ * as five TOF sensors behind a mux is spread across loop iterations instead of blocking setup().
+ * Stages run in registration order. A failed stage is retried in the background with a doubling
+ * delay while later stages continue, so a missing sensor no longer forces a reboot. Time spent in
+ * each stage and the boot time at which it finished are recorded for tracking boot time.
+ */
+class StartupSequencer {
+ public:
+  StartupSequencer();
+
+  int AddStage(const char *name, StageFunction begin, bool required = false);
+  void Update();
+
+  bool IsStageDone(int id) const;
+  bool IsRequiredDone() const;
+  bool IsDone() const;
+  uint32_t GetRequiredDoneMs() const { return requiredDoneMs; }
+  uint32_t GetDoneMs() const { return doneMs; }
+
+  void PrintInfo(Print &output, bool printConfig = false) const;
+  friend Print &operator<<(Print &output, const StartupSequencer &sequencer);
+
+ private:
+  /**
+   * @struct Stage
+   * @brief Registration and progress of one bring-up stage.
+   */
+  struct Stage {
+    const char *name = nullptr;     ///< Name used in status output.
+    StageFunction begin = nullptr;  ///< Called until it returns STAGE_DONE.
+    bool required = false;          ///< Whether the robot may not arm until this is done.
+    bool done = false;              ///< Set once begin() returns STAGE_DONE.
+    uint16_t attempts = 0;          ///< Number of attempts started, including retries.
+    uint32_t busyUs = 0;            ///< Total time spent inside begin().
+    uint32_t doneMs = 0;            ///< millis() when the stage finished.
+    uint32_t retryMs = 0;           ///< Current retry delay.
+    uint32_t nextAttemptMs = 0;     ///< millis() before which a failed stage is not retried.
+  };
+
+  Stage stages[STARTUP_MAX_STAGES];  ///< Registered stages.
+  int numStages;                     ///< Number of registered stages.
+  int current;                       ///< Stage that returned STAGE_PENDING, or -1.
+  uint32_t requiredDoneMs;           ///< millis() when every required stage was done, or 0.
+  uint32_t doneMs;                   ///< millis() when every stage was done, or 0.
+
+  void updateTotals(uint32_t nowMs);
+};
+
+#endif  // STARTUPSEQUENCER_H
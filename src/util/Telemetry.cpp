@@ -0,0 +1,176 @@
+/**
+ * @file Telemetry.cpp
+ * @author Aldem Pido
+ * @brief Implements the Telemetry class for COBS-framed binary status packets.
+ */
+#include "Telemetry.h"
+
+#include <Arduino.h>  // For millis(), Print, F()
+
+/**
+ * @brief Constructs a Telemetry encoder.
+ * @param output Stream packets are written to, e.g. Serial.
+ */
+Telemetry::Telemetry(Print &output) : output(output), packets(0), bytes(0), drops(0) {
+  for (int t = 0; t < TELEMETRY_MESSAGE_COUNT; t++) {
+    sequence[t] = 0;
+    sinceKeyframe[t] = 0;
+    for (int f = 0; f <= TELEMETRY_MAX_FIELDS; f++) {
+      previous[t][f] = 0;
+    }
+  }
+}
+
+/**
+ * @brief Encodes and writes one message, or drops it if the output has no room.
+ *  The first packet of each type, and every TELEMETRY_KEYFRAME_INTERVAL-th packet after it,
+ * carries absolute values. The rest carry differences from the previous packet of that type, so
+ * after a drop the next packet of the type is made a keyframe. A type must always be sent with
+ * the same number of fields.
+ * @param type Message type.
+ * @param fields Scaled field values in the layout documented for the type.
+ * @param numFields Number of fields. Clamped to TELEMETRY_MAX_FIELDS.
+ * @return True if the packet was written, false if it was dropped.
+ */
+bool Telemetry::Send(TelemetryMessage type, const int32_t *fields, uint8_t numFields) {
+  if (type >= TELEMETRY_MESSAGE_COUNT) return false;
+  if (numFields > TELEMETRY_MAX_FIELDS) numFields = TELEMETRY_MAX_FIELDS;
+
+  const bool keyframe = (sinceKeyframe[type] == 0);
+  sinceKeyframe[type] = (sinceKeyframe[type] + 1) % TELEMETRY_KEYFRAME_INTERVAL;
+
+  uint8_t raw[TELEMETRY_BUFFER_SIZE];
+  size_t length = 0;
+  raw[length++] = TELEMETRY_SCHEMA_ID;
+  raw[length++] = type | (keyframe ? TELEMETRY_KEYFRAME_FLAG : 0);
+  raw[length++] = sequence[type]++;
+
+  int32_t *last = previous[type];
+  for (uint8_t i = 0; i <= numFields; i++) {
+    const int32_t value = (i == 0) ? static_cast<int32_t>(millis()) : fields[i - 1];
+    length += putVarint(raw + length, keyframe ? value : value - last[i]);
+    last[i] = value;
+  }
+
+  const uint16_t crc = Crc16(raw, length);
+  raw[length++] = crc & 0xFF;
+  raw[length++] = crc >> 8;
+
+  uint8_t framed[TELEMETRY_BUFFER_SIZE + 2];
+  size_t framedLength = CobsEncode(raw, length, framed);
+  framed[framedLength++] = 0x00;  // Frame delimiter
+  if (output.availableForWrite() < static_cast<int>(framedLength)) {
+    drops++;
+    sinceKeyframe[type] = 0;  // The reader is missing this delta
+    return false;
+  }
+  output.write(framed, framedLength);
+
+  packets++;
+  bytes += framedLength;
+  return true;
+}
+
+/**
+ * @brief Makes the next packet of every type a keyframe.
+ *  Call this when a reader may have just connected.
+ */
+void Telemetry::ForceKeyframe() {
+  for (int t = 0; t < TELEMETRY_MESSAGE_COUNT; t++) {
+    sinceKeyframe[t] = 0;
+  }
+}
+
+/**
+ * @brief Computes a CRC-16/CCITT-FALSE checksum (polynomial 0x1021, initial value 0xFFFF).
+ * @param data Bytes to check.
+ * @param length Number of bytes.
+ * @return The checksum.
+ */
+uint16_t Telemetry::Crc16(const uint8_t *data, size_t length) {
+  uint16_t crc = 0xFFFF;
+  for (size_t i = 0; i < length; i++) {
+    crc ^= static_cast<uint16_t>(data[i]) << 8;
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+  }
+  return crc;
+}
+
+/**
+ * @brief Applies consistent overhead byte stuffing so the output contains no zero bytes.
+ * @param input Bytes to encode.
+ * @param length Number of input bytes. Must be under 254 so only one overhead byte is needed.
+ * @param output Destination buffer, at least length + 1 bytes.
+ * @return Number of encoded bytes, not including the frame delimiter.
+ */
+size_t Telemetry::CobsEncode(const uint8_t *input, size_t length, uint8_t *output) {
+  size_t codeIndex = 0;
+  size_t outIndex = 1;
+  uint8_t code = 1;
+  for (size_t i = 0; i < length; i++) {
+    if (input[i] == 0) {
+      output[codeIndex] = code;
+      codeIndex = outIndex++;
+      code = 1;
+    } else {
+      output[outIndex++] = input[i];
+      code++;
+    }
+  }
+  output[codeIndex] = code;
+  return outIndex;
+}
+
+/**
+ * @brief Writes a signed value as a zigzag-encoded LEB128 varint.
+ * @param buffer Destination, at least 5 bytes.
+ * @param value Value to encode. Small magnitudes of either sign take one byte.
+ * @return Number of bytes written.
+ */
+size_t Telemetry::putVarint(uint8_t *buffer, int32_t value) {
+  uint32_t zigzag = (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+  size_t length = 0;
+  while (zigzag >= 0x80) {
+    buffer[length++] = static_cast<uint8_t>(zigzag) | 0x80;
+    zigzag >>= 7;
+  }
+  buffer[length++] = static_cast<uint8_t>(zigzag);
+  return length;
+}
+
+/**
+ * @brief Prints the telemetry configuration or traffic counters.
+ *  Do not print to the telemetry stream itself while packets are being decoded.
+ * @param output Output stream for logging.
+ * @param printConfig If true, prints the schema; otherwise, prints packet and byte counts.
+ */
+void Telemetry::PrintInfo(Print &output, bool printConfig) const {
+  if (printConfig) {
+    output.print(F("Telemetry Configuration: schema "));
+    output.print(TELEMETRY_SCHEMA_ID);
+    output.print(F(", keyframe every "));
+    output.print(TELEMETRY_KEYFRAME_INTERVAL);
+    output.println(F(" packets"));
+  } else {
+    output.print(F("Telemetry: "));
+    output.print(packets);
+    output.print(F(" packets, "));
+    output.print(bytes);
+    output.print(F(" bytes, "));
+    output.print(drops);
+    output.println(F(" dropped"));
+  }
+}
+
+/**
+ * @brief Overloaded stream operator for printing telemetry counters.
+ * @param output Output stream.
+ * @param telemetry Telemetry instance.
+ * @return Modified output stream.
+ */
+Print &operator<<(Print &output, const Telemetry &telemetry) {
+  telemetry.PrintInfo(output, false);
+  return output;
+}
@@ -0,0 +1,79 @@
+/**
+ * @file Telemetry.h
+ * @author Aldem Pido
+ * @brief Defines the Telemetry class for sending compact binary status packets.
+ * @ingroup util
+ */
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <Arduino.h>
+#include <Print.h>
+
+#define TELEMETRY_SCHEMA_ID 2           ///< Bumped whenever a message layout changes.
+#define TELEMETRY_MAX_FIELDS 16         ///< Maximum number of fields in one message.
+#define TELEMETRY_KEYFRAME_INTERVAL 50  ///< Every Nth packet of a type carries absolute values.
+#define TELEMETRY_KEYFRAME_FLAG 0x80    ///< Set in the type byte of keyframe packets.
+#define TELEMETRY_BUFFER_SIZE 128       ///< Size of the raw and COBS-encoded packet buffers.
+
+/**
+ * @brief Message types and their field layouts.
+ *  Every message starts with a millis() timestamp, followed by the listed fields as scaled
+ * integers. tools/telemetry_decode.py mirrors these layouts.
+ */
+enum TelemetryMessage : uint8_t {
+  TELEMETRY_POSE,      ///< x, y (0.01 in), theta (mrad).
+  TELEMETRY_VELOCITY,  ///< vx, vy (0.01 in/s), omega (mrad/s), ideal and measured vx, vy, omega.
+  TELEMETRY_ENCODERS,  ///< Raw encoder counts, one per drive motor.
+  TELEMETRY_TOF,       ///< Distances (mm), one per sensor.
+  TELEMETRY_RC,        ///< Scaled channel values (-255 to 255), one per channel.
+  TELEMETRY_SERVO,     ///< Commanded angles (deg), one per servo.
+  TELEMETRY_MOTOR,     ///< Commanded speeds (-255 to 255): drive motors, intake, transfer.
+  TELEMETRY_MESSAGE_COUNT
+};
+
+/**
+ * @class Telemetry
+ * @ingroup util
+ * @brief Encodes status messages as COBS-framed binary packets.
+ *  Packet layout before framing: schema id, type (with TELEMETRY_KEYFRAME_FLAG on keyframes),
+ * sequence number, the timestamp and fields as zigzag varints, and a CRC-16/CCITT of everything
+ * before it. Between keyframes each value is sent as the difference from the previous packet of
+ * the same type, so slowly changing fields cost one byte. The packet is COBS encoded and
+ * terminated with a zero byte so a reader can resynchronize after any corruption.
+ *
+ *  Send() never blocks: a packet that does not fit in the output's availableForWrite() is dropped
+ * and counted, and the next packet of that type is a keyframe so the deltas resynchronize. The
+ * dropped packet still uses up a sequence number, so the reader sees the gap.
+ */
+class Telemetry {
+ public:
+  Telemetry(Print &output);
+
+  bool Send(TelemetryMessage type, const int32_t *fields, uint8_t numFields);
+  void ForceKeyframe();
+
+  uint32_t GetPacketCount() const { return packets; }
+  uint32_t GetByteCount() const { return bytes; }
+  uint32_t GetDropCount() const { return drops; }
+
+  void PrintInfo(Print &output, bool printConfig = false) const;
+  friend Print &operator<<(Print &output, const Telemetry &telemetry);
+
+  static uint16_t Crc16(const uint8_t *data, size_t length);
+  static size_t CobsEncode(const uint8_t *input, size_t length, uint8_t *output);
+
+ private:
+  Print &output;                                                        ///< Packet destination.
+  uint8_t sequence[TELEMETRY_MESSAGE_COUNT];                            ///< Next sequence per type.
+  uint8_t sinceKeyframe[TELEMETRY_MESSAGE_COUNT];                       ///< Packets since keyframe.
+  int32_t previous[TELEMETRY_MESSAGE_COUNT][TELEMETRY_MAX_FIELDS + 1];  ///< Last values per type.
+  uint32_t packets;                                                     ///< Packets sent.
+  uint32_t bytes;                                                       ///< Framed bytes sent.
+  uint32_t drops;                                                       ///< Packets dropped.
+
+  static size_t putVarint(uint8_t *buffer, int32_t value);
+};
+
+#endif  // TELEMETRY_H
@@ -0,0 +1,104 @@
+/**
+ * @file Tracer.cpp
+ * @author Aldem Pido
+ * @brief Implements the Tracer class for timeline traces.
+ */
+#include "Tracer.h"
+
+#include <Arduino.h>  // For F_CPU_ACTUAL, Print, F()
+
+Tracer Trace;
+
+/**
+ * @brief Constructs a Tracer that records every track.
+ */
+Tracer::Tracer()
+    : trackMask(TRACE_ALL_TRACKS), wraps(0), lastCycles(Profiler::Cycles()), overwritten(0) {}
+
+/**
+ * @brief Discards every recorded event.
+ */
+void Tracer::Clear() {
+  events.Clear();
+  overwritten = 0;
+}
+
+/**
+ * @brief Prints every recorded event for tools/trace_to_chrome.py.
+ *  Format: `TRC H <events> <overwritten>`, then `TRC <us> <phase> <track> <value> <name>` per
+ * event, then `TRC E`. Times are microseconds since the oldest event with three decimals. The
+ * whole buffer is printed at once, so send it to Serial rather than the logger.
+ * @param output Output stream.
+ */
+void Tracer::Dump(Print &output) const {
+  static const char phases[] = {'B', 'E', 'i', 'C'};
+#if defined(__IMXRT1062__)
+  const uint32_t cyclesPerUs = F_CPU_ACTUAL / 1000000;
+#else
+  const uint32_t cyclesPerUs = 1000;  // Profiler::Cycles() counts nanoseconds on the host
+#endif
+  output.print(F("TRC H "));
+  output.print(events.Size());
+  output.print(' ');
+  output.println(overwritten);
+  if (!events.Empty()) {
+    const TraceEvent &oldest = events.Peek(0);
+    const uint64_t start = (static_cast<uint64_t>(oldest.wraps) << 32) | oldest.cycles;
+    for (size_t i = 0; i < events.Size(); i++) {
+      const TraceEvent &event = events.Peek(i);
+      const uint64_t cycles = (static_cast<uint64_t>(event.wraps) << 32) | event.cycles;
+      const uint64_t ns = (cycles - start) * 1000 / cyclesPerUs;
+      const uint32_t fraction = ns % 1000;
+      output.print(F("TRC "));
+      output.print(static_cast<uint32_t>(ns / 1000));
+      output.print('.');
+      if (fraction < 100) output.print('0');
+      if (fraction < 10) output.print('0');
+      output.print(fraction);
+      output.print(' ');
+      output.print(phases[event.type]);
+      output.print(' ');
+      output.print(event.track);
+      output.print(' ');
+      output.print(event.value);
+      output.print(' ');
+      output.println(event.name);
+    }
+  }
+  output.println(F("TRC E"));
+}
+
+/**
+ * @brief Prints the buffer size or how full it is.
+ * @param output Output stream for logging.
+ * @param printConfig If true, prints the capacity; otherwise, prints the fill and track mask.
+ */
+void Tracer::PrintInfo(Print &output, bool printConfig) const {
+  if (printConfig) {
+    output.print(F("Tracer Configuration: "));
+    output.print(events.Capacity());
+    output.print(F(" events, "));
+    output.print(sizeof(events));
+    output.println(F(" bytes"));
+  } else {
+    output.print(F("Tracer: "));
+    output.print(events.Size());
+    output.print(F("/"));
+    output.print(events.Capacity());
+    output.print(F(" events, "));
+    output.print(overwritten);
+    output.print(F(" overwritten, tracks 0x"));
+    output.println(trackMask, HEX);
+  }
+}
+
+/**
+ * @brief Overloaded stream operator for printing how full the trace buffer is.
+ * @param output Output stream.
+ * @param tracer Tracer instance.
+ * @return Modified output stream.
+ */
+Print &operator<<(Print &output, const Tracer &tracer) {
+  tracer.PrintInfo(output, false);
+  return output;
+}
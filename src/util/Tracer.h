@@ -0,0 +1,150 @@
+/**
+ * @file Tracer.h
+ * @author Aldem Pido
+ * @brief Defines the Tracer class, an in-RAM timeline of begin/end/instant events, and the
+ * TRACE_* macros.
+ * @ingroup util
+ */
+
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <Arduino.h>
+#include <Print.h>
+
+#include "Profiler.h"  // For Profiler::Cycles()
+#include "RingBuffer.h"
+
+#ifndef TRACE_ENABLED
+#define TRACE_ENABLED 1  ///< Set to 0 to compile the TRACE_* macros out entirely.
+#endif
+
+#ifndef TRACE_BUFFER_EVENTS
+#define TRACE_BUFFER_EVENTS 2048  ///< Events kept, 16 bytes each. The oldest are overwritten.
+#endif
+
+/**
+ * @enum TraceType
+ * @brief Kind of a trace event. The letters match the Chrome trace event phases.
+ */
+enum TraceType : uint8_t {
+  TRACE_TYPE_BEGIN,    ///< 'B': a span starts.
+  TRACE_TYPE_END,      ///< 'E': the span with the same name on the same track ends.
+  TRACE_TYPE_INSTANT,  ///< 'i': a point in time.
+  TRACE_TYPE_COUNTER,  ///< 'C': a value changes.
+};
+
+/**
+ * @enum TraceTrack
+ * @brief Timeline row an event is drawn on. Spans must nest properly within one track.
+ */
+enum TraceTrack : uint8_t {
+  TRACE_TRACK_LOOP,     ///< Profiler zones: handler updates and drive steps.
+  TRACE_TRACK_STATE,    ///< Robot state machine.
+  TRACE_TRACK_MISSION,  ///< Mission steps.
+  TRACE_TRACK_COUNT
+};
+
+#define TRACE_ALL_TRACKS ((1 << TRACE_TRACK_COUNT) - 1)  ///< Mask that records every track.
+
+/**
+ * @struct TraceEvent
+ * @ingroup util
+ * @brief One recorded event.
+ */
+struct TraceEvent {
+  uint32_t cycles;   ///< Cycle counter when the event was recorded.
+  const char *name;  ///< Span, instant or counter name. Not copied.
+  int32_t value;     ///< Counter value; 0 for other events.
+  uint8_t type;      ///< TraceType.
+  uint8_t track;     ///< TraceTrack.
+  uint16_t wraps;    ///< Cycle counter wraps seen before this event.
+};
+
+/**
+ * @class Tracer
+ * @ingroup util
+ * @brief Records a timeline of the state machine, mission steps and profiler zones.
+ *  Recording stores the cycle counter and a name pointer in a ring buffer, so it costs a few
+ * dozen cycles and never allocates or prints. Dump() prints the buffer as text and
+ * tools/trace_to_chrome.py turns it into Chrome trace JSON for Perfetto or chrome://tracing.
+ *
+ *  Tracks can be switched off with a mask, e.g. to keep only state and mission events over a
+ * whole match. Update() must run at least every few seconds to keep the cycle counter wraps
+ * counted. Record() is not interrupt safe; call it from the main loop only.
+ */
+class Tracer {
+ public:
+  Tracer();
+
+  /**
+   * @brief Appends an event if its track is enabled.
+   * @param type TraceType of the event.
+   * @param track TraceTrack to draw it on.
+   * @param name Event name. Must outlive the tracer.
+   * @param value Counter value.
+   */
+  void Record(TraceType type, TraceTrack track, const char *name, int32_t value = 0) {
+    if (!(trackMask & (1 << track))) return;
+    TraceEvent event;
+    event.cycles = countWraps();
+    event.name = name;
+    event.value = value;
+    event.type = type;
+    event.track = track;
+    event.wraps = wraps;
+    if (events.Full()) {
+      TraceEvent oldest;
+      events.Pop(oldest);
+      overwritten++;
+    }
+    events.Push(event);
+  }
+
+  void Update() { countWraps(); }
+  void SetTrackMask(uint8_t mask) { trackMask = mask; }
+  uint8_t GetTrackMask() const { return trackMask; }
+  void Clear();
+  void Dump(Print &output) const;
+
+  void PrintInfo(Print &output, bool printConfig = false) const;
+  friend Print &operator<<(Print &output, const Tracer &tracer);
+
+ private:
+  RingBuffer<TraceEvent, TRACE_BUFFER_EVENTS> events;  ///< Recorded events, oldest first.
+  uint8_t trackMask;                                   ///< Bit per TraceTrack that is recorded.
+  uint16_t wraps;                                      ///< Cycle counter wraps seen.
+  uint32_t lastCycles;                                 ///< Cycle counter at the last check.
+  uint32_t overwritten;                                ///< Events lost to a full buffer.
+
+  /**
+   * @brief Reads the cycle counter and counts a wrap if it went backwards.
+   * @return The current cycle count.
+   */
+  uint32_t countWraps() {
+    const uint32_t now = Profiler::Cycles();
+    if (now < lastCycles) wraps++;
+    lastCycles = now;
+    return now;
+  }
+};
+
+extern Tracer Trace;  ///< Shared timeline recorder.
+
+#if TRACE_ENABLED
+/// Starts a span on a track.
+#define TRACE_BEGIN(track, name) Trace.Record(TRACE_TYPE_BEGIN, track, name)
+/// Ends the span with the same name on a track.
+#define TRACE_END(track, name) Trace.Record(TRACE_TYPE_END, track, name)
+/// Marks a point in time on a track.
+#define TRACE_INSTANT(track, name) Trace.Record(TRACE_TYPE_INSTANT, track, name)
+/// Records a new value of a counter.
+#define TRACE_COUNTER(track, name, value) Trace.Record(TRACE_TYPE_COUNTER, track, name, value)
+#else
+#define TRACE_BEGIN(track, name) ((void)0)
+#define TRACE_END(track, name) ((void)0)
+#define TRACE_INSTANT(track, name) ((void)0)
+#define TRACE_COUNTER(track, name, value) ((void)0)
+#endif
+
+#endif  // TRACER_H
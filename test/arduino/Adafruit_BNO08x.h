@@ -0,0 +1,61 @@
+/**
+ * @file Adafruit_BNO08x.h
+ * @author Aldem Pido
+ * @brief Host stand-in for the Adafruit BNO08x driver that replays a scripted report stream.
+ *  Tests push reports onto hostBnoReports; getSensorEvent() hands them out in order.
+ */
+
+#ifndef HOST_ADAFRUIT_BNO08X_H
+#define HOST_ADAFRUIT_BNO08X_H
+
+#include <deque>
+
+#include "Wire.h"
+
+#define SH2_GYROSCOPE_CALIBRATED 0x02  ///< Calibrated gyroscope report ID.
+#define SH2_GAME_ROTATION_VECTOR 0x08  ///< Game rotation vector report ID.
+
+/**
+ * @struct sh2_SensorValue_t
+ * @brief The fields of an SH-2 report the tested sources read.
+ */
+struct sh2_SensorValue_t {
+  uint8_t sensorId;    ///< Report ID.
+  uint8_t status;      ///< Accuracy status.
+  uint64_t timestamp;  ///< Host time of the report in us, in 1 ms steps like the Adafruit HAL.
+  union {
+    struct {
+      float i, j, k, real;
+    } gameRotationVector;
+    struct {
+      float x, y, z;
+    } gyroscope;
+  } un;
+};
+
+inline std::deque<sh2_SensorValue_t> hostBnoReports;  ///< Reports still to be read.
+inline bool hostBnoReset = false;                     ///< Returned once by wasReset().
+
+/**
+ * @class Adafruit_BNO08x
+ * @brief Hub that is always found and reads from hostBnoReports.
+ */
+class Adafruit_BNO08x {
+ public:
+  explicit Adafruit_BNO08x(int8_t = -1) {}
+  bool begin_I2C(uint8_t = 0x4A, TwoWire * = &Wire, int32_t = 0) { return true; }
+  bool enableReport(uint8_t, uint32_t = 10000) { return true; }
+  bool wasReset() {
+    const bool reset = hostBnoReset;
+    hostBnoReset = false;
+    return reset;
+  }
+  bool getSensorEvent(sh2_SensorValue_t *value) {
+    if (hostBnoReports.empty()) return false;
+    *value = hostBnoReports.front();
+    hostBnoReports.pop_front();
+    return true;
+  }
+};
+
+#endif  // HOST_ADAFRUIT_BNO08X_H
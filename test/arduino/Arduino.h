@@ -0,0 +1,133 @@
+/**
+ * @file Arduino.h
+ * @author Aldem Pido
+ * @brief Host stand-in for the parts of the Teensy core the tested sources use.
+ *  Time does not pass on its own: tests set hostMicros (see arduino.cpp) to drive micros() and
+ * millis(). Serial writes to stdout.
+ */
+
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+
+#define PI 3.14159265358979f
+#define HEX 16
+#define DEC 10
+#define LOW 0
+#define HIGH 1
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define OUTPUT_OPENDRAIN 4
+#define F(string) (string)
+#define FLASHMEM
+#define DMAMEM
+#define FASTRUN
+#define sq(x) ((x) * (x))
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+using std::max;
+using std::min;
+
+extern uint32_t hostMicros;  ///< Current host time; tests advance it by hand.
+
+inline uint32_t micros() { return hostMicros; }
+inline uint32_t millis() { return hostMicros / 1000; }
+inline void delay(uint32_t ms) { hostMicros += ms * 1000; }
+inline void delayMicroseconds(uint32_t us) { hostMicros += us; }
+inline void noInterrupts() {}
+inline void interrupts() {}
+inline void pinMode(uint8_t, uint8_t) {}
+inline void digitalWrite(uint8_t, uint8_t) {}
+inline int digitalRead(uint8_t) { return HIGH; }
+inline void analogWrite(uint8_t, int) {}
+inline void analogWriteFrequency(uint8_t, float) {}
+inline long map(long x, long inLow, long inHigh, long outLow, long outHigh) {
+  return (x - inLow) * (outHigh - outLow) / (inHigh - inLow) + outLow;
+}
+
+/**
+ * @class elapsedMicros
+ * @brief Microseconds since it was last set, read from micros().
+ */
+class elapsedMicros {
+ public:
+  elapsedMicros(uint32_t value = 0) : start(micros() - value) {}
+  operator uint32_t() const { return micros() - start; }
+  elapsedMicros &operator=(uint32_t value) {
+    start = micros() - value;
+    return *this;
+  }
+
+ private:
+  uint32_t start;
+};
+
+/**
+ * @class Print
+ * @brief Byte sink with the Arduino print overloads.
+ */
+class Print {
+ public:
+  virtual ~Print() = default;
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t *buffer, size_t size);
+  virtual int availableForWrite() { return 0; }
+  virtual void flush() {}
+  size_t write(const char *str) {
+    return write(reinterpret_cast<const uint8_t *>(str), strlen(str));
+  }
+
+  size_t print(const char *str) { return write(str); }
+  size_t print(char c) { return write(static_cast<uint8_t>(c)); }
+  size_t print(int value, int base = DEC) { return print(static_cast<long>(value), base); }
+  size_t print(unsigned value, int base = DEC) {
+    return print(static_cast<unsigned long>(value), base);
+  }
+  size_t print(long value, int base = DEC);
+  size_t print(unsigned long value, int base = DEC);
+  size_t print(double value, int digits = 2);
+  size_t println() { return write("\r\n"); }
+  template <typename T>
+  size_t println(T value) {
+    return print(value) + println();
+  }
+  template <typename T>
+  size_t println(T value, int format) {
+    return print(value, format) + println();
+  }
+};
+
+/**
+ * @class Stream
+ * @brief Print that can also be read.
+ */
+class Stream : public Print {
+ public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+};
+
+/**
+ * @class HostSerial
+ * @brief Serial port that writes to stdout, never blocks and never receives.
+ */
+class HostSerial : public Stream {
+ public:
+  size_t write(uint8_t c) override;
+  using Print::write;
+  int availableForWrite() override { return 4096; }
+  int available() override { return 0; }
+  int read() override { return -1; }
+};
+
+extern HostSerial Serial;  ///< Log and command port.
+
+#endif  // HOST_ARDUINO_H
@@ -0,0 +1,6 @@
+/**
+ * @file Print.h
+ * @author Aldem Pido
+ * @brief Host stand-in for Print.h; Print lives in the host Arduino.h.
+ */
+#include "Arduino.h"
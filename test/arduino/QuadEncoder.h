@@ -0,0 +1,34 @@
+/**
+ * @file QuadEncoder.h
+ * @author Aldem Pido
+ * @brief Host stand-in for the Teensy 4 QuadEncoder library.
+ *  Each encoder reads hostEncoderCounts[channel], which tests set to script the wheel motion.
+ */
+
+#ifndef HOST_QUADENCODER_H
+#define HOST_QUADENCODER_H
+
+#include "Arduino.h"
+
+inline int32_t hostEncoderCounts[5] = {};  ///< Count of each encoder channel, 1 to 4.
+
+/**
+ * @class QuadEncoder
+ * @brief Hardware quadrature decoder reading its channel's scripted count.
+ */
+class QuadEncoder {
+ public:
+  QuadEncoder(uint8_t channel, uint8_t pinA, uint8_t pinB) : channel(channel) {}
+  struct {
+    uint8_t decoderWorkMode = 0;
+  } EncConfig;  ///< The one setting DriveMotor changes.
+  void setInitConfig() {}
+  void init() {}
+  int32_t read() { return hostEncoderCounts[channel]; }
+  void write(uint32_t value) { hostEncoderCounts[channel] = value; }
+
+ private:
+  uint8_t channel;
+};
+
+#endif  // HOST_QUADENCODER_H
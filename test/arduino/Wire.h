@@ -0,0 +1,33 @@
+/**
+ * @file Wire.h
+ * @author Aldem Pido
+ * @brief Host stand-in for the Teensy Wire library. No device ever answers.
+ */
+
+#ifndef HOST_WIRE_H
+#define HOST_WIRE_H
+
+#include "Arduino.h"
+
+/**
+ * @class TwoWire
+ * @brief I2C port whose transactions all fail.
+ */
+class TwoWire : public Stream {
+ public:
+  void begin() {}
+  void end() {}
+  void setClock(uint32_t) {}
+  void beginTransmission(uint8_t) {}
+  uint8_t endTransmission(bool = true) { return 2; }
+  uint8_t requestFrom(uint8_t, uint8_t, bool = true) { return 0; }
+  size_t write(uint8_t) override { return 1; }
+  using Print::write;
+  int available() override { return 0; }
+  int read() override { return -1; }
+};
+
+inline TwoWire Wire;   ///< First I2C port.
+inline TwoWire Wire1;  ///< Second I2C port.
+
+#endif  // HOST_WIRE_H
@@ -0,0 +1,37 @@
+/**
+ * @file arduino.cpp
+ * @author Aldem Pido
+ * @brief Implements the host stand-ins declared in the host Arduino.h.
+ */
+#include "Arduino.h"
+
+#include <stdio.h>
+
+uint32_t hostMicros = 0;
+HostSerial Serial;
+
+size_t HostSerial::write(uint8_t c) { return fputc(c, stdout) == EOF ? 0 : 1; }
+
+size_t Print::write(const uint8_t *buffer, size_t size) {
+  size_t written = 0;
+  while (size--) written += write(*buffer++);
+  return written;
+}
+
+size_t Print::print(long value, int base) {
+  char text[24];
+  snprintf(text, sizeof(text), base == HEX ? "%lX" : "%ld", value);
+  return write(text);
+}
+
+size_t Print::print(unsigned long value, int base) {
+  char text[24];
+  snprintf(text, sizeof(text), base == HEX ? "%lX" : "%lu", value);
+  return write(text);
+}
+
+size_t Print::print(double value, int digits) {
+  char text[40];
+  snprintf(text, sizeof(text), "%.*f", digits, value);
+  return write(text);
+}
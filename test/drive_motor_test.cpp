@@ -0,0 +1,125 @@
+/**
+ * @file drive_motor_test.cpp
+ * @author Aldem Pido
+ * @brief Host test of DriveMotor's edge-timed wheel velocity against a fixed-window count.
+ */
+#include "../src/drive/DriveMotor.h"
+
+#include "test.h"
+
+static const uint32_t READ_US = 500;  // DriveLoop odometry period
+
+/**
+ * @class NullPrint
+ * @brief Discards DriveMotor's setup messages.
+ */
+class NullPrint : public Print {
+ public:
+  size_t write(uint8_t) override { return 1; }
+  using Print::write;
+};
+
+static NullPrint quiet;
+static const MotorSetup SETUP = {-1, -1, 3, 4, true};
+
+/**
+ * @class Wheel
+ * @brief Scripted wheel on one encoder channel, with the fixed-window estimate kept alongside.
+ */
+class Wheel {
+ public:
+  DriveMotor motor;
+  double position = 0;  // Ticks
+  float windowVelocity = 0;
+
+  explicit Wheel(uint8_t channel) : motor(SETUP, quiet), channel(channel) { motor.Begin(); }
+
+  // Turns at ticksPerSecond for durationUs, reading every READ_US
+  void Run(double ticksPerSecond, uint32_t durationUs) {
+    for (uint32_t t = 0; t < durationUs; t += READ_US) {
+      hostMicros += READ_US;
+      position += ticksPerSecond * READ_US * 1e-6;
+      hostEncoderCounts[channel] = static_cast<int32_t>(floor(position));
+      motor.ReadEnc();
+      if (hostMicros - windowStartUs >= ENC_VELOCITY_WINDOW_US) {
+        windowVelocity = (motor.GetEnc() - windowStartEnc) * 1e6f / (hostMicros - windowStartUs);
+        windowStartUs = hostMicros;
+        windowStartEnc = motor.GetEnc();
+      }
+    }
+  }
+
+ private:
+  uint8_t channel;
+  uint32_t windowStartUs = 0;
+  long windowStartEnc = 0;
+};
+
+// At steady speeds the edge-timed estimate is never worse than counting over the same window,
+// and much better for a slow wheel, which a 10 ms window sees as 0 or 100 ticks/s
+static void testAgainstFixedWindow() {
+  hostMicros = 1000000;
+  Wheel wheel(1);
+  const double speeds[] = {3.3, 23.7, 61.3, 213.4, 1487.9, -41.2};
+  printf("ticks/s   edge err   window err\n");
+  for (double speed : speeds) {
+    wheel.Run(speed, 2000000);  // Settle
+    double edgeError = 0, windowError = 0;
+    int samples = 0;
+    for (int i = 0; i < 200; i++, samples++) {
+      wheel.Run(speed, 5000);
+      edgeError += fabs(wheel.motor.GetVelocity() - speed);
+      windowError += fabs(wheel.windowVelocity - speed);
+    }
+    edgeError /= samples;
+    windowError /= samples;
+    printf("%7.1f %10.2f %12.2f\n", speed, edgeError, windowError);
+    CHECK(edgeError <= windowError + 0.5);
+    if (fabs(speed) <= 60) CHECK(edgeError < 0.3 * windowError);
+    CHECK(edgeError < 0.05 * fabs(speed) + 1);
+  }
+  wheel.Run(0, ENC_VELOCITY_TIMEOUT_US + READ_US);
+  CHECK(wheel.motor.GetVelocity() == 0);
+}
+
+// A count left over from before boot is not taken as motion, nor is a reset of the count, nor the
+// first edge after a stop
+static void testNoSpikes() {
+  hostMicros = 300000;
+  hostEncoderCounts[2] = 5000;
+  Wheel wheel(2);
+  wheel.position = 5000;
+  float worst = 0;
+  for (int i = 0; i < 100; i++) {
+    wheel.Run(100, READ_US);
+    worst = max(worst, fabsf(wheel.motor.GetVelocity()));
+  }
+  CHECK(worst < 150);
+  CHECK_NEAR(wheel.motor.GetVelocity(), 100, 10);
+
+  wheel.motor.ResetEnc();
+  wheel.position = 0;
+  CHECK(wheel.motor.GetEnc() == 0);
+  worst = 0;
+  for (int i = 0; i < 100; i++) {
+    wheel.Run(100, READ_US);
+    worst = max(worst, fabsf(wheel.motor.GetVelocity()));
+  }
+  CHECK(worst < 150);
+
+  wheel.Run(0, 2 * ENC_VELOCITY_TIMEOUT_US);
+  CHECK(wheel.motor.GetVelocity() == 0);
+  wheel.position += 50;  // Bumped while stopped, between reads
+  worst = 0;
+  for (int i = 0; i < 100; i++) {
+    wheel.Run(100, READ_US);
+    worst = max(worst, fabsf(wheel.motor.GetVelocity()));
+  }
+  CHECK(worst < 150);
+}
+
+int main() {
+  testAgainstFixedWindow();
+  testNoSpikes();
+  return TEST_RESULT();
+}
@@ -0,0 +1,78 @@
+/**
+ * @file ekf_bench.cpp
+ * @author Aldem Pido
+ * @brief Host benchmark of PoseEKF cost per update, replaying a weaving drive at the DriveLoop
+ * odometry rate with range fixes at the localizer's rate.
+ *  Predict() and UpdateYawRate() run every DriveLoop tick and UpdatePose() once per fix, so their
+ * times are printed next to the tick period. Host times are only a guide to the Teensy's; the
+ * DriveLoop tick statistics give the figure on the robot.
+ */
+#include <chrono>
+#include <vector>
+
+#include "../src/drive/PoseEKF.h"
+#include "test.h"
+
+static const int RATE_HZ = 2000;  // DRIVE_ODOMETRY_RATE_HZ in the sketch
+static const float DT = 1.0f / RATE_HZ;
+static const double PERIOD_US = 1e6 / RATE_HZ;
+static const int FIX_EVERY = RATE_HZ / 20;  // The localizer corrects at up to 20 Hz
+static const int DURATION_S = 30;
+
+/**
+ * @struct Tick
+ * @brief The filter inputs of one DriveLoop tick.
+ */
+struct Tick {
+  Pose2D step;  // Odometry step in the robot frame
+  float rate;   // Gyro yaw rate
+  Pose2D fix;   // Range fix, used every FIX_EVERY ticks
+};
+
+int main() {
+  // Build the inputs first so only the filter is timed
+  std::vector<Tick> ticks(DURATION_S * RATE_HZ);
+  double x = 20, y = 20, theta = 0;
+  for (size_t k = 0; k < ticks.size(); k++) {
+    const double t = k * DT;
+    const double forward = 20, left = 5 * sin(t), turn = 0.8 * sin(0.7 * t);
+    x += (forward * cos(theta) - left * sin(theta)) * DT;
+    y += (forward * sin(theta) + left * cos(theta)) * DT;
+    theta += turn * DT;
+    ticks[k].step = Pose2D(forward * 1.02 * DT, left * DT, turn * DT);  // Wheels read 2% long
+    ticks[k].rate = turn;
+    ticks[k].fix = Pose2D(x, y, remainder(theta, 2 * M_PI));
+  }
+
+  PoseEKF ekf;
+  ekf.Reset(Pose2D(20, 20, 0), EKF_RESET_SIGMA_XY, EKF_RESET_SIGMA_THETA);
+  std::chrono::duration<double, std::micro> predictUs(0), fixUs(0);
+  int fixes = 0;
+  for (size_t k = 0; k < ticks.size(); k++) {
+    auto start = std::chrono::steady_clock::now();
+    ekf.Predict(ticks[k].step, DT);
+    ekf.UpdateYawRate(ticks[k].rate);
+    predictUs += std::chrono::steady_clock::now() - start;
+    if (k % FIX_EVERY == FIX_EVERY - 1) {
+      start = std::chrono::steady_clock::now();
+      ekf.UpdatePose(ticks[k].fix, EKF_FIX_SIGMA_XY, EKF_FIX_SIGMA_THETA);
+      fixUs += std::chrono::steady_clock::now() - start;
+      fixes++;
+    }
+  }
+
+  const double tickUs = predictUs.count() / ticks.size();
+  const double perFixUs = fixUs.count() / fixes;
+  const double meanUs = tickUs + perFixUs / FIX_EVERY;
+  printf("update                      host us  of %.0f us tick\n", PERIOD_US);
+  printf("Predict + UpdateYawRate %11.3f %13.3f%%\n", tickUs, 100 * tickUs / PERIOD_US);
+  printf("UpdatePose (per fix)    %11.3f %13.3f%%\n", perFixUs, 100 * perFixUs / PERIOD_US);
+  printf("mean per tick           %11.3f %13.3f%%\n", meanUs, 100 * meanUs / PERIOD_US);
+
+  const Pose2D pose = ekf.GetPose();
+  const double error = hypot(pose.getX() - x, pose.getY() - y);
+  printf("final error %.3f in\n", error);
+  CHECK(error < 0.5);
+  CHECK(tickUs + perFixUs < PERIOD_US);
+  return TEST_RESULT();
+}
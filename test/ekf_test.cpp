@@ -0,0 +1,144 @@
+/**
+ * @file ekf_test.cpp
+ * @author Aldem Pido
+ * @brief Host test replaying simulated odometry, gyro and range fixes through LocalizationEncoder
+ * and PoseEKF the way SimpleRobotDrive::ReadAll() does.
+ */
+#include <random>
+
+#include "../src/drive/LocalizationEncoder.h"
+#include "../src/drive/PoseEKF.h"
+#include "test.h"
+
+static const int RATE_HZ = 500;
+static const float DT = 1.0f / RATE_HZ;
+static const int FIX_EVERY = RATE_HZ / 20;  // The localizer corrects at up to 20 Hz
+
+/**
+ * @class Replay
+ * @brief A robot weaving across the field, with the wheels reading 2% long and a noisy gyro.
+ */
+class Replay {
+ public:
+  LocalizationEncoder odometry;
+  PoseEKF ekf;
+  double x = 0, y = 0, theta = 0;  // Truth
+
+  Replay() : noise(1) {
+    odometry.updatePosition(counts, 0);
+    odometry.setPosition(Pose2D());
+    ekf.Reset(Pose2D(), EKF_RESET_SIGMA_XY, EKF_RESET_SIGMA_THETA);
+  }
+
+  // Moves the truth one step, then runs the odometry and filter on the readings
+  void Step(int k) {
+    const double t = k * DT;
+    const double forward = t < 1 ? 20 * t : 20;
+    const double left = 5 * sin(t);
+    const double turn = 0.8 * sin(0.7 * t);
+    for (int i = 0; i < odometry.getWheelCount(); i++) {
+      const float *row = odometry.getRow(i);
+      travel[i] += 1.02 * (row[0] * forward + row[1] * left + row[2] * turn) * DT;
+      counts[i] = lround(travel[i] / IN_PER_TICK);
+    }
+    x += (forward * cos(theta) - left * sin(theta)) * DT;
+    y += (forward * sin(theta) + left * cos(theta)) * DT;
+    theta += turn * DT;
+    const float yaw = remainder(theta + 0.003 * gauss(noise), 2 * M_PI);
+    odometry.updatePosition(counts, yaw);
+    ekf.Predict(odometry.getStep(), DT);
+    ekf.UpdateYawRate(turn + 0.02 * gauss(noise));
+  }
+
+  // A range fix of the true pose, fused like CorrectPosition() and copied back to the odometry
+  void Fix(float sigmaXY) {
+    const Pose2D fix(x + sigmaXY * gauss(noise), y + sigmaXY * gauss(noise),
+                     remainder(theta + EKF_FIX_SIGMA_THETA * gauss(noise), 2 * M_PI));
+    ekf.UpdatePose(fix, sigmaXY, EKF_FIX_SIGMA_THETA);
+    odometry.setPosition(ekf.GetPose());
+  }
+
+  double Error() const {
+    const Pose2D pose = ekf.GetPose();
+    return hypot(pose.getX() - x, pose.getY() - y);
+  }
+
+ private:
+  std::mt19937 noise;
+  std::normal_distribution<double> gauss;
+  long counts[ODOM_MAX_WHEELS] = {};
+  double travel[ODOM_MAX_WHEELS] = {};
+};
+
+// Fixes at 20 Hz keep the error bounded and the covariance describing it, rather than pinning
+// the covariance to the reset value
+static void testFixesTrackUncertainty() {
+  Replay replay;
+  int within = 0, checks = 0;
+  bool shrinks = true;
+  double sigmaSum = 0;
+  for (int k = 1; k <= 20 * RATE_HZ; k++) {
+    replay.Step(k);
+    if (k % FIX_EVERY != 0) continue;
+    const float before = replay.ekf.GetEstimate().GetPositionSigma();
+    replay.Fix(EKF_FIX_SIGMA_XY);
+    const float after = replay.ekf.GetEstimate().GetPositionSigma();
+    shrinks = shrinks && after < before;
+    if (k < 2 * RATE_HZ) continue;
+    checks++;
+    sigmaSum += after;
+    if (replay.Error() < 2 * after) within++;  // PathHandler's tolerance
+  }
+  const double meanSigma = sigmaSum / checks;
+  CHECK(shrinks);
+  CHECK(meanSigma < EKF_FIX_SIGMA_XY);
+  CHECK(fabs(meanSigma - sqrtf(2) * EKF_RESET_SIGMA_XY) > 0.1);
+  CHECK(within > 0.85 * checks);
+  printf("fixes: mean sigma %.3f in, error within 2 sigma %d of %d\n", meanSigma, within, checks);
+}
+
+// Without fixes the wheel scale error builds up, and so does the reported uncertainty
+static void testUncertaintyGrowsWithoutFixes() {
+  Replay replay;
+  float previous = replay.ekf.GetEstimate().GetPositionSigma();
+  for (int second = 1; second <= 5; second++) {
+    for (int k = (second - 1) * RATE_HZ + 1; k <= second * RATE_HZ; k++) replay.Step(k);
+    const float sigma = replay.ekf.GetEstimate().GetPositionSigma();
+    CHECK(sigma > previous);
+    previous = sigma;
+  }
+  CHECK(replay.Error() > 1);
+  CHECK(replay.Error() < 3 * previous);
+}
+
+// The gyro enters once, through the odometry step: heading uncertainty grows with turning, and a
+// heading fix brings it back down
+static void testHeadingFromStepsOnly() {
+  PoseEKF ekf;
+  ekf.Reset(Pose2D(), EKF_RESET_SIGMA_XY, EKF_RESET_SIGMA_THETA);
+  const float start = ekf.GetEstimate().GetHeadingSigma();
+  for (int k = 0; k < RATE_HZ; k++) ekf.Predict(Pose2D(0, 0, 2 * DT), DT);
+  const float turned = ekf.GetEstimate().GetHeadingSigma();
+  CHECK(turned > start);
+  CHECK_NEAR(ekf.GetPose().getTheta(), 2, 1e-3);
+  ekf.UpdatePose(ekf.GetPose(), EKF_FIX_SIGMA_XY, 0.01f);
+  CHECK(ekf.GetEstimate().GetHeadingSigma() < turned);
+}
+
+// A heading fix across the +/-PI seam pulls the short way and stays wrapped
+static void testFixAcrossSeam() {
+  PoseEKF ekf;
+  ekf.Reset(Pose2D(0, 0, PI - 0.01f), EKF_RESET_SIGMA_XY, 0.1f);
+  ekf.UpdatePose(Pose2D(0, 0, -PI + 0.01f), EKF_FIX_SIGMA_XY, 0.1f);
+  const float theta = ekf.GetPose().getTheta();
+  CHECK(fabsf(theta) > PI - 0.01f);
+  CHECK(theta <= PI && theta >= -PI);
+}
+
+int main() {
+  testFixesTrackUncertainty();
+  testUncertaintyGrowsWithoutFixes();
+  testHeadingFromStepsOnly();
+  testFixAcrossSeam();
+  return TEST_RESULT();
+}
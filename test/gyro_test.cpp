@@ -0,0 +1,136 @@
+/**
+ * @file gyro_test.cpp
+ * @author Aldem Pido
+ * @brief Host test of GyroHandler replaying a scripted SH-2 report stream.
+ */
+#include "../src/handler/GyroHandler.h"
+
+#include "test.h"
+
+static const uint32_t POLL_US = GYRO_REPORT_INTERVAL_US / 2;  // Gyro task period in the sketch
+
+// Queues a game rotation vector for a turn of yaw radians about z, stamped like the Adafruit HAL
+static void pushYaw(float yaw, uint32_t timeUs) {
+  sh2_SensorValue_t value = {};
+  value.sensorId = SH2_GAME_ROTATION_VECTOR;
+  value.timestamp = (timeUs / 1000) * 1000ULL;
+  value.un.gameRotationVector.real = cosf(yaw / 2);
+  value.un.gameRotationVector.k = sinf(yaw / 2);
+  hostBnoReports.push_back(value);
+}
+
+// Queues a calibrated gyroscope report
+static void pushRate(float rate, uint32_t timeUs) {
+  sh2_SensorValue_t value = {};
+  value.sensorId = SH2_GYROSCOPE_CALIBRATED;
+  value.timestamp = (timeUs / 1000) * 1000ULL;
+  value.un.gyroscope.z = rate;
+  hostBnoReports.push_back(value);
+}
+
+// Samples are stamped with micros() at read, not with the millisecond SH-2 timestamp
+static void testReadTimestamps() {
+  hostBnoReports.clear();
+  hostMicros = 1002700;
+  GyroHandler gyro;
+  CHECK(gyro.Begin());
+  pushRate(0.5f, hostMicros);
+  pushYaw(0.25f, hostMicros);
+  gyro.Update();
+
+  GyroSample sample;
+  CHECK(gyro.GetLatestSample(sample));
+  CHECK(sample.timeUs == 1002700);
+  CHECK_NEAR(sample.yaw, 0.25f, 1e-5);
+  float rate;
+  uint32_t rateUs;
+  CHECK(gyro.GetYawRate(rate, rateUs));
+  CHECK(rateUs == 1002700);
+  CHECK_NEAR(rate, 0.5f, 1e-6);
+}
+
+// One Update() drains everything queued, up to GYRO_MAX_EVENTS_PER_UPDATE
+static void testDrain() {
+  hostBnoReports.clear();
+  hostMicros = 5000;
+  GyroHandler gyro;
+  CHECK(gyro.Begin());
+  for (int i = 0; i < GYRO_MAX_EVENTS_PER_UPDATE + 2; i++) pushYaw(0.01f * i, hostMicros);
+  gyro.Update();
+  CHECK(gyro.GetSampleCount() == GYRO_MAX_EVENTS_PER_UPDATE);
+  gyro.Update();
+  CHECK(gyro.GetSampleCount() == GYRO_MAX_EVENTS_PER_UPDATE + 2);
+  CHECK(hostBnoReports.empty());
+}
+
+// Replays a constant turn: reports every 5 ms, each read at the next poll. GetSampleAt() at any
+// moment between reads stays within one poll period of turning of the true yaw.
+static void testReplayInterpolation() {
+  hostBnoReports.clear();
+  const float rate = 1.0f;
+  const uint32_t startUs = 100000;
+  const uint32_t reportPhaseUs = 1700;  // Reports are not aligned with the polls
+  GyroHandler gyro;
+  CHECK(gyro.Begin());
+  gyro.SetMoving(true);
+
+  uint32_t nextReportUs = startUs + reportPhaseUs;
+  uint32_t previousUs = 0;
+  float worst = 0;
+  for (hostMicros = startUs; hostMicros < startUs + 200000; hostMicros += POLL_US) {
+    while (static_cast<int32_t>(hostMicros - nextReportUs) >= 0) {
+      const float yaw = rate * (nextReportUs - startUs) * 1e-6f;
+      pushRate(rate, nextReportUs);
+      pushYaw(yaw, nextReportUs);
+      nextReportUs += GYRO_REPORT_INTERVAL_US;
+    }
+    gyro.Update();
+
+    GyroSample sample;
+    if (!gyro.GetLatestSample(sample)) continue;
+    CHECK(sample.timeUs == hostMicros || sample.timeUs == previousUs);
+    previousUs = sample.timeUs;
+    if (gyro.GetSampleCount() < 2) continue;
+    const uint32_t queryUs = hostMicros - POLL_US / 2;
+    GyroSample at;
+    CHECK(gyro.GetSampleAt(queryUs, at));
+    const float truth = rate * (queryUs - startUs) * 1e-6f;
+    worst = max(worst, fabsf(at.yaw - truth));
+  }
+  CHECK(gyro.GetSampleCount() == 40);
+  CHECK(worst <= rate * POLL_US * 1e-6f);
+  printf("replay: worst interpolated yaw error %.5f rad\n", worst);
+}
+
+// A still robot with a biased gyroscope becomes stationary and learns the bias
+static void testStationaryBias() {
+  hostBnoReports.clear();
+  const float bias = 0.01f;
+  GyroHandler gyro;
+  CHECK(gyro.Begin());
+  gyro.SetMoving(false);
+  for (hostMicros = 10000; hostMicros < 10000 + 6 * GYRO_STILL_TIME_US;
+       hostMicros += GYRO_REPORT_INTERVAL_US) {
+    pushRate(bias + ((hostMicros / GYRO_REPORT_INTERVAL_US) % 2 ? 0.001f : -0.001f), hostMicros);
+    pushYaw(0.5f, hostMicros);
+    gyro.Update();
+  }
+  CHECK(gyro.IsStationary());
+  CHECK_NEAR(gyro.GetRateBias(), bias, 0.003f);
+
+  float rate;
+  uint32_t rateUs;
+  CHECK(gyro.GetYawRate(rate, rateUs));
+  CHECK_NEAR(rate, 0, 0.004f);
+
+  gyro.SetMoving(true);
+  CHECK(!gyro.IsStationary());
+}
+
+int main() {
+  testReadTimestamps();
+  testDrain();
+  testReplayInterpolation();
+  testStationaryBias();
+  return TEST_RESULT();
+}
@@ -0,0 +1,91 @@
+/**
+ * @file localizer_bench.cpp
+ * @author Aldem Pido
+ * @brief Host benchmark of ParticleLocalizer accuracy and Correct() cost against particle count.
+ *  Host times only compare particle counts with each other; GetLastCorrectUs() gives the Teensy
+ * figure on the robot.
+ */
+#include <chrono>
+#include <vector>  // For paths.h
+
+#include "../src/drive/ParticleLocalizer.h"
+#include "../src/drive/paths.h"
+#include "test.h"
+
+static const RangeBeam BEAMS[] = {
+    {4.5f, 0.0f, 0.0f}, {0.0f, 4.5f, PI / 2}, {-4.5f, 0.0f, PI}, {0.0f, -4.5f, -PI / 2}};
+static const int NUM_BEAMS = sizeof(BEAMS) / sizeof(BEAMS[0]);
+static const float CAVE_OPENING = 12.0f;  // As in the sketch
+static const int STEPS = 150;
+
+/**
+ * @struct Result
+ * @brief Outcome of one run.
+ */
+struct Result {
+  float error;       // Final position error, in
+  float spread;      // Final particle spread, in
+  double correctUs;  // Mean host time of Correct()
+  bool converged;    // IsConverged() at the end
+};
+
+// Drives a slow curve from a start guess 2 in off, with odometry reading 3% long, correcting
+// against ranges cast from the true pose
+static Result run(const FieldMap &map, int particles) {
+  ParticleLocalizer localizer(map, BEAMS, NUM_BEAMS, particles);
+  float x = 20, y = 10, theta = 0.3f;
+  Pose2D odometry(22, 8, 0.3f);
+  localizer.Reset(odometry, 3, 0.05f);
+  double totalUs = 0;
+  int corrections = 0;
+  for (int k = 0; k < STEPS; k++) {
+    const float forward = 0.3f, left = 0.05f, turn = 0.004f;
+    x += cosf(theta) * forward - sinf(theta) * left;
+    y += sinf(theta) * forward + cosf(theta) * left;
+    theta += turn;
+    const float c = cosf(odometry.getTheta()), s = sinf(odometry.getTheta());
+    odometry = Pose2D(odometry.getX() + c * forward * 1.03f - s * left,
+                      odometry.getY() + s * forward * 1.03f + c * left, odometry.getTheta() + turn);
+    localizer.Predict(odometry);
+
+    float ranges[NUM_BEAMS];
+    for (int i = 0; i < NUM_BEAMS; i++) {
+      const float bx = x + cosf(theta) * BEAMS[i].x - sinf(theta) * BEAMS[i].y;
+      const float by = y + sinf(theta) * BEAMS[i].x + cosf(theta) * BEAMS[i].y;
+      const float angle = theta + BEAMS[i].angle;
+      ranges[i] = map.RayCast(bx, by, cosf(angle), sinf(angle), PF_MAX_RANGE);
+      if (ranges[i] >= PF_MAX_RANGE) ranges[i] = -1;
+    }
+    const auto start = std::chrono::steady_clock::now();
+    const bool corrected = localizer.Correct(ranges);
+    const auto end = std::chrono::steady_clock::now();
+    if (corrected) {
+      totalUs += std::chrono::duration<double, std::micro>(end - start).count();
+      corrections++;
+    }
+  }
+  const Pose2D estimate = localizer.GetPose();
+  return {hypotf(estimate.getX() - x, estimate.getY() - y), localizer.GetSpread(),
+          corrections ? totalUs / corrections : 0, localizer.IsConverged()};
+}
+
+int main() {
+  FieldMap map;
+  map.AddBox(0, 0, MAXX, MAXY);
+  map.AddWall(LEFTCAVEWALLX, 0, LEFTCAVEWALLX, CENTERY - CAVE_OPENING / 2);
+  map.AddWall(LEFTCAVEWALLX, CENTERY + CAVE_OPENING / 2, LEFTCAVEWALLX, MAXY);
+
+  const int counts[] = {25, 50, 100, 150, PF_MAX_PARTICLES};
+  printf("particles  ray casts  host us  error in  spread in\n");
+  for (int particles : counts) {
+    const Result result = run(map, particles);
+    printf("%9d %10d %8.1f %9.2f %10.2f\n", particles,
+           particles * NUM_BEAMS * map.GetWallCount(), result.correctUs, result.error,
+           result.spread);
+    if (particles >= 100) {
+      CHECK(result.converged);
+      CHECK(result.error < 1.0f);
+    }
+  }
+  return TEST_RESULT();
+}
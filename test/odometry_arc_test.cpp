@@ -0,0 +1,80 @@
+/**
+ * @file odometry_arc_test.cpp
+ * @author Aldem Pido
+ * @brief Host test of LocalizationEncoder's exact-arc integration against a straight-step (Euler)
+ * integration of the same motion, at several update rates.
+ */
+#include "../src/drive/LocalizationEncoder.h"
+#include "test.h"
+
+static const double INCHES_PER_TICK = 1e-4;  // Fine enough that counting error does not show
+
+/**
+ * @struct Drift
+ * @brief End position errors of one run, in inches.
+ */
+struct Drift {
+  double arc;    // LocalizationEncoder
+  double euler;  // Straight steps along the end heading of each update
+};
+
+// Drives a constant twist for durationS at rateHz and compares both integrations with the
+// closed-form path
+static Drift drive(int rateHz, double forward, double left, double turn, double durationS) {
+  LocalizationEncoder odometry;
+  odometry.setInchesPerTick(INCHES_PER_TICK);
+  long counts[ODOM_MAX_WHEELS] = {};
+  double travel[ODOM_MAX_WHEELS] = {};
+  odometry.updatePosition(counts, 0);
+  odometry.setPosition(Pose2D());
+
+  const double dt = 1.0 / rateHz;
+  double eulerX = 0, eulerY = 0;
+  const int steps = lround(durationS * rateHz);
+  for (int k = 1; k <= steps; k++) {
+    for (int i = 0; i < odometry.getWheelCount(); i++) {
+      const float *row = odometry.getRow(i);
+      travel[i] += (row[0] * forward + row[1] * left + row[2] * turn) * dt;
+      counts[i] = lround(travel[i] / INCHES_PER_TICK);
+    }
+    const double heading = turn * k * dt;
+    odometry.updatePosition(counts, remainder(heading, 2 * M_PI));
+    eulerX += (forward * cos(heading) - left * sin(heading)) * dt;
+    eulerY += (forward * sin(heading) + left * cos(heading)) * dt;
+  }
+
+  // Closed form: the robot-frame velocity rotated by turn * t, integrated
+  const double theta = turn * durationS;
+  double x = forward * durationS, y = left * durationS;
+  if (fabs(turn) > 1e-9) {
+    x = (forward * sin(theta) - left * (1 - cos(theta))) / turn;
+    y = (forward * (1 - cos(theta)) + left * sin(theta)) / turn;
+  }
+  const Pose2D pose = odometry.getPosition();
+  return {hypot(pose.getX() - x, pose.getY() - y), hypot(eulerX - x, eulerY - y)};
+}
+
+// A fast sweeping turn: the arc integration stays exact at every rate, while the straight steps
+// drift in proportion to the update period
+static void testSweep() {
+  const int rates[] = {50, 200, 500, 2000};
+  printf("rate Hz   arc drift in   euler drift in\n");
+  for (int rate : rates) {
+    const Drift drift = drive(rate, 20, 4, 2, 3);
+    printf("%7d %14.4f %16.4f\n", rate, drift.arc, drift.euler);
+    CHECK(drift.arc < 0.01);
+    if (rate <= 500) CHECK(drift.euler > 10 * drift.arc);
+  }
+}
+
+// Turning in place does not show up as travel
+static void testTurnInPlace() {
+  const Drift drift = drive(500, 0, 0, 3, 2);
+  CHECK(drift.arc < 0.01);
+}
+
+int main() {
+  testSweep();
+  testTurnInPlace();
+  return TEST_RESULT();
+}
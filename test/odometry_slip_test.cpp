@@ -0,0 +1,119 @@
+/**
+ * @file odometry_slip_test.cpp
+ * @author Aldem Pido
+ * @brief Host test comparing LocalizationEncoder's least-squares solve with the fixed three-wheel
+ * formulas when a wheel slips.
+ */
+#include "../src/drive/LocalizationEncoder.h"
+#include "test.h"
+
+static const int RATE_HZ = 500;
+static const double FORWARD = 20;  // in/s
+static const double TURN = 1;      // rad/s
+static const double DURATION_S = 3;
+
+/**
+ * @struct Outcome
+ * @brief End of one run.
+ */
+struct Outcome {
+  double error;          // End position error, in
+  uint32_t slipEvents0;  // Slip events flagged on the slipping wheel
+  uint32_t otherEvents;  // Slip events flagged on the other wheels
+};
+
+// Drives an arc while wheel 0 (left) reads 1.5 times its travel from 1 s to 1.5 s. With useGyro
+// false and the three default wheels the solve has no redundancy, which makes it the fixed
+// left/back/right formulas the odometry used before.
+static Outcome drive(LocalizationEncoder &odometry, bool useGyro) {
+  odometry.setInchesPerTick(IN_PER_TICK);
+  long counts[ODOM_MAX_WHEELS] = {};
+  double travel[ODOM_MAX_WHEELS] = {};
+  odometry.updatePosition(counts, useGyro ? 0 : NAN);
+  odometry.setPosition(Pose2D());
+  const double dt = 1.0 / RATE_HZ;
+  for (int k = 1; k <= DURATION_S * RATE_HZ; k++) {
+    const double t = k * dt;
+    for (int i = 0; i < odometry.getWheelCount(); i++) {
+      const float *row = odometry.getRow(i);
+      const double slip = i == 0 && t > 1 && t < 1.5 ? 1.5 : 1;
+      travel[i] += slip * (row[0] * FORWARD + row[2] * TURN) * dt;
+      counts[i] = lround(travel[i] / IN_PER_TICK);
+    }
+    odometry.updatePosition(counts, useGyro ? remainder(TURN * t, 2 * M_PI) : NAN);
+  }
+  const double theta = TURN * DURATION_S;
+  const Pose2D pose = odometry.getPosition();
+  Outcome outcome;
+  outcome.error = hypot(pose.getX() - FORWARD / TURN * sin(theta),
+                        pose.getY() - FORWARD / TURN * (1 - cos(theta)));
+  outcome.slipEvents0 = odometry.getSlipEvents(0);
+  outcome.otherEvents = 0;
+  for (int i = 1; i < odometry.getWheelCount(); i++) {
+    outcome.otherEvents += odometry.getSlipEvents(i);
+  }
+  return outcome;
+}
+
+static void testSlip() {
+  LocalizationEncoder fixed;
+  const Outcome formulas = drive(fixed, false);
+
+  LocalizationEncoder withGyro;
+  const Outcome gyro = drive(withGyro, true);
+
+  // A fourth wheel on the centerline makes the slipping wheel identifiable
+  LocalizationEncoder fourWheels;
+  OdometryWheel wheels[4];
+  wheels[0].y = WHEEL_OFFSET_Y + TRACK_WIDTH * 0.5f;
+  wheels[1].x = -BACK_OFFSET_F;
+  wheels[1].angle = PI * 0.5f;
+  wheels[2].y = WHEEL_OFFSET_Y - TRACK_WIDTH * 0.5f;
+  wheels[3].x = 2;
+  CHECK(fourWheels.setWheels(wheels, 4));
+  const Outcome four = drive(fourWheels, true);
+
+  printf("solve                   error in  wheel 0 slips  other slips\n");
+  printf("fixed 3-wheel formulas %9.2f %14u %12u\n", formulas.error, formulas.slipEvents0,
+         formulas.otherEvents);
+  printf("3 wheels + gyro        %9.2f %14u %12u\n", gyro.error, gyro.slipEvents0,
+         gyro.otherEvents);
+  printf("4 wheels + gyro        %9.2f %14u %12u\n", four.error, four.slipEvents0,
+         four.otherEvents);
+
+  CHECK(formulas.slipEvents0 == 0 && formulas.otherEvents == 0);  // Nothing is redundant
+  CHECK(gyro.error < 0.6 * formulas.error);
+  CHECK(four.error < gyro.error);
+  CHECK(four.slipEvents0 > 0);
+  CHECK(four.otherEvents == 0);
+}
+
+// Without slip every solve agrees with the path to within counting error
+static void testNoSlip() {
+  LocalizationEncoder odometry;
+  odometry.setInchesPerTick(IN_PER_TICK);
+  long counts[ODOM_MAX_WHEELS] = {};
+  double travel[ODOM_MAX_WHEELS] = {};
+  odometry.updatePosition(counts, 0);
+  odometry.setPosition(Pose2D());
+  const double dt = 1.0 / RATE_HZ;
+  for (int k = 1; k <= DURATION_S * RATE_HZ; k++) {
+    for (int i = 0; i < odometry.getWheelCount(); i++) {
+      const float *row = odometry.getRow(i);
+      travel[i] += (row[0] * FORWARD + row[2] * TURN) * dt;
+      counts[i] = lround(travel[i] / IN_PER_TICK);
+    }
+    odometry.updatePosition(counts, remainder(TURN * k * dt, 2 * M_PI));
+  }
+  const double theta = TURN * DURATION_S;
+  const Pose2D pose = odometry.getPosition();
+  CHECK_NEAR(pose.getX(), FORWARD / TURN * sin(theta), 0.05);
+  CHECK_NEAR(pose.getY(), FORWARD / TURN * (1 - cos(theta)), 0.05);
+  for (int i = 0; i < odometry.getWheelCount(); i++) CHECK(!odometry.isSlipping(i));
+}
+
+int main() {
+  testSlip();
+  testNoSlip();
+  return TEST_RESULT();
+}
@@ -0,0 +1,39 @@
+/**
+ * @file odometry_start_test.cpp
+ * @author Aldem Pido
+ * @brief Host test of LocalizationEncoder's first update, with and without a pose set before it.
+ */
+#include "../src/drive/LocalizationEncoder.h"
+#include "test.h"
+
+// A fitted start pose set before the first update keeps its heading; later yaw turns it
+static void testSetPoseKeepsHeading() {
+  LocalizationEncoder odometry;
+  long counts[ODOM_MAX_WHEELS] = {100, -40, 250};
+  odometry.setPosition(Pose2D(STARTX, STARTY, PI / 2));
+  odometry.updatePosition(counts, PI / 2);  // Gyro already offset to start at the fit
+  CHECK_NEAR(odometry.getPosition().getX(), STARTX, 1e-6);
+  CHECK_NEAR(odometry.getPosition().getY(), STARTY, 1e-6);
+  CHECK_NEAR(odometry.getPosition().getTheta(), PI / 2, 1e-6);
+
+  for (int i = 0; i < odometry.getWheelCount(); i++) {  // Turn 0.1 rad in place
+    counts[i] += lround(odometry.getRow(i)[2] * 0.1f / IN_PER_TICK);
+  }
+  odometry.updatePosition(counts, PI / 2 + 0.1f);
+  CHECK_NEAR(odometry.getPosition().getTheta(), PI / 2 + 0.1f, 1e-3);
+}
+
+// Without a set pose the first gyro yaw is the start heading
+static void testNominalTakesGyroHeading() {
+  LocalizationEncoder odometry;
+  long counts[ODOM_MAX_WHEELS] = {};
+  odometry.updatePosition(counts, 0.3f);
+  CHECK_NEAR(odometry.getPosition().getX(), STARTX, 1e-6);
+  CHECK_NEAR(odometry.getPosition().getTheta(), 0.3f, 1e-6);
+}
+
+int main() {
+  testSetPoseKeepsHeading();
+  testNominalTakesGyroHeading();
+  return TEST_RESULT();
+}
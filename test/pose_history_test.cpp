@@ -0,0 +1,119 @@
+/**
+ * @file pose_history_test.cpp
+ * @author Aldem Pido
+ * @brief Host test for PoseHistory: sample spacing, interpolated and carried-forward lookups,
+ * misses, heading and micros() wraparound, and rebasing a late correction onto the present.
+ */
+#include "../src/drive/PoseHistory.h"
+#include "test.h"
+
+static const float SPEED = 10;   // in/s
+static const float TURN = 0.5f;  // rad/s
+
+// Pose on a constant arc from the origin after t seconds, starting at heading theta0
+static Pose2D arc(double t, double theta0 = 0) {
+  const double radius = SPEED / TURN;
+  const double theta = theta0 + TURN * t;
+  return Pose2D(radius * (sin(theta) - sin(theta0)), radius * (cos(theta0) - cos(theta)),
+                remainder(theta, 2 * M_PI));
+}
+
+// Fills a history as the robot loop would, offering a sample every 500 us for a second
+static void fill(PoseHistory &history, uint32_t startUs, double theta0 = 0) {
+  for (uint32_t t = 0; t <= 1000000; t += 500) {
+    history.Add(startUs + t, arc(t * 1e-6, theta0), Pose2D(SPEED, 0, TURN));
+  }
+}
+
+static void testLookup() {
+  PoseHistory history;
+  fill(history, 0);
+  CHECK(history.GetSize() == POSE_HISTORY_SIZE);
+  CHECK(history.GetSpanUs() == (POSE_HISTORY_SIZE - 1) * POSE_HISTORY_PERIOD_US);
+
+  // Between samples
+  PoseSample sample;
+  CHECK(history.Lookup(902500, sample));
+  CHECK(sample.timeUs == 902500);
+  CHECK_NEAR(sample.pose.getX(), arc(0.9025).getX(), 1e-3);
+  CHECK_NEAR(sample.pose.getY(), arc(0.9025).getY(), 1e-3);
+  CHECK_NEAR(sample.pose.getTheta(), arc(0.9025).getTheta(), 1e-4);
+  CHECK_NEAR(sample.velocity.getX(), SPEED, 1e-4);
+
+  // After the newest sample, carried forward at its velocity
+  CHECK(history.Lookup(1003000, sample));
+  CHECK_NEAR(sample.pose.getX(), arc(1.003).getX(), 1e-3);
+  CHECK_NEAR(sample.pose.getY(), arc(1.003).getY(), 1e-3);
+  CHECK_NEAR(sample.pose.getTheta(), arc(1.003).getTheta(), 1e-4);
+
+  // Older than the span
+  CHECK(!history.Lookup(500000, sample));
+  CHECK(history.GetMissCount() == 1);
+
+  StdoutPrint out;
+  history.PrintInfo(out);
+
+  history.Clear();
+  CHECK(!history.Lookup(1000000, sample));
+  CHECK(history.GetMissCount() == 2);
+}
+
+// A late fix moves the pose at its time; the present must keep the motion made since
+static void testRebase() {
+  PoseHistory history;
+  fill(history, 0);
+  PoseSample now;
+  PoseSample then;
+  CHECK(history.Lookup(1000000, now));
+  CHECK(history.Lookup(900000, then));
+  const Pose2D to(then.pose.getX() + 1, then.pose.getY() - 0.5f, then.pose.getTheta() + 0.1f);
+
+  const Pose2D moved = PoseHistory::Rebase(now.pose, then.pose, to);
+  history.Rebase(then.pose, to);
+
+  // Distance and turn since the fix are unchanged
+  const float before =
+      hypotf(now.pose.getX() - then.pose.getX(), now.pose.getY() - then.pose.getY());
+  const float after = hypotf(moved.getX() - to.getX(), moved.getY() - to.getY());
+  CHECK_NEAR(after, before, 1e-4);
+  CHECK_NEAR(moved.getTheta() - to.getTheta(), now.pose.getTheta() - then.pose.getTheta(), 1e-5);
+
+  // The history agrees with the fix at its time and with the rebased pose now
+  PoseSample sample;
+  CHECK(history.Lookup(900000, sample));
+  CHECK_NEAR(sample.pose.getX(), to.getX(), 1e-4);
+  CHECK_NEAR(sample.pose.getY(), to.getY(), 1e-4);
+  CHECK_NEAR(sample.pose.getTheta(), to.getTheta(), 1e-5);
+  CHECK(history.Lookup(1000000, sample));
+  CHECK_NEAR(sample.pose.getX(), moved.getX(), 1e-4);
+  CHECK_NEAR(sample.pose.getY(), moved.getY(), 1e-4);
+  CHECK_NEAR(sample.pose.getTheta(), moved.getTheta(), 1e-5);
+
+  // A rebase across PI stays wrapped
+  const Pose2D wrapped = PoseHistory::Rebase(Pose2D(0, 0, 3.1f), Pose2D(), Pose2D(0, 0, 0.1f));
+  CHECK_NEAR(wrapped.getTheta(), 3.2 - 2 * M_PI, 1e-5);
+}
+
+// The heading crosses PI and micros() rolls over inside the span
+static void testWraparound() {
+  PoseHistory history;
+  const uint32_t startUs = 0xFFFFFFFFu - 800000;
+  const double theta0 = M_PI - 0.45;  // Crosses PI at 0.9 s
+  fill(history, startUs, theta0);
+  CHECK(history.GetSpanUs() == (POSE_HISTORY_SIZE - 1) * POSE_HISTORY_PERIOD_US);
+
+  PoseSample sample;
+  CHECK(history.Lookup(startUs + 902500, sample));
+  CHECK_NEAR(sample.pose.getX(), arc(0.9025, theta0).getX(), 1e-3);
+  CHECK_NEAR(sample.pose.getY(), arc(0.9025, theta0).getY(), 1e-3);
+  CHECK_NEAR(sample.pose.getTheta(), arc(0.9025, theta0).getTheta(), 1e-4);
+  CHECK(fabsf(sample.pose.getTheta()) <= PI);
+  CHECK(!history.Lookup(startUs + 500000, sample));
+}
+
+int main() {
+  testLookup();
+  testRebase();
+  testWraparound();
+  return TEST_RESULT();
+}
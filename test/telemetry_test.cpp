@@ -0,0 +1,96 @@
+/**
+ * @file telemetry_test.cpp
+ * @author Aldem Pido
+ * @brief Host test of Telemetry framing and of dropping packets when the output is full.
+ */
+#include "../src/util/Telemetry.h"
+
+#include "test.h"
+
+/**
+ * @class BufferPrint
+ * @brief Captures written bytes and reports a settable amount of free space.
+ */
+class BufferPrint : public Print {
+ public:
+  uint8_t data[1024];
+  size_t length = 0;
+  int room = 1024;
+
+  size_t write(uint8_t c) override {
+    if (length >= sizeof(data)) return 0;
+    data[length++] = c;
+    room--;
+    return 1;
+  }
+  using Print::write;
+  int availableForWrite() override { return room; }
+};
+
+// Undoes COBS on one frame ending at the delimiter; returns the decoded length
+static size_t cobsDecode(const uint8_t *frame, size_t length, uint8_t *out) {
+  size_t in = 0, written = 0;
+  while (in < length) {
+    const uint8_t code = frame[in++];
+    for (uint8_t i = 1; i < code; i++) out[written++] = frame[in++];
+    if (code < 0xFF && in < length) out[written++] = 0;
+  }
+  return written;
+}
+
+// Returns the type byte of the last frame written to the buffer
+static uint8_t lastType(const BufferPrint &buffer) {
+  size_t end = buffer.length - 1;  // Delimiter
+  size_t start = end;
+  while (start > 0 && buffer.data[start - 1] != 0) start--;
+  uint8_t raw[TELEMETRY_BUFFER_SIZE];
+  const size_t length = cobsDecode(buffer.data + start, end - start, raw);
+  CHECK(length >= 6);
+  CHECK(Telemetry::Crc16(raw, length - 2) == (raw[length - 2] | (raw[length - 1] << 8)));
+  CHECK(raw[0] == TELEMETRY_SCHEMA_ID);
+  return raw[1];
+}
+
+static void testDropForcesKeyframe() {
+  BufferPrint buffer;
+  Telemetry telemetry(buffer);
+  const int32_t fields[3] = {1200, -340, 1571};
+
+  CHECK(telemetry.Send(TELEMETRY_POSE, fields, 3));
+  CHECK(lastType(buffer) == (TELEMETRY_POSE | TELEMETRY_KEYFRAME_FLAG));
+  CHECK(telemetry.Send(TELEMETRY_POSE, fields, 3));
+  CHECK(lastType(buffer) == TELEMETRY_POSE);
+
+  // A full output drops the packet without writing or blocking
+  const size_t before = buffer.length;
+  buffer.room = 4;
+  CHECK(!telemetry.Send(TELEMETRY_POSE, fields, 3));
+  CHECK(buffer.length == before);
+  CHECK(telemetry.GetDropCount() == 1);
+  CHECK(telemetry.GetPacketCount() == 2);
+
+  // Once there is room again, the next packet carries absolute values
+  buffer.room = 1024;
+  CHECK(telemetry.Send(TELEMETRY_POSE, fields, 3));
+  CHECK(lastType(buffer) == (TELEMETRY_POSE | TELEMETRY_KEYFRAME_FLAG));
+  CHECK(telemetry.Send(TELEMETRY_POSE, fields, 3));
+  CHECK(lastType(buffer) == TELEMETRY_POSE);
+}
+
+static void testCobsHasNoZeros() {
+  uint8_t input[40];
+  for (size_t i = 0; i < sizeof(input); i++) input[i] = (i % 3 == 0) ? 0 : i;
+  uint8_t encoded[sizeof(input) + 1];
+  const size_t length = Telemetry::CobsEncode(input, sizeof(input), encoded);
+  CHECK(length == sizeof(input) + 1);
+  for (size_t i = 0; i < length; i++) CHECK(encoded[i] != 0);
+  uint8_t decoded[sizeof(input)];
+  CHECK(cobsDecode(encoded, length, decoded) == sizeof(input));
+  CHECK(memcmp(decoded, input, sizeof(input)) == 0);
+}
+
+int main() {
+  testDropForcesKeyframe();
+  testCobsHasNoZeros();
+  return TEST_RESULT();
+}
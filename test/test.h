@@ -0,0 +1,49 @@
+/**
+ * @file test.h
+ * @author Aldem Pido
+ * @brief Minimal checks for the host tests: each failed CHECK prints where it failed and the test
+ * exits non-zero from TEST_RESULT().
+ */
+
+#ifndef TEST_H
+#define TEST_H
+
+#include <stdio.h>
+
+#include "Arduino.h"
+
+static int testFailures = 0;  ///< Failed checks so far.
+
+#define CHECK(condition)                                                   \
+  do {                                                                     \
+    if (!(condition)) {                                                    \
+      printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+      testFailures++;                                                      \
+    }                                                                      \
+  } while (0)
+
+#define CHECK_NEAR(actual, expected, tolerance)                                                 \
+  do {                                                                                          \
+    const double checkActual = (actual);                                                        \
+    const double checkExpected = (expected);                                                    \
+    if (!(fabs(checkActual - checkExpected) <= (tolerance))) {                                  \
+      printf("%s:%d: %s = %g, expected %g +/- %g\n", __FILE__, __LINE__, #actual, checkActual, \
+             checkExpected, static_cast<double>(tolerance));                                    \
+      testFailures++;                                                                           \
+    }                                                                                           \
+  } while (0)
+
+#define TEST_RESULT() (printf("%s: %s\n", __FILE__, testFailures ? "FAILED" : "passed"), \
+                       testFailures ? 1 : 0)
+
+/**
+ * @class StdoutPrint
+ * @brief Print that writes to stdout, for PrintInfo() output in test logs.
+ */
+class StdoutPrint : public Print {
+ public:
+  size_t write(uint8_t c) override { return fputc(c, stdout) == EOF ? 0 : 1; }
+  using Print::write;
+};
+
+#endif  // TEST_H
@@ -0,0 +1,150 @@
+/**
+ * @file tof_filter_test.cpp
+ * @author Aldem Pido
+ * @brief Host test of TOFFilter on scripted VL53L0X reading traces.
+ */
+#include "../src/handler/TOFFilter.h"
+
+#include "test.h"
+
+static const uint8_t VALID = TOF_RANGE_STATUS_VALID << 3;  // RESULT_RANGE_STATUS values
+static const uint8_t SIGMA = TOF_RANGE_STATUS_SIGMA << 3;
+static const uint8_t PHASE = 6 << 3;
+static const uint32_t PERIOD_US = 20000;  // Sorter sensor budget
+
+/**
+ * @struct Reading
+ * @brief One raw reading of a trace.
+ */
+struct Reading {
+  uint16_t mm;
+  uint8_t status;
+};
+
+// Feeds a trace from timeUs on, storing the distance after each reading; returns the end time
+static uint32_t play(TOFFilter &filter, const Reading *trace, int count, int *distances,
+                     uint32_t timeUs = PERIOD_US) {
+  for (int i = 0; i < count; i++, timeUs += PERIOD_US) {
+    filter.Update(trace[i].mm, trace[i].status, timeUs);
+    distances[i] = filter.GetDistance();
+  }
+  return timeUs;
+}
+
+// Readings after the first one at or past index that satisfies the predicate
+template <typename Predicate>
+static int readingsUntil(const int *distances, int count, int index, Predicate predicate) {
+  for (int i = index; i < count; i++) {
+    if (predicate(distances[i])) return i - index;
+  }
+  return count;
+}
+
+// The first good reading is already a valid distance
+static void testFirstReading() {
+  TOFFilter filter;
+  filter.Update(412, VALID, 1000);
+  CHECK(filter.IsValid());
+  CHECK(filter.GetDistance() == 412);
+
+  TOFFilter weak;
+  weak.Update(412, SIGMA, 1000);
+  CHECK(weak.IsValid());
+  CHECK(weak.GetDistance() == 412);
+}
+
+// A block arriving in front of the sorter: empty chute at 310 mm, then the block at 95 mm
+static const Reading ARRIVAL[] = {
+    {311, VALID}, {309, VALID}, {312, VALID}, {308, VALID}, {310, VALID}, {311, VALID},
+    {96, VALID},  {94, VALID},  {95, VALID},  {97, VALID},  {95, VALID},  {94, VALID},
+};
+static const int ARRIVAL_COUNT = sizeof(ARRIVAL) / sizeof(ARRIVAL[0]);
+static const int ARRIVAL_STEP = 6;
+
+// A real step shows after one reading with the median, and at once without it
+static void testStep() {
+  int distances[ARRIVAL_COUNT];
+  const auto arrived = [](int mm) { return mm >= 0 && mm < 150; };
+
+  TOFFilter standard;
+  play(standard, ARRIVAL, ARRIVAL_COUNT, distances);
+  CHECK(readingsUntil(distances, ARRIVAL_COUNT, ARRIVAL_STEP, arrived) == 1);
+  CHECK(standard.GetRejectedCount() == 0);
+
+  TOFFilterConfig config;
+  config.medianWindow = 1;
+  config.maxOutliers = 1;
+  TOFFilter sorter;
+  sorter.Configure(config);
+  play(sorter, ARRIVAL, ARRIVAL_COUNT, distances);
+  CHECK(readingsUntil(distances, ARRIVAL_COUNT, ARRIVAL_STEP, arrived) == 0);
+  CHECK_NEAR(distances[ARRIVAL_COUNT - 1], 95, 2);
+}
+
+// Wall at 600 mm with single spikes both ways, a phase-fail dropout and some sigma fails
+static const Reading SPIKES[] = {
+    {601, VALID}, {598, VALID}, {603, VALID}, {1450, VALID}, {600, VALID}, {597, VALID},
+    {602, SIGMA}, {41, VALID},  {599, VALID}, {8190, PHASE}, {601, VALID}, {604, SIGMA},
+    {598, VALID}, {600, VALID}, {2900, VALID}, {603, VALID}, {599, VALID}, {600, VALID},
+};
+static const int SPIKES_COUNT = sizeof(SPIKES) / sizeof(SPIKES[0]);
+
+// Single spikes never reach the output, and one dropout does not invalidate the distance
+static void testSpikes() {
+  int distances[SPIKES_COUNT];
+  TOFFilter standard;
+  play(standard, SPIKES, SPIKES_COUNT, distances);
+  for (int i = 0; i < SPIKES_COUNT; i++) {
+    CHECK_NEAR(distances[i], 600, 10);
+  }
+
+  TOFFilterConfig config;
+  config.medianWindow = 1;
+  TOFFilter unmedianed;
+  unmedianed.Configure(config);
+  play(unmedianed, SPIKES, SPIKES_COUNT, distances);
+  for (int i = 0; i < SPIKES_COUNT; i++) {
+    if (distances[i] >= 0) CHECK_NEAR(distances[i], 600, 10);
+  }
+  CHECK(unmedianed.GetRejectedCount() == 2);  // The 1450 mm and 41 mm readings
+}
+
+// The target leaves: after a run of phase fails the distance reads -1, and a new one is taken
+// as soon as it is seen
+static void testLostTarget() {
+  TOFFilter filter;
+  uint32_t timeUs = PERIOD_US;
+  for (int i = 0; i < 5; i++, timeUs += PERIOD_US) filter.Update(450, VALID, timeUs);
+  int lostAfter = -1;
+  for (int i = 0; i < 10; i++, timeUs += PERIOD_US) {
+    filter.Update(8190, PHASE, timeUs);
+    if (lostAfter < 0 && filter.GetDistance() < 0) lostAfter = i;
+  }
+  CHECK(lostAfter >= 1 && lostAfter <= 3);
+  filter.Update(220, VALID, timeUs);
+  CHECK(filter.GetDistance() == 220);
+}
+
+// Approach at 0.5 m/s: the alpha-beta filter settles on the rate and keeps up
+static void testRamp() {
+  TOFFilter filter;
+  float worst = 0;
+  for (int i = 0; i < 40; i++) {
+    const float truth = 900 - 500 * (i * PERIOD_US * 1e-6f);
+    const uint16_t mm = static_cast<uint16_t>(truth + ((i % 3) - 1) * 4);
+    filter.Update(mm, VALID, (i + 1) * PERIOD_US);
+    if (i >= 20) worst = max(worst, fabsf(filter.GetDistance() - truth));
+  }
+  CHECK(filter.IsValid());
+  CHECK_NEAR(filter.GetRate(), -500, 100);
+  CHECK(worst < 25);
+}
+
+int main() {
+  testFirstReading();
+  testStep();
+  testSpikes();
+  testLostTarget();
+  testRamp();
+  return TEST_RESULT();
+}
@@ -0,0 +1,188 @@
+#!/usr/bin/env python3
+"""Read, diff and write the Teensy tuning configuration over Serial.
+
+The configuration is the RobotConfig blob held by src/util/ConfigStore.cpp.
+The robot must not be RUNNING for writes.
+
+Usage:
+    config_tool.py --port /dev/ttyACM0 read [-o tuning.json]
+    config_tool.py --port /dev/ttyACM0 diff tuning.json
+    config_tool.py --port /dev/ttyACM0 write tuning.json [--no-save]
+
+A JSON file for write may list only the fields to change, e.g.
+    {"thetaPID.kp": 6.5, "sorter.objectRange": 80}
+
+Requires pyserial. Binary telemetry on the same port is ignored.
+"""
+
+import argparse
+import json
+import re
+import struct
+import sys
+import time
+
+CONFIG_VERSION = 1
+CONFIG_SIZE = 240
+CHUNK_BYTES = 16
+
+# Mirrors struct RobotConfig in src/util/ConfigStore.h (little-endian, ARM EABI alignment).
+PID_FIELDS = ["kp", "ki", "kd", "kaw", "timeConst", "max", "min", "maxRate", "thetaFix"]
+LAYOUT = (
+    [("xPID." + f, "d" if f != "thetaFix" else "?") for f in PID_FIELDS] + [(None, "7x")]
+    + [("yPID." + f, "d" if f != "thetaFix" else "?") for f in PID_FIELDS] + [(None, "7x")]
+    + [("thetaPID." + f, "d" if f != "thetaFix" else "?") for f in PID_FIELDS] + [(None, "7x")]
+    + [("wheelDiameter", "f")]
+    + [("sorter." + f, "B") for f in ["left", "softLeft", "center", "softRight", "right"]]
+    + [(None, "x"), ("sorter.objectRange", "h")]
+    + [("mandibles." + f, "B") for f in ["leftOpen", "leftClose", "rightOpen", "rightClose"]]
+    + [("beacon." + f, "B") for f in ["up", "down1", "down2", "down"]]
+    + [(None, "4x")]
+)
+FORMAT = "<" + "".join(fmt for _, fmt in LAYOUT)
+NAMES = [name for name, _ in LAYOUT if name is not None]
+assert struct.calcsize(FORMAT) == CONFIG_SIZE
+
+LINE = re.compile(r"CFG (V|D|E|OK|ERR)\b ?([^\r\n]*)")
+
+
+def crc16(data):
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+def decode(blob):
+    values = struct.unpack(FORMAT, blob)
+    return {name: (round(v, 6) if isinstance(v, float) else v) for name, v in zip(NAMES, values)}
+
+
+def encode(fields):
+    return struct.pack(FORMAT, *(fields[name] for name in NAMES))
+
+
+class Robot:
+    def __init__(self, port, baud, timeout):
+        import serial  # Imported here so --help works without pyserial
+
+        self.port = serial.Serial(port, baud, timeout=0.1)
+        self.timeout = timeout
+        self.pending = b""
+
+    def send(self, command):
+        self.port.write((command + "\n").encode("ascii"))
+
+    def lines(self):
+        """Yields (kind, rest) for every CFG line until the timeout."""
+        deadline = time.time() + self.timeout
+        while time.time() < deadline:
+            self.pending += self.port.read(256)
+            *complete, self.pending = self.pending.split(b"\n")
+            for raw in complete:
+                match = LINE.search(raw.decode("latin-1"))
+                if match:
+                    deadline = time.time() + self.timeout
+                    yield match.group(1), match.group(2).strip()
+        raise TimeoutError("no reply from the robot")
+
+    def command(self, command):
+        self.send(command)
+        for kind, rest in self.lines():
+            if kind == "OK":
+                return
+            if kind == "ERR":
+                raise RuntimeError(f"robot rejected '{command}' {rest}".strip())
+
+    def read(self):
+        self.send("cfg dump")
+        blob = bytearray(CONFIG_SIZE)
+        header = None
+        for kind, rest in self.lines():
+            if kind == "V":
+                version, size, crc = rest.split()
+                header = (int(version), int(size), int(crc, 16))
+            elif kind == "D" and header:
+                offset, data = rest.split()
+                chunk = bytes.fromhex(data)
+                blob[int(offset):int(offset) + len(chunk)] = chunk
+            elif kind == "E" and header:
+                break
+        version, size, crc = header
+        if version != CONFIG_VERSION or size != CONFIG_SIZE:
+            sys.exit(f"robot has config version {version} ({size} bytes); "
+                     f"this tool handles version {CONFIG_VERSION} ({CONFIG_SIZE} bytes)")
+        if crc16(blob) != crc:
+            sys.exit("config dump corrupted (CRC mismatch), try again")
+        return bytes(blob)
+
+    def write(self, blob):
+        self.command("cfg begin")
+        for offset in range(0, len(blob), CHUNK_BYTES):
+            self.command(f"cfg w {offset} {blob[offset:offset + CHUNK_BYTES].hex()}")
+        self.command(f"cfg commit {crc16(blob):x}")
+
+
+def diff(old, new):
+    changes = []
+    for name in NAMES:
+        if name in new and new[name] != old[name]:
+            changes.append((name, old[name], new[name]))
+    return changes
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--port", required=True, help="serial port of the Teensy")
+    parser.add_argument("--baud", type=int, default=115200)
+    parser.add_argument("--timeout", type=float, default=2.0, help="seconds to wait for replies")
+    sub = parser.add_subparsers(dest="action", required=True)
+    read_parser = sub.add_parser("read", help="print the active configuration as JSON")
+    read_parser.add_argument("-o", "--output", help="also save it to this file")
+    diff_parser = sub.add_parser("diff", help="compare the robot against a JSON file")
+    diff_parser.add_argument("file")
+    write_parser = sub.add_parser("write", help="apply the fields in a JSON file")
+    write_parser.add_argument("file")
+    write_parser.add_argument("--no-save", action="store_true", help="apply without saving")
+    args = parser.parse_args()
+
+    robot = Robot(args.port, args.baud, args.timeout)
+    current = decode(robot.read())
+
+    if args.action == "read":
+        text = json.dumps(current, indent=2)
+        print(text)
+        if args.output:
+            with open(args.output, "w") as f:
+                f.write(text + "\n")
+        return
+
+    with open(args.file) as f:
+        wanted = json.load(f)
+    unknown = sorted(set(wanted) - set(NAMES))
+    if unknown:
+        sys.exit("unknown fields: " + ", ".join(unknown))
+    changes = diff(current, wanted)
+    for name, old, new in changes:
+        print(f"{name}: {old} -> {new}")
+
+    if args.action == "diff":
+        sys.exit(1 if changes else 0)
+    if not changes:
+        print("nothing to write")
+        return
+    merged = dict(current)
+    merged.update(wanted)
+    robot.write(encode(merged))
+    if not args.no_save:
+        robot.command("cfg save")
+    if decode(robot.read()) != decode(encode(merged)):
+        sys.exit("read-back does not match what was written")
+    print("written" + ("" if args.no_save else " and saved"))
+
+
+if __name__ == "__main__":
+    main()
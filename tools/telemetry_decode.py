@@ -0,0 +1,195 @@
+#!/usr/bin/env python3
+"""Decode the Teensy binary telemetry stream into CSV files.
+
+The stream is the COBS-framed packet format written by src/util/Telemetry.cpp.
+Each message type is written to its own CSV file, <prefix>_<type>.csv.
+
+Usage:
+    telemetry_decode.py capture.bin -o run1
+    telemetry_decode.py --port /dev/ttyACM0 -o run1     (requires pyserial)
+
+Text printed on the same port (boot messages, command replies) is skipped:
+it never forms a frame with a valid CRC.
+"""
+
+import argparse
+import csv
+import sys
+
+SCHEMA_ID = 2
+KEYFRAME_FLAG = 0x80
+
+# Mirrors enum TelemetryMessage in src/util/Telemetry.h. Field counts that
+# depend on the robot configuration are expanded to numbered columns.
+MESSAGES = {
+    0: ("pose", ["x", "y", "theta"], [0.01, 0.01, 0.001]),
+    1: ("velocity", ["vx", "vy", "omega", "ideal_vx", "ideal_vy", "ideal_omega",
+                     "measured_vx", "measured_vy", "measured_omega"],
+        [0.01, 0.01, 0.001, 0.01, 0.01, 0.001, 0.01, 0.01, 0.001]),
+    2: ("encoders", None, 1),
+    3: ("tof", None, 1),
+    4: ("rc", None, 1),
+    5: ("servo", None, 1),
+    6: ("motor", None, 1),
+}
+
+
+def crc16(data):
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+def cobs_decode(frame):
+    out = bytearray()
+    i = 0
+    while i < len(frame):
+        code = frame[i]
+        if code == 0 or i + code > len(frame):
+            return None
+        out += frame[i + 1:i + code]
+        i += code
+        if code < 0xFF and i < len(frame):
+            out.append(0)
+    return bytes(out)
+
+
+def read_varints(data):
+    values = []
+    shift = 0
+    acc = 0
+    for byte in data:
+        acc |= (byte & 0x7F) << shift
+        if byte & 0x80:
+            shift += 7
+            continue
+        values.append((acc >> 1) ^ -(acc & 1))
+        acc = 0
+        shift = 0
+    if shift:
+        return None  # Truncated varint
+    return values
+
+
+class Decoder:
+    def __init__(self, prefix):
+        self.prefix = prefix
+        self.writers = {}
+        self.files = []
+        self.previous = {}
+        self.sequence = {}
+        self.stats = {"frames": 0, "bad": 0, "lost": 0, "waiting": 0}
+
+    def writer(self, msg_type, count):
+        if msg_type not in self.writers:
+            name, columns, _ = MESSAGES[msg_type]
+            if columns is None:
+                columns = ["%s%d" % (name, i) for i in range(count)]
+            f = open("%s_%s.csv" % (self.prefix, name), "w", newline="")
+            self.files.append(f)
+            w = csv.writer(f)
+            w.writerow(["time_ms", "seq"] + columns)
+            self.writers[msg_type] = w
+        return self.writers[msg_type]
+
+    @staticmethod
+    def check(frame):
+        packet = cobs_decode(frame)
+        if packet is None or len(packet) < 6:
+            return None
+        body, crc = packet[:-2], packet[-2] | (packet[-1] << 8)
+        if crc16(body) != crc or body[0] != SCHEMA_ID:
+            return None
+        return body
+
+    def feed_frame(self, frame):
+        # Text written between packets ends up in front of the next frame, so
+        # fall back to the longest suffix that is a valid packet.
+        body = None
+        for start in range(len(frame) - 5):
+            body = self.check(frame[start:])
+            if body is not None:
+                break
+        if body is None:
+            self.stats["bad"] += 1
+            return
+        msg_type = body[1] & ~KEYFRAME_FLAG
+        keyframe = bool(body[1] & KEYFRAME_FLAG)
+        seq = body[2]
+        values = read_varints(body[3:])
+        if msg_type not in MESSAGES or not values:
+            self.stats["bad"] += 1
+            return
+        self.stats["frames"] += 1
+
+        expected = self.sequence.get(msg_type)
+        if expected is not None and seq != expected:
+            self.stats["lost"] += (seq - expected) & 0xFF
+            self.previous.pop(msg_type, None)  # Deltas are useless until the next keyframe
+        self.sequence[msg_type] = (seq + 1) & 0xFF
+
+        if not keyframe:
+            last = self.previous.get(msg_type)
+            if last is None or len(last) != len(values):
+                self.stats["waiting"] += 1
+                return
+            values = [a + b for a, b in zip(last, values)]
+        self.previous[msg_type] = values
+
+        _, _, scale = MESSAGES[msg_type]
+        fields = values[1:]
+        if isinstance(scale, list):
+            fields = [round(v * s, 3) for v, s in zip(fields, scale)]
+        self.writer(msg_type, len(fields)).writerow([values[0], seq] + fields)
+
+    def feed(self, data, pending):
+        pending += data
+        while True:
+            end = pending.find(b"\x00")
+            if end < 0:
+                return pending
+            if end > 0:
+                self.feed_frame(pending[:end])
+            pending = pending[end + 1:]
+
+    def close(self):
+        for f in self.files:
+            f.close()
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("input", nargs="?", help="captured binary stream")
+    parser.add_argument("--port", help="serial port to read live")
+    parser.add_argument("--baud", type=int, default=9600)
+    parser.add_argument("-o", "--prefix", default="telemetry", help="CSV file prefix")
+    args = parser.parse_args()
+
+    decoder = Decoder(args.prefix)
+    pending = b""
+    try:
+        if args.port:
+            import serial  # pyserial
+
+            with serial.Serial(args.port, args.baud, timeout=0.1) as port:
+                port.write(b"tlm key\n")
+                while True:
+                    pending = decoder.feed(port.read(4096), pending)
+        else:
+            if not args.input:
+                parser.error("give an input file or --port")
+            with open(args.input, "rb") as f:
+                pending = decoder.feed(f.read(), pending)
+    except KeyboardInterrupt:
+        pass
+    finally:
+        decoder.close()
+        print(decoder.stats, file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
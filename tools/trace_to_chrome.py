@@ -0,0 +1,123 @@
+#!/usr/bin/env python3
+"""Convert a Teensy trace dump into Chrome trace JSON.
+
+The dump is the "TRC" text written by Tracer::Dump() in src/util/Tracer.cpp
+in reply to the "trace dump" command. Open the JSON in https://ui.perfetto.dev
+or chrome://tracing.
+
+Usage:
+    trace_to_chrome.py capture.txt -o match.json
+    trace_to_chrome.py --port /dev/ttyACM0 -o match.json     (requires pyserial)
+
+Other text and binary telemetry in the capture are skipped. If the capture
+holds several dumps, the last one is used.
+"""
+
+import argparse
+import json
+import re
+import sys
+import time
+
+# Mirrors enum TraceTrack in src/util/Tracer.h.
+TRACKS = ["loop", "state", "mission"]
+
+LINE = re.compile(rb"TRC (?:(H) (\d+) (\d+)|(E)|([\d.]+) ([BEiC]) (\d+) (-?\d+) ([^\r\n]*))")
+
+
+def parse(data):
+    """Returns (events, overwritten) of the last complete dump in data."""
+    dumps = []
+    events = None
+    overwritten = 0
+    for match in LINE.finditer(data):
+        if match.group(1):
+            events = []
+            overwritten = int(match.group(3))
+        elif match.group(4):
+            if events is not None:
+                dumps.append((events, overwritten))
+            events = None
+        elif events is not None:
+            ts, phase, track, value, name = match.group(5, 6, 7, 8, 9)
+            events.append((float(ts), phase.decode(), int(track), int(value),
+                           name.decode("latin-1").strip()))
+    if not dumps:
+        sys.exit("no complete trace dump found (expected TRC H ... TRC E)")
+    return dumps[-1]
+
+
+def convert(events):
+    """Builds the Chrome trace event list. Spans left open are closed at the last event."""
+    out = []
+    for tid, name in enumerate(TRACKS):
+        out.append({"ph": "M", "name": "thread_name", "pid": 1, "tid": tid,
+                    "args": {"name": name}})
+        out.append({"ph": "M", "name": "thread_sort_index", "pid": 1, "tid": tid,
+                    "args": {"sort_index": tid}})
+    open_spans = {}
+    end_ts = events[-1][0] if events else 0.0
+    for ts, phase, track, value, name in events:
+        event = {"name": name, "ph": phase, "ts": ts, "pid": 1, "tid": track}
+        if phase == "B":
+            open_spans.setdefault(track, []).append(name)
+        elif phase == "E":
+            stack = open_spans.get(track, [])
+            if name not in stack:
+                continue  # Its begin was overwritten in the ring buffer
+            while stack and stack[-1] != name:  # Close spans that never ended, e.g. on abort
+                out.append({"name": stack.pop(), "ph": "E", "ts": ts, "pid": 1, "tid": track})
+            stack.pop()
+        elif phase == "i":
+            event["s"] = "t"
+        elif phase == "C":
+            event["args"] = {name: value}
+        out.append(event)
+    for track, stack in open_spans.items():
+        while stack:
+            out.append({"name": stack.pop(), "ph": "E", "ts": end_ts, "pid": 1, "tid": track})
+    return out
+
+
+def read_port(port_name, baud, timeout):
+    import serial  # pyserial
+
+    data = b""
+    with serial.Serial(port_name, baud, timeout=0.1) as port:
+        port.write(b"trace dump\n")
+        deadline = time.time() + timeout
+        while time.time() < deadline and not re.search(rb"TRC E\r?\n", data):
+            chunk = port.read(65536)
+            if chunk:
+                deadline = time.time() + timeout
+            data += chunk
+    return data
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("input", nargs="?", help="captured serial output")
+    parser.add_argument("--port", help="serial port to request a dump from")
+    parser.add_argument("--baud", type=int, default=9600)
+    parser.add_argument("--timeout", type=float, default=2.0, help="seconds to wait for data")
+    parser.add_argument("-o", "--output", default="trace.json", help="Chrome trace JSON file")
+    args = parser.parse_args()
+
+    if args.port:
+        data = read_port(args.port, args.baud, args.timeout)
+    elif args.input:
+        with open(args.input, "rb") as f:
+            data = f.read()
+    else:
+        parser.error("give an input file or --port")
+
+    events, overwritten = parse(data)
+    with open(args.output, "w") as f:
+        json.dump({"traceEvents": convert(events), "displayTimeUnit": "ns"}, f)
+    print(f"{len(events)} events written to {args.output}", file=sys.stderr)
+    if overwritten:
+        print(f"{overwritten} older events were overwritten on the robot", file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()